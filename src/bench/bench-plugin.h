@@ -0,0 +1,74 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+/**
+ * The audio settings every plugin instance gets set up with.
+ */
+struct ProcessSettings {
+    uint32_t block_size;
+    uint32_t sample_rate;
+};
+
+/**
+ * A single plugin instance that has been set up for processing audio. Instances
+ * are created and destroyed on the main thread, and `process()` gets called
+ * from the instance's own processing thread. The destructor stops processing
+ * and closes the plugin again.
+ */
+class BenchPlugin {
+   public:
+    virtual ~BenchPlugin() noexcept = default;
+
+    /**
+     * The total number of input channels across all of the plugin's input
+     * busses.
+     */
+    virtual int num_inputs() const noexcept = 0;
+
+    /**
+     * The total number of output channels across all of the plugin's output
+     * busses.
+     */
+    virtual int num_outputs() const noexcept = 0;
+
+    /**
+     * Process a single block of `ProcessSettings::block_size` samples.
+     * `inputs` and `outputs` contain `num_inputs()` and `num_outputs()`
+     * channels respectively.
+     */
+    virtual void process(float** inputs, float** outputs) = 0;
+};
+
+/**
+ * A loaded plugin library that can create any number of plugin instances.
+ */
+class BenchPluginLibrary {
+   public:
+    virtual ~BenchPluginLibrary() noexcept = default;
+
+    /**
+     * Create and initialize a new plugin instance, and get it ready to process
+     * audio.
+     *
+     * @throw std::runtime_error If the plugin could not be initialized.
+     */
+    virtual std::unique_ptr<BenchPlugin> create_instance() = 0;
+};
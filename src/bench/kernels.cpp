@@ -0,0 +1,269 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "kernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../common/audio-kernels.h"
+
+/**
+ * The checks cover every buffer size up to this many samples, so every
+ * combination of full vectors and scalar tails gets exercised for all
+ * implementations.
+ */
+constexpr size_t max_checked_samples = 130;
+
+/**
+ * Buffers are also checked at these element offsets from the start of an
+ * allocation, since none of the host's buffers are guaranteed to be aligned.
+ */
+constexpr size_t max_checked_offset = 4;
+
+/**
+ * Check `kernels`' add and silence checking functions for `T` against the
+ * scalar `reference` implementations. Mismatches are printed to STDERR.
+ *
+ * @return The number of failed checks.
+ */
+template <typename T>
+static int check_kernels(
+    const char* name,
+    void (*add)(const T*, size_t, T*) noexcept,
+    bool (*is_silent)(const T*, size_t) noexcept,
+    void (*reference_add)(const T*, size_t, T*) noexcept,
+    bool (*reference_is_silent)(const T*, size_t) noexcept) {
+    std::mt19937 rng(1337);
+    std::uniform_real_distribution<T> noise(-1.0, 1.0);
+
+    int num_failures = 0;
+    auto report = [&](const std::string& check, size_t num_samples,
+                      size_t offset) {
+        std::cerr << "FAIL: " << name << " " << check << " with "
+                  << num_samples << " samples at offset " << offset
+                  << std::endl;
+        num_failures++;
+    };
+
+    std::vector<T> source(max_checked_samples + max_checked_offset);
+    std::vector<T> expected(source.size());
+    std::vector<T> actual(source.size());
+    for (size_t offset = 0; offset < max_checked_offset; offset++) {
+        for (size_t num_samples = 0; num_samples <= max_checked_samples;
+             num_samples++) {
+            // Mixing has to produce bit for bit the same results, and it may
+            // not touch any samples outside of the range
+            for (size_t i = 0; i < source.size(); i++) {
+                source[i] = noise(rng);
+                expected[i] = actual[i] = noise(rng);
+            }
+            reference_add(source.data() + offset, num_samples,
+                          expected.data() + offset);
+            add(source.data() + offset, num_samples, actual.data() + offset);
+            if (expected != actual) {
+                report("add_samples()", num_samples, offset);
+            }
+
+            // The silence checks should find a nonzero sample or a NaN value
+            // in any position, and negative zeroes still count as silence
+            std::fill(actual.begin(), actual.end(), static_cast<T>(0.0));
+            T* samples = actual.data() + offset;
+            if (!is_silent(samples, num_samples)) {
+                report("is_silent() on zeroes", num_samples, offset);
+            }
+            std::fill(actual.begin(), actual.end(), static_cast<T>(-0.0));
+            if (!is_silent(samples, num_samples)) {
+                report("is_silent() on negative zeroes", num_samples, offset);
+            }
+            std::fill(actual.begin(), actual.end(), static_cast<T>(0.0));
+            for (size_t i = 0; i < num_samples; i++) {
+                for (const T value :
+                     {static_cast<T>(1.0),
+                      std::numeric_limits<T>::quiet_NaN()}) {
+                    samples[i] = value;
+                    if (is_silent(samples, num_samples) !=
+                        reference_is_silent(samples, num_samples)) {
+                        report("is_silent() with a nonzero sample at " +
+                                   std::to_string(i),
+                               num_samples, offset);
+                    }
+                }
+                samples[i] = static_cast<T>(0.0);
+            }
+
+            // Samples outside of the range should not be looked at either
+            if (offset > 0) {
+                samples[-1] = static_cast<T>(1.0);
+            }
+            samples[num_samples] = static_cast<T>(1.0);
+            if (!is_silent(samples, num_samples)) {
+                report("is_silent() next to nonzero samples", num_samples,
+                       offset);
+            }
+        }
+    }
+
+    return num_failures;
+}
+
+/**
+ * Call `function` for `num_blocks` blocks after a short warmup, and return the
+ * average time per block in nanoseconds.
+ */
+static double time_per_block(uint32_t num_blocks,
+                             const std::function<void()>& function) {
+    for (uint32_t i = 0; i < std::max(num_blocks / 10, 1u); i++) {
+        function();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < num_blocks; i++) {
+        function();
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return elapsed.count() / num_blocks;
+}
+
+/**
+ * Buffers for `kernel_bench_channels` channels of `T`. The sources contain
+ * noise, and the silent channels are used to measure the worst case for the
+ * silence checks where every sample has to be inspected.
+ */
+template <typename T>
+struct BenchBuffers {
+    explicit BenchBuffers(uint32_t block_size)
+        : sources(kernel_bench_channels, std::vector<T>(block_size)),
+          destinations(kernel_bench_channels, std::vector<T>(block_size)),
+          silence(kernel_bench_channels, std::vector<T>(block_size)) {
+        std::mt19937 rng(kernel_bench_channels);
+        std::uniform_real_distribution<T> noise(-1e-3, 1e-3);
+        for (auto& channel : sources) {
+            std::generate(channel.begin(), channel.end(),
+                          [&]() { return noise(rng); });
+        }
+    }
+
+    std::vector<std::vector<T>> sources;
+    std::vector<std::vector<T>> destinations;
+    std::vector<std::vector<T>> silence;
+};
+
+int run_kernel_benchmark(uint32_t block_size, uint32_t num_blocks) {
+    const std::vector<AudioKernels> implementations = supported_audio_kernels();
+    const AudioKernels& reference = implementations.back();
+
+    int num_failures = 0;
+    for (const AudioKernels& kernels : implementations) {
+        const std::string name(kernels.name);
+        num_failures += check_kernels<float>(
+            (name + " (float)").c_str(), kernels.add_float,
+            kernels.is_silent_float, reference.add_float,
+            reference.is_silent_float);
+        num_failures += check_kernels<double>(
+            (name + " (double)").c_str(), kernels.add_double,
+            kernels.is_silent_double, reference.add_double,
+            reference.is_silent_double);
+    }
+    if (num_failures > 0) {
+        std::cerr << num_failures
+                  << " kernel check(s) failed, skipping the benchmark"
+                  << std::endl;
+        return 1;
+    }
+
+    std::cerr << "All " << implementations.size()
+              << " kernel implementation(s) match the scalar versions"
+              << std::endl
+              << "Processing " << num_blocks << " blocks of "
+              << kernel_bench_channels << " channels with " << block_size
+              << " samples each" << std::endl;
+
+    BenchBuffers<float> float_buffers(block_size);
+    BenchBuffers<double> double_buffers(block_size);
+
+    // The silence checks' results are written here so the calls can't be
+    // optimized away
+    volatile bool is_silent_result = false;
+    auto copy_all = [&]<typename T>(BenchBuffers<T>& buffers) {
+        for (int channel = 0; channel < kernel_bench_channels; channel++) {
+            copy_samples(buffers.sources[channel].data(), block_size,
+                         buffers.destinations[channel].data());
+        }
+    };
+    auto add_all = [&]<typename T>(BenchBuffers<T>& buffers,
+                                   void (*add)(const T*, size_t, T*) noexcept) {
+        for (int channel = 0; channel < kernel_bench_channels; channel++) {
+            add(buffers.sources[channel].data(), block_size,
+                buffers.destinations[channel].data());
+        }
+    };
+    auto check_all = [&]<typename T>(BenchBuffers<T>& buffers,
+                                     bool (*is_silent)(const T*,
+                                                       size_t) noexcept) {
+        for (int channel = 0; channel < kernel_bench_channels; channel++) {
+            is_silent_result =
+                is_silent(buffers.silence[channel].data(), block_size);
+        }
+    };
+
+    // All times are in nanoseconds per block of `kernel_bench_channels`
+    // channels. Copies always use `memcpy()`, so there's only a single
+    // implementation to measure there.
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::left << std::setw(10) << "kernels" << std::right
+              << std::setw(12) << "copy f32" << std::setw(12) << "copy f64"
+              << std::setw(12) << "add f32" << std::setw(12) << "add f64"
+              << std::setw(12) << "silent f32" << std::setw(12)
+              << "silent f64" << std::endl;
+    std::cout << std::left << std::setw(10) << "memcpy" << std::right
+              << std::setw(12)
+              << time_per_block(num_blocks,
+                                [&]() { copy_all(float_buffers); })
+              << std::setw(12)
+              << time_per_block(num_blocks,
+                                [&]() { copy_all(double_buffers); })
+              << std::endl;
+    for (const AudioKernels& kernels : implementations) {
+        std::cout << std::left << std::setw(10) << kernels.name << std::right
+                  << std::setw(12) << "" << std::setw(12) << ""
+                  << std::setw(12) << time_per_block(num_blocks, [&]() {
+                         add_all(float_buffers, kernels.add_float);
+                     })
+                  << std::setw(12) << time_per_block(num_blocks, [&]() {
+                         add_all(double_buffers, kernels.add_double);
+                     })
+                  << std::setw(12) << time_per_block(num_blocks, [&]() {
+                         check_all(float_buffers, kernels.is_silent_float);
+                     })
+                  << std::setw(12) << time_per_block(num_blocks, [&]() {
+                         check_all(double_buffers, kernels.is_silent_double);
+                     })
+                  << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,38 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * The number of channels the kernel benchmark processes every block. This
+ * matches a wide surround bus, which is where the kernels matter the most.
+ */
+constexpr int kernel_bench_channels = 64;
+
+/**
+ * Check every implementation of the audio kernels in
+ * `src/common/audio-kernels.cpp` supported by this CPU against the scalar
+ * versions, and then measure how long copying, mixing and silence checking
+ * `kernel_bench_channels` channels of `block_size` samples takes with each of
+ * them. The benchmark is skipped if any of the implementations produce
+ * different results.
+ *
+ * @return The program's exit code. This is nonzero if any of the checks
+ *   failed.
+ */
+int run_kernel_benchmark(uint32_t block_size, uint32_t num_blocks);
@@ -0,0 +1,430 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// A minimal Windows plugin used by `yabridge-bench` to measure yabridge's own
+// overhead without depending on any third party plugins. This is built with
+// winegcc as a Winelib DLL (`yabridge-bench-stub.dll.so`) that Wine's
+// `LoadLibrary()` can load like any other Windows plugin. The same library
+// exports both a VST2 plugin through `VSTPluginMain()` and a VST3 plugin
+// through `GetPluginFactory()`. Both only apply a gain to a stereo signal, so
+// the plugin itself takes almost no time to process audio.
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+#include <vestige/aeffectx.h>
+
+#ifdef WITH_VST3
+#include <pluginterfaces/base/ipluginbase.h>
+#include <pluginterfaces/vst/ivstaudioprocessor.h>
+#include <pluginterfaces/vst/ivstcomponent.h>
+#endif
+
+constexpr int stub_num_channels = 2;
+
+/**
+ * Write `gain * inputs` to `outputs`. `inputs` and `outputs` may point to the
+ * same buffers.
+ */
+template <typename T>
+static void process_gain(T* const* inputs,
+                         T* const* outputs,
+                         int num_channels,
+                         int num_samples,
+                         float gain) noexcept {
+    for (int channel = 0; channel < num_channels; channel++) {
+        for (int sample = 0; sample < num_samples; sample++) {
+            outputs[channel][sample] =
+                static_cast<T>(inputs[channel][sample] * gain);
+        }
+    }
+}
+
+//
+// VST2
+//
+
+/**
+ * The VST2 version of the stub plugin. A pointer to this object is stored in
+ * the `AEffect` so we can get back to it from the callbacks, and the object
+ * deletes itself when the host sends `effClose`.
+ */
+class StubVst2Plugin {
+   public:
+    StubVst2Plugin() noexcept {
+        effect.magic = kEffectMagic;
+        effect.dispatcher = dispatch;
+        effect.process = process;
+        effect.setParameter = set_parameter;
+        effect.getParameter = get_parameter;
+        effect.numPrograms = 0;
+        effect.numParams = 1;
+        effect.numInputs = stub_num_channels;
+        effect.numOutputs = stub_num_channels;
+        effect.flags = effFlagsCanReplacing;
+        effect.unkown_float = 1.0f;
+        effect.ptr3 = this;
+        effect.uniqueID = CCONST('Y', 'a', 'B', 's');
+        effect.version = 1;
+        effect.processReplacing = process_replacing;
+        effect.processDoubleReplacing = process_double_replacing;
+    }
+
+    AEffect effect{};
+
+   private:
+    static StubVst2Plugin& get(AEffect* effect) noexcept {
+        return *static_cast<StubVst2Plugin*>(effect->ptr3);
+    }
+
+    static intptr_t VST_CALL_CONV dispatch(AEffect* effect,
+                                           int opcode,
+                                           int /*index*/,
+                                           intptr_t /*value*/,
+                                           void* data,
+                                           float /*option*/) {
+        switch (opcode) {
+            case effClose:
+                delete &get(effect);
+                return 1;
+                break;
+            case effGetParamName:
+                strcpy(static_cast<char*>(data), "Gain");
+                return 1;
+                break;
+            case effGetEffectName:
+            case effGetProductString:
+                strcpy(static_cast<char*>(data), "yabridge bench stub");
+                return 1;
+                break;
+            case effGetVendorString:
+                strcpy(static_cast<char*>(data), "yabridge");
+                return 1;
+                break;
+            case effGetPlugCategory:
+                return kPlugCategEffect;
+                break;
+            default:
+                return 0;
+                break;
+        }
+    }
+
+    static void VST_CALL_CONV process(AEffect* effect,
+                                      float** inputs,
+                                      float** outputs,
+                                      int sample_frames) {
+        // The accumulating `process()` function was deprecated a long time
+        // ago, so replacing the outputs is good enough for the benchmark
+        process_replacing(effect, inputs, outputs, sample_frames);
+    }
+
+    static void VST_CALL_CONV process_replacing(AEffect* effect,
+                                                float** inputs,
+                                                float** outputs,
+                                                int sample_frames) {
+        process_gain(inputs, outputs, stub_num_channels, sample_frames,
+                     get(effect).gain.load(std::memory_order_relaxed));
+    }
+
+    static void VST_CALL_CONV process_double_replacing(AEffect* effect,
+                                                       double** inputs,
+                                                       double** outputs,
+                                                       int sample_frames) {
+        process_gain(inputs, outputs, stub_num_channels, sample_frames,
+                     get(effect).gain.load(std::memory_order_relaxed));
+    }
+
+    static void VST_CALL_CONV set_parameter(AEffect* effect,
+                                            int index,
+                                            float value) {
+        if (index == 0) {
+            get(effect).gain.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    static float VST_CALL_CONV get_parameter(AEffect* effect, int index) {
+        return index == 0 ? get(effect).gain.load(std::memory_order_relaxed)
+                          : 0.0f;
+    }
+
+    std::atomic<float> gain = 1.0f;
+};
+
+extern "C" AEffect* VST_CALL_CONV
+VSTPluginMain(audioMasterCallback /*host_callback*/) {
+    return &(new StubVst2Plugin())->effect;
+}
+
+//
+// VST3
+//
+
+#ifdef WITH_VST3
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wnon-virtual-dtor"
+
+using Steinberg::int32;
+using Steinberg::TBool;
+using Steinberg::tresult;
+using Steinberg::uint32;
+
+/**
+ * The class ID for the stub plugin's combined component and audio processor.
+ */
+static const Steinberg::TUID stub_vst3_cid =
+    INLINE_UID(0x5941425A, 0x42656E63, 0x68537475, 0x62564733);
+
+/**
+ * Copy an ASCII string to a VST3 `String128`.
+ */
+static void copy_to_string128(const char* source,
+                              Steinberg::Vst::String128 destination) noexcept {
+    size_t i = 0;
+    for (; source[i] != '\0' &&
+           i < std::extent_v<Steinberg::Vst::String128> - 1;
+         i++) {
+        destination[i] = static_cast<Steinberg::Vst::TChar>(source[i]);
+    }
+    destination[i] = 0;
+}
+
+/**
+ * The VST3 version of the stub plugin. This is a processor without an edit
+ * controller, with one stereo input bus and one stereo output bus.
+ */
+class StubVst3Plugin : public Steinberg::Vst::IComponent,
+                       public Steinberg::Vst::IAudioProcessor {
+   public:
+    StubVst3Plugin() noexcept { FUNKNOWN_CTOR }
+    virtual ~StubVst3Plugin() noexcept { FUNKNOWN_DTOR }
+
+    DECLARE_FUNKNOWN_METHODS
+
+    // From `IPluginBase`
+    tresult PLUGIN_API initialize(FUnknown* /*context*/) override {
+        return Steinberg::kResultOk;
+    }
+    tresult PLUGIN_API terminate() override { return Steinberg::kResultOk; }
+
+    // From `IComponent`
+    tresult PLUGIN_API
+    getControllerClassId(Steinberg::TUID /*classId*/) override {
+        return Steinberg::kResultFalse;
+    }
+    tresult PLUGIN_API setIoMode(Steinberg::Vst::IoMode /*mode*/) override {
+        return Steinberg::kResultOk;
+    }
+    int32 PLUGIN_API
+    getBusCount(Steinberg::Vst::MediaType type,
+                Steinberg::Vst::BusDirection /*dir*/) override {
+        return type == Steinberg::Vst::kAudio ? 1 : 0;
+    }
+    tresult PLUGIN_API
+    getBusInfo(Steinberg::Vst::MediaType type,
+               Steinberg::Vst::BusDirection dir,
+               int32 index,
+               Steinberg::Vst::BusInfo& bus /*out*/) override {
+        if (type != Steinberg::Vst::kAudio || index != 0) {
+            return Steinberg::kInvalidArgument;
+        }
+
+        bus.mediaType = type;
+        bus.direction = dir;
+        bus.channelCount = stub_num_channels;
+        copy_to_string128(dir == Steinberg::Vst::kInput ? "Input" : "Output",
+                          bus.name);
+        bus.busType = Steinberg::Vst::kMain;
+        bus.flags = Steinberg::Vst::BusInfo::kDefaultActive;
+
+        return Steinberg::kResultOk;
+    }
+    tresult PLUGIN_API
+    getRoutingInfo(Steinberg::Vst::RoutingInfo& /*inInfo*/,
+                   Steinberg::Vst::RoutingInfo& /*outInfo*/) override {
+        return Steinberg::kNotImplemented;
+    }
+    tresult PLUGIN_API activateBus(Steinberg::Vst::MediaType /*type*/,
+                                   Steinberg::Vst::BusDirection /*dir*/,
+                                   int32 /*index*/,
+                                   TBool /*state*/) override {
+        return Steinberg::kResultOk;
+    }
+    tresult PLUGIN_API setActive(TBool /*state*/) override {
+        return Steinberg::kResultOk;
+    }
+    tresult PLUGIN_API setState(Steinberg::IBStream* /*state*/) override {
+        return Steinberg::kResultOk;
+    }
+    tresult PLUGIN_API getState(Steinberg::IBStream* /*state*/) override {
+        return Steinberg::kResultOk;
+    }
+
+    // From `IAudioProcessor`
+    tresult PLUGIN_API
+    setBusArrangements(Steinberg::Vst::SpeakerArrangement* inputs,
+                       int32 numIns,
+                       Steinberg::Vst::SpeakerArrangement* outputs,
+                       int32 numOuts) override {
+        return numIns == 1 && numOuts == 1 &&
+                       inputs[0] == Steinberg::Vst::SpeakerArr::kStereo &&
+                       outputs[0] == Steinberg::Vst::SpeakerArr::kStereo
+                   ? Steinberg::kResultTrue
+                   : Steinberg::kResultFalse;
+    }
+    tresult PLUGIN_API
+    getBusArrangement(Steinberg::Vst::BusDirection /*dir*/,
+                      int32 index,
+                      Steinberg::Vst::SpeakerArrangement& arr) override {
+        if (index != 0) {
+            return Steinberg::kInvalidArgument;
+        }
+
+        arr = Steinberg::Vst::SpeakerArr::kStereo;
+        return Steinberg::kResultOk;
+    }
+    tresult PLUGIN_API
+    canProcessSampleSize(int32 /*symbolicSampleSize*/) override {
+        return Steinberg::kResultTrue;
+    }
+    uint32 PLUGIN_API getLatencySamples() override { return 0; }
+    tresult PLUGIN_API
+    setupProcessing(Steinberg::Vst::ProcessSetup& /*setup*/) override {
+        return Steinberg::kResultOk;
+    }
+    tresult PLUGIN_API setProcessing(TBool /*state*/) override {
+        return Steinberg::kResultOk;
+    }
+    tresult PLUGIN_API process(Steinberg::Vst::ProcessData& data) override {
+        // Hosts may send empty blocks to flush parameter changes
+        if (data.numInputs < 1 || data.numOutputs < 1 ||
+            data.numSamples == 0) {
+            return Steinberg::kResultOk;
+        }
+
+        const int num_channels =
+            std::min({static_cast<int>(data.inputs[0].numChannels),
+                      static_cast<int>(data.outputs[0].numChannels),
+                      stub_num_channels});
+        if (data.symbolicSampleSize == Steinberg::Vst::kSample64) {
+            process_gain(data.inputs[0].channelBuffers64,
+                         data.outputs[0].channelBuffers64, num_channels,
+                         data.numSamples, 1.0f);
+        } else {
+            process_gain(data.inputs[0].channelBuffers32,
+                         data.outputs[0].channelBuffers32, num_channels,
+                         data.numSamples, 1.0f);
+        }
+        data.outputs[0].silenceFlags = data.inputs[0].silenceFlags;
+
+        return Steinberg::kResultOk;
+    }
+    uint32 PLUGIN_API getTailSamples() override { return 0; }
+};
+
+IMPLEMENT_REFCOUNT(StubVst3Plugin)
+
+tresult PLUGIN_API StubVst3Plugin::queryInterface(const Steinberg::TUID _iid,
+                                                  void** obj) {
+    QUERY_INTERFACE(_iid, obj, Steinberg::FUnknown::iid,
+                    Steinberg::Vst::IComponent)
+    QUERY_INTERFACE(_iid, obj, Steinberg::IPluginBase::iid,
+                    Steinberg::Vst::IComponent)
+    QUERY_INTERFACE(_iid, obj, Steinberg::Vst::IComponent::iid,
+                    Steinberg::Vst::IComponent)
+    QUERY_INTERFACE(_iid, obj, Steinberg::Vst::IAudioProcessor::iid,
+                    Steinberg::Vst::IAudioProcessor)
+
+    *obj = nullptr;
+    return Steinberg::kNoInterface;
+}
+
+/**
+ * The plugin factory for the VST3 version of the stub plugin. There's only a
+ * single instance of this factory that lives for as long as the library is
+ * loaded, so reference counting is a no-op.
+ */
+class StubVst3Factory : public Steinberg::IPluginFactory {
+   public:
+    tresult PLUGIN_API queryInterface(const Steinberg::TUID _iid,
+                                      void** obj) override {
+        QUERY_INTERFACE(_iid, obj, Steinberg::FUnknown::iid,
+                        Steinberg::IPluginFactory)
+        QUERY_INTERFACE(_iid, obj, Steinberg::IPluginFactory::iid,
+                        Steinberg::IPluginFactory)
+
+        *obj = nullptr;
+        return Steinberg::kNoInterface;
+    }
+    uint32 PLUGIN_API addRef() override { return 1; }
+    uint32 PLUGIN_API release() override { return 1; }
+
+    tresult PLUGIN_API getFactoryInfo(Steinberg::PFactoryInfo* info) override {
+        *info = Steinberg::PFactoryInfo("yabridge", "", "",
+                                        Steinberg::PFactoryInfo::kUnicode);
+        return Steinberg::kResultOk;
+    }
+    int32 PLUGIN_API countClasses() override { return 1; }
+    tresult PLUGIN_API getClassInfo(int32 index,
+                                    Steinberg::PClassInfo* info) override {
+        if (index != 0) {
+            return Steinberg::kInvalidArgument;
+        }
+
+        *info = Steinberg::PClassInfo(
+            stub_vst3_cid, Steinberg::PClassInfo::kManyInstances,
+            kVstAudioEffectClass, "yabridge bench stub");
+        return Steinberg::kResultOk;
+    }
+    tresult PLUGIN_API createInstance(Steinberg::FIDString cid,
+                                      Steinberg::FIDString _iid,
+                                      void** obj) override {
+        if (!Steinberg::FUnknownPrivate::iidEqual(cid, stub_vst3_cid)) {
+            *obj = nullptr;
+            return Steinberg::kInvalidArgument;
+        }
+
+        // The reference from the constructor is dropped again after querying
+        // the requested interface
+        StubVst3Plugin* plugin = new StubVst3Plugin();
+        const tresult result = plugin->queryInterface(_iid, obj);
+        plugin->release();
+
+        return result;
+    }
+};
+
+#pragma GCC diagnostic pop
+
+static StubVst3Factory stub_vst3_factory;
+
+extern "C" Steinberg::IPluginFactory* PLUGIN_API GetPluginFactory() {
+    return &stub_vst3_factory;
+}
+
+#else
+
+// The spec file always exports this function. Without VST3 support the library
+// only contains the VST2 plugin, and yabridge will report that the module does
+// not contain a plugin factory.
+extern "C" void* __stdcall GetPluginFactory() {
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,4 @@
+# The exported entry points for `yabridge-bench-stub.dll.so`. See
+# `stub-plugin.cpp` for more information.
+@ cdecl VSTPluginMain(ptr)
+@ stdcall GetPluginFactory()
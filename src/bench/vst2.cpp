@@ -0,0 +1,112 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "vst2.h"
+
+#include <stdexcept>
+
+/**
+ * `audioMasterGetCurrentProcessLevel()` return value for the realtime audio
+ * thread. This is not part of the VeSTige headers.
+ */
+constexpr intptr_t process_level_realtime = 2;
+
+// These are accessed from the host callback, which doesn't give us a way to
+// pass along any context
+static ProcessSettings settings{};
+thread_local VstTimeInfo time_info{};
+thread_local bool is_audio_thread = false;
+
+static intptr_t VST_CALL_CONV host_callback(AEffect* /*effect*/,
+                                            int opcode,
+                                            int /*index*/,
+                                            intptr_t /*value*/,
+                                            void* /*data*/,
+                                            float /*option*/) {
+    switch (opcode) {
+        case audioMasterVersion:
+            return 2400;
+            break;
+        case audioMasterGetTime:
+            time_info.sampleRate = settings.sample_rate;
+            time_info.tempo = 120.0;
+            time_info.timeSigNumerator = 4;
+            time_info.timeSigDenominator = 4;
+            time_info.flags = kVstTransportPlaying | kVstTempoValid |
+                              kVstPpqPosValid | kVstTimeSigValid;
+            time_info.ppqPos = (time_info.samplePos / settings.sample_rate) *
+                               (time_info.tempo / 60.0);
+
+            return reinterpret_cast<intptr_t>(&time_info);
+            break;
+        case audioMasterGetSampleRate:
+            return settings.sample_rate;
+            break;
+        case audioMasterGetBlockSize:
+            return settings.block_size;
+            break;
+        case audioMasterGetCurrentProcessLevel:
+            return is_audio_thread ? process_level_realtime : 0;
+            break;
+        default:
+            return 0;
+            break;
+    }
+}
+
+Vst2BenchPluginLibrary::Vst2BenchPluginLibrary(VstEntryPoint entry_point,
+                                               ProcessSettings settings)
+    : entry_point(entry_point) {
+    ::settings = settings;
+}
+
+std::unique_ptr<BenchPlugin> Vst2BenchPluginLibrary::create_instance() {
+    AEffect* plugin = entry_point(host_callback);
+    if (!plugin || plugin->magic != kEffectMagic) {
+        throw std::runtime_error("VSTPluginMain() did not return a plugin");
+    }
+
+    return std::make_unique<Vst2BenchPlugin>(*plugin);
+}
+
+Vst2BenchPlugin::Vst2BenchPlugin(AEffect& plugin) : plugin(plugin) {
+    plugin.dispatcher(&plugin, effOpen, 0, 0, nullptr, 0.0);
+    plugin.dispatcher(&plugin, effSetSampleRate, 0, 0, nullptr,
+                      static_cast<float>(settings.sample_rate));
+    plugin.dispatcher(&plugin, effSetBlockSize, 0, settings.block_size,
+                      nullptr, 0.0);
+    plugin.dispatcher(&plugin, effMainsChanged, 0, 1, nullptr, 0.0);
+}
+
+Vst2BenchPlugin::~Vst2BenchPlugin() noexcept {
+    plugin.dispatcher(&plugin, effMainsChanged, 0, 0, nullptr, 0.0);
+    plugin.dispatcher(&plugin, effClose, 0, 0, nullptr, 0.0);
+}
+
+int Vst2BenchPlugin::num_inputs() const noexcept {
+    return plugin.numInputs;
+}
+
+int Vst2BenchPlugin::num_outputs() const noexcept {
+    return plugin.numOutputs;
+}
+
+void Vst2BenchPlugin::process(float** inputs, float** outputs) {
+    is_audio_thread = true;
+    plugin.processReplacing(&plugin, inputs, outputs,
+                            static_cast<int>(settings.block_size));
+    time_info.samplePos += settings.block_size;
+}
@@ -0,0 +1,65 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <vestige/aeffectx.h>
+
+#include "bench-plugin.h"
+
+using VstEntryPoint = AEffect*(VST_CALL_CONV*)(audioMasterCallback);
+
+/**
+ * A VST2 plugin library, such as a copy of `libyabridge-vst2.so`.
+ */
+class Vst2BenchPluginLibrary : public BenchPluginLibrary {
+   public:
+    /**
+     * @param entry_point The library's `VSTPluginMain()` function.
+     * @param settings The settings to set up every plugin instance with.
+     */
+    Vst2BenchPluginLibrary(VstEntryPoint entry_point,
+                           ProcessSettings settings);
+
+    std::unique_ptr<BenchPlugin> create_instance() override;
+
+   private:
+    VstEntryPoint entry_point;
+};
+
+/**
+ * A resumed VST2 plugin instance.
+ */
+class Vst2BenchPlugin : public BenchPlugin {
+   public:
+    /**
+     * Set up and resume `plugin`.
+     */
+    explicit Vst2BenchPlugin(AEffect& plugin);
+
+    /**
+     * Suspend and close the plugin.
+     */
+    ~Vst2BenchPlugin() noexcept override;
+
+    int num_inputs() const noexcept override;
+    int num_outputs() const noexcept override;
+
+    void process(float** inputs, float** outputs) override;
+
+   private:
+    AEffect& plugin;
+};
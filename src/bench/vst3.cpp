@@ -0,0 +1,242 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "vst3.h"
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <pluginterfaces/vst/ivsthostapplication.h>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wnon-virtual-dtor"
+
+/**
+ * The host context passed to `IPluginBase::initialize()`. yabridge requires a
+ * host context, but the benchmark doesn't need to do anything with it. There's
+ * only a single instance of this object, so reference counting is a no-op.
+ */
+class BenchHostApplication : public Steinberg::Vst::IHostApplication {
+   public:
+    Steinberg::tresult PLUGIN_API queryInterface(const Steinberg::TUID _iid,
+                                                 void** obj) override {
+        QUERY_INTERFACE(_iid, obj, Steinberg::FUnknown::iid,
+                        Steinberg::Vst::IHostApplication)
+        QUERY_INTERFACE(_iid, obj, Steinberg::Vst::IHostApplication::iid,
+                        Steinberg::Vst::IHostApplication)
+
+        *obj = nullptr;
+        return Steinberg::kNoInterface;
+    }
+    Steinberg::uint32 PLUGIN_API addRef() override { return 1; }
+    Steinberg::uint32 PLUGIN_API release() override { return 1; }
+
+    Steinberg::tresult PLUGIN_API
+    getName(Steinberg::Vst::String128 name) override {
+        const std::u16string host_name = u"yabridge-bench";
+        std::copy(host_name.begin(), host_name.end(), name);
+        name[host_name.size()] = 0;
+
+        return Steinberg::kResultOk;
+    }
+    Steinberg::tresult PLUGIN_API createInstance(Steinberg::TUID /*cid*/,
+                                                 Steinberg::TUID /*_iid*/,
+                                                 void** obj) override {
+        *obj = nullptr;
+        return Steinberg::kResultFalse;
+    }
+};
+
+#pragma GCC diagnostic pop
+
+static BenchHostApplication host_application;
+
+Vst3BenchPluginLibrary::Vst3BenchPluginLibrary(void* library,
+                                               ProcessSettings settings)
+    : settings(settings) {
+    using ModuleEntryFunc = bool (*)(void*);
+    using GetFactoryProc = Steinberg::IPluginFactory*(PLUGIN_API*)();
+
+    // Linux VST3 modules need to be initialized before the plugin factory can
+    // be requested
+    auto module_entry =
+        reinterpret_cast<ModuleEntryFunc>(dlsym(library, "ModuleEntry"));
+    if (module_entry && !module_entry(library)) {
+        throw std::runtime_error("ModuleEntry() failed");
+    }
+    module_exit =
+        reinterpret_cast<ModuleExitFunc>(dlsym(library, "ModuleExit"));
+
+    auto get_plugin_factory =
+        reinterpret_cast<GetFactoryProc>(dlsym(library, "GetPluginFactory"));
+    if (get_plugin_factory) {
+        factory = Steinberg::owned(get_plugin_factory());
+    }
+    if (!factory) {
+        throw std::runtime_error(
+            "GetPluginFactory() did not return a plugin factory");
+    }
+
+    for (Steinberg::int32 i = 0; i < factory->countClasses(); i++) {
+        Steinberg::PClassInfo info;
+        if (factory->getClassInfo(i, &info) == Steinberg::kResultOk &&
+            strcmp(info.category, kVstAudioEffectClass) == 0) {
+            std::memcpy(cid, info.cid, sizeof(cid));
+            return;
+        }
+    }
+
+    throw std::runtime_error("The module does not contain an audio effect");
+}
+
+Vst3BenchPluginLibrary::~Vst3BenchPluginLibrary() noexcept {
+    factory = nullptr;
+    if (module_exit) {
+        module_exit();
+    }
+}
+
+std::unique_ptr<BenchPlugin> Vst3BenchPluginLibrary::create_instance() {
+    Steinberg::Vst::IComponent* component = nullptr;
+    if (factory->createInstance(cid, Steinberg::Vst::IComponent::iid,
+                                reinterpret_cast<void**>(&component)) !=
+            Steinberg::kResultOk ||
+        !component) {
+        throw std::runtime_error("Could not create an IComponent instance");
+    }
+
+    return std::make_unique<Vst3BenchPlugin>(Steinberg::owned(component),
+                                             settings);
+}
+
+Vst3BenchPlugin::Vst3BenchPlugin(
+    Steinberg::IPtr<Steinberg::Vst::IComponent> component,
+    ProcessSettings settings)
+    : settings(settings), component(component) {
+    if (component->initialize(&host_application) != Steinberg::kResultOk) {
+        throw std::runtime_error("IPluginBase::initialize() failed");
+    }
+
+    processor = Steinberg::FUnknownPtr<Steinberg::Vst::IAudioProcessor>(
+        component);
+    if (!processor) {
+        component->terminate();
+        throw std::runtime_error(
+            "The plugin does not support IAudioProcessor");
+    }
+
+    // We'll just use the plugin's default speaker arrangements and activate
+    // all of its audio busses
+    auto setup_busses =
+        [&](Steinberg::Vst::BusDirection direction,
+            std::vector<Steinberg::Vst::AudioBusBuffers>& busses) {
+            const Steinberg::int32 num_busses =
+                component->getBusCount(Steinberg::Vst::kAudio, direction);
+            for (Steinberg::int32 i = 0; i < num_busses; i++) {
+                Steinberg::Vst::BusInfo info{};
+                component->getBusInfo(Steinberg::Vst::kAudio, direction, i,
+                                      info);
+                component->activateBus(Steinberg::Vst::kAudio, direction, i,
+                                       true);
+
+                Steinberg::Vst::AudioBusBuffers& bus = busses.emplace_back();
+                bus.numChannels = info.channelCount;
+            }
+        };
+    setup_busses(Steinberg::Vst::kInput, input_busses);
+    setup_busses(Steinberg::Vst::kOutput, output_busses);
+
+    Steinberg::Vst::ProcessSetup setup{
+        .processMode = Steinberg::Vst::kRealtime,
+        .symbolicSampleSize = Steinberg::Vst::kSample32,
+        .maxSamplesPerBlock =
+            static_cast<Steinberg::int32>(settings.block_size),
+        .sampleRate =
+            static_cast<Steinberg::Vst::SampleRate>(settings.sample_rate)};
+    if (processor->setupProcessing(setup) != Steinberg::kResultOk ||
+        component->setActive(true) != Steinberg::kResultOk) {
+        component->terminate();
+        throw std::runtime_error("Could not activate the plugin");
+    }
+    processor->setProcessing(true);
+
+    using Steinberg::Vst::ProcessContext;
+    process_context.state =
+        ProcessContext::kPlaying | ProcessContext::kTempoValid |
+        ProcessContext::kTimeSigValid | ProcessContext::kProjectTimeMusicValid;
+    process_context.sampleRate = settings.sample_rate;
+    process_context.tempo = 120.0;
+    process_context.timeSigNumerator = 4;
+    process_context.timeSigDenominator = 4;
+}
+
+Vst3BenchPlugin::~Vst3BenchPlugin() noexcept {
+    processor->setProcessing(false);
+    component->setActive(false);
+    component->terminate();
+}
+
+int Vst3BenchPlugin::num_inputs() const noexcept {
+    int num_channels = 0;
+    for (const auto& bus : input_busses) {
+        num_channels += bus.numChannels;
+    }
+
+    return num_channels;
+}
+
+int Vst3BenchPlugin::num_outputs() const noexcept {
+    int num_channels = 0;
+    for (const auto& bus : output_busses) {
+        num_channels += bus.numChannels;
+    }
+
+    return num_channels;
+}
+
+void Vst3BenchPlugin::process(float** inputs, float** outputs) {
+    for (auto& bus : input_busses) {
+        bus.channelBuffers32 = inputs;
+        bus.silenceFlags = 0;
+        inputs += bus.numChannels;
+    }
+    for (auto& bus : output_busses) {
+        bus.channelBuffers32 = outputs;
+        outputs += bus.numChannels;
+    }
+
+    process_context.projectTimeMusic =
+        (static_cast<double>(process_context.projectTimeSamples) /
+         settings.sample_rate) *
+        (process_context.tempo / 60.0);
+
+    Steinberg::Vst::ProcessData data{};
+    data.processMode = Steinberg::Vst::kRealtime;
+    data.symbolicSampleSize = Steinberg::Vst::kSample32;
+    data.numSamples = static_cast<Steinberg::int32>(settings.block_size);
+    data.numInputs = static_cast<Steinberg::int32>(input_busses.size());
+    data.numOutputs = static_cast<Steinberg::int32>(output_busses.size());
+    data.inputs = input_busses.data();
+    data.outputs = output_busses.data();
+    data.processContext = &process_context;
+
+    processor->process(data);
+    process_context.projectTimeSamples += settings.block_size;
+}
@@ -0,0 +1,99 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <vector>
+
+#include <pluginterfaces/base/ipluginbase.h>
+#include <pluginterfaces/base/smartpointer.h>
+#include <pluginterfaces/vst/ivstaudioprocessor.h>
+#include <pluginterfaces/vst/ivstcomponent.h>
+#include <pluginterfaces/vst/ivstprocesscontext.h>
+
+#include "bench-plugin.h"
+
+/**
+ * A VST3 module, such as the `.so` file inside of a VST3 bundle set up by
+ * yabridgectl. Instances are created from the first audio effect class in the
+ * module's plugin factory. Constructing this object calls the module's
+ * `ModuleEntry()` function, and the destructor calls `ModuleExit()` again.
+ */
+class Vst3BenchPluginLibrary : public BenchPluginLibrary {
+   public:
+    /**
+     * @param library The handle returned by `dlopen()` for the module.
+     * @param settings The settings to set up every plugin instance with.
+     *
+     * @throw std::runtime_error If the module could not be initialized or if
+     *   it does not contain an audio effect class.
+     */
+    Vst3BenchPluginLibrary(void* library, ProcessSettings settings);
+
+    ~Vst3BenchPluginLibrary() noexcept override;
+
+    std::unique_ptr<BenchPlugin> create_instance() override;
+
+   private:
+    using ModuleExitFunc = bool (*)();
+
+    ProcessSettings settings;
+    ModuleExitFunc module_exit = nullptr;
+
+    Steinberg::IPtr<Steinberg::IPluginFactory> factory;
+    Steinberg::TUID cid;
+};
+
+/**
+ * An initialized and activated VST3 plugin instance. All of the plugin's audio
+ * busses are activated, and the channels passed to `process()` are divided
+ * over those busses in order.
+ */
+class Vst3BenchPlugin : public BenchPlugin {
+   public:
+    /**
+     * Initialize and activate a plugin instance created by a plugin factory.
+     *
+     * @throw std::runtime_error If the plugin could not be set up.
+     */
+    Vst3BenchPlugin(Steinberg::IPtr<Steinberg::Vst::IComponent> component,
+                    ProcessSettings settings);
+
+    /**
+     * Deactivate and terminate the plugin.
+     */
+    ~Vst3BenchPlugin() noexcept override;
+
+    int num_inputs() const noexcept override;
+    int num_outputs() const noexcept override;
+
+    void process(float** inputs, float** outputs) override;
+
+   private:
+    ProcessSettings settings;
+
+    Steinberg::IPtr<Steinberg::Vst::IComponent> component;
+    Steinberg::IPtr<Steinberg::Vst::IAudioProcessor> processor;
+
+    /**
+     * The audio busses we pass to the plugin. Only the channel pointers change
+     * between processing cycles.
+     */
+    std::vector<Steinberg::Vst::AudioBusBuffers> input_busses;
+    std::vector<Steinberg::Vst::AudioBusBuffers> output_busses;
+
+    Steinberg::Vst::ProcessContext process_context{};
+};
@@ -0,0 +1,442 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include <algorithm>
+#include <barrier>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kernels.h"
+#include "vst2.h"
+#ifdef WITH_VST3
+#include "vst3.h"
+#endif
+
+/**
+ * The settings for a benchmark run, parsed from the command line.
+ */
+struct Options {
+    std::string plugin_path;
+    uint32_t block_size = 128;
+    uint32_t sample_rate = 48000;
+    uint32_t num_instances = 1;
+    uint32_t num_blocks = 10000;
+    uint32_t num_warmup_blocks = 500;
+    /**
+     * Pace processing cycles to the duration of a block like a real host
+     * would instead of processing blocks back to back.
+     */
+    bool realtime = false;
+    /**
+     * Run the processing threads with `SCHED_FIFO`, like a DAW's audio
+     * threads.
+     */
+    bool fifo = false;
+    /**
+     * Check and benchmark yabridge's audio kernels instead of loading a
+     * plugin.
+     */
+    bool kernels = false;
+};
+
+/**
+ * The measurements for a single plugin instance.
+ */
+struct InstanceResult {
+    int num_inputs = 0;
+    int num_outputs = 0;
+    /**
+     * The round trip time of every measured processing cycle.
+     */
+    std::vector<std::chrono::nanoseconds> block_times;
+    /**
+     * The CPU time spent by the processing thread on this side of the bridge.
+     * With `audio_spin_us` enabled this includes the time spent spinning.
+     */
+    std::chrono::nanoseconds cpu_time{0};
+    std::chrono::nanoseconds wall_time{0};
+};
+
+// The parsed command line options, used throughout the benchmark
+static Options options;
+
+/**
+ * Parse a non-negative integer, or print an error and exit.
+ */
+static uint32_t parse_uint(const char* option, const char* value) {
+    try {
+        const long result = std::stol(value);
+        if (result >= 0) {
+            return static_cast<uint32_t>(result);
+        }
+    } catch (const std::exception&) {
+    }
+
+    std::cerr << "Invalid value '" << value << "' for " << option << std::endl;
+    exit(1);
+}
+
+static void print_usage(const char* program_name) {
+    std::cerr
+        << "Usage: " << program_name << " [options] <plugin.so>\n"
+        << "       " << program_name << " [options] --kernels\n"
+        << "\n"
+        << "Measure the per-block round trip time through yabridge for the\n"
+        << "VST2 plugin or VST3 module set up at <plugin.so>. Use the\n"
+        << "yabridge-bench-stub plugin built alongside this tool (or another\n"
+        << "lightweight plugin) to measure the bridge's own overhead. With\n"
+        << "--kernels, check yabridge's audio kernels for every instruction\n"
+        << "set this CPU supports and measure them on "
+        << kernel_bench_channels << " channels instead.\n"
+        << "\n"
+        << "Options:\n"
+        << "  --block-size <n>   Samples per processing cycle (default: 128)\n"
+        << "  --sample-rate <n>  Sample rate in Hz (default: 48000)\n"
+        << "  --instances <n>    Plugin instances, each processed on its own\n"
+        << "                     thread (default: 1)\n"
+        << "  --blocks <n>       Measured blocks per instance (default: "
+           "10000)\n"
+        << "  --warmup <n>       Unmeasured blocks processed first (default: "
+           "500)\n"
+        << "  --realtime         Wait for the next block's deadline between\n"
+        << "                     processing cycles\n"
+        << "  --fifo             Use SCHED_FIFO for the processing threads\n"
+        << "  --kernels          Benchmark the audio kernels instead of a\n"
+        << "                     plugin\n";
+}
+
+static Options parse_options(int argc, char* argv[]) {
+    Options result;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg(argv[i]);
+        const bool has_value = i + 1 < argc;
+        if (arg == "--block-size" && has_value) {
+            result.block_size = parse_uint(argv[i], argv[i + 1]);
+            i++;
+        } else if (arg == "--sample-rate" && has_value) {
+            result.sample_rate = parse_uint(argv[i], argv[i + 1]);
+            i++;
+        } else if (arg == "--instances" && has_value) {
+            result.num_instances = parse_uint(argv[i], argv[i + 1]);
+            i++;
+        } else if (arg == "--blocks" && has_value) {
+            result.num_blocks = parse_uint(argv[i], argv[i + 1]);
+            i++;
+        } else if (arg == "--warmup" && has_value) {
+            result.num_warmup_blocks = parse_uint(argv[i], argv[i + 1]);
+            i++;
+        } else if (arg == "--realtime") {
+            result.realtime = true;
+        } else if (arg == "--fifo") {
+            result.fifo = true;
+        } else if (arg == "--kernels") {
+            result.kernels = true;
+        } else if (arg.starts_with("--") || !result.plugin_path.empty()) {
+            print_usage(argv[0]);
+            exit(1);
+        } else {
+            result.plugin_path = arg;
+        }
+    }
+
+    // Either a plugin or `--kernels` needs to be passed, but not both
+    const bool has_plugin = !result.plugin_path.empty();
+    if (has_plugin == result.kernels || result.block_size == 0 ||
+        result.sample_rate == 0 || result.num_instances == 0 ||
+        result.num_blocks == 0) {
+        print_usage(argv[0]);
+        exit(1);
+    }
+
+    return result;
+}
+
+static std::chrono::nanoseconds thread_cpu_time() {
+    timespec time{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+
+    return std::chrono::seconds(time.tv_sec) +
+           std::chrono::nanoseconds(time.tv_nsec);
+}
+
+/**
+ * Process `options.num_warmup_blocks + options.num_blocks` blocks of noise
+ * using `plugin` and measure how long every processing cycle takes.
+ * `start_barrier` is used to make sure all instances start processing at the
+ * same time.
+ */
+static void run_instance(BenchPlugin& plugin,
+                         std::barrier<>& start_barrier,
+                         InstanceResult& result) {
+    if (options.fifo) {
+        sched_param params{.sched_priority = 5};
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &params) != 0) {
+            std::cerr << "Could not enable SCHED_FIFO, continuing without it"
+                      << std::endl;
+        }
+    }
+
+    // The inputs contain some noise so plugins that detect silence don't get
+    // to take any shortcuts
+    std::mt19937 rng(plugin.num_inputs());
+    std::uniform_real_distribution<float> noise(-0.5f, 0.5f);
+    std::vector<std::vector<float>> inputs(plugin.num_inputs(),
+                                           std::vector<float>(
+                                               options.block_size));
+    std::vector<std::vector<float>> outputs(plugin.num_outputs(),
+                                            std::vector<float>(
+                                                options.block_size));
+    for (auto& channel : inputs) {
+        std::generate(channel.begin(), channel.end(),
+                      [&]() { return noise(rng); });
+    }
+
+    std::vector<float*> input_pointers;
+    std::vector<float*> output_pointers;
+    for (auto& channel : inputs) {
+        input_pointers.push_back(channel.data());
+    }
+    for (auto& channel : outputs) {
+        output_pointers.push_back(channel.data());
+    }
+
+    result.num_inputs = plugin.num_inputs();
+    result.num_outputs = plugin.num_outputs();
+    result.block_times.reserve(options.num_blocks);
+
+    const std::chrono::nanoseconds block_duration(
+        (static_cast<uint64_t>(options.block_size) * 1'000'000'000) /
+        options.sample_rate);
+    auto process_block = [&]() {
+        plugin.process(input_pointers.data(), output_pointers.data());
+    };
+
+    start_barrier.arrive_and_wait();
+
+    for (uint32_t i = 0; i < options.num_warmup_blocks; i++) {
+        process_block();
+    }
+
+    const auto wall_start = std::chrono::steady_clock::now();
+    const auto cpu_start = thread_cpu_time();
+    auto next_deadline = wall_start;
+    for (uint32_t i = 0; i < options.num_blocks; i++) {
+        const auto block_start = std::chrono::steady_clock::now();
+        process_block();
+        result.block_times.push_back(std::chrono::steady_clock::now() -
+                                     block_start);
+
+        if (options.realtime) {
+            next_deadline += block_duration;
+            std::this_thread::sleep_until(next_deadline);
+        }
+    }
+
+    result.cpu_time = thread_cpu_time() - cpu_start;
+    result.wall_time = std::chrono::steady_clock::now() - wall_start;
+}
+
+/**
+ * Return the `p`th percentile of the sorted `times`, in microseconds.
+ */
+static double percentile_us(const std::vector<std::chrono::nanoseconds>& times,
+                            double p) {
+    const size_t index = std::min(
+        times.size() - 1, static_cast<size_t>(p / 100.0 * times.size()));
+
+    return times[index].count() / 1000.0;
+}
+
+static void print_row(const std::string& name,
+                      std::vector<std::chrono::nanoseconds> times,
+                      std::optional<double> cpu_percentage,
+                      std::chrono::nanoseconds block_duration) {
+    std::sort(times.begin(), times.end());
+    const double mean_us =
+        std::accumulate(times.begin(), times.end(),
+                        std::chrono::nanoseconds(0))
+            .count() /
+        1000.0 / times.size();
+    const size_t missed_deadlines = static_cast<size_t>(
+        times.end() - std::upper_bound(times.begin(), times.end(),
+                                       block_duration));
+
+    std::cout << std::left << std::setw(12) << name << std::right
+              << std::setw(10) << mean_us << std::setw(10)
+              << percentile_us(times, 50) << std::setw(10)
+              << percentile_us(times, 90) << std::setw(10)
+              << percentile_us(times, 99) << std::setw(10)
+              << percentile_us(times, 99.9) << std::setw(10)
+              << times.back().count() / 1000.0 << std::setw(10)
+              << missed_deadlines;
+    if (cpu_percentage) {
+        std::cout << std::setw(9) << *cpu_percentage << "%";
+    }
+    std::cout << std::endl;
+}
+
+/**
+ * Load the VST2 plugin or VST3 module at `options.plugin_path`.
+ *
+ * @throw std::runtime_error If the library could not be loaded.
+ */
+static std::unique_ptr<BenchPluginLibrary> load_plugin_library() {
+    void* library = dlopen(options.plugin_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!library) {
+        throw std::runtime_error("Could not load '" + options.plugin_path +
+                                 "': " + dlerror());
+    }
+
+    const ProcessSettings settings{.block_size = options.block_size,
+                                   .sample_rate = options.sample_rate};
+    if (auto entry_point = reinterpret_cast<VstEntryPoint>(
+            dlsym(library, "VSTPluginMain"))) {
+        return std::make_unique<Vst2BenchPluginLibrary>(entry_point, settings);
+    }
+    if (dlsym(library, "GetPluginFactory")) {
+#ifdef WITH_VST3
+        return std::make_unique<Vst3BenchPluginLibrary>(library, settings);
+#else
+        throw std::runtime_error(
+            "'" + options.plugin_path +
+            "' is a VST3 module, but yabridge-bench was built without VST3 "
+            "support");
+#endif
+    }
+
+    throw std::runtime_error("'" + options.plugin_path +
+                             "' is not a VST2 plugin or a VST3 module");
+}
+
+/**
+ * A minimal VST2 and VST3 host that loads a plugin set up with yabridge and
+ * measures the round trip time of every processing cycle, along with the CPU
+ * usage of the processing threads and the overall throughput. This is meant to
+ * be used to compare changes to yabridge's audio processing path. Plugins and
+ * their configuration can be changed through the usual `yabridge.toml` files.
+ */
+int main(int argc, char* argv[]) {
+    options = parse_options(argc, argv);
+    if (options.kernels) {
+        return run_kernel_benchmark(options.block_size, options.num_blocks);
+    }
+
+    std::unique_ptr<BenchPluginLibrary> library;
+    try {
+        library = load_plugin_library();
+    } catch (const std::runtime_error& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+
+    // Plugins are initialized and resumed one by one, like a host would do
+    std::vector<std::unique_ptr<BenchPlugin>> plugins;
+    for (uint32_t i = 0; i < options.num_instances; i++) {
+        try {
+            plugins.push_back(library->create_instance());
+        } catch (const std::runtime_error& error) {
+            std::cerr << "Could not initialize plugin instance " << i + 1
+                      << ": " << error.what() << std::endl;
+            return 1;
+        }
+    }
+
+    std::cerr << "Processing " << options.num_blocks << " blocks of "
+              << options.block_size << " samples at " << options.sample_rate
+              << " Hz with " << options.num_instances << " instance(s)"
+              << (options.realtime ? ", paced in realtime" : "") << std::endl;
+
+    std::vector<InstanceResult> results(options.num_instances);
+    {
+        std::barrier start_barrier(options.num_instances);
+        std::vector<std::jthread> threads;
+        for (uint32_t i = 0; i < options.num_instances; i++) {
+            threads.emplace_back([&, i]() {
+                run_instance(*plugins[i], start_barrier, results[i]);
+            });
+        }
+    }
+
+    plugins.clear();
+
+    // Everything below is in microseconds, apart from the deadline misses and
+    // CPU usage. A deadline miss is a processing cycle that took longer than
+    // the block's duration, which would cause an xrun in a real host.
+    const std::chrono::nanoseconds block_duration(
+        (static_cast<uint64_t>(options.block_size) * 1'000'000'000) /
+        options.sample_rate);
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::left << std::setw(12) << "instance" << std::right
+              << std::setw(10) << "mean" << std::setw(10) << "p50"
+              << std::setw(10) << "p90" << std::setw(10) << "p99"
+              << std::setw(10) << "p99.9" << std::setw(10) << "max"
+              << std::setw(10) << "missed" << std::setw(10) << "cpu"
+              << std::endl;
+
+    std::vector<std::chrono::nanoseconds> all_block_times;
+    std::chrono::nanoseconds longest_wall_time(0);
+    for (size_t i = 0; i < results.size(); i++) {
+        const InstanceResult& result = results[i];
+        const double cpu_percentage = 100.0 *
+                                      static_cast<double>(
+                                          result.cpu_time.count()) /
+                                      result.wall_time.count();
+        print_row("#" + std::to_string(i + 1) + " (" +
+                      std::to_string(result.num_inputs) + "x" +
+                      std::to_string(result.num_outputs) + ")",
+                  result.block_times, cpu_percentage, block_duration);
+
+        all_block_times.insert(all_block_times.end(),
+                               result.block_times.begin(),
+                               result.block_times.end());
+        longest_wall_time = std::max(longest_wall_time, result.wall_time);
+    }
+    if (results.size() > 1) {
+        print_row("all", all_block_times, std::nullopt, block_duration);
+    }
+
+    // The throughput is expressed as how many times faster than realtime all
+    // instances combined managed to process audio
+    const double processed_seconds =
+        static_cast<double>(options.num_blocks) * options.block_size *
+        options.num_instances / options.sample_rate;
+    const double elapsed_seconds =
+        std::chrono::duration<double>(longest_wall_time).count();
+    std::cout << std::endl
+              << "block duration: " << block_duration.count() / 1000.0
+              << " us, throughput: " << std::setprecision(2)
+              << processed_seconds / elapsed_seconds << "x realtime"
+              << std::endl;
+
+    // Unloading the library while yabridge's threads may still be winding down
+    // is asking for trouble, and we're exiting anyways
+    return 0;
+}
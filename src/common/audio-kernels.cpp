@@ -0,0 +1,331 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "audio-kernels.h"
+
+#include <cstring>
+
+#include <immintrin.h>
+
+// The loops below all process as many samples as possible using full vectors,
+// and then handle the remaining samples one at a time. None of the buffers we
+// deal with are guaranteed to be aligned, so we always use unaligned loads and
+// stores. On any CPU from the last decade those are just as fast as the aligned
+// variants when the data happens to be aligned.
+
+template <typename T>
+static void add_scalar(const T* source,
+                       size_t num_samples,
+                       T* destination) noexcept {
+    for (size_t i = 0; i < num_samples; i++) {
+        destination[i] += source[i];
+    }
+}
+
+template <typename T>
+static bool is_silent_scalar(const T* samples, size_t num_samples) noexcept {
+    for (size_t i = 0; i < num_samples; i++) {
+        if (samples[i] != static_cast<T>(0.0)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static __attribute__((target("sse2"))) void add_float_sse2(
+    const float* source,
+    size_t num_samples,
+    float* destination) noexcept {
+    size_t i = 0;
+    for (; i + 4 <= num_samples; i += 4) {
+        _mm_storeu_ps(destination + i, _mm_add_ps(_mm_loadu_ps(destination + i),
+                                                  _mm_loadu_ps(source + i)));
+    }
+
+    add_scalar(source + i, num_samples - i, destination + i);
+}
+
+static __attribute__((target("sse2"))) void add_double_sse2(
+    const double* source,
+    size_t num_samples,
+    double* destination) noexcept {
+    size_t i = 0;
+    for (; i + 2 <= num_samples; i += 2) {
+        _mm_storeu_pd(destination + i, _mm_add_pd(_mm_loadu_pd(destination + i),
+                                                  _mm_loadu_pd(source + i)));
+    }
+
+    add_scalar(source + i, num_samples - i, destination + i);
+}
+
+// For the silence checks we use a not-equal comparison that also returns true
+// for unordered values, so NaN values will not count as silence
+
+static __attribute__((target("sse2"))) bool is_silent_float_sse2(
+    const float* samples,
+    size_t num_samples) noexcept {
+    const __m128 zero = _mm_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 4 <= num_samples; i += 4) {
+        if (_mm_movemask_ps(_mm_cmpneq_ps(_mm_loadu_ps(samples + i), zero))) {
+            return false;
+        }
+    }
+
+    return is_silent_scalar(samples + i, num_samples - i);
+}
+
+static __attribute__((target("sse2"))) bool is_silent_double_sse2(
+    const double* samples,
+    size_t num_samples) noexcept {
+    const __m128d zero = _mm_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 2 <= num_samples; i += 2) {
+        if (_mm_movemask_pd(_mm_cmpneq_pd(_mm_loadu_pd(samples + i), zero))) {
+            return false;
+        }
+    }
+
+    return is_silent_scalar(samples + i, num_samples - i);
+}
+
+static __attribute__((target("avx2"))) void add_float_avx2(
+    const float* source,
+    size_t num_samples,
+    float* destination) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8) {
+        _mm256_storeu_ps(destination + i,
+                         _mm256_add_ps(_mm256_loadu_ps(destination + i),
+                                       _mm256_loadu_ps(source + i)));
+    }
+
+    add_scalar(source + i, num_samples - i, destination + i);
+}
+
+static __attribute__((target("avx2"))) void add_double_avx2(
+    const double* source,
+    size_t num_samples,
+    double* destination) noexcept {
+    size_t i = 0;
+    for (; i + 4 <= num_samples; i += 4) {
+        _mm256_storeu_pd(destination + i,
+                         _mm256_add_pd(_mm256_loadu_pd(destination + i),
+                                       _mm256_loadu_pd(source + i)));
+    }
+
+    add_scalar(source + i, num_samples - i, destination + i);
+}
+
+static __attribute__((target("avx2"))) bool is_silent_float_avx2(
+    const float* samples,
+    size_t num_samples) noexcept {
+    const __m256 zero = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8) {
+        if (_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(samples + i), zero,
+                                             _CMP_NEQ_UQ))) {
+            return false;
+        }
+    }
+
+    return is_silent_scalar(samples + i, num_samples - i);
+}
+
+static __attribute__((target("avx2"))) bool is_silent_double_avx2(
+    const double* samples,
+    size_t num_samples) noexcept {
+    const __m256d zero = _mm256_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 4 <= num_samples; i += 4) {
+        if (_mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(samples + i), zero,
+                                             _CMP_NEQ_UQ))) {
+            return false;
+        }
+    }
+
+    return is_silent_scalar(samples + i, num_samples - i);
+}
+
+static __attribute__((target("avx512f"))) void add_float_avx512(
+    const float* source,
+    size_t num_samples,
+    float* destination) noexcept {
+    size_t i = 0;
+    for (; i + 16 <= num_samples; i += 16) {
+        _mm512_storeu_ps(destination + i,
+                         _mm512_add_ps(_mm512_loadu_ps(destination + i),
+                                       _mm512_loadu_ps(source + i)));
+    }
+
+    add_scalar(source + i, num_samples - i, destination + i);
+}
+
+static __attribute__((target("avx512f"))) void add_double_avx512(
+    const double* source,
+    size_t num_samples,
+    double* destination) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8) {
+        _mm512_storeu_pd(destination + i,
+                         _mm512_add_pd(_mm512_loadu_pd(destination + i),
+                                       _mm512_loadu_pd(source + i)));
+    }
+
+    add_scalar(source + i, num_samples - i, destination + i);
+}
+
+static __attribute__((target("avx512f"))) bool is_silent_float_avx512(
+    const float* samples,
+    size_t num_samples) noexcept {
+    const __m512 zero = _mm512_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 16 <= num_samples; i += 16) {
+        if (_mm512_cmp_ps_mask(_mm512_loadu_ps(samples + i), zero,
+                               _CMP_NEQ_UQ)) {
+            return false;
+        }
+    }
+
+    return is_silent_scalar(samples + i, num_samples - i);
+}
+
+static __attribute__((target("avx512f"))) bool is_silent_double_avx512(
+    const double* samples,
+    size_t num_samples) noexcept {
+    const __m512d zero = _mm512_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 8 <= num_samples; i += 8) {
+        if (_mm512_cmp_pd_mask(_mm512_loadu_pd(samples + i), zero,
+                               _CMP_NEQ_UQ)) {
+            return false;
+        }
+    }
+
+    return is_silent_scalar(samples + i, num_samples - i);
+}
+
+static constexpr AudioKernels avx512_kernels{
+    .name = "avx512f",
+    .add_float = add_float_avx512,
+    .add_double = add_double_avx512,
+    .is_silent_float = is_silent_float_avx512,
+    .is_silent_double = is_silent_double_avx512};
+static constexpr AudioKernels avx2_kernels{
+    .name = "avx2",
+    .add_float = add_float_avx2,
+    .add_double = add_double_avx2,
+    .is_silent_float = is_silent_float_avx2,
+    .is_silent_double = is_silent_double_avx2};
+static constexpr AudioKernels sse2_kernels{
+    .name = "sse2",
+    .add_float = add_float_sse2,
+    .add_double = add_double_sse2,
+    .is_silent_float = is_silent_float_sse2,
+    .is_silent_double = is_silent_double_sse2};
+static constexpr AudioKernels scalar_kernels{
+    .name = "scalar",
+    .add_float = add_scalar<float>,
+    .add_double = add_scalar<double>,
+    .is_silent_float = is_silent_scalar<float>,
+    .is_silent_double = is_silent_scalar<double>};
+
+/**
+ * Pick the widest implementations supported by the current CPU. The 32-bit
+ * bitbridge may in theory run on CPUs without SSE2, so we also have a scalar
+ * fallback.
+ */
+static AudioKernels select_kernels() noexcept {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return avx512_kernels;
+    } else if (__builtin_cpu_supports("avx2")) {
+        return avx2_kernels;
+    } else if (__builtin_cpu_supports("sse2")) {
+        return sse2_kernels;
+    } else {
+        return scalar_kernels;
+    }
+}
+
+/**
+ * The kernels are selected the first time any of them gets used. Since this
+ * happens on the audio thread, the initial call will do a couple of `cpuid`
+ * instructions. After that this only costs an already initialized static
+ * check.
+ */
+static const AudioKernels& kernels() noexcept {
+    static const AudioKernels selected_kernels = select_kernels();
+
+    return selected_kernels;
+}
+
+void copy_samples(const float* source,
+                  size_t num_samples,
+                  float* destination) noexcept {
+    std::memcpy(destination, source, num_samples * sizeof(float));
+}
+
+void copy_samples(const double* source,
+                  size_t num_samples,
+                  double* destination) noexcept {
+    std::memcpy(destination, source, num_samples * sizeof(double));
+}
+
+void add_samples(const float* source,
+                 size_t num_samples,
+                 float* destination) noexcept {
+    kernels().add_float(source, num_samples, destination);
+}
+
+void add_samples(const double* source,
+                 size_t num_samples,
+                 double* destination) noexcept {
+    kernels().add_double(source, num_samples, destination);
+}
+
+bool is_silent(const float* samples, size_t num_samples) noexcept {
+    return kernels().is_silent_float(samples, num_samples);
+}
+
+bool is_silent(const double* samples, size_t num_samples) noexcept {
+    return kernels().is_silent_double(samples, num_samples);
+}
+
+std::vector<AudioKernels> supported_audio_kernels() {
+    __builtin_cpu_init();
+
+    std::vector<AudioKernels> result;
+    if (__builtin_cpu_supports("avx512f")) {
+        result.push_back(avx512_kernels);
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        result.push_back(avx2_kernels);
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        result.push_back(sse2_kernels);
+    }
+    result.push_back(scalar_kernels);
+
+    return result;
+}
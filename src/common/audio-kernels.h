@@ -0,0 +1,84 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// These are the small kernels we use to move audio between the host's buffers
+// and our shared memory audio buffers. Yabridge is built for generic x86 and
+// x86_64 targets, so the compiler can only use SSE2 for the scalar loops. The
+// functions below pick an AVX-512, AVX2 or SSE2 implementation at runtime
+// based on what the CPU supports instead. With wide busses (e.g. 64 channel
+// surround busses) at small buffer sizes these loops run for every channel
+// during every processing cycle, so this adds up.
+
+/**
+ * Copy `num_samples` samples from `source` to `destination`. This has the same
+ * semantics as `std::copy_n()`, except that the two ranges may not overlap.
+ * The C library's `memcpy()` already dispatches to the widest vector
+ * instructions available, so this simply uses that instead of rolling our own.
+ */
+void copy_samples(const float* source,
+                  size_t num_samples,
+                  float* destination) noexcept;
+void copy_samples(const double* source,
+                  size_t num_samples,
+                  double* destination) noexcept;
+
+/**
+ * Add `num_samples` samples from `source` to the samples in `destination`.
+ * This is used for the accumulating VST2 `process()` function.
+ */
+void add_samples(const float* source,
+                 size_t num_samples,
+                 float* destination) noexcept;
+void add_samples(const double* source,
+                 size_t num_samples,
+                 double* destination) noexcept;
+
+/**
+ * Check whether all of the `num_samples` samples in `samples` are zero. A
+ * buffer containing NaN values is not silent. This returns as soon as it finds
+ * a nonzero sample, so checking non-silent buffers is usually very cheap.
+ */
+bool is_silent(const float* samples, size_t num_samples) noexcept;
+bool is_silent(const double* samples, size_t num_samples) noexcept;
+
+/**
+ * One set of implementations for `add_samples()` and `is_silent()`. The
+ * functions above dispatch to the widest set supported by the CPU. These are
+ * only exposed so `yabridge-bench --kernels` can check every implementation
+ * against the scalar versions and compare their performance.
+ */
+struct AudioKernels {
+    /**
+     * The instruction set this implementation uses, e.g. `avx2`.
+     */
+    const char* name;
+
+    void (*add_float)(const float*, size_t, float*) noexcept;
+    void (*add_double)(const double*, size_t, double*) noexcept;
+    bool (*is_silent_float)(const float*, size_t) noexcept;
+    bool (*is_silent_double)(const double*, size_t) noexcept;
+};
+
+/**
+ * Return every implementation the current CPU supports, from widest to
+ * narrowest. The last element is always the scalar fallback.
+ */
+std::vector<AudioKernels> supported_audio_kernels();
@@ -16,9 +16,61 @@
 
 #include "audio-shm.h"
 
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <xmmintrin.h>
+#include <cerrno>
+#include <concepts>
+#include <ctime>
 #include <iostream>
 
 #include "logging/common.h"
+#include "utils.h"
+
+/**
+ * How long the native plugin side should wait for a response before checking
+ * whether the Wine plugin host is still alive. Under normal circumstances we'll
+ * be woken up long before this.
+ */
+constexpr time_t response_liveness_check_interval_sec = 1;
+
+/**
+ * Wait on a futex word in shared memory as long as it contains `expected`. We
+ * can't use the `_PRIVATE` variants since the other side lives in a different
+ * process.
+ *
+ * @return `false` if the wait timed out.
+ */
+static bool futex_wait(uint32_t& word,
+                       uint32_t expected,
+                       const timespec* timeout = nullptr) noexcept {
+    const long result = syscall(SYS_futex, &word, FUTEX_WAIT, expected,
+                                timeout, nullptr, 0);
+
+    return !(result == -1 && errno == ETIMEDOUT);
+}
+
+static void futex_wake(uint32_t& word) noexcept {
+    syscall(SYS_futex, &word, FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+}
+
+/**
+ * Busy wait until `condition` returns `true` or until `duration` has passed,
+ * whichever comes first. This does nothing when `duration` is zero.
+ */
+template <std::predicate F>
+static void spin_until(std::chrono::microseconds duration,
+                       F&& condition) noexcept {
+    if (duration.count() <= 0) {
+        return;
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + duration;
+    while (!condition() && std::chrono::steady_clock::now() < deadline) {
+        _mm_pause();
+    }
+}
 
 AudioShmBuffer::AudioShmBuffer(const Config& config)
     : config(config),
@@ -26,6 +78,10 @@ AudioShmBuffer::AudioShmBuffer(const Config& config)
           config.name.c_str(),
           boost::interprocess::read_write) {
     setup_mapping();
+
+#ifdef __WINE__
+    std::atomic_ref(control().host_pid).store(getpid());
+#endif
 }
 
 AudioShmBuffer::~AudioShmBuffer() noexcept {
@@ -33,6 +89,7 @@ AudioShmBuffer::~AudioShmBuffer() noexcept {
     // removed, so we'll do it on both sides to reduce the chance that we leak
     // shared memory
     if (!is_moved) {
+        shutdown();
         boost::interprocess::shared_memory_object::remove(config.name.c_str());
     }
 }
@@ -40,6 +97,7 @@ AudioShmBuffer::~AudioShmBuffer() noexcept {
 AudioShmBuffer::AudioShmBuffer(AudioShmBuffer&& o) noexcept
     : config(std::move(o.config)),
       shm(std::move(o.shm)),
+      control_region(std::move(o.control_region)),
       buffer(std::move(o.buffer)) {
     o.is_moved = true;
 }
@@ -47,6 +105,7 @@ AudioShmBuffer::AudioShmBuffer(AudioShmBuffer&& o) noexcept
 AudioShmBuffer& AudioShmBuffer::operator=(AudioShmBuffer&& o) noexcept {
     config = std::move(o.config);
     shm = std::move(o.shm);
+    control_region = std::move(o.control_region);
     buffer = std::move(o.buffer);
     o.is_moved = true;
 
@@ -64,15 +123,160 @@ void AudioShmBuffer::resize(const Config& new_config) {
     setup_mapping();
 }
 
+uint32_t AudioShmBuffer::message_size() noexcept {
+    return std::atomic_ref(control().message_size)
+        .load(std::memory_order_relaxed);
+}
+
+bool AudioShmBuffer::send_request_and_wait(
+    uint32_t size,
+    std::chrono::microseconds spin_duration) noexcept {
+    send_request(size);
+
+    return wait_for_response(spin_duration);
+}
+
+void AudioShmBuffer::send_request(uint32_t size) noexcept {
+    Control& control = this->control();
+
+    std::atomic_ref(control.message_size)
+        .store(size, std::memory_order_relaxed);
+    std::atomic_ref(control.request_futex).fetch_add(1);
+    if (std::atomic_ref(control.request_waiting).load()) {
+        futex_wake(control.request_futex);
+    }
+}
+
+bool AudioShmBuffer::wait_for_response(
+    std::chrono::microseconds spin_duration) noexcept {
+    Control& control = this->control();
+    std::atomic_ref response_futex(control.response_futex);
+    std::atomic_ref response_waiting(control.response_waiting);
+    std::atomic_ref shutdown(control.shutdown);
+
+    // Only this side modifies the request futex (apart from `shutdown()`), so
+    // this is the ID of the request we sent last
+    const uint32_t request_id = std::atomic_ref(control.request_futex)
+                                    .load(std::memory_order_relaxed);
+
+    // If the Wine side finishes processing within the spin duration, then we
+    // won't have to go through the scheduler at all
+    spin_until(spin_duration, [&]() {
+        return response_futex.load(std::memory_order_acquire) == request_id ||
+               shutdown.load(std::memory_order_relaxed);
+    });
+
+    const timespec timeout{.tv_sec = response_liveness_check_interval_sec,
+                           .tv_nsec = 0};
+    uint32_t current_response_id;
+    while ((current_response_id = response_futex.load(
+                std::memory_order_acquire)) != request_id) {
+        if (shutdown.load(std::memory_order_relaxed)) [[unlikely]] {
+            return false;
+        }
+
+        // The Wine side will only make the wake system call when we're
+        // actually sleeping. The kernel checks whether the futex word still
+        // contains `current_response_id` before going to sleep, so we can't
+        // miss a response this way.
+        // NOTE: If the Wine plugin host crashed, then nobody will ever wake us
+        //       up again. With sockets we would get an error in that case.
+        response_waiting.store(1);
+        const bool timed_out = !futex_wait(control.response_futex,
+                                           current_response_id, &timeout);
+        response_waiting.store(0, std::memory_order_relaxed);
+
+        if (timed_out) [[unlikely]] {
+            const pid_t host_pid = std::atomic_ref(control.host_pid)
+                                       .load(std::memory_order_relaxed);
+            if (host_pid != 0 && !pid_running(host_pid)) {
+                return false;
+            }
+        }
+    }
+
+    // `shutdown()` also bumps the response futex, so we need to check this
+    // again to make sure we actually received a response
+    return !shutdown.load(std::memory_order_relaxed);
+}
+
+bool AudioShmBuffer::wait_for_request(
+    std::chrono::microseconds spin_duration) noexcept {
+    Control& control = this->control();
+    std::atomic_ref request_futex(control.request_futex);
+    std::atomic_ref response_futex(control.response_futex);
+    std::atomic_ref request_waiting(control.request_waiting);
+    std::atomic_ref shutdown(control.shutdown);
+
+    // The last request we handled is the one we sent a response for, so there's
+    // a pending request whenever these two values differ
+    spin_until(spin_duration, [&]() {
+        return request_futex.load(std::memory_order_acquire) !=
+                   response_futex.load(std::memory_order_relaxed) ||
+               shutdown.load(std::memory_order_relaxed);
+    });
+
+    uint32_t current_request_id;
+    while ((current_request_id = request_futex.load(
+                std::memory_order_acquire)) ==
+           response_futex.load(std::memory_order_relaxed)) {
+        if (shutdown.load(std::memory_order_relaxed)) [[unlikely]] {
+            return false;
+        }
+
+        // See the comment in `wait_for_response()`
+        request_waiting.store(1);
+        futex_wait(control.request_futex, current_request_id);
+        request_waiting.store(0, std::memory_order_relaxed);
+    }
+
+    return !shutdown.load(std::memory_order_relaxed);
+}
+
+void AudioShmBuffer::send_response(uint32_t size) noexcept {
+    Control& control = this->control();
+
+    std::atomic_ref(control.message_size)
+        .store(size, std::memory_order_relaxed);
+    std::atomic_ref(control.response_futex)
+        .store(std::atomic_ref(control.request_futex)
+                   .load(std::memory_order_relaxed));
+    if (std::atomic_ref(control.response_waiting).load()) {
+        futex_wake(control.response_futex);
+    }
+}
+
+void AudioShmBuffer::shutdown() noexcept {
+    if (!control_region.get_address()) {
+        return;
+    }
+
+    // We'll also bump both futex words so a waiter that's just about to go to
+    // sleep won't miss this wakeup
+    Control& control = this->control();
+    std::atomic_ref(control.shutdown).store(1, std::memory_order_relaxed);
+    std::atomic_ref(control.request_futex)
+        .fetch_add(1, std::memory_order_release);
+    std::atomic_ref(control.response_futex)
+        .fetch_add(1, std::memory_order_release);
+    futex_wake(control.request_futex);
+    futex_wake(control.response_futex);
+}
+
 void AudioShmBuffer::setup_mapping() {
     try {
-        // Apparently you get a `Resource temporarily unavailable` when calling
-        // `ftruncate()` with a size of 0 on shared memory
+        // The control region always has the same size, so it only needs to be
+        // mapped once. The audio buffers start right after it.
+        shm.truncate(control_region_size + config.size);
+        if (!control_region.get_address()) {
+            control_region = boost::interprocess::mapped_region(
+                shm, boost::interprocess::read_write, 0, control_region_size);
+        }
+
         if (config.size > 0) {
-            shm.truncate(config.size);
             buffer = boost::interprocess::mapped_region(
-                shm, boost::interprocess::read_write, 0, config.size, nullptr,
-                MAP_LOCKED);
+                shm, boost::interprocess::read_write, control_region_size,
+                config.size, nullptr, MAP_LOCKED);
         }
     } catch (const boost::interprocess::interprocess_exception& error) {
         if (error.get_native_error() == EAGAIN) {
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <vector>
 
 #ifdef __WINE__
@@ -47,6 +49,16 @@
  * for audio processing. The configuration (e.g. name, and dimensions) for this
  * shared memory object are then sent back to the plugin so the plugin can map
  * the same shared memory region.
+ *
+ * Aside from the audio buffers, the shared memory object also starts with a
+ * small control region. This contains a couple of futex words and a message
+ * area, and it lets us pass the actual process request and the completion
+ * signal between the two processes without having to go through a socket at
+ * all. A socket round trip costs two system calls and two wakeups per
+ * processing cycle on both sides, which adds up quickly with small buffer
+ * sizes and many plugin instances. Sockets are still used for everything that's
+ * not part of the realtime audio processing path, and they also act as a
+ * fallback when a request doesn't fit in the message area.
  */
 class AudioShmBuffer {
    public:
@@ -70,10 +82,11 @@ class AudioShmBuffer {
         std::string name;
 
         /**
-         * The size of the shared memory object **in bytes** (so not samples).
-         * This should be large enough to hold all input and output buffers, and
-         * it depends on whether the host is going to pass 32-bit single
-         * precision or 64-bit double precision audio to the plugin.
+         * The size of the audio buffers **in bytes** (so not samples). This
+         * should be large enough to hold all input and output buffers, and it
+         * depends on whether the host is going to pass 32-bit single precision
+         * or 64-bit double precision audio to the plugin. The control region
+         * described in `AudioShmBuffer`'s docstring comes on top of this.
          */
         uint32_t size;
 
@@ -178,15 +191,171 @@ class AudioShmBuffer {
                config.output_offsets[bus][channel];
     }
 
+    /**
+     * The message area in the control region. Process requests and their
+     * responses are serialized here. Since the plugin side only writes a
+     * request while the Wine side is waiting, and the Wine side only writes a
+     * response while the plugin side is waiting, the same area is used for
+     * both.
+     */
+    inline uint8_t* message_data() noexcept {
+        return reinterpret_cast<uint8_t*>(control_region.get_address()) +
+               sizeof(Control);
+    }
+
+    /**
+     * The number of bytes that fit in the message area.
+     */
+    static constexpr size_t message_capacity() noexcept {
+        return control_region_size - sizeof(Control);
+    }
+
+    /**
+     * The size of the message currently stored in the message area, in bytes.
+     */
+    uint32_t message_size() noexcept;
+
+    /**
+     * Signal the Wine side that a new request of `size` bytes has been written
+     * to the message area, and then block until the Wine side has written a
+     * response. This is used on the native plugin side.
+     *
+     * @param size The size of the request in the message area.
+     * @param spin_duration If nonzero, busy wait for up to this long before
+     *   going to sleep. See the `audio_spin_us` option.
+     *
+     * @return `false` if the other side has shut down or died while we were
+     *   waiting, in which case there is no response to read.
+     */
+    bool send_request_and_wait(
+        uint32_t size,
+        std::chrono::microseconds spin_duration =
+            std::chrono::microseconds::zero()) noexcept;
+
+    /**
+     * Signal the Wine side that a new request of `size` bytes has been written
+     * to the message area without waiting for the response. The caller must
+     * call `wait_for_response()` before touching the message area or the audio
+     * buffers again. This is used for pipelined processing, where the native
+     * plugin returns to the host while the Wine plugin host is still
+     * processing.
+     */
+    void send_request(uint32_t size) noexcept;
+
+    /**
+     * Block until the Wine side has written a response to the last request
+     * sent using `send_request()`. This is used on the native plugin side.
+     *
+     * @param spin_duration If nonzero, busy wait for up to this long before
+     *   going to sleep. See the `audio_spin_us` option.
+     *
+     * @return `false` if the other side has shut down or died while we were
+     *   waiting, in which case there is no response to read.
+     */
+    bool wait_for_response(std::chrono::microseconds spin_duration =
+                               std::chrono::microseconds::zero()) noexcept;
+
+    /**
+     * Block until the plugin side has written a new request to the message
+     * area. This is used on the Wine plugin host side.
+     *
+     * @param spin_duration If nonzero, busy wait for up to this long before
+     *   going to sleep. See the `audio_spin_us` option.
+     *
+     * @return `false` if `shutdown()` has been called on either side, in which
+     *   case the caller should stop listening for requests.
+     */
+    bool wait_for_request(std::chrono::microseconds spin_duration =
+                              std::chrono::microseconds::zero()) noexcept;
+
+    /**
+     * Signal the native plugin side that a response of `size` bytes has been
+     * written to the message area in response to the last request. This is
+     * used on the Wine plugin host side.
+     */
+    void send_response(uint32_t size) noexcept;
+
+    /**
+     * Wake up anything waiting on this buffer and make all further waits return
+     * `false`. This is called from the destructor, and the Wine side should
+     * call this before joining the thread that's waiting on requests.
+     */
+    void shutdown() noexcept;
+
     Config config;
 
    private:
+    /**
+     * The data at the start of the control region. All fields are 32-bit
+     * integers so the layout is the same for the 64-bit plugin and a 32-bit
+     * Wine plugin host. The futex words are placed on their own cache lines to
+     * avoid false sharing between the two processes.
+     */
+    struct Control {
+        /**
+         * Incremented by the plugin side every time a new request has been
+         * written to the message area.
+         */
+        alignas(64) uint32_t request_futex;
+        /**
+         * Set to 1 while the Wine side is sleeping on `request_futex`. The
+         * plugin side only needs to wake up the Wine side when this is set, so
+         * we can skip that system call when the other side is spinning.
+         */
+        uint32_t request_waiting;
+        /**
+         * Set to the value of `request_futex` by the Wine side after the
+         * response for that request has been written to the message area.
+         */
+        alignas(64) uint32_t response_futex;
+        /**
+         * The same as `request_waiting`, but for the plugin side sleeping on
+         * `response_futex`.
+         */
+        uint32_t response_waiting;
+        /**
+         * Set to 1 once either side has called `shutdown()`.
+         */
+        alignas(64) uint32_t shutdown;
+        /**
+         * The size of the message currently stored in the message area.
+         */
+        uint32_t message_size;
+        /**
+         * The process ID of the Wine plugin host, so the plugin side can tell
+         * whether the other side is still alive when it has been waiting for a
+         * response for an unreasonably long time.
+         */
+        int32_t host_pid;
+    };
+
+    /**
+     * The size of the control region at the start of the shared memory object
+     * in bytes. This is mapped separately from the audio buffers and it is not
+     * locked into memory, so the (mostly unused) message area only takes up
+     * physical memory for the parts that have actually been written to.
+     */
+    static constexpr size_t control_region_size = 1 << 20;
+
+    inline Control& control() noexcept {
+        return *reinterpret_cast<Control*>(control_region.get_address());
+    }
+
     /**
      * Resize the shared memory object, and set up the memory mapping.
      */
     void setup_mapping();
 
     boost::interprocess::shared_memory_object shm;
+    /**
+     * The control region described above. This mapping stays the same during
+     * `resize()`, so the futex words won't move while the other side is
+     * waiting on them.
+     */
+    boost::interprocess::mapped_region control_region;
+    /**
+     * The audio buffers, starting after the control region.
+     */
     boost::interprocess::mapped_region buffer;
 
     bool is_moved = false;
@@ -0,0 +1,112 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <unistd.h>
+
+#include <bitsery/details/serialization_common.h>
+#include <bitsery/traits/core/traits.h>
+
+#include "../../bulk-transfer.h"
+
+namespace bitsery {
+namespace ext {
+
+/**
+ * An adapter for serializing potentially very large byte buffers, like VST2
+ * chunk data and VST3 plugin state. Buffers up to `bulk_transfer_threshold`
+ * bytes are serialized inline like a regular container. Anything larger is
+ * copied to an anonymous memfd using `create_bulk_transfer()`, and only the
+ * buffer's size is serialized. The memfd's file descriptor is added to the
+ * thread's active `BulkTransferFds` object so `write_object()` can send it
+ * along with the message. Buffers are always serialized inline when there is
+ * no active `BulkTransferFds` object, since the file descriptor would otherwise
+ * have no way to reach the other side.
+ */
+class BulkBuffer {
+   public:
+    /**
+     * @param max_inline_size The maximum size for buffers that get serialized
+     *   inline. This is only used as a sanity check.
+     */
+    explicit BulkBuffer(size_t max_inline_size)
+        : max_inline_size(max_inline_size) {}
+
+    template <typename Ser, typename Fnc>
+    void serialize(Ser& ser, const std::vector<uint8_t>& buffer, Fnc&&) const {
+        BulkTransferFds* bulk_transfers = BulkTransferFds::active();
+        const bool use_memfd =
+            bulk_transfers && buffer.size() > bulk_transfer_threshold &&
+            bulk_transfers->size() < max_bulk_transfers_per_message;
+        ser.value1b(use_memfd);
+        if (use_memfd) {
+            bulk_transfers->push(create_bulk_transfer(buffer));
+            ser.value8b(static_cast<uint64_t>(buffer.size()));
+        } else {
+            ser.container1b(buffer, max_inline_size);
+        }
+    }
+
+    template <typename Des, typename Fnc>
+    void deserialize(Des& des, std::vector<uint8_t>& buffer, Fnc&&) const {
+        bool use_memfd;
+        des.value1b(use_memfd);
+        if (use_memfd) {
+            uint64_t size;
+            des.value8b(size);
+
+            BulkTransferFds* bulk_transfers = BulkTransferFds::active();
+            if (!bulk_transfers) {
+                throw std::runtime_error(
+                    "Received a bulk transfer outside of 'read_object()'");
+            }
+
+            const int fd = bulk_transfers->pop();
+            try {
+                read_bulk_transfer(fd, size, buffer);
+            } catch (...) {
+                close(fd);
+                throw;
+            }
+            close(fd);
+        } else {
+            des.container1b(buffer, max_inline_size);
+        }
+    }
+
+   private:
+    size_t max_inline_size;
+};
+
+}  // namespace ext
+
+namespace traits {
+
+template <>
+struct ExtensionTraits<ext::BulkBuffer, std::vector<uint8_t>> {
+    using TValue = void;
+    static constexpr bool SupportValueOverload = false;
+    static constexpr bool SupportObjectOverload = true;
+    static constexpr bool SupportLambdaOverload = false;
+};
+
+}  // namespace traits
+}  // namespace bitsery
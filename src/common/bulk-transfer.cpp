@@ -0,0 +1,262 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "bulk-transfer.h"
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#ifdef __WINE__
+#include "../wine-host/boost-fix.h"
+#endif
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <boost/asio/error.hpp>
+#include <boost/system/system_error.hpp>
+
+/**
+ * The `BulkTransferFds` object that's currently active on this thread.
+ */
+static thread_local BulkTransferFds* active_bulk_transfer_fds = nullptr;
+
+/**
+ * A buffer large enough to hold a control message containing the maximum
+ * number of file descriptors we'll send along with a single message.
+ */
+using FdControlBuffer =
+    std::array<char, CMSG_SPACE(sizeof(int) * max_bulk_transfers_per_message)>;
+
+/**
+ * Wait until a socket in non-blocking mode becomes readable or writable again
+ * after a call returned `EAGAIN`.
+ */
+static void wait_for_socket(int socket_fd, short events) {
+    pollfd poll_fd{.fd = socket_fd, .events = events, .revents = 0};
+    while (poll(&poll_fd, 1, -1) == -1 && errno == EINTR) {
+    }
+}
+
+BulkTransferFds::BulkTransferFds() noexcept
+    : previous(active_bulk_transfer_fds) {
+    active_bulk_transfer_fds = this;
+}
+
+BulkTransferFds::~BulkTransferFds() noexcept {
+    for (const int fd : fds()) {
+        close(fd);
+    }
+
+    active_bulk_transfer_fds = previous;
+}
+
+BulkTransferFds* BulkTransferFds::active() noexcept {
+    return active_bulk_transfer_fds;
+}
+
+void BulkTransferFds::push(int fd) {
+    try {
+        fds_.push_back(fd);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+}
+
+int BulkTransferFds::pop() {
+    if (empty()) {
+        throw std::runtime_error(
+            "Expected a file descriptor for a bulk transfer, but none were "
+            "sent along with the message");
+    }
+
+    return fds_[next_fd++];
+}
+
+std::span<const int> BulkTransferFds::fds() const noexcept {
+    return std::span(fds_).subspan(next_fd);
+}
+
+int create_bulk_transfer(const std::vector<uint8_t>& data) {
+    const int fd = memfd_create("yabridge-bulk", MFD_CLOEXEC);
+    if (fd == -1) {
+        throw std::system_error(errno, std::system_category(),
+                                "Could not create a memfd for a bulk transfer");
+    }
+
+    // Writing the data directly is cheaper than mapping the file first, and it
+    // avoids having to zero the pages only to overwrite them right after
+    size_t bytes_written = 0;
+    while (bytes_written < data.size()) {
+        const ssize_t result = write(fd, data.data() + bytes_written,
+                                     data.size() - bytes_written);
+        if (result == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            const int error = errno;
+            close(fd);
+            throw std::system_error(error, std::system_category(),
+                                    "Could not write a bulk transfer");
+        }
+
+        bytes_written += static_cast<size_t>(result);
+    }
+
+    return fd;
+}
+
+void read_bulk_transfer(int fd, uint64_t size, std::vector<uint8_t>& data) {
+    if (size == 0) {
+        data.clear();
+        return;
+    }
+
+    // Mapping more than the file contains would succeed, but reading past the
+    // end of the file would then kill the process with a `SIGBUS`
+    struct stat file_info {};
+    if (fstat(fd, &file_info) == -1) {
+        throw std::system_error(errno, std::system_category(),
+                                "Could not stat a bulk transfer");
+    }
+    if (file_info.st_size < 0 ||
+        static_cast<uint64_t>(file_info.st_size) < size) {
+        throw std::runtime_error(
+            "Expected a bulk transfer of " + std::to_string(size) +
+            " bytes, but the file only contains " +
+            std::to_string(file_info.st_size) + " bytes");
+    }
+
+    data.resize(size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        throw std::system_error(errno, std::system_category(),
+                                "Could not map a bulk transfer");
+    }
+
+    std::memcpy(data.data(), mapping, size);
+    munmap(mapping, size);
+}
+
+void send_with_fds(int socket_fd,
+                   const void* data,
+                   size_t size,
+                   std::span<const int> fds) {
+    if (fds.size() > max_bulk_transfers_per_message) {
+        throw std::runtime_error("Too many file descriptors in a message");
+    }
+
+    alignas(cmsghdr) FdControlBuffer control_buffer{};
+
+    size_t bytes_written = 0;
+    while (bytes_written < size) {
+        iovec iov{.iov_base = const_cast<char*>(static_cast<const char*>(data) +
+                                                bytes_written),
+                  .iov_len = size - bytes_written};
+        msghdr message{};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+
+        // The file descriptors only need to be sent with the first chunk
+        if (bytes_written == 0 && !fds.empty()) {
+            message.msg_control = control_buffer.data();
+            message.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+
+            cmsghdr* control_message = CMSG_FIRSTHDR(&message);
+            control_message->cmsg_level = SOL_SOCKET;
+            control_message->cmsg_type = SCM_RIGHTS;
+            control_message->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+            std::memcpy(CMSG_DATA(control_message), fds.data(),
+                        sizeof(int) * fds.size());
+        }
+
+        const ssize_t result = sendmsg(socket_fd, &message, MSG_NOSIGNAL);
+        if (result == -1) {
+            if (errno == EINTR) {
+                continue;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                wait_for_socket(socket_fd, POLLOUT);
+                continue;
+            }
+
+            throw boost::system::system_error(boost::system::error_code(
+                errno, boost::system::system_category()));
+        }
+
+        bytes_written += static_cast<size_t>(result);
+    }
+}
+
+void receive_with_fds(int socket_fd,
+                      void* data,
+                      size_t size,
+                      std::vector<int>& fds) {
+    alignas(cmsghdr) FdControlBuffer control_buffer;
+
+    size_t bytes_read = 0;
+    while (bytes_read < size) {
+        iovec iov{.iov_base = static_cast<char*>(data) + bytes_read,
+                  .iov_len = size - bytes_read};
+        msghdr message{};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control_buffer.data();
+        message.msg_controllen = control_buffer.size();
+
+        const ssize_t result = recvmsg(socket_fd, &message, MSG_CMSG_CLOEXEC);
+        if (result == -1) {
+            if (errno == EINTR) {
+                continue;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                wait_for_socket(socket_fd, POLLIN);
+                continue;
+            }
+
+            throw boost::system::system_error(boost::system::error_code(
+                errno, boost::system::system_category()));
+        } else if (result == 0) {
+            throw boost::system::system_error(boost::asio::error::eof);
+        }
+
+        for (cmsghdr* control_message = CMSG_FIRSTHDR(&message);
+             control_message;
+             control_message = CMSG_NXTHDR(&message, control_message)) {
+            if (control_message->cmsg_level != SOL_SOCKET ||
+                control_message->cmsg_type != SCM_RIGHTS) {
+                continue;
+            }
+
+            const size_t num_fds =
+                (control_message->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (size_t i = 0; i < num_fds; i++) {
+                int fd;
+                std::memcpy(&fd, CMSG_DATA(control_message) + (i * sizeof(int)),
+                            sizeof(int));
+                fds.push_back(fd);
+            }
+        }
+
+        bytes_read += static_cast<size_t>(result);
+    }
+}
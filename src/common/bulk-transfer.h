@@ -0,0 +1,165 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+ * Buffers larger than this will be transferred through an anonymous shared
+ * memory file instead of being serialized inline as part of the message. This
+ * is used for `effGetChunk()`/`effSetChunk()` chunk data and for VST3 plugin
+ * state. Those can easily be hundreds of megabytes for sample based
+ * instruments, and pushing all of that through a socket means serializing it
+ * into yet another buffer, doing thousands of socket writes and reads, and then
+ * deserializing it again on the other side. Smaller buffers are still sent
+ * inline since creating and mapping a memfd has a fixed cost of its own.
+ */
+constexpr size_t bulk_transfer_threshold = 1 << 20;
+
+/**
+ * The maximum number of bulk transfers in a single message. Every transfer's
+ * file descriptor is sent along with the message, and the kernel limits the
+ * number of file descriptors that can be sent at once. Messages currently
+ * contain at most a single large buffer, so any buffers past this limit are
+ * simply serialized inline.
+ */
+constexpr size_t max_bulk_transfers_per_message = 16;
+
+/**
+ * The file descriptors for the bulk transfers in the message that's currently
+ * being written or read on this thread. `write_object()` and `read_object()`
+ * create one of these while serializing or deserializing a message. Serializing
+ * a large buffer with `bitsery::ext::BulkBuffer` copies it to a new memfd and
+ * adds that file descriptor here, and `write_object()` then sends these file
+ * descriptors along with the message using `SCM_RIGHTS`. On the receiving side
+ * `read_object()` collects the file descriptors sent along with the message
+ * here, and deserializing the buffer takes them out again in the same order.
+ *
+ * Since the memfds are anonymous, they're freed as soon as the last file
+ * descriptor referring to them gets closed. This object closes any file
+ * descriptors it still holds when it goes out of scope, and the kernel closes
+ * the file descriptors that are still in flight if the other side exits before
+ * reading the message. That way a crash on either side can never leave a
+ * plugin's state lingering in memory.
+ */
+class BulkTransferFds {
+   public:
+    /**
+     * Make this the active object for the current thread.
+     */
+    BulkTransferFds() noexcept;
+
+    /**
+     * Close all remaining file descriptors and restore the previously active
+     * object for this thread, if any.
+     */
+    ~BulkTransferFds() noexcept;
+
+    BulkTransferFds(const BulkTransferFds&) = delete;
+    BulkTransferFds& operator=(const BulkTransferFds&) = delete;
+
+    /**
+     * The object that's currently active on this thread, or a null pointer if
+     * we're not currently writing or reading a message. Serializing outside of
+     * `write_object()` always sends buffers inline.
+     */
+    static BulkTransferFds* active() noexcept;
+
+    /**
+     * Take ownership of a file descriptor.
+     */
+    void push(int fd);
+
+    /**
+     * Take the next file descriptor out of this object. The caller becomes
+     * responsible for closing it.
+     *
+     * @throw std::runtime_error If no more file descriptors were sent along
+     *   with the message.
+     */
+    int pop();
+
+    /**
+     * The file descriptors that have not yet been taken out of this object.
+     */
+    std::span<const int> fds() const noexcept;
+
+    inline bool empty() const noexcept { return next_fd == fds_.size(); }
+    inline size_t size() const noexcept { return fds_.size() - next_fd; }
+
+   private:
+    std::vector<int> fds_;
+    size_t next_fd = 0;
+
+    BulkTransferFds* previous;
+};
+
+/**
+ * Copy `data` into a new anonymous memfd so it can be transferred to the other
+ * side without going through a socket.
+ *
+ * @param data The data to copy.
+ *
+ * @return The memfd's file descriptor.
+ *
+ * @throw std::system_error If the memfd could not be created or written to,
+ *   for instance because there's not enough memory.
+ *
+ * @relates read_bulk_transfer
+ */
+int create_bulk_transfer(const std::vector<uint8_t>& data);
+
+/**
+ * Read the data stored in a memfd created by `create_bulk_transfer()` into
+ * `data`. This does not close the file descriptor.
+ *
+ * @param fd The memfd's file descriptor, received from the other side.
+ * @param size The size of the data. This is sent along with the message.
+ * @param data The vector to write the data to. This will be resized to `size`.
+ *
+ * @throw std::system_error If the memfd could not be mapped.
+ * @throw std::runtime_error If the memfd is smaller than `size`.
+ *
+ * @relates create_bulk_transfer
+ */
+void read_bulk_transfer(int fd, uint64_t size, std::vector<uint8_t>& data);
+
+/**
+ * Write `size` bytes to a Unix domain socket, sending `fds` along with the
+ * first byte using `SCM_RIGHTS`. This blocks until all data has been written,
+ * even if the socket is in non-blocking mode.
+ *
+ * @throw boost::system::system_error If the socket is closed.
+ */
+void send_with_fds(int socket_fd,
+                   const void* data,
+                   size_t size,
+                   std::span<const int> fds);
+
+/**
+ * Read exactly `size` bytes from a Unix domain socket, adding any file
+ * descriptors received along with that data to `fds`. This blocks until all
+ * data has been read, even if the socket is in non-blocking mode.
+ *
+ * @throw boost::system::system_error If the socket is closed.
+ */
+void receive_with_fds(int socket_fd,
+                      void* data,
+                      size_t size,
+                      std::vector<int>& fds);
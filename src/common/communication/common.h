@@ -33,9 +33,12 @@
 #include <boost/container/small_vector.hpp>
 #include <boost/filesystem.hpp>
 
+#include "../audio-shm.h"
 #include "../bitsery/traits/small-vector.h"
+#include "../bulk-transfer.h"
 #include "../logging/common.h"
 #include "../utils.h"
+#include "multiplexed.h"
 
 // Our input and output adapters for binary serialization always expect the data
 // to be encoded in little endian format. This should not make any difference
@@ -138,6 +141,11 @@ template <typename T, typename Socket>
 inline void write_object(Socket& socket,
                          const T& object,
                          SerializationBufferBase& buffer) {
+    // Large buffers in the object will be copied to memfds during
+    // serialization, and the file descriptors are sent along with the size
+    // below. Any file descriptors still held by this object get closed when it
+    // goes out of scope, so nothing is left behind if writing fails.
+    BulkTransferFds bulk_transfers;
     const size_t size =
         bitsery::quickSerialization<OutputAdapter<SerializationBufferBase>>(
             buffer, object);
@@ -149,8 +157,16 @@ inline void write_object(Socket& socket,
     //       bit bridge. This won't make any function difference aside from the
     //       32-bit host application having to convert between 64 and 32 bit
     //       integers.
-    boost::asio::write(socket,
-                       boost::asio::buffer(std::array<uint64_t, 1>{size}));
+    const std::array<uint64_t, 1> message_length{size};
+    if (bulk_transfers.empty()) [[likely]] {
+        boost::asio::write(socket, boost::asio::buffer(message_length));
+    } else if constexpr (std::is_same_v<Socket, MultiplexedStream>) {
+        socket.write_with_fds(boost::asio::buffer(message_length),
+                              bulk_transfers.fds());
+    } else {
+        send_with_fds(socket.native_handle(), message_length.data(),
+                      sizeof(message_length), bulk_transfers.fds());
+    }
     const size_t bytes_written =
         boost::asio::write(socket, boost::asio::buffer(buffer, size));
     assert(bytes_written == size);
@@ -189,10 +205,27 @@ template <typename T, typename Socket>
 inline T& read_object(Socket& socket,
                       T& object,
                       SerializationBufferBase& buffer) {
+    // The file descriptors for any large buffers in the object are sent along
+    // with the size, see `write_object()`. Deserializing those buffers takes
+    // the file descriptors out of this object again, and any file descriptors
+    // that were not used are closed when it goes out of scope.
+    BulkTransferFds bulk_transfers;
+    std::vector<int> received_fds;
+
     // See the note above on the use of `uint64_t` instead of `size_t`
     std::array<uint64_t, 1> message_length;
-    boost::asio::read(socket, boost::asio::buffer(message_length),
-                      boost::asio::transfer_exactly(sizeof(message_length)));
+    if constexpr (std::is_same_v<Socket, MultiplexedStream>) {
+        boost::asio::read(
+            socket, boost::asio::buffer(message_length),
+            boost::asio::transfer_exactly(sizeof(message_length)));
+        socket.take_fds(received_fds);
+    } else {
+        receive_with_fds(socket.native_handle(), message_length.data(),
+                         sizeof(message_length), received_fds);
+    }
+    for (const int fd : received_fds) {
+        bulk_transfers.push(fd);
+    }
 
     // Make sure the buffer is large enough
     const size_t size = message_length[0];
@@ -257,6 +290,75 @@ inline T read_object(Socket& socket) {
     return object;
 }
 
+/**
+ * Serialize an object using bitsery and write it to the message area in an
+ * `AudioShmBuffer`'s control region. This is used together with
+ * `AudioShmBuffer::send_request_and_wait()` and
+ * `AudioShmBuffer::send_response()` to exchange audio processing requests
+ * without going through a socket.
+ *
+ * @param shm The shared memory object to write to.
+ * @param object The object to write to the message area.
+ * @param buffer The buffer to serialize into before copying the result to the
+ *   message area.
+ *
+ * @return The size of the serialized object in bytes, or a nullopt if the
+ *   object did not fit in the message area. The caller should fall back to
+ *   sending the object over a socket in that case.
+ *
+ * @relates read_shm_object
+ */
+template <typename T>
+inline std::optional<uint32_t> write_shm_object(
+    AudioShmBuffer& shm,
+    const T& object,
+    SerializationBufferBase& buffer) {
+    const size_t size =
+        bitsery::quickSerialization<OutputAdapter<SerializationBufferBase>>(
+            buffer, object);
+    if (size > AudioShmBuffer::message_capacity()) [[unlikely]] {
+        return std::nullopt;
+    }
+
+    std::copy_n(buffer.begin(), size, shm.message_data());
+
+    return static_cast<uint32_t>(size);
+}
+
+/**
+ * Deserialize an object from the message area in an `AudioShmBuffer`'s control
+ * region. This should be used together with `write_shm_object()`, after the
+ * other side has signalled that a new message has been written.
+ *
+ * @param shm The shared memory object to read from.
+ * @param object The object to deserialize into.
+ * @param buffer The buffer to copy the serialized object into before
+ *   deserializing it.
+ *
+ * @throw std::runtime_error If the conversion to an object was not successful.
+ *
+ * @relates write_shm_object
+ */
+template <typename T>
+inline T& read_shm_object(AudioShmBuffer& shm,
+                          T& object,
+                          SerializationBufferBase& buffer) {
+    const size_t size = shm.message_size();
+    buffer.resize(size);
+    std::copy_n(shm.message_data(), size, buffer.begin());
+
+    auto [_, success] =
+        bitsery::quickDeserialization<InputAdapter<SerializationBufferBase>>(
+            {buffer.begin(), size}, object);
+
+    if (!success) [[unlikely]] {
+        throw std::runtime_error("Deserialization failure in call: " +
+                                 std::string(__PRETTY_FUNCTION__));
+    }
+
+    return object;
+}
+
 /**
  * Generate a unique base directory that can be used as a prefix for all Unix
  * domain socket endpoints used in `Vst2PluginBridge`/`Vst2Bridge`. This will
@@ -394,11 +496,29 @@ class SocketHandler {
         }
     }
 
+    /**
+     * Use the primary stream of a channel on a multiplexed connection instead
+     * of a dedicated socket. This should be called instead of `connect()` on
+     * both sides, and the handler should have been constructed with `listen`
+     * set to `false`.
+     *
+     * @see MultiplexedConnection
+     */
+    void connect_multiplexed(MultiplexedConnection& connection,
+                             uint16_t channel) {
+        multiplexed_stream.emplace(connection.primary_stream(channel));
+    }
+
     /**
      * Close the socket. Both sides that are actively listening will be thrown a
      * `boost::system_error` when this happens.
      */
     void close() {
+        if (multiplexed_stream) {
+            multiplexed_stream->close();
+            return;
+        }
+
         // The shutdown can fail when the socket is already closed
         boost::system::error_code err;
         socket.shutdown(
@@ -427,7 +547,8 @@ class SocketHandler {
      */
     template <typename T>
     inline void send(const T& object, SerializationBufferBase& buffer) {
-        write_object(socket, object, buffer);
+        with_socket(
+            [&](auto& socket) { write_object(socket, object, buffer); });
     }
 
     /**
@@ -437,7 +558,7 @@ class SocketHandler {
      */
     template <typename T>
     inline void send(const T& object) {
-        write_object(socket, object);
+        with_socket([&](auto& socket) { write_object(socket, object); });
     }
 
     /**
@@ -471,7 +592,9 @@ class SocketHandler {
      */
     template <typename T>
     inline T& receive_single(T& object, SerializationBufferBase& buffer) {
-        return read_object<T>(socket, object, buffer);
+        return with_socket([&](auto& socket) -> T& {
+            return read_object<T>(socket, object, buffer);
+        });
     }
 
     /**
@@ -482,7 +605,8 @@ class SocketHandler {
      */
     template <typename T>
     inline T receive_single() {
-        return read_object<T>(socket);
+        return with_socket(
+            [&](auto& socket) -> T { return read_object<T>(socket); });
     }
 
     /**
@@ -521,6 +645,19 @@ class SocketHandler {
     }
 
    private:
+    /**
+     * Call `callback` with either the socket or the multiplexed stream,
+     * depending on whether `connect_multiplexed()` has been called.
+     */
+    template <typename F>
+    decltype(auto) with_socket(F&& callback) {
+        if (multiplexed_stream) {
+            return callback(*multiplexed_stream);
+        } else {
+            return callback(socket);
+        }
+    }
+
     boost::asio::local::stream_protocol::endpoint endpoint;
     boost::asio::local::stream_protocol::socket socket;
 
@@ -529,6 +666,13 @@ class SocketHandler {
      * connection.
      */
     std::optional<boost::asio::local::stream_protocol::acceptor> acceptor;
+
+    /**
+     * When set, this stream is used instead of `socket`.
+     *
+     * @see connect_multiplexed
+     */
+    std::optional<MultiplexedStream> multiplexed_stream;
 };
 
 /**
@@ -550,12 +694,35 @@ class SocketHandler {
  *   socket instead. On the listening side the new connection will be accepted,
  *   and a newly spawned thread will handle incoming connection just like it
  *   would for the primary socket.
+ * - Because connecting a socket and spawning a thread is relatively expensive,
+ *   these secondary connections are not thrown away after a single request.
+ *   The sending side keeps up to `max_idle_secondary_sockets` idle secondary
+ *   sockets around and it will reuse those the next time the primary socket is
+ *   busy. On the listening side the thread handling a secondary connection
+ *   will keep handling requests until the sending side closes the connection.
+ *   Under contention sending a request thus only costs a pool checkout.
+ *
+ * Instead of using dedicated sockets, this can also use a channel on a
+ * `MultiplexedConnection` by calling `connect_multiplexed()` instead of
+ * `connect()`. The primary socket is then replaced by the channel's primary
+ * stream, and secondary sockets are replaced by new streams on that same
+ * connection. Those are pooled in the exact same way.
  *
  * @tparam Thread The thread implementation to use. On the Linux side this
  *   should be `std::jthread` and on the Wine side this should be `Win32Thread`.
  */
 template <typename Thread>
 class AdHocSocketHandler {
+   public:
+    /**
+     * The maximum number of idle secondary sockets we'll keep around on the
+     * sending side. When more secondary sockets are in use at the same time,
+     * then the additional sockets will be closed after their request has been
+     * handled. Each idle socket corresponds to a sleeping thread on the
+     * receiving side.
+     */
+    static constexpr size_t max_idle_secondary_sockets = 8;
+
    protected:
     /**
      * Sets up a single primary socket. The sockets won't be active until
@@ -603,17 +770,58 @@ class AdHocSocketHandler {
         }
     }
 
+    /**
+     * Use a channel on a multiplexed connection instead of dedicated sockets.
+     * This should be called instead of `connect()` on both sides, and the
+     * handler should have been constructed with `listen` set to `false`.
+     *
+     * @see MultiplexedConnection
+     */
+    void connect_multiplexed(MultiplexedConnection& connection,
+                             uint16_t channel) {
+        multiplexed_connection = &connection;
+        multiplexed_channel = channel;
+        primary_stream.emplace(connection.primary_stream(channel));
+    }
+
     /**
      * Close the socket. Both sides that are actively listening will be thrown a
      * `boost::system_error` when this happens.
      */
     void close() {
+        if (primary_stream) {
+            primary_stream->close();
+            {
+                std::lock_guard lock(idle_secondary_streams_mutex);
+                idle_secondary_streams.clear();
+            }
+
+            while (currently_listening) {
+                // See below
+            }
+
+            return;
+        }
+
         // The shutdown can fail when the socket is already closed
         boost::system::error_code err;
         socket.shutdown(
             boost::asio::local::stream_protocol::socket::shutdown_both, err);
         socket.close();
 
+        // This will also terminate the threads handling these connections on
+        // the other side
+        {
+            std::lock_guard lock(idle_secondary_sockets_mutex);
+            for (auto& secondary_socket : idle_secondary_sockets) {
+                secondary_socket.shutdown(
+                    boost::asio::local::stream_protocol::socket::shutdown_both,
+                    err);
+                secondary_socket.close();
+            }
+            idle_secondary_sockets.clear();
+        }
+
         while (currently_listening) {
             // If another thread is currently calling `receive_multi()`, we'll
             // spinlock until that function has exited. We would otherwise get a
@@ -629,14 +837,17 @@ class AdHocSocketHandler {
      * for details on the parameters and return value of this function.
      *
      * As described above, if this function is currently being called from
-     * another thread, then this will create a new socket connection and send
-     * the event there instead.
+     * another thread, then this will send the event over an idle secondary
+     * socket instead, connecting a new one if none are available.
      *
      * @param callback A function that will be called with a reference to a
-     *   socket. This is either the primary `socket`, or a new ad hock socket if
-     *   this function is currently being called from another thread.
+     *   socket. This is either the primary `socket`, or a secondary socket if
+     *   this function is currently being called from another thread. When
+     *   using a multiplexed connection this will be called with a
+     *   `MultiplexedStream` instead, so this should be a generic lambda.
      */
     template <std::invocable<boost::asio::local::stream_protocol::socket&> F>
+        requires std::invocable<F, MultiplexedStream&>
     std::invoke_result_t<F, boost::asio::local::stream_protocol::socket&> send(
         F&& callback) {
         // A bit of template and constexpr nastiness to allow us to either
@@ -646,31 +857,51 @@ class AdHocSocketHandler {
         constexpr bool returns_void = std::is_void_v<std::invoke_result_t<
             F, boost::asio::local::stream_protocol::socket&>>;
 
-        // XXX: Maybe at some point we should benchmark how often this
-        //      ad hoc socket spawning mechanism gets used. If some hosts
-        //      for instance consistently and repeatedly trigger this then
-        //      we might be able to do some optimizations there.
         std::unique_lock lock(write_mutex, std::try_to_lock);
         if (lock.owns_lock()) {
             // This was used to always block when sending the first message,
             // because the other side may not be listening for additional
             // connections yet
             if constexpr (returns_void) {
-                callback(socket);
+                with_primary_socket(callback);
                 sent_first_event = true;
             } else {
-                auto result = callback(socket);
+                auto result = with_primary_socket(callback);
                 sent_first_event = true;
 
+                return result;
+            }
+        } else if (multiplexed_connection) {
+            // Opening a new stream can't fail because the other side is not
+            // yet listening, since the other side will queue up the new
+            // streams until it starts accepting them
+            MultiplexedStream secondary_stream = checkout_secondary_stream();
+            if constexpr (returns_void) {
+                callback(secondary_stream);
+                return_secondary_stream(std::move(secondary_stream));
+            } else {
+                auto result = callback(secondary_stream);
+                return_secondary_stream(std::move(secondary_stream));
+
                 return result;
             }
         } else {
             try {
-                boost::asio::local::stream_protocol::socket secondary_socket(
-                    io_context);
-                secondary_socket.connect(endpoint);
+                boost::asio::local::stream_protocol::socket secondary_socket =
+                    checkout_secondary_socket();
+
+                // The socket only gets returned to the pool if the request
+                // succeeded, since a failed request may have left unread data
+                // in the socket
+                if constexpr (returns_void) {
+                    callback(secondary_socket);
+                    return_secondary_socket(std::move(secondary_socket));
+                } else {
+                    auto result = callback(secondary_socket);
+                    return_secondary_socket(std::move(secondary_socket));
 
-                return callback(secondary_socket);
+                    return result;
+                }
             } catch (const boost::system::system_error&) {
                 // So, what do we do when noone is listening on the endpoint
                 // yet? This can happen with plugin groups when the Wine
@@ -715,13 +946,16 @@ class AdHocSocketHandler {
      * @param primary_callback A function that will do a single read cycle for
      *   the primary socket socket that should do a single read cycle. This is
      *   called in a loop so it shouldn't do any looping itself.
-     * @param secondary_callback A function that will be called when we receive
-     *   an incoming connection on a secondary socket. This would often do the
-     *   same thing as `primary_callback`, but secondary sockets may need some
-     *   different handling.
+     * @param secondary_callback A function that will do a single read cycle
+     *   for a secondary socket. Like `primary_callback`, this is called in a
+     *   loop until the sending side closes the connection. This would often do
+     *   the same thing as `primary_callback`, but secondary sockets may need
+     *   some different handling.
      */
     template <std::invocable<boost::asio::local::stream_protocol::socket&> F,
               std::invocable<boost::asio::local::stream_protocol::socket&> G>
+        requires std::invocable<F, MultiplexedStream&> &&
+                 std::invocable<G, MultiplexedStream&>
     void receive_multi(std::optional<std::reference_wrapper<Logger>> logger,
                        F&& primary_callback,
                        G&& secondary_callback) {
@@ -731,12 +965,20 @@ class AdHocSocketHandler {
         assert(!currently_listening);
         currently_listening = true;
 
+        if (multiplexed_connection) {
+            receive_multi_multiplexed(primary_callback, secondary_callback);
+
+            currently_listening = false;
+            return;
+        }
+
         // As described above we'll handle incoming requests for `socket` on
         // this thread. We'll also listen for incoming connections on `endpoint`
         // on another thread. For any incoming connection we'll spawn a new
-        // thread to handle the request. When `socket` closes and this loop
-        // breaks, the listener and any still active threads will be cleaned up
-        // before this function exits.
+        // thread that keeps handling requests until the other side closes the
+        // connection. When `socket` closes and this loop breaks, the listener
+        // and any still active threads will be cleaned up before this function
+        // exits.
         boost::asio::io_context secondary_context{};
 
         // The previous acceptor has already been shut down by
@@ -744,7 +986,13 @@ class AdHocSocketHandler {
         acceptor.emplace(secondary_context, endpoint);
 
         // This works the exact same was as `active_plugins` and
-        // `next_plugin_id` in `GroupBridge`
+        // `next_plugin_id` in `GroupBridge`. The sockets are stored separately
+        // so we can shut them down when the primary socket gets closed. Since
+        // the sending side reuses these connections, the threads handling them
+        // may otherwise block forever. These sockets need to outlive the
+        // threads, so they're declared first.
+        std::unordered_map<size_t, boost::asio::local::stream_protocol::socket>
+            active_secondary_sockets{};
         std::unordered_map<size_t, Thread> active_secondary_requests{};
         std::atomic_size_t next_request_id{};
         std::mutex active_secondary_requests_mutex{};
@@ -753,15 +1001,24 @@ class AdHocSocketHandler {
             [&](boost::asio::local::stream_protocol::socket secondary_socket) {
                 const size_t request_id = next_request_id.fetch_add(1);
 
-                // We have to make sure to keep moving these sockets into the
-                // threads that will handle them
                 std::lock_guard lock(active_secondary_requests_mutex);
-                active_secondary_requests[request_id] = Thread(
-                    [&, request_id](boost::asio::local::stream_protocol::socket
-                                        secondary_socket) {
-                        secondary_callback(secondary_socket);
-
-                        // When we have processed this request, we'll join the
+                boost::asio::local::stream_protocol::socket& socket_ref =
+                    active_secondary_sockets
+                        .emplace(request_id, std::move(secondary_socket))
+                        .first->second;
+                active_secondary_requests[request_id] =
+                    Thread([&, request_id, &secondary_socket = socket_ref]() {
+                        // The other side will keep using this connection for
+                        // additional requests until it closes the socket
+                        while (true) {
+                            try {
+                                secondary_callback(secondary_socket);
+                            } catch (const boost::system::system_error&) {
+                                break;
+                            }
+                        }
+
+                        // When the connection has been closed, we'll join the
                         // thread again with the thread that's handling
                         // `secondary_context`
                         boost::asio::post(secondary_context, [&, request_id]() {
@@ -771,9 +1028,9 @@ class AdHocSocketHandler {
                             // The join is implicit because we're using
                             // `std::jthread`/`Win32Thread`
                             active_secondary_requests.erase(request_id);
+                            active_secondary_sockets.erase(request_id);
                         });
-                    },
-                    std::move(secondary_socket));
+                    });
             });
 
         Thread secondary_requests_handler([&]() {
@@ -796,10 +1053,18 @@ class AdHocSocketHandler {
 
         // After the primary socket gets terminated (during shutdown) we'll make
         // sure all outstanding jobs have been processed and then drop all work
-        // from the IO context
+        // from the IO context. Shutting down the secondary sockets causes the
+        // threads handling them to exit, after which they will be joined when
+        // `active_secondary_requests` goes out of scope.
         std::lock_guard lock(active_secondary_requests_mutex);
         secondary_context.stop();
         acceptor.reset();
+        for (auto& [request_id, secondary_socket] : active_secondary_sockets) {
+            boost::system::error_code err;
+            secondary_socket.shutdown(
+                boost::asio::local::stream_protocol::socket::shutdown_both,
+                err);
+        }
 
         currently_listening = false;
     }
@@ -811,12 +1076,160 @@ class AdHocSocketHandler {
      * @overload
      */
     template <std::invocable<boost::asio::local::stream_protocol::socket&> F>
+        requires std::invocable<F, MultiplexedStream&>
     void receive_multi(std::optional<std::reference_wrapper<Logger>> logger,
                        F&& callback) {
         receive_multi(logger, callback, std::forward<F>(callback));
     }
 
    private:
+    /**
+     * The multiplexed version of `receive_multi()`. This works the same way,
+     * except that the new streams on our channel are passed to us by the
+     * connection's reader thread instead of having to be accepted on a socket.
+     */
+    template <typename F, typename G>
+    void receive_multi_multiplexed(F& primary_callback, G& secondary_callback) {
+        // Threads that finished handling their stream are joined the next time
+        // a stream gets accepted, or when this function returns. Like in
+        // `receive_multi()` the streams need to outlive their threads.
+        std::unordered_map<size_t, MultiplexedStream>
+            active_secondary_streams{};
+        std::unordered_map<size_t, Thread> active_secondary_requests{};
+        std::vector<size_t> finished_requests{};
+        size_t next_request_id = 0;
+        std::mutex active_secondary_requests_mutex{};
+        multiplexed_connection->accept_streams(
+            multiplexed_channel, [&](MultiplexedStream secondary_stream) {
+                std::lock_guard lock(active_secondary_requests_mutex);
+                for (const size_t request_id : finished_requests) {
+                    active_secondary_requests.erase(request_id);
+                    active_secondary_streams.erase(request_id);
+                }
+                finished_requests.clear();
+
+                const size_t request_id = next_request_id++;
+                MultiplexedStream& stream_ref =
+                    active_secondary_streams
+                        .emplace(request_id, std::move(secondary_stream))
+                        .first->second;
+                active_secondary_requests[request_id] =
+                    Thread([&, request_id, &secondary_stream = stream_ref]() {
+                        while (true) {
+                            try {
+                                secondary_callback(secondary_stream);
+                            } catch (const boost::system::system_error&) {
+                                break;
+                            }
+                        }
+
+                        std::lock_guard lock(active_secondary_requests_mutex);
+                        finished_requests.push_back(request_id);
+                    });
+            });
+
+        while (true) {
+            try {
+                primary_callback(*primary_stream);
+            } catch (const boost::system::system_error&) {
+                break;
+            }
+        }
+
+        // No new streams will be accepted after this. Closing the streams
+        // wakes up the threads handling them so they can be joined.
+        multiplexed_connection->accept_streams(multiplexed_channel, nullptr);
+        {
+            std::lock_guard lock(active_secondary_requests_mutex);
+            for (auto& [request_id, secondary_stream] :
+                 active_secondary_streams) {
+                secondary_stream.close();
+            }
+        }
+        active_secondary_requests.clear();
+    }
+
+    /**
+     * Call `callback` with either the primary socket or the primary stream,
+     * depending on whether `connect_multiplexed()` has been called.
+     */
+    template <typename F>
+    decltype(auto) with_primary_socket(F&& callback) {
+        if (primary_stream) {
+            return callback(*primary_stream);
+        } else {
+            return callback(socket);
+        }
+    }
+
+    /**
+     * Take an idle secondary stream from the pool, or open a new one on our
+     * channel if there are no idle streams left.
+     */
+    MultiplexedStream checkout_secondary_stream() {
+        {
+            std::lock_guard lock(idle_secondary_streams_mutex);
+            if (!idle_secondary_streams.empty()) {
+                MultiplexedStream secondary_stream =
+                    std::move(idle_secondary_streams.back());
+                idle_secondary_streams.pop_back();
+
+                return secondary_stream;
+            }
+        }
+
+        return multiplexed_connection->open_stream(multiplexed_channel);
+    }
+
+    /**
+     * The same as `return_secondary_socket()`, but for streams.
+     */
+    void return_secondary_stream(MultiplexedStream secondary_stream) {
+        std::lock_guard lock(idle_secondary_streams_mutex);
+        if (idle_secondary_streams.size() < max_idle_secondary_sockets) {
+            idle_secondary_streams.push_back(std::move(secondary_stream));
+        }
+    }
+
+    /**
+     * Take an idle secondary socket from the pool, or connect a new one if
+     * there are no idle sockets left.
+     *
+     * @throw boost::system::system_error If a new socket had to be created,
+     *   but nothing was listening on `endpoint`.
+     */
+    boost::asio::local::stream_protocol::socket checkout_secondary_socket() {
+        {
+            std::lock_guard lock(idle_secondary_sockets_mutex);
+            if (!idle_secondary_sockets.empty()) {
+                boost::asio::local::stream_protocol::socket secondary_socket =
+                    std::move(idle_secondary_sockets.back());
+                idle_secondary_sockets.pop_back();
+
+                return secondary_socket;
+            }
+        }
+
+        boost::asio::local::stream_protocol::socket secondary_socket(
+            io_context);
+        secondary_socket.connect(endpoint);
+
+        return secondary_socket;
+    }
+
+    /**
+     * Put a secondary socket back into the pool after it has been used for a
+     * request. If the pool is already full, then the socket will be closed
+     * instead, and the thread handling it on the other side will exit.
+     */
+    void return_secondary_socket(
+        boost::asio::local::stream_protocol::socket secondary_socket) {
+        std::lock_guard lock(idle_secondary_sockets_mutex);
+        if (idle_secondary_sockets.size() < max_idle_secondary_sockets) {
+            idle_secondary_sockets.push_back(std::move(secondary_socket));
+        }
+    }
+
     /**
      * Used in `receive_multi()` to asynchronously listen for secondary socket
      * connections. After `callback()` returns this function will continue to be
@@ -890,10 +1303,39 @@ class AdHocSocketHandler {
 
     /**
      * A mutex that locks the primary `socket`. If this is locked, then any new
-     * events will be sent over a new socket instead.
+     * events will be sent over a secondary socket instead.
      */
     std::mutex write_mutex;
 
+    /**
+     * Secondary socket connections from earlier requests that are not
+     * currently in use. These will be reused by `send()` when the primary
+     * socket is busy. This never contains more than
+     * `max_idle_secondary_sockets` sockets.
+     *
+     * @see checkout_secondary_socket
+     * @see return_secondary_socket
+     */
+    std::vector<boost::asio::local::stream_protocol::socket>
+        idle_secondary_sockets;
+    std::mutex idle_secondary_sockets_mutex;
+
+    /**
+     * The connection and channel used in place of `socket` after
+     * `connect_multiplexed()` has been called. The primary stream takes the
+     * role of `socket`.
+     */
+    MultiplexedConnection* multiplexed_connection = nullptr;
+    uint16_t multiplexed_channel = 0;
+    std::optional<MultiplexedStream> primary_stream;
+
+    /**
+     * The same as `idle_secondary_sockets`, but for secondary streams on a
+     * multiplexed connection.
+     */
+    std::vector<MultiplexedStream> idle_secondary_streams;
+    std::mutex idle_secondary_streams_mutex;
+
     /**
      * Indicates whether or not the remove has processed an event we sent from
      * this side. When a Windows VST2 plugin performs a host callback in its
@@ -0,0 +1,355 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "multiplexed.h"
+
+#include <unistd.h>
+#include <boost/asio/read.hpp>
+#include <boost/filesystem.hpp>
+
+MultiplexedStreamInbox::~MultiplexedStreamInbox() noexcept {
+    for (const auto& [offset, fd] : fds) {
+        close(fd);
+    }
+}
+
+MultiplexedStream::MultiplexedStream(
+    MultiplexedConnection& connection,
+    uint32_t id,
+    uint16_t channel,
+    std::shared_ptr<MultiplexedStreamInbox> inbox) noexcept
+    : connection(&connection), id(id), channel(channel), inbox(inbox) {}
+
+MultiplexedStream::~MultiplexedStream() noexcept {
+    close();
+}
+
+MultiplexedStream::MultiplexedStream(MultiplexedStream&& o) noexcept
+    : connection(o.connection),
+      id(o.id),
+      channel(o.channel),
+      inbox(std::move(o.inbox)) {}
+
+MultiplexedStream& MultiplexedStream::operator=(
+    MultiplexedStream&& o) noexcept {
+    if (this != &o) {
+        close();
+
+        connection = o.connection;
+        id = o.id;
+        channel = o.channel;
+        inbox = std::move(o.inbox);
+    }
+
+    return *this;
+}
+
+void MultiplexedStream::close() noexcept {
+    // The inbox is only reset when this handle gets moved from, so another
+    // thread blocked in `read_some()` can keep using it until it wakes up
+    if (!inbox) {
+        return;
+    }
+
+    // We'll only notify the other side if it hasn't already closed the stream
+    bool closed_by_other_side;
+    {
+        std::lock_guard lock(inbox->mutex);
+        if (inbox->released) {
+            return;
+        }
+
+        closed_by_other_side = inbox->closed;
+        inbox->closed = true;
+        inbox->released = true;
+    }
+    inbox->data_available.notify_all();
+
+    connection->release_stream(id, channel, !closed_by_other_side);
+}
+
+void MultiplexedStream::write_with_fds(boost::asio::const_buffer buffer,
+                                       std::span<const int> fds) {
+    boost::system::error_code err;
+    if (!inbox) {
+        err = boost::asio::error::bad_descriptor;
+    } else {
+        std::unique_lock lock(inbox->mutex);
+        if (inbox->released) {
+            err = boost::asio::error::bad_descriptor;
+        }
+    }
+    if (!err) {
+        connection->write_frame(id, channel, 0, buffer, err, fds);
+    }
+
+    if (err) {
+        throw boost::system::system_error(err);
+    }
+}
+
+void MultiplexedStream::take_fds(std::vector<int>& fds) {
+    if (!inbox) {
+        return;
+    }
+
+    std::lock_guard lock(inbox->mutex);
+    while (!inbox->fds.empty() &&
+           inbox->fds.front().first < inbox->total_bytes_read) {
+        fds.push_back(inbox->fds.front().second);
+        inbox->fds.pop_front();
+    }
+}
+
+MultiplexedConnection::MultiplexedConnection(
+    boost::asio::io_context& io_context,
+    boost::asio::local::stream_protocol::endpoint endpoint,
+    bool listen)
+    : endpoint(endpoint),
+      socket(io_context),
+      next_stream_id(first_dynamic_stream_id + (listen ? 0 : 1)) {
+    if (listen) {
+        boost::filesystem::create_directories(
+            boost::filesystem::path(endpoint.path()).parent_path());
+        acceptor.emplace(io_context, endpoint);
+    }
+}
+
+void MultiplexedConnection::connect() {
+    if (acceptor) {
+        acceptor->accept(socket);
+
+        acceptor.reset();
+        boost::filesystem::remove(endpoint.path());
+    } else {
+        socket.connect(endpoint);
+    }
+}
+
+void MultiplexedConnection::close() noexcept {
+    // The shutdown can fail when the socket is already closed
+    boost::system::error_code err;
+    socket.shutdown(boost::asio::local::stream_protocol::socket::shutdown_both,
+                    err);
+}
+
+void MultiplexedConnection::run() {
+    std::vector<uint8_t> payload;
+    std::vector<int> fds;
+    while (true) {
+        MultiplexedFrameHeader header;
+        payload.clear();
+        fds.clear();
+        try {
+            // File descriptors for bulk transfers are sent along with the
+            // frame's header, see `MultiplexedStream::write_with_fds()`
+            receive_with_fds(socket.native_handle(), &header, sizeof(header),
+                             fds);
+            payload.resize(header.size);
+            boost::asio::read(socket, boost::asio::buffer(payload));
+        } catch (const boost::system::system_error&) {
+            // This happens when the connection gets closed during shutdown
+            for (const int fd : fds) {
+                ::close(fd);
+            }
+
+            break;
+        }
+
+        // New streams are passed to the callback registered for their channel,
+        // or they're queued up until a callback gets registered
+        if (header.flags & MultiplexedFrameHeader::open_flag) {
+            std::shared_ptr<MultiplexedStreamInbox> inbox;
+            {
+                std::lock_guard lock(streams_mutex);
+                inbox = get_or_create_inbox(header.stream_id);
+            }
+            MultiplexedStream stream(*this, header.stream_id, header.channel,
+                                     std::move(inbox));
+
+            std::lock_guard lock(acceptors_mutex);
+            if (auto it = stream_acceptors.find(header.channel);
+                it != stream_acceptors.end()) {
+                it->second(std::move(stream));
+            } else {
+                pending_streams[header.channel].push_back(std::move(stream));
+            }
+
+            continue;
+        }
+
+        std::shared_ptr<MultiplexedStreamInbox> inbox;
+        {
+            std::lock_guard lock(streams_mutex);
+            if (header.stream_id < first_dynamic_stream_id) {
+                // Primary streams may receive data before this side has
+                // requested a handle to them
+                inbox = get_or_create_inbox(header.stream_id);
+            } else if (auto it = streams.find(header.stream_id);
+                       it != streams.end()) {
+                inbox = it->second;
+            }
+        }
+
+        // Frames for streams we have already closed on our side are dropped.
+        // The same goes for streams that have exceeded their inbox's size
+        // limit, see `MultiplexedStreamInbox::max_unread_bytes`.
+        bool accepted = false;
+        bool overflowed = false;
+        if (inbox) {
+            {
+                std::lock_guard lock(inbox->mutex);
+                const size_t unread_bytes =
+                    inbox->data.size() - inbox->read_position;
+                if (inbox->closed) {
+                    // Nothing can read this data anymore
+                } else if (unread_bytes + payload.size() >
+                           MultiplexedStreamInbox::max_unread_bytes) {
+                    inbox->data.clear();
+                    inbox->data.shrink_to_fit();
+                    inbox->read_position = 0;
+                    inbox->closed = true;
+                    overflowed = true;
+                } else {
+                    for (const int fd : fds) {
+                        inbox->fds.emplace_back(inbox->total_bytes_received,
+                                                fd);
+                    }
+                    inbox->total_bytes_received += payload.size();
+                    inbox->data.insert(inbox->data.end(), payload.begin(),
+                                       payload.end());
+                    if (header.flags & MultiplexedFrameHeader::close_flag) {
+                        inbox->closed = true;
+                    }
+
+                    accepted = true;
+                }
+            }
+            inbox->data_available.notify_all();
+        }
+        if (overflowed) {
+            // The other side may be waiting for a response on this stream, so
+            // it needs to know that the stream is gone
+            boost::system::error_code err;
+            write_frame(header.stream_id, header.channel,
+                        MultiplexedFrameHeader::close_flag,
+                        boost::asio::const_buffer(), err);
+        }
+        if (!accepted) {
+            for (const int fd : fds) {
+                ::close(fd);
+            }
+        }
+    }
+
+    // All blocking reads should be woken up once the connection is gone. The
+    // pending streams are moved out of the map first since their destructors
+    // need to lock `streams_mutex`.
+    std::unordered_map<uint16_t, std::vector<MultiplexedStream>>
+        unaccepted_streams;
+    {
+        std::lock_guard lock(write_mutex);
+        is_closed.store(true, std::memory_order_release);
+    }
+    {
+        std::lock_guard lock(streams_mutex);
+        for (auto& [stream_id, inbox] : streams) {
+            {
+                std::lock_guard inbox_lock(inbox->mutex);
+                inbox->closed = true;
+            }
+            inbox->data_available.notify_all();
+        }
+    }
+    {
+        std::lock_guard lock(acceptors_mutex);
+        unaccepted_streams = std::move(pending_streams);
+        pending_streams.clear();
+    }
+}
+
+MultiplexedStream MultiplexedConnection::primary_stream(uint16_t channel) {
+    std::lock_guard lock(streams_mutex);
+
+    return MultiplexedStream(*this, channel, channel,
+                             get_or_create_inbox(channel));
+}
+
+MultiplexedStream MultiplexedConnection::open_stream(uint16_t channel) {
+    const uint32_t stream_id = next_stream_id.fetch_add(2);
+
+    std::shared_ptr<MultiplexedStreamInbox> inbox;
+    {
+        std::lock_guard lock(streams_mutex);
+        inbox = get_or_create_inbox(stream_id);
+    }
+    MultiplexedStream stream(*this, stream_id, channel, inbox);
+
+    // The other side only learns about the stream through this frame
+    boost::system::error_code err;
+    write_frame(stream_id, channel, MultiplexedFrameHeader::open_flag,
+                boost::asio::const_buffer(), err);
+    if (err) {
+        throw boost::system::system_error(err);
+    }
+
+    return stream;
+}
+
+void MultiplexedConnection::accept_streams(
+    uint16_t channel,
+    std::function<void(MultiplexedStream)> callback) {
+    // Since the reader thread calls these callbacks while holding this mutex,
+    // no callback can be running anymore once this returns
+    std::lock_guard lock(acceptors_mutex);
+    if (!callback) {
+        stream_acceptors.erase(channel);
+        return;
+    }
+
+    stream_acceptors[channel] = callback;
+    if (auto it = pending_streams.find(channel); it != pending_streams.end()) {
+        for (auto& stream : it->second) {
+            callback(std::move(stream));
+        }
+        pending_streams.erase(it);
+    }
+}
+
+void MultiplexedConnection::release_stream(uint32_t stream_id,
+                                           uint16_t channel,
+                                           bool send_close) noexcept {
+    {
+        std::lock_guard lock(streams_mutex);
+        streams.erase(stream_id);
+    }
+
+    if (send_close) {
+        boost::system::error_code err;
+        write_frame(stream_id, channel, MultiplexedFrameHeader::close_flag,
+                    boost::asio::const_buffer(), err);
+    }
+}
+
+std::shared_ptr<MultiplexedStreamInbox>
+MultiplexedConnection::get_or_create_inbox(uint32_t stream_id) {
+    std::shared_ptr<MultiplexedStreamInbox>& inbox = streams[stream_id];
+    if (!inbox) {
+        inbox = std::make_shared<MultiplexedStreamInbox>();
+    }
+
+    return inbox;
+}
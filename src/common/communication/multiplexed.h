@@ -0,0 +1,456 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __WINE__
+#include "../wine-host/boost-fix.h"
+#endif
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/write.hpp>
+
+#include "../bulk-transfer.h"
+
+class MultiplexedConnection;
+
+/**
+ * The header written in front of every frame sent over a
+ * `MultiplexedConnection`. The sizes are fixed width so the 32-bit bit bridge
+ * uses the same layout.
+ */
+struct MultiplexedFrameHeader {
+    /**
+     * Set on the first frame for a stream that was opened using
+     * `MultiplexedConnection::open_stream()`.
+     */
+    static constexpr uint16_t open_flag = 1 << 0;
+    /**
+     * Set on the last frame for a stream. After this the stream will no longer
+     * be used, and reads on the other side will fail once all data has been
+     * consumed.
+     */
+    static constexpr uint16_t close_flag = 1 << 1;
+
+    uint32_t stream_id;
+    uint16_t channel;
+    uint16_t flags;
+    uint64_t size;
+};
+
+static_assert(sizeof(MultiplexedFrameHeader) == 16);
+
+/**
+ * The data received for a single stream that has not yet been read. This is
+ * shared between the connection's reader and the `MultiplexedStream` handle.
+ */
+struct MultiplexedStreamInbox {
+    /**
+     * The maximum number of unread bytes a single stream can hold. Streams are
+     * only used for request/response pairs and large buffers are sent as bulk
+     * transfers, so a stream should never come anywhere near this. If the
+     * other side sends more data than this without it being read, then the
+     * data gets dropped and the stream is closed. The reader thread can't
+     * block until there's room again, since that would also block every other
+     * stream on the connection.
+     */
+    static constexpr size_t max_unread_bytes = 64 << 20;
+
+    /**
+     * After all data has been read, the buffer is shrunk again if its
+     * capacity is larger than this. This way a single large message doesn't
+     * keep a large allocation alive for as long as the stream exists.
+     */
+    static constexpr size_t max_retained_capacity = 1 << 20;
+
+    MultiplexedStreamInbox() noexcept = default;
+
+    /**
+     * Close any file descriptors that were received but never taken out of
+     * the inbox.
+     */
+    ~MultiplexedStreamInbox() noexcept;
+
+    MultiplexedStreamInbox(const MultiplexedStreamInbox&) = delete;
+    MultiplexedStreamInbox& operator=(const MultiplexedStreamInbox&) = delete;
+
+    std::mutex mutex;
+    std::condition_variable data_available;
+    std::vector<uint8_t> data;
+    size_t read_position = 0;
+    /**
+     * The total number of bytes that have been read from this stream so far.
+     * Used together with `fds` so file descriptors are only handed out once
+     * the data they were sent with has been read.
+     */
+    uint64_t total_bytes_read = 0;
+    /**
+     * The total number of bytes received for this stream so far.
+     */
+    uint64_t total_bytes_received = 0;
+    /**
+     * File descriptors sent along with a frame using `SCM_RIGHTS`, together
+     * with the value of `total_bytes_received` at the start of that frame.
+     */
+    std::deque<std::pair<uint64_t, int>> fds;
+    /**
+     * Set when the stream has been closed on either side, or when the
+     * connection got closed. Reads will fail once `data` has been fully
+     * consumed.
+     */
+    bool closed = false;
+    /**
+     * Set when the stream has been closed on this side. Writes will fail after
+     * this point.
+     */
+    bool released = false;
+};
+
+/**
+ * A single logical, bidirectional byte stream within a `MultiplexedConnection`.
+ * This implements Boost.Asio's `SyncReadStream` and `SyncWriteStream` concepts,
+ * so `read_object()` and `write_object()` work the same way on these streams
+ * as they do on sockets. Just like with a socket, only a single thread should
+ * be reading from and writing to a stream at any given time.
+ *
+ * These are move-only handles. Destroying a handle closes the stream on both
+ * sides.
+ */
+class MultiplexedStream {
+   public:
+    MultiplexedStream(MultiplexedConnection& connection,
+                      uint32_t id,
+                      uint16_t channel,
+                      std::shared_ptr<MultiplexedStreamInbox> inbox) noexcept;
+    ~MultiplexedStream() noexcept;
+
+    MultiplexedStream(const MultiplexedStream&) = delete;
+    MultiplexedStream& operator=(const MultiplexedStream&) = delete;
+
+    MultiplexedStream(MultiplexedStream&&) noexcept;
+    MultiplexedStream& operator=(MultiplexedStream&&) noexcept;
+
+    /**
+     * Close the stream. Any thread blocked reading from this stream on either
+     * side will be woken up. This is a no-op if the stream has already been
+     * closed. Like with sockets, this can safely be called while another
+     * thread is blocked reading from the stream.
+     */
+    void close() noexcept;
+
+    template <typename MutableBufferSequence>
+    size_t read_some(const MutableBufferSequence& buffers,
+                     boost::system::error_code& err) {
+        err = {};
+        if (boost::asio::buffer_size(buffers) == 0) {
+            return 0;
+        }
+        if (!inbox) {
+            err = boost::asio::error::bad_descriptor;
+            return 0;
+        }
+
+        std::unique_lock lock(inbox->mutex);
+        inbox->data_available.wait(lock, [&]() {
+            return inbox->read_position < inbox->data.size() || inbox->closed;
+        });
+
+        if (inbox->read_position == inbox->data.size()) {
+            err = boost::asio::error::eof;
+            return 0;
+        }
+
+        const size_t bytes_read = boost::asio::buffer_copy(
+            buffers,
+            boost::asio::buffer(inbox->data.data() + inbox->read_position,
+                                inbox->data.size() - inbox->read_position));
+        inbox->read_position += bytes_read;
+        inbox->total_bytes_read += bytes_read;
+        if (inbox->read_position == inbox->data.size()) {
+            inbox->data.clear();
+            inbox->read_position = 0;
+            if (inbox->data.capacity() >
+                MultiplexedStreamInbox::max_retained_capacity) {
+                inbox->data.shrink_to_fit();
+            }
+        }
+
+        return bytes_read;
+    }
+
+    template <typename MutableBufferSequence>
+    size_t read_some(const MutableBufferSequence& buffers) {
+        boost::system::error_code err;
+        const size_t bytes_read = read_some(buffers, err);
+        if (err) {
+            throw boost::system::system_error(err);
+        }
+
+        return bytes_read;
+    }
+
+    template <typename ConstBufferSequence>
+    size_t write_some(const ConstBufferSequence& buffers,
+                      boost::system::error_code& err);
+
+    /**
+     * Write a buffer as a single frame, sending `fds` along with it using
+     * `SCM_RIGHTS`. The other side can retrieve these file descriptors using
+     * `take_fds()` after reading that buffer. This is used to send bulk
+     * transfers, see `BulkTransferFds`.
+     *
+     * @throw boost::system::system_error If the stream or the connection has
+     *   been closed.
+     */
+    void write_with_fds(boost::asio::const_buffer buffer,
+                        std::span<const int> fds);
+
+    /**
+     * Move the file descriptors that were sent along with the data read from
+     * this stream so far to `fds`. The caller becomes responsible for closing
+     * them.
+     */
+    void take_fds(std::vector<int>& fds);
+
+    template <typename ConstBufferSequence>
+    size_t write_some(const ConstBufferSequence& buffers) {
+        boost::system::error_code err;
+        const size_t bytes_written = write_some(buffers, err);
+        if (err) {
+            throw boost::system::system_error(err);
+        }
+
+        return bytes_written;
+    }
+
+   private:
+    MultiplexedConnection* connection;
+    uint32_t id;
+    uint16_t channel;
+    std::shared_ptr<MultiplexedStreamInbox> inbox;
+};
+
+/**
+ * A single socket connection that carries any number of independent
+ * `MultiplexedStream`s. Every write on a stream gets sent as a frame tagged
+ * with that stream's ID, and a reader thread calling `run()` sorts the
+ * incoming frames into the right stream. This way all of the non-realtime
+ * traffic for a plugin instance can share a single connection, while still
+ * allowing any number of requests to be in flight at the same time and
+ * allowing the responses to those requests to arrive in any order.
+ *
+ * Streams belong to a channel, which takes the role of a dedicated socket.
+ * Every channel has a primary stream with a well known ID that both sides can
+ * use right away. Additional streams can be opened at any time to handle
+ * concurrent requests. This replaces connecting a new socket in
+ * `AdHocSocketHandler`, and the other side gets notified about these streams
+ * through the callback passed to `accept_streams()`.
+ */
+class MultiplexedConnection {
+   public:
+    /**
+     * Streams with IDs below this value are the primary streams for the
+     * channel with the same number.
+     */
+    static constexpr uint32_t first_dynamic_stream_id = 1 << 16;
+
+    /**
+     * Set up the connection. Like with `SocketHandler`, the connection won't
+     * be active until `connect()` gets called.
+     *
+     * @param io_context The IO context the socket should be bound to.
+     * @param endpoint The endpoint this socket should connect to or listen on.
+     * @param listen If `true`, start listening on the socket. This should be
+     *   set to `true` on the plugin side, and `false` on the Wine host side.
+     */
+    MultiplexedConnection(
+        boost::asio::io_context& io_context,
+        boost::asio::local::stream_protocol::endpoint endpoint,
+        bool listen);
+
+    /**
+     * Either accept the connection on the listening side or connect to the
+     * other side.
+     */
+    void connect();
+
+    /**
+     * Close the connection. `run()` will return, and every stream will be
+     * marked as closed so that any blocking reads get woken up.
+     */
+    void close() noexcept;
+
+    /**
+     * Read frames from the socket and distribute them over the streams until
+     * the connection gets closed. This should be run on a dedicated thread
+     * after calling `connect()`.
+     */
+    void run();
+
+    /**
+     * Get a handle to the primary stream for a channel. Each side should only
+     * do this once per channel.
+     */
+    MultiplexedStream primary_stream(uint16_t channel);
+
+    /**
+     * Open a new stream on a channel. The other side will receive a handle to
+     * this stream through the callback it passed to `accept_streams()` for
+     * that channel once the first data arrives.
+     *
+     * @throw boost::system::system_error If the connection has been closed.
+     */
+    MultiplexedStream open_stream(uint16_t channel);
+
+    /**
+     * Set the function that will be called on the reader thread with every new
+     * stream the other side opens on `channel`. Streams that were opened
+     * before this function got called are passed to the callback immediately.
+     * Passing an empty function stops accepting streams. After that call
+     * returns, the previous callback is guaranteed to no longer be running.
+     */
+    void accept_streams(uint16_t channel,
+                        std::function<void(MultiplexedStream)> callback);
+
+    /**
+     * Write a single frame. This is used by `MultiplexedStream::write_some()`.
+     * Writing the frame is atomic with respect to other frames. If `fds` is
+     * not empty, then those file descriptors are sent along with the frame's
+     * header using `SCM_RIGHTS`.
+     */
+    template <typename ConstBufferSequence>
+    size_t write_frame(uint32_t stream_id,
+                       uint16_t channel,
+                       uint16_t flags,
+                       const ConstBufferSequence& buffers,
+                       boost::system::error_code& err,
+                       std::span<const int> fds = {}) {
+        const MultiplexedFrameHeader header{
+            .stream_id = stream_id,
+            .channel = channel,
+            .flags = flags,
+            .size = boost::asio::buffer_size(buffers)};
+
+        std::lock_guard lock(write_mutex);
+        if (is_closed.load(std::memory_order_acquire)) {
+            err = boost::asio::error::broken_pipe;
+            return 0;
+        }
+
+        if (fds.empty()) [[likely]] {
+            boost::asio::write(
+                socket, boost::asio::buffer(&header, sizeof(header)), err);
+        } else {
+            try {
+                send_with_fds(socket.native_handle(), &header, sizeof(header),
+                              fds);
+            } catch (const boost::system::system_error& error) {
+                err = error.code();
+            }
+        }
+        if (err) {
+            return 0;
+        }
+
+        return boost::asio::write(socket, buffers, err);
+    }
+
+    /**
+     * Stop tracking a stream after its handle has been closed, and tell the
+     * other side about it if `send_close` is set.
+     */
+    void release_stream(uint32_t stream_id,
+                        uint16_t channel,
+                        bool send_close) noexcept;
+
+   private:
+    /**
+     * Find the inbox for a stream, or create a new one if it does not yet
+     * exist. `streams_mutex` should be locked when calling this.
+     */
+    std::shared_ptr<MultiplexedStreamInbox> get_or_create_inbox(
+        uint32_t stream_id);
+
+    boost::asio::local::stream_protocol::endpoint endpoint;
+    boost::asio::local::stream_protocol::socket socket;
+    std::optional<boost::asio::local::stream_protocol::acceptor> acceptor;
+
+    /**
+     * Frames consist of a header and a payload, so writes need to be
+     * serialized.
+     */
+    std::mutex write_mutex;
+    std::atomic_bool is_closed = false;
+
+    /**
+     * The streams that are currently open, indexed by their IDs.
+     */
+    std::unordered_map<uint32_t, std::shared_ptr<MultiplexedStreamInbox>>
+        streams;
+    std::mutex streams_mutex;
+
+    /**
+     * The callbacks passed to `accept_streams()`, indexed by channel.
+     */
+    std::unordered_map<uint16_t, std::function<void(MultiplexedStream)>>
+        stream_acceptors;
+    /**
+     * Streams the other side opened on a channel we're not yet accepting
+     * streams for.
+     */
+    std::unordered_map<uint16_t, std::vector<MultiplexedStream>>
+        pending_streams;
+    std::mutex acceptors_mutex;
+
+    /**
+     * The listening side uses even stream IDs and the connecting side uses odd
+     * stream IDs for the streams they open, so IDs never collide.
+     */
+    std::atomic_uint32_t next_stream_id;
+};
+
+template <typename ConstBufferSequence>
+size_t MultiplexedStream::write_some(const ConstBufferSequence& buffers,
+                                     boost::system::error_code& err) {
+    err = {};
+    if (!inbox) {
+        err = boost::asio::error::bad_descriptor;
+        return 0;
+    }
+    {
+        std::lock_guard lock(inbox->mutex);
+        if (inbox->released) {
+            err = boost::asio::error::bad_descriptor;
+            return 0;
+        }
+    }
+
+    return connection->write_frame(id, channel, 0, buffers, err);
+}
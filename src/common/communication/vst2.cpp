@@ -79,3 +79,11 @@ Vst2EventResult DefaultDataConverter::send_event(
     write_object(socket, event, buffer);
     return read_object<Vst2EventResult>(socket, buffer);
 }
+
+Vst2EventResult DefaultDataConverter::send_event(
+    MultiplexedStream& stream,
+    const Vst2Event& event,
+    SerializationBufferBase& buffer) const {
+    write_object(stream, event, buffer);
+    return read_object<Vst2EventResult>(stream, buffer);
+}
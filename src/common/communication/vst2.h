@@ -89,6 +89,17 @@ class DefaultDataConverter {
         boost::asio::local::stream_protocol::socket& socket,
         const Vst2Event& event,
         SerializationBufferBase& buffer) const;
+
+    /**
+     * The same as the above, but for sending the event over a stream on a
+     * multiplexed connection. Converters that override one of these functions
+     * should also override the other.
+     *
+     * @overload
+     */
+    virtual Vst2EventResult send_event(MultiplexedStream& stream,
+                                       const Vst2Event& event,
+                                       SerializationBufferBase& buffer) const;
 };
 
 /**
@@ -205,11 +216,10 @@ class Vst2EventHandler : public AdHocSocketHandler<Thread> {
         // from the socket, so we can override this for specific function calls
         // that potentially need to have their responses handled on the same
         // calling thread (i.e. mutual recursion).
-        const Vst2EventResult response = this->send(
-            [&](boost::asio::local::stream_protocol::socket& socket) {
-                return data_converter.send_event(socket, event,
-                                                 serialization_buffer());
-            });
+        const Vst2EventResult response = this->send([&](auto& socket) {
+            return data_converter.send_event(socket, event,
+                                             serialization_buffer());
+        });
 
         if (logging) {
             auto [logger, is_dispatch] = *logging;
@@ -248,39 +258,33 @@ class Vst2EventHandler : public AdHocSocketHandler<Thread> {
                         F&& callback) {
         // Reading, processing, and writing back event data from the sockets
         // works in the same way regardless of which socket we're using
-        const auto process_event =
-            [&](boost::asio::local::stream_protocol::socket& socket,
-                bool on_main_thread) {
-                SerializationBufferBase& buffer = serialization_buffer();
-
-                auto event = read_object<Vst2Event>(socket, buffer);
-                if (logging) {
-                    auto [logger, is_dispatch] = *logging;
-                    logger.log_event(is_dispatch, event.opcode, event.index,
-                                     event.value, event.payload, event.option,
-                                     event.value_payload);
-                }
-
-                Vst2EventResult response = callback(event, on_main_thread);
-                if (logging) {
-                    auto [logger, is_dispatch] = *logging;
-                    logger.log_event_response(
-                        is_dispatch, event.opcode, response.return_value,
-                        response.payload, response.value_payload);
-                }
-
-                write_object(socket, response, buffer);
-            };
+        const auto process_event = [&](auto& socket, bool on_main_thread) {
+            SerializationBufferBase& buffer = serialization_buffer();
+
+            auto event = read_object<Vst2Event>(socket, buffer);
+            if (logging) {
+                auto [logger, is_dispatch] = *logging;
+                logger.log_event(is_dispatch, event.opcode, event.index,
+                                 event.value, event.payload, event.option,
+                                 event.value_payload);
+            }
+
+            Vst2EventResult response = callback(event, on_main_thread);
+            if (logging) {
+                auto [logger, is_dispatch] = *logging;
+                logger.log_event_response(
+                    is_dispatch, event.opcode, response.return_value,
+                    response.payload, response.value_payload);
+            }
+
+            write_object(socket, response, buffer);
+        };
 
         this->receive_multi(
             logging ? std::optional(std::ref(logging->first.logger))
                     : std::nullopt,
-            [&](boost::asio::local::stream_protocol::socket& socket) {
-                process_event(socket, true);
-            },
-            [&](boost::asio::local::stream_protocol::socket& socket) {
-                process_event(socket, false);
-            });
+            [&](auto& socket) { process_event(socket, true); },
+            [&](auto& socket) { process_event(socket, false); });
     }
 
    private:
@@ -338,38 +342,82 @@ class Vst2Sockets final : public Sockets {
      * @param listen If `true`, start listening on the sockets. Incoming
      *   connections will be accepted when `connect()` gets called. This should
      *   be set to `true` on the plugin side, and `false` on the Wine host side.
+     * @param multiplexed Whether the `dispatch()`, `audioMaster()` and
+     *   parameter sockets should be replaced by streams on a single
+     *   `MultiplexedConnection`. This is only read on the listening side. The
+     *   Wine host side will learn about this during `connect()`.
      *
      * @see Vst2Sockets::connect
      */
     Vst2Sockets(boost::asio::io_context& io_context,
                 const boost::filesystem::path& endpoint_base_dir,
-                bool listen)
+                bool listen,
+                bool multiplexed = false)
         : Sockets(endpoint_base_dir),
+          io_context(io_context),
+          listen(listen),
           host_vst_dispatch(io_context,
                             (base_dir / "host_vst_dispatch.sock").string(),
-                            listen),
+                            listen && !multiplexed),
           vst_host_callback(io_context,
                             (base_dir / "vst_host_callback.sock").string(),
-                            listen),
+                            listen && !multiplexed),
           host_vst_parameters(io_context,
                               (base_dir / "host_vst_parameters.sock").string(),
-                              listen),
+                              listen && !multiplexed),
           host_vst_process_replacing(
               io_context,
               (base_dir / "host_vst_process_replacing.sock").string(),
               listen),
           host_vst_control(io_context,
                            (base_dir / "host_vst_control.sock").string(),
-                           listen) {}
+                           listen) {
+        if (listen && multiplexed) {
+            multiplexed_connection.emplace(
+                io_context, (base_dir / "multiplexed.sock").string(), true);
+        }
+    }
 
     ~Vst2Sockets() noexcept override { close(); }
 
+    /**
+     * Connect the sockets. The control socket is connected first, and the
+     * listening side then sends a `SocketsHandshake` over it so the Wine host
+     * knows whether it should connect to the dedicated sockets or to a single
+     * multiplexed connection.
+     */
     void connect() override {
-        host_vst_dispatch.connect();
-        vst_host_callback.connect();
-        host_vst_parameters.connect();
-        host_vst_process_replacing.connect();
         host_vst_control.connect();
+        if (listen) {
+            host_vst_control.send(SocketsHandshake{
+                .multiplexed = multiplexed_connection.has_value()});
+        } else {
+            const auto handshake =
+                host_vst_control.receive_single<SocketsHandshake>();
+            if (handshake.multiplexed) {
+                multiplexed_connection.emplace(
+                    io_context, (base_dir / "multiplexed.sock").string(),
+                    false);
+            }
+        }
+
+        if (multiplexed_connection) {
+            multiplexed_connection->connect();
+            multiplexed_reader =
+                Thread([&]() { multiplexed_connection->run(); });
+
+            host_vst_dispatch.connect_multiplexed(*multiplexed_connection,
+                                                  dispatch_channel);
+            vst_host_callback.connect_multiplexed(*multiplexed_connection,
+                                                  host_callback_channel);
+            host_vst_parameters.connect_multiplexed(*multiplexed_connection,
+                                                    parameters_channel);
+        } else {
+            host_vst_dispatch.connect();
+            vst_host_callback.connect();
+            host_vst_parameters.connect();
+        }
+        host_vst_process_replacing.connect();
     }
 
     void close() override {
@@ -380,8 +428,39 @@ class Vst2Sockets final : public Sockets {
         host_vst_parameters.close();
         host_vst_process_replacing.close();
         host_vst_control.close();
+        if (multiplexed_connection) {
+            multiplexed_connection->close();
+        }
     }
 
+   private:
+    boost::asio::io_context& io_context;
+    bool listen;
+
+    /**
+     * The channels on `multiplexed_connection` used in place of the dedicated
+     * sockets.
+     */
+    static constexpr uint16_t dispatch_channel = 1;
+    static constexpr uint16_t host_callback_channel = 2;
+    static constexpr uint16_t parameters_channel = 3;
+
+   public:
+    /**
+     * When multiplexing is enabled, the `dispatch()`, `audioMaster()` and
+     * parameter traffic all share this single connection instead of using
+     * dedicated sockets. Any additional concurrent requests will open a new
+     * stream on this connection instead of connecting a new socket. Audio
+     * processing still uses its own socket (and usually shared memory), so the
+     * realtime path never has to share a connection with other traffic.
+     */
+    std::optional<MultiplexedConnection> multiplexed_connection;
+    /**
+     * Reads the frames from `multiplexed_connection` and distributes them over
+     * the streams. Only active when multiplexing is enabled.
+     */
+    Thread multiplexed_reader;
+
     // The naming convention for these sockets is `<from>_<to>_<event>`. For
     // instance the socket named `host_vst_dispatch` forwards
     // `AEffect.dispatch()` calls from the native VST host to the Windows VST
@@ -495,6 +574,11 @@ Vst2EventResult passthrough_event(AEffect* plugin,
             return nullptr;
         },
         [&](const WantsChunkBuffer&) -> void* { return string_buffer.data(); },
+        [](const WantsParameterStrings&) -> void* {
+            // This is handled by the Wine plugin host in `Vst2Bridge::run()`
+            // and never reaches the plugin
+            return nullptr;
+        },
         [](VstIOProperties& props) -> void* { return &props; },
         [](VstMidiKeyName& key_name) -> void* { return &key_name; },
         [](VstParameterProperties& props) -> void* { return &props; },
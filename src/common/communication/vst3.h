@@ -138,7 +138,7 @@ class Vst3MessageHandler : public AdHocSocketHandler<Thread> {
         // messages from arriving out of order. `AdHocSocketHandler::send()`
         // will either use a long-living primary socket, or if that's currently
         // in use it will spawn a new socket for us.
-        this->send([&](boost::asio::local::stream_protocol::socket& socket) {
+        this->send([&](auto& socket) {
             write_object(socket, Request(object), buffer);
             read_object<TResponse>(socket, response_object, buffer);
         });
@@ -204,65 +204,64 @@ class Vst3MessageHandler : public AdHocSocketHandler<Thread> {
         // Reading, processing, and writing back the response for the requests
         // we receive works in the same way regardless of which socket we're
         // using
-        const auto process_message =
-            [&](boost::asio::local::stream_protocol::socket& socket) {
-                // The persistent buffer is only used when the
-                // `persistent_buffers` template value is enabled, but we'll
-                // always use the thread local persistent object. Because of
-                // loading and storing state the buffer can grow a lot in size
-                // which is why we might not want to reuse that for tasks that
-                // don't need to be realtime safe, but the object has a fixed
-                // size. Normally reusing this object doesn't make much sense
-                // since it's a variant and it will likely have to be recreated
-                // every time, but on the audio processor side we store the
-                // actual variant within an object and we then use some hackery
-                // to always keep the large process data object in memory.
-                thread_local SerializationBuffer<256> persistent_buffer{};
-                thread_local Request persistent_object;
-
-                auto& request =
-                    persistent_buffers
-                        ? read_object<Request>(socket, persistent_object,
-                                               persistent_buffer)
-                        : read_object<Request>(socket, persistent_object);
-
-                // See the comment in `receive_into()` for more information
-                bool should_log_response = false;
-                if (logging) {
-                    should_log_response = std::visit(
-                        [&](const auto& object) {
-                            auto [logger, is_host_vst] = *logging;
-                            return logger.log_request(is_host_vst, object);
-                        },
-                        // In the case of `AudioProcessorRequest`, we need to
-                        // actually fetch the variant field since our object
-                        // also contains a persistent object to store process
-                        // data into so we can prevent allocations during audio
-                        // processing
-                        get_request_variant(request));
-                }
-
-                // We do the visiting here using a templated lambda. This way we
-                // always know for sure that the function returns the correct
-                // type, and we can scrap a lot of boilerplate elsewhere.
-                std::visit(
-                    [&]<typename T>(T object) {
-                        typename T::Response response = callback(object);
-
-                        if (should_log_response) {
-                            auto [logger, is_host_vst] = *logging;
-                            logger.log_response(!is_host_vst, response);
-                        }
-
-                        if constexpr (persistent_buffers) {
-                            write_object(socket, response, persistent_buffer);
-                        } else {
-                            write_object(socket, response);
-                        }
+        const auto process_message = [&](auto& socket) {
+            // The persistent buffer is only used when the
+            // `persistent_buffers` template value is enabled, but we'll
+            // always use the thread local persistent object. Because of
+            // loading and storing state the buffer can grow a lot in size
+            // which is why we might not want to reuse that for tasks that
+            // don't need to be realtime safe, but the object has a fixed
+            // size. Normally reusing this object doesn't make much sense
+            // since it's a variant and it will likely have to be recreated
+            // every time, but on the audio processor side we store the
+            // actual variant within an object and we then use some hackery
+            // to always keep the large process data object in memory.
+            thread_local SerializationBuffer<256> persistent_buffer{};
+            thread_local Request persistent_object;
+
+            auto& request =
+                persistent_buffers
+                    ? read_object<Request>(socket, persistent_object,
+                                           persistent_buffer)
+                    : read_object<Request>(socket, persistent_object);
+
+            // See the comment in `receive_into()` for more information
+            bool should_log_response = false;
+            if (logging) {
+                should_log_response = std::visit(
+                    [&](const auto& object) {
+                        auto [logger, is_host_vst] = *logging;
+                        return logger.log_request(is_host_vst, object);
                     },
-                    // See above
+                    // In the case of `AudioProcessorRequest`, we need to
+                    // actually fetch the variant field since our object
+                    // also contains a persistent object to store process
+                    // data into so we can prevent allocations during audio
+                    // processing
                     get_request_variant(request));
-            };
+            }
+
+            // We do the visiting here using a templated lambda. This way we
+            // always know for sure that the function returns the correct
+            // type, and we can scrap a lot of boilerplate elsewhere.
+            std::visit(
+                [&]<typename T>(T object) {
+                    typename T::Response response = callback(object);
+
+                    if (should_log_response) {
+                        auto [logger, is_host_vst] = *logging;
+                        logger.log_response(!is_host_vst, response);
+                    }
+
+                    if constexpr (persistent_buffers) {
+                        write_object(socket, response, persistent_buffer);
+                    } else {
+                        write_object(socket, response);
+                    }
+                },
+                // See above
+                get_request_variant(request));
+        };
 
         this->receive_multi(logging
                                 ? std::optional(std::ref(logging->first.logger))
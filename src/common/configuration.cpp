@@ -86,6 +86,31 @@ Configuration::Configuration(const fs::path& config_path,
                 } else {
                     invalid_options.push_back(key);
                 }
+            } else if (key == "audio_pipelining") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    audio_pipelining = parsed_value->get();
+                } else {
+                    invalid_options.push_back(key);
+                }
+            } else if (key == "audio_spin_us") {
+                if (const auto parsed_value = value.as_integer();
+                    parsed_value && parsed_value->get() >= 0) {
+                    audio_spin_us = static_cast<uint32_t>(parsed_value->get());
+                } else {
+                    invalid_options.push_back(key);
+                }
+            } else if (key == "cache_plugin_metadata") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    cache_plugin_metadata = parsed_value->get();
+                } else {
+                    invalid_options.push_back(key);
+                }
+            } else if (key == "cache_state") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    cache_state = parsed_value->get();
+                } else {
+                    invalid_options.push_back(key);
+                }
             } else if (key == "disable_pipes") {
                 // This option can be either enabled or disable with a boolean,
                 // or it can be set to an absolute path
@@ -136,6 +161,31 @@ Configuration::Configuration(const fs::path& config_path,
                 } else {
                     invalid_options.push_back(key);
                 }
+            } else if (key == "host_pool_size") {
+                if (const auto parsed_value = value.as_integer();
+                    parsed_value && parsed_value->get() >= 0) {
+                    host_pool_size = static_cast<uint32_t>(parsed_value->get());
+                } else {
+                    invalid_options.push_back(key);
+                }
+            } else if (key == "vst2_cache_strings") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst2_cache_strings = parsed_value->get();
+                } else {
+                    invalid_options.push_back(key);
+                }
+            } else if (key == "vst2_multiplex_sockets") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst2_multiplex_sockets = parsed_value->get();
+                } else {
+                    invalid_options.push_back(key);
+                }
+            } else if (key == "vst2_shared_parameters") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst2_shared_parameters = parsed_value->get();
+                } else {
+                    invalid_options.push_back(key);
+                }
             } else if (key == "vst3_no_scaling") {
                 if (const auto parsed_value = value.as_boolean()) {
                     vst3_no_scaling = parsed_value->get();
@@ -148,6 +198,12 @@ Configuration::Configuration(const fs::path& config_path,
                 } else {
                     invalid_options.push_back(key);
                 }
+            } else if (key == "vst3_skip_silence") {
+                if (const auto parsed_value = value.as_boolean()) {
+                    vst3_skip_silence = parsed_value->get();
+                } else {
+                    invalid_options.push_back(key);
+                }
             } else {
                 unknown_options.push_back(key);
             }
@@ -162,3 +218,7 @@ std::chrono::steady_clock::duration Configuration::event_loop_interval()
     return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
         std::chrono::milliseconds(1000) / frame_rate.value_or(60.0));
 }
+
+std::chrono::microseconds Configuration::audio_spin_duration() const noexcept {
+    return std::chrono::microseconds(audio_spin_us.value_or(0));
+}
@@ -81,6 +81,60 @@ class Configuration {
      */
     std::optional<std::string> group;
 
+    /**
+     * If enabled, the native plugin will return the results from the previous
+     * processing cycle to the host while the Wine plugin host is still
+     * processing the current block. This lets the host's audio thread do other
+     * work while a heavy plugin is processing audio, at the cost of exactly one
+     * maximum block size of added latency which we'll report to the host
+     * through `AEffect::initialDelay` or
+     * `IAudioProcessor::getLatencySamples()`.
+     */
+    bool audio_pipelining = false;
+
+    /**
+     * If set to a nonzero value, then both the native plugin and the Wine
+     * plugin host will busy wait for up to this many microseconds when waiting
+     * on the other side during audio processing before going to sleep. At
+     * small buffer sizes this avoids the scheduler wakeup latency entirely, at
+     * the cost of burning CPU time. This only makes sense on systems with
+     * dedicated cores for audio processing, so it's disabled by default.
+     *
+     * @relates audio_spin_duration
+     */
+    std::optional<uint32_t> audio_spin_us;
+
+    /**
+     * If enabled, the information hosts query while scanning plugins gets
+     * stored in a persistent cache, keyed by the Windows plugin's path, size
+     * and modification time along with yabridge's version. When loading a
+     * plugin with a cache entry, yabridge answers those queries from the cache
+     * and only starts the Wine plugin host once the host actually starts using
+     * the plugin. This is disabled by default because plugins that change
+     * their metadata based on things other than the plugin's library, like a
+     * parameter count that depends on some settings file, would otherwise
+     * report outdated information.
+     *
+     * @see PluginMetadataCache
+     */
+    bool cache_plugin_metadata = false;
+
+    /**
+     * If enabled, the native plugin keeps a copy of the last state it fetched
+     * from the plugin through `effGetChunk()` or `getState()`, and it will
+     * return that copy again when the host asks for the plugin's state and
+     * nothing could have changed in the meantime. Hosts will often request the
+     * state of every plugin when creating undo points or when autosaving, so
+     * this saves a lot of round trips in large projects. The cache is
+     * invalidated whenever parameters change, when the host loads a new state
+     * or program, when the plugin notifies the host about changes, and while
+     * the plugin's editor is open. Plugins could still change their state in
+     * other ways, so this is disabled by default.
+     *
+     * @see StateCache
+     */
+    bool cache_state = false;
+
     /**
      * If enabled, we'll redirect the plugin's STDOUT and STDERR streams to this
      * file instead of using pipes to intersperse it with yabridge's other
@@ -144,6 +198,66 @@ class Configuration {
      */
     bool hide_daw = false;
 
+    /**
+     * If set to a nonzero value, then individually hosted plugins will keep
+     * this many idle Wine plugin host processes around for every Wine prefix
+     * and architecture. These processes have already gone through Wine's
+     * startup sequence and they are waiting for a `HostRequest`, so when a
+     * plugin gets loaded it only has to wait for the Windows plugin's library
+     * to be loaded. Every time a plugin takes one of these processes, a new
+     * one will be started in the background to take its place. This has no
+     * effect when using plugin groups.
+     *
+     * @see PooledHost
+     */
+    std::optional<uint32_t> host_pool_size;
+
+    /**
+     * If enabled, the native VST2 plugin fetches all of the plugin's parameter
+     * names, labels, and display strings along with its program names in a
+     * single request, and it then answers the host's `effGetParamName()`,
+     * `effGetParamLabel()`, `effGetParamDisplay()`, and
+     * `effGetProgramNameIndexed()` queries from that cache. Changing a
+     * parameter only causes that parameter's display string to be fetched
+     * again, and loading a new program, state, or the plugin notifying the
+     * host about changes causes the cache to be refreshed in bulk. Plugins
+     * that change these strings without telling the host would show stale
+     * strings, so this is disabled by default.
+     *
+     * @see ParameterStringCache
+     */
+    bool vst2_cache_strings = false;
+
+    /**
+     * If enabled, the `dispatch()`, `audioMaster()` and parameter sockets for a
+     * VST2 plugin instance are replaced by streams on a single multiplexed
+     * connection. Concurrent requests then open additional streams on that
+     * connection instead of connecting new sockets. This reduces the number of
+     * file descriptors needed for each instance, which adds up in projects
+     * with hundreds of bridged plugins. It does not reduce the number of
+     * threads: the connection's reader thread takes the place of the socket
+     * acceptor threads, but every channel still runs its own receive loop and
+     * every concurrent request still gets its own handler thread. Audio
+     * processing is not affected by this option.
+     *
+     * @see MultiplexedConnection
+     */
+    bool vst2_multiplex_sockets = false;
+
+    /**
+     * If enabled, a VST2 plugin's parameter values are mirrored in shared
+     * memory while the plugin is processing audio. The native plugin then
+     * answers `getParameter()` calls from that table, and `setParameter()`
+     * calls from the host's audio thread are queued and applied right before
+     * the next block gets processed. Keeping the table up to date means
+     * reading up to 64 parameters from the plugin after every processing
+     * cycle, and queued values only reach the plugin at the start of the next
+     * cycle, so this is disabled by default.
+     *
+     * @see ParameterShmTable
+     */
+    bool vst2_shared_parameters = false;
+
     /**
      * Disable `IPlugViewContentScaleSupport::setContentScaleFactor()`. Wine
      * does not properly implement fractional DPI scaling, so without this
@@ -164,6 +278,18 @@ class Configuration {
      */
     bool vst3_prefer_32bit = false;
 
+    /**
+     * If enabled, we'll skip the round trip to the Wine plugin host for VST3
+     * plugins that report a tail length of zero when their inputs are silent,
+     * there are no incoming parameter changes or events, and the plugin's
+     * output was already silent during the last processing cycle. We'll then
+     * output silence directly. This can save a lot of CPU time in large
+     * projects, but plugins that generate sound on their own without any
+     * input or that report the wrong tail length would get cut off, so this is
+     * disabled by default.
+     */
+    bool vst3_skip_silence = false;
+
     /**
      * The path to the configuration file that was parsed.
      */
@@ -193,11 +319,23 @@ class Configuration {
      */
     std::chrono::steady_clock::duration event_loop_interval() const noexcept;
 
+    /**
+     * The maximum duration to spin for before blocking while waiting for the
+     * other side during audio processing. This is based on `audio_spin_us`, and
+     * it is zero if that option is not set.
+     */
+    std::chrono::microseconds audio_spin_duration() const noexcept;
+
     template <typename S>
     void serialize(S& s) {
         s.ext(group, bitsery::ext::InPlaceOptional(),
               [](S& s, auto& v) { s.text1b(v, 4096); });
 
+        s.value1b(audio_pipelining);
+        s.ext(audio_spin_us, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.value4b(v); });
+        s.value1b(cache_plugin_metadata);
+        s.value1b(cache_state);
         s.ext(disable_pipes, bitsery::ext::InPlaceOptional(),
               [](S& s, auto& v) { s.ext(v, bitsery::ext::BoostPath{}); });
         s.value1b(editor_coordinate_hack);
@@ -206,8 +344,14 @@ class Configuration {
         s.ext(frame_rate, bitsery::ext::InPlaceOptional(),
               [](S& s, auto& v) { s.value4b(v); });
         s.value1b(hide_daw);
+        s.ext(host_pool_size, bitsery::ext::InPlaceOptional(),
+              [](S& s, auto& v) { s.value4b(v); });
+        s.value1b(vst2_cache_strings);
+        s.value1b(vst2_multiplex_sockets);
+        s.value1b(vst2_shared_parameters);
         s.value1b(vst3_no_scaling);
         s.value1b(vst3_prefer_32bit);
+        s.value1b(vst3_skip_silence);
 
         s.ext(matched_file, bitsery::ext::InPlaceOptional(),
               [](S& s, auto& v) { s.ext(v, bitsery::ext::BoostPath{}); });
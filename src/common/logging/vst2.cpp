@@ -168,6 +168,9 @@ std::optional<std::string> opcode_to_string(bool is_dispatch, int opcode) {
             case effSetProcessPrecision:
                 return "effSetProcessPrecision";
                 break;
+            case effYabridgeGetParameterStrings:
+                return "effYabridgeGetParameterStrings";
+                break;
             default:
                 return std::nullopt;
                 break;
@@ -341,10 +344,13 @@ void Vst2Logger::log_get_parameter(int index) {
     }
 }
 
-void Vst2Logger::log_get_parameter_response(float value) {
+void Vst2Logger::log_get_parameter_response(float value, bool from_cache) {
     if (logger.verbosity >= Logger::Verbosity::most_events) [[unlikely]] {
         std::ostringstream message;
         message << "   getParameter() :: " << value;
+        if (from_cache) {
+            message << " (from cache)";
+        }
 
         log(message.str());
     }
@@ -359,9 +365,13 @@ void Vst2Logger::log_set_parameter(int index, float value) {
     }
 }
 
-void Vst2Logger::log_set_parameter_response() {
+void Vst2Logger::log_set_parameter_response(bool queued) {
     if (logger.verbosity >= Logger::Verbosity::most_events) [[unlikely]] {
-        log("   setParameter() :: OK");
+        if (queued) {
+            log("   setParameter() :: OK (queued)");
+        } else {
+            log("   setParameter() :: OK");
+        }
     }
 }
 
@@ -450,6 +460,17 @@ void Vst2Logger::log_event(
                 [&](const WantsChunkBuffer&) {
                     message << "<writable_buffer>";
                 },
+                [&](const WantsParameterStrings& request) {
+                    if (!request.values_only) {
+                        message << "<all parameter and program strings>";
+                    } else if (request.parameters.empty()) {
+                        message << "<labels and display strings>";
+                    } else {
+                        message << "<labels and display strings for "
+                                << request.parameters.size()
+                                << " parameters>";
+                    }
+                },
                 [&](const WantsVstRect&) { message << "VstRect**"; },
                 [&](const WantsVstTimeInfo&) { message << "nullptr"; },
                 [&](const WantsString&) { message << "<writable_string>"; }},
@@ -537,6 +558,11 @@ void Vst2Logger::log_event_response(
                             << "tempo = " << info.tempo << " bpm"
                             << ", quarter_notes = " << info.ppqPos
                             << ", samples = " << info.samplePos << ">";
+                },
+                [&](const Vst2ParameterStrings& strings) {
+                    message << ", <strings for " << strings.displays.size()
+                            << " parameters and "
+                            << strings.program_names.size() << " programs>";
                 }},
             payload);
 
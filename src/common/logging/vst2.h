@@ -49,9 +49,9 @@ class Vst2Logger {
     // The following functions are for logging specific events, they are only
     // enabled for verbosity levels higher than 1 (i.e. `Verbosity::events`)
     void log_get_parameter(int index);
-    void log_get_parameter_response(float vlaue);
+    void log_get_parameter_response(float vlaue, bool from_cache = false);
     void log_set_parameter(int index, float value);
-    void log_set_parameter_response();
+    void log_set_parameter_response(bool queued = false);
     // If `is_dispatch` is `true`, then use opcode names from the plugin's
     // dispatch function. Otherwise use names for the host callback function
     // opcodes.
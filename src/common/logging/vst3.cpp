@@ -46,7 +46,11 @@ std::string format_bstream(const YaBStream& stream) {
         formatted << "for \"" << VST3::StringConvert::convert(*stream.file_name)
                   << "\" ";
     }
-    formatted << "containing " << stream.size() << " bytes>";
+    formatted << "containing " << stream.size() << " bytes";
+    if (stream.stream_id) {
+        formatted << ", streamed";
+    }
+    formatted << ">";
 
     return formatted.str();
 }
@@ -250,6 +254,16 @@ bool Vst3Logger::log_request(
     });
 }
 
+bool Vst3Logger::log_request(
+    bool is_host_vst,
+    const YaEditController::GetAllParameterInfo& request) {
+    return log_request_base(is_host_vst, [&](auto& message) {
+        message << request.instance_id
+                << ": IEditController::getParameterCount() and "
+                   "IEditController::getParameterInfo() for all parameters";
+    });
+}
+
 bool Vst3Logger::log_request(
     bool is_host_vst,
     const YaEditController::GetParamStringByValue& request) {
@@ -1174,6 +1188,28 @@ bool Vst3Logger::log_request(bool is_host_vst, const WantsConfiguration&) {
     });
 }
 
+bool Vst3Logger::log_request(bool is_host_vst,
+                             const YaBStream::Read& request) {
+    return log_request_base(
+        is_host_vst, Logger::Verbosity::all_events, [&](auto& message) {
+            message << request.owner_instance_id
+                    << ": IBStream::read(<stream " << request.stream_id
+                    << ">, position = " << request.position
+                    << ", numBytes = " << request.size << ")";
+        });
+}
+
+bool Vst3Logger::log_request(bool is_host_vst,
+                             const YaBStream::Write& request) {
+    return log_request_base(
+        is_host_vst, Logger::Verbosity::all_events, [&](auto& message) {
+            message << request.owner_instance_id
+                    << ": IBStream::write(<stream " << request.stream_id
+                    << ">, position = " << request.position
+                    << ", numBytes = " << request.data.size() << ")";
+        });
+}
+
 bool Vst3Logger::log_request(bool is_host_vst,
                              const YaComponentHandler::BeginEdit& request) {
     return log_request_base(is_host_vst, [&](auto& message) {
@@ -1502,6 +1538,15 @@ void Vst3Logger::log_response(
     });
 }
 
+void Vst3Logger::log_response(
+    bool is_host_vst,
+    const YaEditController::GetAllParameterInfoResponse& response) {
+    log_response_base(is_host_vst, [&](auto& message) {
+        message << "<" << response.parameter_count << " parameters, "
+                << response.parameter_infos.size() << " ParameterInfo objects>";
+    });
+}
+
 void Vst3Logger::log_response(
     bool is_host_vst,
     const YaEditController::GetParamStringByValueResponse& response) {
@@ -1949,3 +1994,13 @@ void Vst3Logger::log_response(bool is_host_vst,
         }
     });
 }
+
+void Vst3Logger::log_response(bool is_host_vst,
+                              const YaBStream::ReadResponse& response) {
+    log_response_base(is_host_vst, [&](auto& message) {
+        message << response.result.string();
+        if (response.result == Steinberg::kResultOk) {
+            message << ", <" << response.data.size() << " bytes>";
+        }
+    });
+}
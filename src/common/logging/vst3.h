@@ -86,6 +86,8 @@ class Vst3Logger {
                      const YaEditController::GetParameterCount&);
     bool log_request(bool is_host_vst,
                      const YaEditController::GetParameterInfo&);
+    bool log_request(bool is_host_vst,
+                     const YaEditController::GetAllParameterInfo&);
     bool log_request(bool is_host_vst,
                      const YaEditController::GetParamStringByValue&);
     bool log_request(bool is_host_vst,
@@ -208,6 +210,8 @@ class Vst3Logger {
 
     bool log_request(bool is_host_vst, const Vst3ContextMenuProxy::Destruct&);
     bool log_request(bool is_host_vst, const WantsConfiguration&);
+    bool log_request(bool is_host_vst, const YaBStream::Read&);
+    bool log_request(bool is_host_vst, const YaBStream::Write&);
     bool log_request(bool is_host_vst, const YaComponentHandler::BeginEdit&);
     bool log_request(bool is_host_vst, const YaComponentHandler::PerformEdit&);
     bool log_request(bool is_host_vst, const YaComponentHandler::EndEdit&);
@@ -259,6 +263,8 @@ class Vst3Logger {
     void log_response(bool is_host_vst,
                       const YaEditController::GetParameterInfoResponse&,
                       bool from_cache = false);
+    void log_response(bool is_host_vst,
+                      const YaEditController::GetAllParameterInfoResponse&);
     void log_response(bool is_host_vst,
                       const YaEditController::GetParamStringByValueResponse&);
     void log_response(bool is_host_vst,
@@ -331,6 +337,7 @@ class Vst3Logger {
     void log_response(bool is_host_vst,
                       const YaHostApplication::GetNameResponse&);
     void log_response(bool is_host_vst, const YaProgress::StartResponse&);
+    void log_response(bool is_host_vst, const YaBStream::ReadResponse&);
 
     template <typename T>
     void log_response(bool is_host_vst,
@@ -0,0 +1,177 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "metadata-cache.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <boost/process/environment.hpp>
+
+// Generated inside of the build directory
+#include <version.h>
+
+#include "utils.h"
+
+namespace bp = boost::process;
+namespace fs = boost::filesystem;
+
+/**
+ * Return the directory metadata cache entries are stored in. This respects
+ * `$XDG_CACHE_HOME`, and falls back to `~/.cache`.
+ */
+static fs::path get_metadata_cache_directory() {
+    const bp::environment environment = boost::this_process::environment();
+    if (auto xdg_cache_home = environment.find("XDG_CACHE_HOME");
+        xdg_cache_home != environment.end()) {
+        return fs::path(xdg_cache_home->to_string()) / "yabridge" /
+               "plugin-metadata";
+    } else if (auto home_directory = environment.find("HOME");
+               home_directory != environment.end()) {
+        return fs::path(home_directory->to_string()) / ".cache" / "yabridge" /
+               "plugin-metadata";
+    } else {
+        return get_temporary_directory() / "plugin-metadata";
+    }
+}
+
+/**
+ * Hash a plugin path for use in a cache file name. This uses 64-bit FNV-1a
+ * instead of `std::hash` because the 32-bit `yabridge-scan-32.exe` needs to
+ * come up with the same file names as the 64-bit plugin libraries.
+ */
+static uint64_t hash_plugin_path(const std::string& plugin_path) noexcept {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (const char& c : plugin_path) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
+
+PluginMetadataCache::PluginMetadataCache() noexcept {}
+
+PluginMetadataCache::PluginMetadataCache(PluginType plugin_type,
+                                         const fs::path& plugin_path,
+                                         const fs::path& library_path) {
+    // For VST3 bundles the Windows plugin path points to a directory, so we'll
+    // look at the actual library inside of it instead
+    boost::system::error_code err;
+    const uintmax_t library_size = fs::file_size(library_path, err);
+    if (err) {
+        return;
+    }
+    const std::time_t modification_time =
+        fs::last_write_time(library_path, err);
+    if (err) {
+        return;
+    }
+
+    key = PluginMetadataKey{
+        .yabridge_version = yabridge_git_version,
+        .plugin_type = plugin_type,
+        .plugin_path = plugin_path.string(),
+        .library_size = static_cast<uint64_t>(library_size),
+        .library_modification_time = static_cast<int64_t>(modification_time)};
+
+    // The file name only has to be unique, the key stored in the file is what
+    // determines whether an entry is valid
+    std::ostringstream file_name;
+    file_name << plugin_type_to_string(plugin_type) << "-" << std::hex
+              << std::setfill('0') << std::setw(16)
+              << hash_plugin_path(key->plugin_path) << ".bin";
+    cache_file = get_metadata_cache_directory() / file_name.str();
+}
+
+bool PluginMetadataCache::contains_entry() const {
+    if (!key) {
+        return false;
+    }
+
+    const std::optional<std::vector<uint8_t>> buffer = read_file();
+    if (!buffer) {
+        return false;
+    }
+
+    Deserializer deserializer(buffer->begin(), buffer->size());
+
+    return read_matching_key(deserializer);
+}
+
+bool PluginMetadataCache::read_matching_key(Deserializer& deserializer) const {
+    PluginMetadataKey stored_key{};
+    deserializer.object(stored_key);
+
+    return deserializer.adapter().error() == bitsery::ReaderError::NoError &&
+           stored_key == *key;
+}
+
+std::optional<std::vector<uint8_t>> PluginMetadataCache::read_file() const {
+    std::ifstream file(cache_file.string(), std::ios::binary);
+    if (!file) {
+        return std::nullopt;
+    }
+
+    std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(file)),
+                                std::istreambuf_iterator<char>());
+    if (file.bad()) {
+        return std::nullopt;
+    }
+
+    return buffer;
+}
+
+void PluginMetadataCache::write_file(const std::vector<uint8_t>& buffer,
+                                     Logger& logger) const {
+    // Other instances of this plugin may be reading the file at the same time,
+    // so we'll write to a temporary file first and then atomically move it
+    // into place
+    boost::system::error_code err;
+    fs::create_directories(cache_file.parent_path(), err);
+    if (err) {
+        logger.log("WARNING: Could not create '" +
+                   cache_file.parent_path().string() + "': " + err.message());
+        return;
+    }
+
+    const fs::path temporary_file =
+        cache_file.parent_path() /
+        fs::unique_path(cache_file.filename().string() + "-%%%%%%%%.tmp");
+    {
+        std::ofstream file(temporary_file.string(),
+                           std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(buffer.data()),
+                   static_cast<std::streamsize>(buffer.size()));
+        if (!file) {
+            logger.log("WARNING: Could not write the plugin metadata cache "
+                       "file '" +
+                       temporary_file.string() + "'");
+            file.close();
+            fs::remove(temporary_file, err);
+            return;
+        }
+    }
+
+    fs::rename(temporary_file, cache_file, err);
+    if (err) {
+        logger.log("WARNING: Could not write the plugin metadata cache file '" +
+                   cache_file.string() + "': " + err.message());
+        fs::remove(temporary_file, err);
+    }
+}
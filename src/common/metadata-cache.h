@@ -0,0 +1,191 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include <bitsery/adapter/buffer.h>
+#include <bitsery/bitsery.h>
+#include <bitsery/traits/string.h>
+#include <bitsery/traits/vector.h>
+
+#ifdef __WINE__
+#include "../wine-host/boost-fix.h"
+#endif
+#include <boost/filesystem.hpp>
+
+#include "logging/common.h"
+#include "plugins.h"
+
+/**
+ * The bitsery config used for metadata cache files. Unlike with our sockets,
+ * these files can be modified or truncated behind our back, so we'll check for
+ * errors while reading them.
+ */
+struct MetadataFileConfig {
+    static constexpr bitsery::EndiannessType Endianness =
+        bitsery::EndiannessType::LittleEndian;
+    static constexpr bool CheckDataErrors = true;
+    static constexpr bool CheckAdapterErrors = true;
+};
+
+/**
+ * Identifies the exact plugin a metadata cache entry was written for. An entry
+ * is only used when all of these fields match, so updating either yabridge or
+ * the Windows plugin automatically invalidates the cached metadata.
+ */
+struct PluginMetadataKey {
+    std::string yabridge_version;
+    PluginType plugin_type;
+    std::string plugin_path;
+    uint64_t library_size;
+    int64_t library_modification_time;
+
+    bool operator==(const PluginMetadataKey&) const = default;
+
+    template <typename S>
+    void serialize(S& s) {
+        s.text1b(yabridge_version, 256);
+        s.object(plugin_type);
+        s.text1b(plugin_path, 4096);
+        s.value8b(library_size);
+        s.value8b(library_modification_time);
+    }
+};
+
+/**
+ * A persistent on-disk cache for the information the host asks for while
+ * scanning plugins, stored in `$XDG_CACHE_HOME/yabridge/plugin-metadata`. When
+ * the `cache_plugin_metadata` option is enabled, the plugin bridges use this
+ * to answer those queries without having to start the Wine plugin host. The
+ * Wine plugin host is then only started once the host actually uses the
+ * plugin. Every plugin gets its own file, containing a `PluginMetadataKey`
+ * followed by the bridge-specific metadata object. These entries can also be
+ * written ahead of time by `yabridge-scan.exe`, which uses this same class.
+ *
+ * Reading and writing the cache never throws. A missing, outdated or
+ * corrupted entry simply results in a cache miss.
+ */
+class PluginMetadataCache {
+   public:
+    /**
+     * Create a disabled cache. `load()` will always return an `std::nullopt`
+     * and `store()` will do nothing. This is used when the
+     * `cache_plugin_metadata` option is disabled.
+     */
+    PluginMetadataCache() noexcept;
+
+    /**
+     * Compute the cache key for a plugin. If the plugin's library cannot be
+     * read, then the cache will be disabled.
+     *
+     * @param plugin_type The type of the plugin.
+     * @param plugin_path The path to the plugin as passed to the Wine plugin
+     *   host. See `PluginInfo::windows_plugin_path`.
+     * @param library_path The path to the plugin's actual Windows library. For
+     *   VST3 bundles this is the module inside of the bundle.
+     */
+    PluginMetadataCache(PluginType plugin_type,
+                        const boost::filesystem::path& plugin_path,
+                        const boost::filesystem::path& library_path);
+
+    /**
+     * Whether this cache is enabled and the plugin's library could be found.
+     */
+    inline bool enabled() const noexcept { return key.has_value(); }
+
+    /**
+     * Whether the cache already contains an entry for this exact version of
+     * the plugin. This only reads the key, so it's much cheaper than
+     * `load()`.
+     */
+    bool contains_entry() const;
+
+    /**
+     * Read the cached metadata for this plugin, if there is an entry for this
+     * exact version of the plugin.
+     */
+    template <typename T>
+    std::optional<T> load() const {
+        if (!key) {
+            return std::nullopt;
+        }
+
+        const std::optional<std::vector<uint8_t>> buffer = read_file();
+        if (!buffer) {
+            return std::nullopt;
+        }
+
+        // The key is read separately first so we won't even try to parse
+        // entries written by other versions of yabridge
+        Deserializer deserializer(buffer->begin(), buffer->size());
+        if (!read_matching_key(deserializer)) {
+            return std::nullopt;
+        }
+
+        T metadata{};
+        deserializer.object(metadata);
+        if (!deserializer.adapter().isCompletedSuccessfully()) {
+            return std::nullopt;
+        }
+
+        return metadata;
+    }
+
+    /**
+     * Write the metadata for this plugin to the cache, replacing any existing
+     * entry. Failures are logged to `logger`, and otherwise ignored.
+     */
+    template <typename T>
+    void store(T metadata, Logger& logger) const {
+        if (!key) {
+            return;
+        }
+
+        std::vector<uint8_t> buffer{};
+        bitsery::Serializer<bitsery::OutputBufferAdapter<std::vector<uint8_t>,
+                                                         MetadataFileConfig>>
+            serializer(buffer);
+        PluginMetadataKey stored_key = *key;
+        serializer.object(stored_key);
+        serializer.object(metadata);
+        serializer.adapter().flush();
+        buffer.resize(serializer.adapter().writtenBytesCount());
+
+        write_file(buffer, logger);
+    }
+
+   private:
+    using Deserializer = bitsery::Deserializer<
+        bitsery::InputBufferAdapter<std::vector<uint8_t>, MetadataFileConfig>>;
+
+    /**
+     * Read a `PluginMetadataKey` and check whether it matches `key`.
+     */
+    bool read_matching_key(Deserializer& deserializer) const;
+
+    std::optional<std::vector<uint8_t>> read_file() const;
+    void write_file(const std::vector<uint8_t>& buffer, Logger& logger) const;
+
+    /**
+     * The key for the plugin. This is only set when the cache is enabled.
+     */
+    std::optional<PluginMetadataKey> key;
+    boost::filesystem::path cache_file;
+};
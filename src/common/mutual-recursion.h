@@ -16,15 +16,17 @@
 
 #pragma once
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <future>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <thread>
 #include <type_traits>
-
-#ifdef __WINE__
-#include "../wine-host/boost-fix.h"
-#endif
-#include <boost/asio/dispatch.hpp>
-#include <boost/asio/io_context.hpp>
+#include <vector>
 
 /**
  * A helper to allow mutually recursive calling sequences with remote function
@@ -49,22 +51,48 @@
  * thread 2:            \-----waiting for fn() to return-----/
  * ```
  *
- * Here `fork(fn)` will call the function `fn` on a new thread (which presumably
- * does some blocking socket operations), and `handle(foo)` will call `foo()` on
- * the thread that originally called `fork(fn)`. If the function passed to
+ * Here `fork(fn)` will call the function `fn` on another thread (which
+ * presumably does some blocking socket operations), and `handle(foo)` will call
+ * `foo()` on the thread that originally called `fork(fn)`. If the function passed to
  * `handle()` also calls `fork()` (or more likely, the function pass to
  * `handle()` calls an unmanaged plugin/host function that ends up performing a
  * mutually recursive callback), then this sequence allows for arbitrarily
  * nested mutual recursion.
  *
+ * Mutual recursion happens all the time while opening and resizing editors, so
+ * this is kept as cheap as possible. The threads calling `fn` are kept around
+ * and reused for later `fork()` calls, and the calls made through `handle()`
+ * are passed to the waiting thread through a simple queue instead of through
+ * a dedicated IO context.
+ *
  * @tparam Thread The thread implementation to use. On the Linux side this
  *   should be `std::jthread` and on the Wine side this should be `Win32Thread`.
  */
 template <typename Thread>
 class MutualRecursionHelper {
    public:
+    MutualRecursionHelper() noexcept = default;
+
     /**
-     * Run `fn` from a new thread, while handling calls to `handle()` and
+     * Stop all idle sending threads. These threads will be joined when the
+     * object gets destroyed.
+     */
+    ~MutualRecursionHelper() noexcept {
+        std::lock_guard lock(sending_threads_mutex);
+        for (auto& sending_thread : sending_threads) {
+            {
+                std::lock_guard thread_lock(sending_thread->mutex);
+                sending_thread->stopping = true;
+            }
+            sending_thread->task_available.notify_one();
+        }
+    }
+
+    MutualRecursionHelper(const MutualRecursionHelper&) = delete;
+    MutualRecursionHelper& operator=(const MutualRecursionHelper&) = delete;
+
+    /**
+     * Run `fn` from another thread, while handling calls to `handle()` and
      * `maybe_handle()` on this thread. See the docstring on
      * `MutualRecursionHelper` for more information on this mechanism.
      *
@@ -78,48 +106,56 @@ class MutualRecursionHelper {
     std::invoke_result_t<F> fork(F&& fn) {
         using Result = std::invoke_result_t<F>;
 
-        // This IO context will accept incoming calls from `handle()` and
-        // `maybe_handle()` until the function returns. We keep these on a stack
-        // as we need to support multiple levels of mutual recursion. This can
-        // for instance happen during `IPlugView::attached() ->
+        // Calls from `handle()` and `maybe_handle()` will be queued up in this
+        // frame until the function returns. We keep these on a stack as we
+        // need to support multiple levels of mutual recursion. This can for
+        // instance happen during `IPlugView::attached() ->
         // IPlugFrame::resizeView() -> IPlugView::onSize()`.
-        std::shared_ptr<boost::asio::io_context> current_io_context =
-            std::make_shared<boost::asio::io_context>();
+        RecursionFrame frame{};
         {
-            std::unique_lock lock(mutual_recursion_contexts_mutex);
-            mutual_recursion_contexts.push_back(current_io_context);
+            std::lock_guard lock(recursion_frames_mutex);
+            recursion_frames.push_back(&frame);
         }
 
-        // Instead of directly stopping the IO context, we'll reset this work
-        // guard instead. This prevents us from accidentally cancelling any
-        // outstanding tasks.
-        auto work_guard = boost::asio::make_work_guard(*current_io_context);
-
         // We will call the function from another thread so we can handle calls
-        // to `handle()`/`maybe_handle()` from this thread
-        std::promise<Result> response_promise{};
-        Thread sending_thread([&]() {
-            const Result response = fn();
+        // to `handle()`/`maybe_handle()` from this thread. Instead of spawning
+        // a new thread every time, we'll reuse an idle thread from previous
+        // calls whenever possible.
+        std::optional<Result> response;
+        run_on_sending_thread([&]() {
+            response.emplace(fn());
 
             // Stop accepting additional work to be run from the calling thread
             // once `fn` returns (and we'll likely have gotten a response from
-            // the other side). By resetting the work guard we do not cancel any
-            // pending tasks, but `current_io_context->run()` will stop blocking
-            // eventually.
-            std::lock_guard lock(mutual_recursion_contexts_mutex);
-            work_guard.reset();
-            mutual_recursion_contexts.erase(
-                std::find(mutual_recursion_contexts.begin(),
-                          mutual_recursion_contexts.end(), current_io_context));
-
-            response_promise.set_value(response);
+            // the other side). Any calls that have already been queued will
+            // still be handled before `fork()` returns.
+            std::lock_guard lock(recursion_frames_mutex);
+            recursion_frames.erase(std::find(recursion_frames.begin(),
+                                             recursion_frames.end(), &frame));
+
+            // The frame may be destroyed as soon as we release this lock
+            std::lock_guard frame_lock(frame.mutex);
+            frame.done = true;
+            frame.work_available.notify_one();
         });
 
-        // Accept work from the other thread until we receive a response, at
-        // which point the context will be stopped
-        current_io_context->run();
+        // Accept work from the other thread until we receive a response
+        while (true) {
+            std::unique_lock lock(frame.mutex);
+            frame.work_available.wait(
+                lock, [&]() { return !frame.tasks.empty() || frame.done; });
+            if (frame.tasks.empty()) {
+                break;
+            }
+
+            std::function<void()> task = std::move(frame.tasks.front());
+            frame.tasks.pop_front();
+            lock.unlock();
 
-        return response_promise.get_future().get();
+            task();
+        }
+
+        return std::move(*response);
     }
 
     /**
@@ -158,34 +194,150 @@ class MutualRecursionHelper {
     std::optional<std::invoke_result_t<F>> maybe_handle(F&& fn) {
         using Result = std::invoke_result_t<F>;
 
-        std::unique_lock mutual_recursion_lock(mutual_recursion_contexts_mutex);
-        if (mutual_recursion_contexts.empty()) {
+        std::unique_lock recursion_frames_lock(recursion_frames_mutex);
+        if (recursion_frames.empty()) {
             return std::nullopt;
         }
 
+        // If this is called from the thread that's handling the active frame,
+        // then queueing the call would deadlock. This can happen when a
+        // function called through `handle()` calls `handle()` again.
+        RecursionFrame& frame = *recursion_frames.back();
+        if (frame.owner == std::this_thread::get_id()) {
+            recursion_frames_lock.unlock();
+            return fn();
+        }
+
         // This function is only used in synchronous contexts, so we'll just
         // pretend that we're not doing any async things here
         std::packaged_task<Result()> do_call(std::forward<F>(fn));
         std::future<Result> do_call_response = do_call.get_future();
-        boost::asio::dispatch(*mutual_recursion_contexts.back(),
-                              std::move(do_call));
-        mutual_recursion_lock.unlock();
+        {
+            std::lock_guard frame_lock(frame.mutex);
+            frame.tasks.push_back([&do_call]() { do_call(); });
+        }
+        frame.work_available.notify_one();
+        recursion_frames_lock.unlock();
 
         return do_call_response.get();
     }
 
    private:
     /**
-     * These IO contexts will let us call functions from the thread that's
-     * currently calling `fork()` while we're waiting for the passed function to
-     * return. We need an entire stack of these to be able to support deeply
-     * nested mutual recursion, how fun! If `fork()` is being called multiple
-     * times from the same thread (in a mutual recursion sequence), this stack
-     * will contain multiple IO contexts. In that case the last context is the
-     * active one. If the stack is empty, then there's currently no mutual
-     * recursion going on.
+     * The calls queued up for a thread that's currently blocked in `fork()`.
+     * These live on that thread's stack. They're only removed from
+     * `recursion_frames` after `fn` has returned, while holding
+     * `recursion_frames_mutex`, so other threads can safely queue calls while
+     * holding that mutex.
+     */
+    struct RecursionFrame {
+        std::thread::id owner = std::this_thread::get_id();
+
+        std::mutex mutex;
+        std::condition_variable work_available;
+        std::deque<std::function<void()>> tasks;
+        /**
+         * Set once the function passed to `fork()` has returned. The calling
+         * thread will then handle the remaining tasks and return.
+         */
+        bool done = false;
+    };
+
+    /**
+     * A thread that runs the functions passed to `fork()`. These are kept
+     * around after the function returns so nested or repeated mutually
+     * recursive calls don't have to spawn a new thread every time.
+     */
+    struct SendingThread {
+        std::mutex mutex;
+        std::condition_variable task_available;
+        std::function<void()> task;
+        bool stopping = false;
+
+        /**
+         * This should be the last field so the thread gets joined before the
+         * other fields are destroyed.
+         */
+        Thread thread;
+    };
+
+    /**
+     * Run `task` on an idle sending thread, or on a new sending thread if all
+     * existing sending threads are busy.
+     */
+    void run_on_sending_thread(std::function<void()> task) {
+        SendingThread* sending_thread = nullptr;
+        {
+            std::lock_guard lock(sending_threads_mutex);
+            if (!idle_sending_threads.empty()) {
+                sending_thread = idle_sending_threads.back();
+                idle_sending_threads.pop_back();
+            } else {
+                sending_thread = sending_threads
+                                     .emplace_back(
+                                         std::make_unique<SendingThread>())
+                                     .get();
+                sending_thread->thread = Thread(
+                    [this, sending_thread]() { run_tasks(*sending_thread); });
+            }
+        }
+
+        {
+            std::lock_guard lock(sending_thread->mutex);
+            sending_thread->task = std::move(task);
+        }
+        sending_thread->task_available.notify_one();
+    }
+
+    /**
+     * The loop running on a sending thread. The thread puts itself back into
+     * the idle pool after each task.
+     */
+    void run_tasks(SendingThread& sending_thread) {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock(sending_thread.mutex);
+                sending_thread.task_available.wait(lock, [&]() {
+                    return sending_thread.task || sending_thread.stopping;
+                });
+                if (!sending_thread.task) {
+                    return;
+                }
+
+                task = std::move(sending_thread.task);
+                sending_thread.task = nullptr;
+            }
+
+            task();
+
+            std::lock_guard lock(sending_threads_mutex);
+            idle_sending_threads.push_back(&sending_thread);
+        }
+    }
+
+    /**
+     * The frames for the threads currently blocked in `fork()`. We need an
+     * entire stack of these to be able to support deeply nested mutual
+     * recursion, how fun! If `fork()` is being called multiple times from the
+     * same thread (in a mutual recursion sequence), this stack will contain
+     * multiple frames. In that case the last frame is the active one. If the
+     * stack is empty, then there's currently no mutual recursion going on.
+     */
+    std::vector<RecursionFrame*> recursion_frames;
+    std::mutex recursion_frames_mutex;
+
+    /**
+     * The mutex and the idle list are declared before the threads since a
+     * thread that just finished its last task may still access them while it's
+     * being joined.
+     */
+    std::mutex sending_threads_mutex;
+    std::vector<SendingThread*> idle_sending_threads;
+    /**
+     * All sending threads that have been spawned so far. The number of threads
+     * is bounded by the deepest level of concurrent mutual recursion we've
+     * encountered, which in practice is only a handful.
      */
-    std::vector<std::shared_ptr<boost::asio::io_context>>
-        mutual_recursion_contexts;
-    std::mutex mutual_recursion_contexts_mutex;
+    std::vector<std::unique_ptr<SendingThread>> sending_threads;
 };
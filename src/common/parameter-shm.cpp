@@ -0,0 +1,55 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "parameter-shm.h"
+
+ParameterShmTable::ParameterShmTable(std::string name, uint32_t num_parameters)
+    : name(std::move(name)),
+      num_parameters(num_parameters),
+      shm(boost::interprocess::open_or_create,
+          this->name.c_str(),
+          boost::interprocess::read_write) {
+    // A zero sized mapping is not allowed, so we'll always have room for at
+    // least the first word of both bitmaps
+    const size_t size =
+        (num_parameters * sizeof(float) * 2) +
+        (std::max(num_dirty_words(), 1u) * sizeof(uint32_t) * 2);
+
+    // Both sides will call this, but resizing the object to the same size does
+    // not touch its contents. Newly created objects are zero initialized.
+    shm.truncate(size);
+    region = boost::interprocess::mapped_region(
+        shm, boost::interprocess::read_write, 0, size, nullptr);
+}
+
+ParameterShmTable::~ParameterShmTable() noexcept {
+    boost::interprocess::shared_memory_object::remove(name.c_str());
+}
+
+void ParameterShmTable::update(uint32_t index, float value) noexcept {
+    if (is_stale(index)) {
+        return;
+    }
+
+    std::atomic_ref(values()[index]).store(value, std::memory_order_relaxed);
+}
+
+void ParameterShmTable::queue(uint32_t index, float value) noexcept {
+    std::atomic_ref(queued_values()[index])
+        .store(value, std::memory_order_relaxed);
+    std::atomic_ref(dirty()[index / 32]).fetch_or(1u << (index % 32));
+    std::atomic_ref(stale()[index / 32]).fetch_or(1u << (index % 32));
+}
@@ -0,0 +1,200 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <string>
+#include <type_traits>
+
+#ifdef __WINE__
+#include "../wine-host/boost-fix.h"
+#endif
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+
+/**
+ * A table of a VST2 plugin's parameter values in shared memory. Some hosts will
+ * call `getParameter()` for hundreds of parameters every GUI frame, and during
+ * automation playback they will call `setParameter()` many times per
+ * processing cycle. Doing a socket round trip for every one of those calls adds
+ * up quickly. This table lets the native plugin answer `getParameter()` with a
+ * simple memory read, and it lets the native plugin queue `setParameter()`
+ * calls made from the audio thread so the Wine plugin host can apply them all
+ * at once at the start of the next processing cycle.
+ *
+ * The table contains the last known value for every parameter, the values for
+ * queued `setParameter()` calls, a bitmap indicating which parameters have a
+ * queued value, and a second bitmap indicating which parameters have a stale
+ * last known value. The Wine side keeps the last known values up to date by
+ * periodically reading them from the plugin, by updating them whenever the
+ * plugin calls `audioMasterAutomate()`, and by reading the value back from the
+ * plugin after applying a queued `setParameter()` call. Plugins may quantize or
+ * clamp the values they receive, so until that has happened the native plugin
+ * should not answer `getParameter()` calls for a parameter with a queued value
+ * from the table. All fields are 32-bit values so the layout is the same for
+ * the 64-bit plugin and a 32-bit Wine plugin host.
+ *
+ * Like `AudioShmBuffer`, the object is created by the Wine plugin host, and the
+ * native plugin then connects to it using the same name. The native plugin
+ * only uses this table while the plugin is processing audio. At other times the
+ * values may be stale, so it will use the sockets instead.
+ */
+class ParameterShmTable {
+   public:
+    /**
+     * Connect to or create the shared memory object and map it to this
+     * process's memory.
+     *
+     * @param name The unique identifier for this shared memory object.
+     * @param num_parameters The number of parameters in the table. Both sides
+     *   need to agree on this, so this is the plugin's `numParams` value at
+     *   the time the plugin was initialized. Parameters with indices outside of
+     *   this range are not mirrored.
+     */
+    ParameterShmTable(std::string name, uint32_t num_parameters);
+
+    /**
+     * Destroy the shared memory object. Just like with `AudioShmBuffer`, either
+     * side dropping the object will cause the object to get destroyed.
+     */
+    ~ParameterShmTable() noexcept;
+
+    ParameterShmTable(const ParameterShmTable&) = delete;
+    ParameterShmTable& operator=(const ParameterShmTable&) = delete;
+
+    /**
+     * Whether a parameter index is mirrored in this table.
+     */
+    inline bool contains(int index) const noexcept {
+        return index >= 0 && static_cast<uint32_t>(index) < num_parameters;
+    }
+
+    /**
+     * Read the last known value for a parameter.
+     */
+    inline float get(uint32_t index) const noexcept {
+        return std::atomic_ref(values()[index]).load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Whether the last known value for a parameter is stale because a
+     * `setParameter()` call for it has been queued and the Wine side has not
+     * yet read back the value the plugin ended up using. `get()` should not be
+     * used for these parameters.
+     */
+    inline bool is_stale(uint32_t index) const noexcept {
+        return std::atomic_ref(stale()[index / 32]).load() &
+               (1u << (index % 32));
+    }
+
+    /**
+     * Store the current value for a parameter. This is used on the Wine side to
+     * keep the table up to date. Parameters that have a queued value are left
+     * alone since the plugin will only see that value when it gets applied,
+     * and the value will be read back from the plugin at that point.
+     */
+    void update(uint32_t index, float value) noexcept;
+
+    /**
+     * Queue a `setParameter()` call to be applied at the start of the next
+     * processing cycle. This is used on the native plugin side. The
+     * parameter's last known value is marked as stale until the Wine side has
+     * applied the queued value and read back the plugin's actual value, since
+     * the plugin may not use the exact value we passed to it.
+     */
+    void queue(uint32_t index, float value) noexcept;
+
+    /**
+     * Call `fn(index, value)` for every queued `setParameter()` call and clear
+     * the queue. The function should apply the value, and return the
+     * parameter's value as reported by the plugin afterwards. That value is
+     * stored as the new last known value. This is used on the Wine side at the
+     * start of every processing cycle. If the native plugin queues a new value
+     * while we're doing this, then that value will either be applied now or
+     * during the next processing cycle, and the parameter will stay marked as
+     * stale until then.
+     */
+    template <typename F>
+        requires std::is_invocable_r_v<float, F, uint32_t, float>
+    void apply_queued(F&& fn) noexcept(
+        std::is_nothrow_invocable_r_v<float, F, uint32_t, float>) {
+        for (uint32_t word = 0; word < num_dirty_words(); word++) {
+            std::atomic_ref dirty_word(dirty()[word]);
+            if (dirty_word.load(std::memory_order_relaxed) == 0) {
+                continue;
+            }
+
+            uint32_t bits = dirty_word.exchange(0, std::memory_order_acquire);
+            while (bits != 0) {
+                const uint32_t index =
+                    (word * 32) + static_cast<uint32_t>(std::countr_zero(bits));
+                bits &= bits - 1;
+
+                const uint32_t bit = 1u << (index % 32);
+                const float value = std::atomic_ref(queued_values()[index])
+                                        .load(std::memory_order_relaxed);
+                std::atomic_ref(values()[index])
+                    .store(fn(index, value), std::memory_order_relaxed);
+
+                // `queue()` sets the dirty bit before the stale bit, so if the
+                // native plugin queued a new value in the meantime then we'll
+                // either see that here or it will set the stale bit again
+                // after we clear it
+                std::atomic_ref stale_word(stale()[word]);
+                stale_word.fetch_and(~bit);
+                if (dirty_word.load() & bit) {
+                    stale_word.fetch_or(bit);
+                }
+            }
+        }
+    }
+
+    /**
+     * The number of parameters mirrored in this table.
+     */
+    inline uint32_t size() const noexcept { return num_parameters; }
+
+   private:
+    inline uint32_t num_dirty_words() const noexcept {
+        return (num_parameters + 31) / 32;
+    }
+
+    // The table consists of the last known values, followed by the queued
+    // values, followed by the dirty bitmap and the stale bitmap
+
+    inline float* values() const noexcept {
+        return static_cast<float*>(region.get_address());
+    }
+    inline float* queued_values() const noexcept {
+        return values() + num_parameters;
+    }
+    inline uint32_t* dirty() const noexcept {
+        return reinterpret_cast<uint32_t*>(queued_values() + num_parameters);
+    }
+    inline uint32_t* stale() const noexcept {
+        return dirty() + num_dirty_words();
+    }
+
+    std::string name;
+    uint32_t num_parameters;
+
+    boost::interprocess::shared_memory_object shm;
+    boost::interprocess::mapped_region region;
+};
@@ -19,6 +19,8 @@
 #include <fstream>
 #include <sstream>
 
+#include "utils.h"
+
 namespace fs = boost::filesystem;
 
 LibArchitecture find_dll_architecture(const fs::path& plugin_path) {
@@ -89,3 +91,29 @@ std::string plugin_type_to_string(const PluginType& plugin_type) {
         return "<unknown>";
     }
 }
+
+fs::path normalize_plugin_path(const fs::path& windows_library_path,
+                               PluginType plugin_type) {
+    switch (plugin_type) {
+        case PluginType::vst2:
+            return windows_library_path;
+            break;
+        case PluginType::vst3: {
+            // Now we'll have to figure out if this is a new-style bundle or
+            // an old standalone module
+            const fs::path win_module_name =
+                windows_library_path.filename().replace_extension(".vst3");
+            const fs::path windows_bundle_home =
+                windows_library_path.parent_path().parent_path().parent_path();
+            if (equals_case_insensitive(windows_bundle_home.filename().string(),
+                                        win_module_name.string())) {
+                return windows_bundle_home;
+            } else {
+                return windows_library_path;
+            }
+        } break;
+        default:
+            throw std::runtime_error("How did you manage to get this?");
+            break;
+    }
+}
@@ -62,3 +62,22 @@ LibArchitecture find_dll_architecture(const boost::filesystem::path&);
 
 PluginType plugin_type_from_string(const std::string& plugin_type) noexcept;
 std::string plugin_type_to_string(const PluginType& plugin_type);
+
+/**
+ * Get the path to the plugin that should be passed to the Wine plugin host,
+ * based on the path to the plugin's actual Windows library. For VST2 plugins
+ * this is simply the `.dll` file. VST3 plugins can either be old style
+ * standalone `.vst3` modules, or a module inside of a VST 3.6.10 style bundle,
+ * in which case this returns the path to the bundle.
+ *
+ * @param windows_library_path The canonical path to the plugin's `.dll` or
+ *   `.vst3` library file.
+ * @param plugin_type The type of the plugin.
+ *
+ * @throw std::runtime_error If `plugin_type` is `PluginType::unknown`.
+ *
+ * @see PluginInfo::windows_plugin_path
+ */
+boost::filesystem::path normalize_plugin_path(
+    const boost::filesystem::path& windows_library_path,
+    PluginType plugin_type);
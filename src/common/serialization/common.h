@@ -88,6 +88,25 @@ struct HostResponse {
     }
 };
 
+/**
+ * Sent by the native plugin over the control socket right after it has been
+ * connected to. This tells the Wine plugin host how the rest of the sockets
+ * should be set up, since the Wine plugin host can't read the configuration
+ * until after all sockets have been connected.
+ */
+struct SocketsHandshake {
+    /**
+     * Whether all non-realtime sockets should be replaced by streams on a
+     * single `MultiplexedConnection`.
+     */
+    bool multiplexed;
+
+    template <typename S>
+    void serialize(S& s) {
+        s.value1b(multiplexed);
+    }
+};
+
 /**
  * A reference wrapper similar `std::reference_wrapper<T>` that supports default
  * initializing (which is of course UB, but we need this for serialization) and
@@ -36,11 +36,14 @@ AEffect& update_aeffect(AEffect& plugin,
 
 DynamicVstEvents::DynamicVstEvents() noexcept {}
 
-DynamicVstEvents::DynamicVstEvents(const VstEvents& c_events)
-    : events(c_events.numEvents) {
+DynamicVstEvents::DynamicVstEvents(const VstEvents& c_events) {
+    append(c_events);
+}
+
+void DynamicVstEvents::append(const VstEvents& c_events) {
     // Copy from the C-style array into a vector for serialization
     for (int i = 0; i < c_events.numEvents; i++) {
-        events[i] = *c_events.events[i];
+        events.push_back(*c_events.events[i]);
 
         // If we encounter a SysEx event, also store the payload data in an
         // associative list (so we can potentially still avoid allocations)
@@ -48,11 +51,17 @@ DynamicVstEvents::DynamicVstEvents(const VstEvents& c_events)
             reinterpret_cast<VstMidiSysExEvent*>(c_events.events[i]);
         if (sysex_event->type == kVstSysExType) {
             sysex_data.emplace_back(
-                i, std::string(sysex_event->sysexDump, sysex_event->byteSize));
+                events.size() - 1,
+                std::string(sysex_event->sysexDump, sysex_event->byteSize));
         }
     }
 }
 
+void DynamicVstEvents::clear() noexcept {
+    events.clear();
+    sysex_data.clear();
+}
+
 VstEvents& DynamicVstEvents::as_c_events() {
     // As explained in `vst_events_buffer`'s docstring we have to build the
     // `VstEvents` struct by hand on the heap since it's actually a dynamically
@@ -24,6 +24,7 @@
 #include <boost/container/small_vector.hpp>
 
 #include "../audio-shm.h"
+#include "../bitsery/ext/bulk-buffer.h"
 #include "../bitsery/ext/in-place-optional.h"
 #include "../bitsery/ext/in-place-variant.h"
 #include "../bitsery/traits/small-vector.h"
@@ -56,12 +57,22 @@ constexpr size_t max_midi_events = max_buffer_size / sizeof(size_t);
 [[maybe_unused]] constexpr size_t max_string_length = 64;
 
 /**
- * The maximum size for the buffer we're receiving chunks in. Allows for up to
- * 50 MB chunks. Hopefully no plugin will come anywhere near this limit, but it
- * will add up when plugins start to audio include samples in their presets.
+ * The maximum size for chunk data serialized inline as part of a message.
+ * Chunks larger than `bulk_transfer_threshold` are sent through shared memory
+ * instead, so this is only a sanity check and not a limit on the chunk size.
  */
 constexpr size_t binary_buffer_size = 50 << 20;
 
+/**
+ * A yabridge specific `dispatcher()` opcode that fetches the names, labels and
+ * display strings for all of a plugin's parameters, as well as the names of
+ * all of its programs, in a single request. This is never passed to the
+ * plugin. The value is far outside of the range used by the VST 2.4 opcodes.
+ *
+ * @see WantsParameterStrings
+ */
+constexpr int effYabridgeGetParameterStrings = 0x79620001;
+
 /**
  * Update an `AEffect` object, copying values from `updated_plugin` to `plugin`.
  * This will copy all flags and regular values, leaving all pointers in `plugin`
@@ -72,7 +83,8 @@ AEffect& update_aeffect(AEffect& plugin,
                         const AEffect& updated_plugin) noexcept;
 
 /**
- * Wrapper for chunk data.
+ * Wrapper for chunk data. Large chunks are transferred through shared memory,
+ * see `bitsery::ext::BulkBuffer`.
  */
 struct ChunkData {
     using Response = std::nullptr_t;
@@ -81,7 +93,7 @@ struct ChunkData {
 
     template <typename S>
     void serialize(S& s) {
-        s.container1b(buffer, binary_buffer_size);
+        s.ext(buffer, bitsery::ext::BulkBuffer{binary_buffer_size});
     }
 };
 
@@ -108,6 +120,18 @@ class alignas(16) DynamicVstEvents {
 
     explicit DynamicVstEvents(const VstEvents& c_events);
 
+    /**
+     * Append the events from a `VstEvents` struct to this object. This will
+     * not allocate unless there are more than 64 events in total or if
+     * `c_events` contains SysEx data.
+     */
+    void append(const VstEvents& c_events);
+
+    /**
+     * Remove all events, keeping the allocated capacity.
+     */
+    void clear() noexcept;
+
     /**
      * Construct a `VstEvents` struct from the events vector. This contains a
      * pointer to that vector's elements, so the returned object should not
@@ -303,6 +327,131 @@ struct WantsVstTimeInfo {
     void serialize(S&) {}
 };
 
+/**
+ * The strings returned by the plugin for `effGetParamName`,
+ * `effGetParamLabel`, `effGetParamDisplay` and `effGetProgramNameIndexed` for
+ * every parameter and every program. This is the response to an
+ * `effYabridgeGetParameterStrings` event.
+ */
+struct Vst2ParameterStrings {
+    /**
+     * A single string along with the value returned by the plugin's
+     * `dispatcher()` function.
+     */
+    struct Entry {
+        native_intptr_t return_value;
+        std::string string;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.value8b(return_value);
+            s.text1b(string, max_string_length);
+        }
+    };
+
+    /**
+     * These are left empty when only the value strings were requested.
+     */
+    std::vector<Entry> names;
+    /**
+     * When the value strings were requested for specific parameters, these
+     * contain the strings for those parameters in the order they were
+     * requested in.
+     *
+     * @see WantsParameterStrings::parameters
+     */
+    std::vector<Entry> labels;
+    std::vector<Entry> displays;
+    std::vector<Entry> program_names;
+
+    template <typename S>
+    void serialize(S& s) {
+        s.container(names, 1 << 16);
+        s.container(labels, 1 << 16);
+        s.container(displays, 1 << 16);
+        s.container(program_names, 1 << 16);
+    }
+};
+
+/**
+ * The payload for an `effYabridgeGetParameterStrings` event. This is handled
+ * by the Wine plugin host itself in `Vst2Bridge::run()`.
+ */
+struct WantsParameterStrings {
+    using Response = Vst2ParameterStrings;
+
+    /**
+     * If set, only fetch the value strings, i.e. the parameters' labels and
+     * display strings. The parameter and program names will be left empty.
+     */
+    bool values_only;
+    /**
+     * If `values_only` is set and this is not empty, then only fetch the value
+     * strings for these parameters instead of for all parameters.
+     */
+    std::vector<int32_t> parameters;
+
+    template <typename S>
+    void serialize(S& s) {
+        s.value1b(values_only);
+        s.container4b(parameters, 1 << 16);
+    }
+};
+
+/**
+ * The information about a VST2 plugin stored in the plugin metadata cache. This
+ * is enough to answer the queries hosts make while scanning for plugins. These
+ * entries are written by `Vst2PluginBridge` after the host is done with the
+ * plugin, and ahead of time by `yabridge-scan.exe`. See `PluginMetadataCache`
+ * for more information.
+ */
+struct Vst2PluginMetadata {
+    /**
+     * The result of a single dispatcher call.
+     */
+    struct Query {
+        int opcode;
+        int index;
+        /**
+         * The query string for `effCanDo()`. Empty for all other opcodes.
+         */
+        std::string query;
+        native_intptr_t return_value;
+        /**
+         * The string the plugin wrote to the `data` argument, for opcodes that
+         * return a string.
+         */
+        std::string result;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.value4b(opcode);
+            s.value4b(index);
+            s.text1b(query, max_string_length);
+            s.value8b(return_value);
+            s.text1b(result, max_string_length);
+        }
+    };
+
+    /**
+     * The `AEffect` object as it was returned after initializing the plugin.
+     */
+    AEffect initialized_plugin{};
+    /**
+     * The `AEffect` object after the host called `effOpen()`. Some plugins
+     * only fill in some of the fields at this point.
+     */
+    std::optional<AEffect> opened_plugin;
+    std::vector<Query> queries;
+
+    template <typename S>
+    void serialize(S& s) {
+        s.object(initialized_plugin);
+        s.ext(opened_plugin, bitsery::ext::InPlaceOptional());
+        s.container(queries, 1 << 10);
+    }
+};
+
 /**
  * Marker struct to indicate that that the event requires some buffer to write
  * a C-string into.
@@ -343,7 +492,8 @@ struct Vst2EventResult {
                                  VstMidiKeyName,
                                  VstParameterProperties,
                                  VstRect,
-                                 VstTimeInfo>;
+                                 VstTimeInfo,
+                                 Vst2ParameterStrings>;
 
     /**
      * The result that should be returned from the dispatch function.
@@ -439,6 +589,7 @@ struct Vst2Event {
                                  WantsAEffectUpdate,
                                  WantsAudioShmBufferConfig,
                                  WantsChunkBuffer,
+                                 WantsParameterStrings,
                                  VstIOProperties,
                                  VstMidiKeyName,
                                  VstParameterProperties,
@@ -527,6 +678,34 @@ struct Parameter {
     }
 };
 
+/**
+ * The response to a `Vst2ProcessRequest`. Plugins will send any MIDI events
+ * they produce to the host using `audioMasterProcessEvents()` during their
+ * processing function. Instead of forwarding those over the host callback
+ * socket we'll collect them on the Wine side and send them back as part of the
+ * response, so the native plugin can pass them to the host at the end of its
+ * own processing function without needing any additional synchronisation.
+ */
+struct Vst2ProcessResponse {
+    /**
+     * The events the plugin sent to the host while processing audio. This
+     * object is reused on both sides, so it won't allocate in normal use.
+     */
+    DynamicVstEvents output_events;
+
+    /**
+     * How long the plugin spent processing this block on the Wine side, in
+     * nanoseconds. The native plugin uses this for its performance counters.
+     */
+    uint64_t processing_time_ns = 0;
+
+    template <typename S>
+    void serialize(S& s) {
+        s.object(output_events);
+        s.value8b(processing_time_ns);
+    }
+};
+
 /**
  * When the host calls `processReplacing()`, `processDoubleReplacing()`, or the
  * deprecated `process()` function on our VST2 plugin, we'll write the input
@@ -535,7 +714,7 @@ struct Parameter {
  * host with the rest of the .
  */
 struct Vst2ProcessRequest {
-    using Response = Ack;
+    using Response = Vst2ProcessResponse;
 
     /**
      * The number of samples per channel. We'll trust the host to never provide
@@ -550,6 +729,18 @@ struct Vst2ProcessRequest {
      */
     bool double_precision;
 
+    /**
+     * Whether the host is processing audio in place, i.e. whether the host
+     * passed the same buffer for every input channel and the output channel
+     * with the same index. In that case the Wine plugin host will also have the
+     * plugin process those channels in place, so the plugin reads its input
+     * from and writes its output to the same region in the shared memory
+     * object. The native plugin then copies those output channels back from
+     * the input channel regions. This halves the amount of shared memory the
+     * two processes touch for those channels.
+     */
+    bool in_place;
+
     /**
      * We'll prefetch the current transport information as part of handling an
      * audio processing call. This lets us a void an unnecessary callback (or in
@@ -577,6 +768,7 @@ struct Vst2ProcessRequest {
     void serialize(S& s) {
         s.value4b(sample_frames);
         s.value1b(double_precision);
+        s.value1b(in_place);
 
         s.ext(current_time_info, bitsery::ext::InPlaceOptional{});
         s.value4b(current_process_level);
@@ -92,6 +92,7 @@ using ControlRequest =
                  YaEditController::SetComponentState,
                  YaEditController::GetParameterCount,
                  YaEditController::GetParameterInfo,
+                 YaEditController::GetAllParameterInfo,
                  YaEditController::GetParamStringByValue,
                  YaEditController::GetParamValueByString,
                  YaEditController::NormalizedParamToPlain,
@@ -245,6 +246,8 @@ struct AudioProcessorRequest {
 using CallbackRequest =
     std::variant<Vst3ContextMenuProxy::Destruct,
                  WantsConfiguration,
+                 YaBStream::Read,
+                 YaBStream::Write,
                  YaComponentHandler::BeginEdit,
                  YaComponentHandler::PerformEdit,
                  YaComponentHandler::EndEdit,
@@ -21,7 +21,9 @@
 
 YaBStream::YaBStream() noexcept {FUNKNOWN_CTOR}
 
-YaBStream::YaBStream(Steinberg::IBStream* stream) {
+YaBStream::YaBStream(Steinberg::IBStream* stream,
+                     std::optional<native_size_t> stream_id)
+    : stream_id(stream_id) {
     FUNKNOWN_CTOR
 
     if (!stream) {
@@ -42,6 +44,15 @@ YaBStream::YaBStream(Steinberg::IBStream* stream) {
         stream->tell(&size);
         size -= old_position;
 
+        // For streamed streams we'll only send the first window along with
+        // the request, and the Wine plugin host will fetch the rest when it
+        // needs it
+        stream_size = size;
+        if (stream_id) {
+            size = std::min(size,
+                            static_cast<int64>(streamed_bstream_window_size));
+        }
+
         if (size > 0) {
             int32 num_bytes_read = 0;
             buffer.resize(size);
@@ -139,7 +150,11 @@ tresult YaBStream::write_back(Steinberg::IBStream* stream) const {
 }
 
 size_t YaBStream::size() const noexcept {
-    return buffer.size();
+    return stream_id ? static_cast<size_t>(stream_size) : buffer.size();
+}
+
+std::vector<uint8_t>& YaBStream::inline_data() noexcept {
+    return buffer;
 }
 
 tresult PLUGIN_API YaBStream::read(void* buffer,
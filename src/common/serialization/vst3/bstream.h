@@ -21,12 +21,22 @@
 #include <pluginterfaces/base/ibstream.h>
 #include <pluginterfaces/vst/ivstattributes.h>
 
+#include "../../bitsery/ext/bulk-buffer.h"
+#include "../common.h"
 #include "attribute-list.h"
 #include "base.h"
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wnon-virtual-dtor"
 
+/**
+ * The size of the windows used for streamed `YaBStream`s. When a plugin's state
+ * is larger than this, the Wine plugin host will read and write the host's
+ * `IBStream` in windows of this size instead of transferring the entire state
+ * at once. See `YaBStream::stream_id`.
+ */
+constexpr size_t streamed_bstream_window_size = 1 << 20;
+
 /**
  * Serialize an `IBStream` into an `std::vector<uint8_t>`, and allow the
  * receiving side to use it as an `IBStream` again. `ISizeableStream` is defined
@@ -34,6 +44,10 @@
  *
  * If we're copying data from an existing `IBstream` and that stream supports
  * VST 3.6.0 preset meta data, then we'll copy that meta data as well.
+ *
+ * Large streams, like the state of sample based instruments, are transferred
+ * through shared memory instead of being serialized inline. See
+ * `bitsery::ext::BulkBuffer`.
  */
 class YaBStream : public Steinberg::IBStream,
                   public Steinberg::ISizeableStream,
@@ -49,9 +63,19 @@ class YaBStream : public Steinberg::IBStream,
     /**
      * Read an existing stream.
      *
+     * @param stream The host's stream.
+     * @param stream_id If set, then the stream can be streamed. This is used
+     *   for `{IComponent,IEditController}::{get,set}State()`. In that case we
+     *   will only copy up to `streamed_bstream_window_size` bytes, and the Wine
+     *   plugin host will request the rest of the data through `YaBStream::Read`
+     *   callbacks, and write data back through `YaBStream::Write` callbacks.
+     *   The native plugin should have registered the stream under this ID
+     *   before sending the stream to the Wine plugin host.
+     *
      * @throw std::runtime_error If we couldn't read from the stream.
      */
-    YaBStream(Steinberg::IBStream* stream);
+    YaBStream(Steinberg::IBStream* stream,
+              std::optional<native_size_t> stream_id = std::nullopt);
 
     virtual ~YaBStream() noexcept;
 
@@ -64,10 +88,20 @@ class YaBStream : public Steinberg::IBStream,
     tresult write_back(Steinberg::IBStream* stream) const;
 
     /**
-     * Return the buffer's, used in the logging messages.
+     * Return the buffer's size, used in the logging messages. For streamed
+     * streams this is the size of the entire stream.
      */
     size_t size() const noexcept;
 
+    /**
+     * Direct access to the buffer. This is used by the Wine plugin host's
+     * `Vst3HostStreamProxy` to take over the data that was sent along with a
+     * streamed stream, and to send the data back inline when it turned out to
+     * be small enough. The native plugin uses this to hold on to the last
+     * returned state when the `cache_state` option is enabled.
+     */
+    std::vector<uint8_t>& inline_data() noexcept;
+
     // From `IBstream`
     tresult PLUGIN_API read(void* buffer,
                             int32 numBytes,
@@ -90,7 +124,7 @@ class YaBStream : public Steinberg::IBStream,
 
     template <typename S>
     void serialize(S& s) {
-        s.container1b(buffer, max_vector_stream_size);
+        s.ext(buffer, bitsery::ext::BulkBuffer{max_vector_stream_size});
         // The seek position should always be initialized at 0
 
         s.value1b(supports_stream_attributes);
@@ -99,8 +133,80 @@ class YaBStream : public Steinberg::IBStream,
                   s.text2b(name, std::extent_v<Steinberg::Vst::String128>);
               });
         s.ext(attributes, bitsery::ext::InPlaceOptional{});
+
+        s.ext(stream_id, bitsery::ext::InPlaceOptional{},
+              [](S& s, native_size_t& id) { s.value8b(id); });
+        s.value8b(stream_size);
     }
 
+    /**
+     * The response to a `YaBStream::Read` callback.
+     */
+    struct ReadResponse {
+        UniversalTResult result;
+        std::vector<uint8_t> data;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.object(result);
+            s.container1b(data, streamed_bstream_window_size);
+        }
+    };
+
+    /**
+     * Read a window of data from the host's stream registered under
+     * `stream_id`. This is sent by the Wine plugin host while the plugin reads
+     * from a streamed `YaBStream`.
+     */
+    struct Read {
+        using Response = ReadResponse;
+
+        native_size_t owner_instance_id;
+        native_size_t stream_id;
+
+        /**
+         * The position to read from, relative to the host's seek position at
+         * the time the stream was registered.
+         */
+        int64 position;
+        int32 size;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.value8b(owner_instance_id);
+            s.value8b(stream_id);
+            s.value8b(position);
+            s.value4b(size);
+        }
+    };
+
+    /**
+     * Write a window of data to the host's stream registered under
+     * `stream_id`. This is sent by the Wine plugin host while the plugin
+     * writes to a streamed `YaBStream`.
+     */
+    struct Write {
+        using Response = UniversalTResult;
+
+        native_size_t owner_instance_id;
+        native_size_t stream_id;
+
+        /**
+         * The position to write to, relative to the host's seek position at
+         * the time the stream was registered.
+         */
+        int64 position;
+        std::vector<uint8_t> data;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.value8b(owner_instance_id);
+            s.value8b(stream_id);
+            s.value8b(position);
+            s.container1b(data, streamed_bstream_window_size);
+        }
+    };
+
     /**
      * Whether this stream supports `IStreamAttributes`. This will be true if we
      * copied a stream provided by the host that also supported meta data.
@@ -118,6 +224,23 @@ class YaBStream : public Steinberg::IBStream,
      */
     std::optional<YaAttributeList> attributes;
 
+    /**
+     * If this is set, then the native plugin registered the host's stream
+     * under this ID and the Wine plugin host can read and write the rest of
+     * the stream through `YaBStream::Read` and `YaBStream::Write` callbacks.
+     * In that case `buffer` only contains the first window of data, and
+     * `stream_size` contains the size of the entire stream. This keeps memory
+     * usage bounded when the plugin's state is hundreds of megabytes large,
+     * and the first bytes can be transferred before the plugin has finished
+     * serializing its state.
+     */
+    std::optional<native_size_t> stream_id;
+
+    /**
+     * The size of the entire stream, only used when `stream_id` is set.
+     */
+    int64_t stream_size = 0;
+
    private:
     std::vector<uint8_t> buffer;
     int64_t seek_position = 0;
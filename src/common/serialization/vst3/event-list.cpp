@@ -213,6 +213,37 @@ void YaEventList::write_back_outputs(
     }
 }
 
+void YaEventList::append_delayed(const YaEventList& other, int32 delay) {
+    for (const auto& event : other.events) {
+        events.push_back(event);
+        events.back().sample_offset += delay;
+    }
+}
+
+void YaEventList::write_back_delayed_outputs(
+    Steinberg::Vst::IEventList* output_events,
+    int32 num_samples) {
+    // The events that are not yet due are moved to the front of the vector so
+    // this doesn't allocate
+    size_t num_remaining = 0;
+    for (size_t i = 0; i < events.size(); i++) {
+        if (events[i].sample_offset < num_samples) {
+            if (output_events) {
+                Steinberg::Vst::Event reconstructed_event = events[i].get();
+                output_events->addEvent(reconstructed_event);
+            }
+        } else {
+            events[i].sample_offset -= num_samples;
+            if (i != num_remaining) {
+                events[num_remaining] = std::move(events[i]);
+            }
+            num_remaining++;
+        }
+    }
+
+    events.resize(num_remaining);
+}
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wdelete-non-virtual-dtor"
 IMPLEMENT_FUNKNOWN_METHODS(YaEventList,
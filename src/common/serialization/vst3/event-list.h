@@ -257,6 +257,23 @@ class YaEventList : public Steinberg::Vst::IEventList {
      */
     void write_back_outputs(Steinberg::Vst::IEventList& output_events) const;
 
+    /**
+     * Append the events from `other` to this list, delaying them by `delay`
+     * samples. Used to keep output events in sync with the delayed audio when
+     * using pipelined processing.
+     */
+    void append_delayed(const YaEventList& other, int32 delay);
+
+    /**
+     * Write the events that fall within the next `num_samples` samples to the
+     * host's output events queue and remove them from this list. The offsets
+     * of the remaining events are made relative to the start of the next
+     * block. If `output_events` is a null pointer, then the events that are
+     * due will be dropped.
+     */
+    void write_back_delayed_outputs(Steinberg::Vst::IEventList* output_events,
+                                    int32 num_samples);
+
     // From `IEventList`
     virtual int32 PLUGIN_API getEventCount() override;
     virtual tresult PLUGIN_API
@@ -58,6 +58,42 @@ void YaParamValueQueue::write_back_outputs(
     }
 }
 
+void YaParamValueQueue::append_delayed(const YaParamValueQueue& other,
+                                       int32 delay) {
+    for (const auto& [sample_offset, value] : other.queue) {
+        queue.emplace_back(sample_offset + delay, value);
+    }
+}
+
+bool YaParamValueQueue::write_back_delayed_outputs(
+    Steinberg::Vst::IParameterChanges* output_queues,
+    int32 num_samples) {
+    // We'll only add a queue to the host's parameter changes if we actually
+    // have points to write to it
+    Steinberg::Vst::IParamValueQueue* output_queue = nullptr;
+    int32 index;
+    size_t num_remaining = 0;
+    for (size_t i = 0; i < queue.size(); i++) {
+        const auto [sample_offset, value] = queue[i];
+        if (sample_offset < num_samples) {
+            if (!output_queue && output_queues) {
+                output_queue =
+                    output_queues->addParameterData(parameter_id, index);
+            }
+            if (output_queue) {
+                output_queue->addPoint(sample_offset, value, index);
+            }
+        } else {
+            queue[num_remaining++] =
+                std::pair(sample_offset - num_samples, value);
+        }
+    }
+
+    queue.resize(num_remaining);
+
+    return num_remaining > 0;
+}
+
 Steinberg::Vst::ParamID PLUGIN_API YaParamValueQueue::getParameterId() {
     return parameter_id;
 }
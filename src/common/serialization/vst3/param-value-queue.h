@@ -67,6 +67,25 @@ class alignas(16) YaParamValueQueue : public Steinberg::Vst::IParamValueQueue {
     void write_back_outputs(
         Steinberg::Vst::IParamValueQueue& output_queue) const;
 
+    /**
+     * Append the points from `other` to this queue, delaying them by `delay`
+     * samples. Used in `YaParameterChanges::append_delayed()`.
+     */
+    void append_delayed(const YaParamValueQueue& other, int32 delay);
+
+    /**
+     * Write the points that fall within the next `num_samples` samples to a
+     * new queue for this parameter on the host's output parameter changes
+     * object, and remove them from this queue. The offsets of the remaining
+     * points are made relative to the start of the next block. Used in
+     * `YaParameterChanges::write_back_delayed_outputs()`.
+     *
+     * @return Whether there are any points left in this queue.
+     */
+    bool write_back_delayed_outputs(
+        Steinberg::Vst::IParameterChanges* output_queues,
+        int32 num_samples);
+
     // From `IParamValueQueue`
     Steinberg::Vst::ParamID PLUGIN_API getParameterId() override;
     int32 PLUGIN_API getPointCount() override;
@@ -16,6 +16,8 @@
 
 #include "parameter-changes.h"
 
+#include <algorithm>
+
 YaParameterChanges::YaParameterChanges() noexcept {FUNKNOWN_CTOR}
 
 YaParameterChanges::~YaParameterChanges() noexcept {
@@ -59,6 +61,42 @@ void YaParameterChanges::write_back_outputs(
     }
 }
 
+void YaParameterChanges::append_delayed(const YaParameterChanges& other,
+                                        int32 delay) {
+    for (const auto& other_queue : other.queues) {
+        auto existing_queue =
+            std::find_if(queues.begin(), queues.end(),
+                         [&](const YaParamValueQueue& queue) {
+                             return queue.parameter_id ==
+                                    other_queue.parameter_id;
+                         });
+        if (existing_queue != queues.end()) {
+            existing_queue->append_delayed(other_queue, delay);
+        } else {
+            int32 index;
+            addParameterData(other_queue.parameter_id, index);
+            queues[index].append_delayed(other_queue, delay);
+        }
+    }
+}
+
+void YaParameterChanges::write_back_delayed_outputs(
+    Steinberg::Vst::IParameterChanges* output_queues,
+    int32 num_samples) {
+    bool has_remaining_points = false;
+    for (auto& queue : queues) {
+        if (queue.write_back_delayed_outputs(output_queues, num_samples)) {
+            has_remaining_points = true;
+        }
+    }
+
+    // Empty queues are kept around until everything has been written back so
+    // they can be reused for the same parameter
+    if (!has_remaining_points) {
+        queues.clear();
+    }
+}
+
 int32 PLUGIN_API YaParameterChanges::getParameterCount() {
     return static_cast<int32>(queues.size());
 }
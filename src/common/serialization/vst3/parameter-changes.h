@@ -68,6 +68,25 @@ class YaParameterChanges : public Steinberg::Vst::IParameterChanges {
     void write_back_outputs(
         Steinberg::Vst::IParameterChanges& output_queues) const;
 
+    /**
+     * Append the parameter changes from `other` to this object, delaying them
+     * by `delay` samples. Points for parameters we already have a queue for
+     * are added to that queue. Used to keep output parameter changes in sync
+     * with the delayed audio when using pipelined processing.
+     */
+    void append_delayed(const YaParameterChanges& other, int32 delay);
+
+    /**
+     * Write the parameter changes that fall within the next `num_samples`
+     * samples to the host's output parameter changes object and remove them
+     * from this object. The offsets of the remaining points are made relative
+     * to the start of the next block. If `output_queues` is a null pointer,
+     * then the changes that are due will be dropped.
+     */
+    void write_back_delayed_outputs(
+        Steinberg::Vst::IParameterChanges* output_queues,
+        int32 num_samples);
+
     // From `IParameterChanges`
     int32 PLUGIN_API getParameterCount() override;
     Steinberg::Vst::IParamValueQueue* PLUGIN_API
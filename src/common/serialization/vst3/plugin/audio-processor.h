@@ -240,10 +240,18 @@ class YaAudioProcessor : public Steinberg::Vst::IAudioProcessor {
         UniversalTResult result;
         YaProcessData::Response output_data;
 
+        /**
+         * How long the plugin spent in `IAudioProcessor::process()` on the
+         * Wine side, in nanoseconds. The native plugin uses this for its
+         * performance counters.
+         */
+        uint64_t processing_time_ns = 0;
+
         template <typename S>
         void serialize(S& s) {
             s.object(result);
             s.object(output_data);
+            s.value8b(processing_time_ns);
         }
     };
 
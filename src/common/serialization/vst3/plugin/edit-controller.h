@@ -150,6 +150,43 @@ class YaEditController : public Steinberg::Vst::IEditController {
     getParameterInfo(int32 paramIndex,
                      Steinberg::Vst::ParameterInfo& info /*out*/) override = 0;
 
+    /**
+     * The results of calling `IEditController::getParameterCount()` followed
+     * by `IEditController::getParameterInfo()` for every parameter.
+     */
+    struct GetAllParameterInfoResponse {
+        int32 parameter_count;
+        /**
+         * The results for `getParameterInfo(0..parameter_count)`, in order.
+         */
+        std::vector<GetParameterInfoResponse> parameter_infos;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.value4b(parameter_count);
+            s.container(parameter_infos, 1 << 20);
+        }
+    };
+
+    /**
+     * Message to fetch the plugin's parameter count and the information for
+     * all of its parameters at once. Hosts will query every parameter when
+     * building automation lists and generic editors, so for plugins with
+     * thousands of parameters this replaces thousands of round trips with a
+     * single one. This has no direct counterpart in the VST3 API, and the
+     * results are cached in `Vst3PluginProxyImpl::function_result_cache`.
+     */
+    struct GetAllParameterInfo {
+        using Response = GetAllParameterInfoResponse;
+
+        native_size_t instance_id;
+
+        template <typename S>
+        void serialize(S& s) {
+            s.value8b(instance_id);
+        }
+    };
+
     /**
      * The response code and returned parameter information for a call to
      * `IEditController::getParamStringByValue(id, value_normalized,
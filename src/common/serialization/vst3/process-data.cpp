@@ -16,8 +16,18 @@
 
 #include "process-data.h"
 
+#include "../../audio-kernels.h"
 #include "../../utils.h"
 
+/**
+ * The silence flags value for a bus where all `num_channels` channels are
+ * silent. Only the first 64 channels can be marked as silent.
+ */
+constexpr uint64 all_channels_mask(int32 num_channels) noexcept {
+    return num_channels >= 64 ? ~static_cast<uint64>(0)
+                              : (static_cast<uint64>(1) << num_channels) - 1;
+}
+
 YaProcessData::YaProcessData() noexcept
     // This response object acts as an optimization. It stores pointers to the
     // original fields in our objects, so we can both only serialize those
@@ -47,8 +57,51 @@ void YaProcessData::repopulate(const Steinberg::Vst::ProcessData& process_data,
 
     // The actual audio is stored in an accompanying `AudioShmBuffer` object, so
     // these inputs and outputs objects are only used to serialize metadata
-    // about the input and output audio bus buffers
+    // about the input and output audio bus buffers. We'll handle the outputs
+    // first since we need to know which busses are processed in place before
+    // copying the inputs.
+    outputs.resize(process_data.numOutputs);
+    in_place_outputs.resize(process_data.numOutputs);
+    for (int bus = 0; bus < process_data.numOutputs; bus++) {
+        // NOTE: The host might provide more output channels than what the
+        //       plugin asked for. Carla does this for some reason. We should
+        //       just ignore these.
+        outputs[bus].numChannels = std::min(
+            static_cast<int32>(shared_audio_buffers.num_output_channels(bus)),
+            process_data.outputs[bus].numChannels);
+        outputs[bus].silenceFlags = process_data.outputs[bus].silenceFlags;
+
+        // If the host uses the same buffers for this bus's inputs and outputs,
+        // then we'll also have the Windows plugin process in place. On the Wine
+        // side every output channel that also exists as an input channel in
+        // the shared memory object then points to that input channel. If the
+        // host provides fewer channels than that, then some of those input
+        // regions won't be written to during this cycle and they would still
+        // contain the last cycle's outputs. We'll process those busses out of
+        // place instead.
+        in_place_outputs[bus] = false;
+        if (bus < process_data.numInputs) {
+            const int32 num_aliased_channels = static_cast<int32>(
+                std::min(shared_audio_buffers.num_input_channels(bus),
+                         shared_audio_buffers.num_output_channels(bus)));
+            in_place_outputs[bus] =
+                num_aliased_channels > 0 &&
+                process_data.inputs[bus].numChannels >= num_aliased_channels &&
+                process_data.outputs[bus].numChannels >= num_aliased_channels;
+            for (int channel = 0;
+                 in_place_outputs[bus] && channel < num_aliased_channels;
+                 channel++) {
+                // These are stored in a union, so the actual type doesn't
+                // matter here
+                in_place_outputs[bus] =
+                    process_data.inputs[bus].channelBuffers32[channel] ==
+                    process_data.outputs[bus].channelBuffers32[channel];
+            }
+        }
+    }
+
     inputs.resize(process_data.numInputs);
+    silent_input_samples.resize(process_data.numInputs);
     for (int bus = 0; bus < process_data.numInputs; bus++) {
         // NOTE: The host might provide more input channels than what the plugin
         //       asked for. Carla does this for some reason. We should just
@@ -56,34 +109,59 @@ void YaProcessData::repopulate(const Steinberg::Vst::ProcessData& process_data,
         inputs[bus].numChannels = std::min(
             static_cast<int32>(shared_audio_buffers.num_input_channels(bus)),
             process_data.inputs[bus].numChannels);
-        inputs[bus].silenceFlags = process_data.inputs[bus].silenceFlags;
+        silent_input_samples[bus].resize(inputs[bus].numChannels);
+
+        // When the bus is processed in place the plugin will overwrite the
+        // input channels, so we can't assume they still contain silence
+        const bool bus_in_place =
+            bus < static_cast<int>(in_place_outputs.size()) &&
+            in_place_outputs[bus];
 
         // We copy the actual input audio for every bus to the shared memory
-        // object
-        for (int channel = 0; channel < inputs[bus].numChannels; channel++) {
-            if (process_data.symbolicSampleSize == Steinberg::Vst::kSample64) {
-                std::copy_n(process_data.inputs[bus].channelBuffers64[channel],
-                            process_data.numSamples,
-                            shared_audio_buffers.input_channel_ptr<double>(
-                                bus, channel));
-            } else {
-                std::copy_n(process_data.inputs[bus].channelBuffers32[channel],
-                            process_data.numSamples,
-                            shared_audio_buffers.input_channel_ptr<float>(
-                                bus, channel));
+        // object. Most hosts don't set the silence flags, so we'll also compute
+        // them ourselves. Silent channels don't need to be copied, and if the
+        // channel's region in the shared memory object already contains enough
+        // silence from the last processing cycle then we don't need to touch
+        // it at all. This assumes the plugin doesn't write to its input
+        // buffers, which would also break most hosts.
+        auto copy_inputs = [&]<typename T>(T** host_channels) {
+            inputs[bus].silenceFlags = 0;
+            for (int channel = 0; channel < inputs[bus].numChannels;
+                 channel++) {
+                T* shm_channel =
+                    shared_audio_buffers.input_channel_ptr<T>(bus, channel);
+                const bool silent =
+                    channel < 64 &&
+                    ((process_data.inputs[bus].silenceFlags &
+                      (static_cast<uint64>(1) << channel)) ||
+                     is_silent(host_channels[channel],
+                               process_data.numSamples));
+                if (silent) {
+                    inputs[bus].silenceFlags |= static_cast<uint64>(1)
+                                                << channel;
+                    if (!bus_in_place &&
+                        silent_input_samples[bus][channel] >=
+                            process_data.numSamples) {
+                        continue;
+                    }
+
+                    std::fill_n(shm_channel, process_data.numSamples,
+                                static_cast<T>(0.0));
+                    silent_input_samples[bus][channel] =
+                        bus_in_place ? 0 : process_data.numSamples;
+                } else {
+                    copy_samples(host_channels[channel],
+                                 process_data.numSamples, shm_channel);
+                    silent_input_samples[bus][channel] = 0;
+                }
             }
-        }
-    }
+        };
 
-    outputs.resize(process_data.numOutputs);
-    for (int bus = 0; bus < process_data.numOutputs; bus++) {
-        // NOTE: The host might provide more output channels than what the
-        //       plugin asked for. Carla does this for some reason. We should
-        //       just ignore these.
-        outputs[bus].numChannels = std::min(
-            static_cast<int32>(shared_audio_buffers.num_output_channels(bus)),
-            process_data.outputs[bus].numChannels);
-        outputs[bus].silenceFlags = process_data.outputs[bus].silenceFlags;
+        if (process_data.symbolicSampleSize == Steinberg::Vst::kSample64) {
+            copy_inputs(process_data.inputs[bus].channelBuffers64);
+        } else {
+            copy_inputs(process_data.inputs[bus].channelBuffers32);
+        }
     }
 
     // Even though `ProcessData::inputParamterChanges` is mandatory, the VST3
@@ -131,7 +209,8 @@ void YaProcessData::repopulate(const Steinberg::Vst::ProcessData& process_data,
 
 Steinberg::Vst::ProcessData& YaProcessData::reconstruct(
     std::vector<std::vector<void*>>& input_pointers,
-    std::vector<std::vector<void*>>& output_pointers) {
+    std::vector<std::vector<void*>>& output_pointers,
+    std::vector<std::vector<void*>>& in_place_output_pointers) {
     reconstructed_process_data.processMode = process_mode;
     reconstructed_process_data.symbolicSampleSize = symbolic_sample_size;
     reconstructed_process_data.numSamples = num_samples;
@@ -147,14 +226,17 @@ Steinberg::Vst::ProcessData& YaProcessData::reconstruct(
     //       same thing on both the native plugin side and on the Wine plugin
     //       host
     assert(inputs.size() <= input_pointers.size() &&
-           outputs.size() <= output_pointers.size());
+           outputs.size() <= output_pointers.size() &&
+           outputs.size() <= in_place_output_pointers.size() &&
+           outputs.size() == in_place_outputs.size());
     for (size_t bus = 0; bus < inputs.size(); bus++) {
         inputs[bus].channelBuffers32 =
             reinterpret_cast<float**>(input_pointers[bus].data());
     }
     for (size_t bus = 0; bus < outputs.size(); bus++) {
-        outputs[bus].channelBuffers32 =
-            reinterpret_cast<float**>(output_pointers[bus].data());
+        outputs[bus].channelBuffers32 = reinterpret_cast<float**>(
+            in_place_outputs[bus] ? in_place_output_pointers[bus].data()
+                                  : output_pointers[bus].data());
     }
 
     reconstructed_process_data.inputs = inputs.data();
@@ -203,29 +285,40 @@ void YaProcessData::write_back_outputs(
     const AudioShmBuffer& shared_audio_buffers) {
     assert(static_cast<int32>(outputs.size()) == process_data.numOutputs);
     for (int bus = 0; bus < process_data.numOutputs; bus++) {
-        process_data.outputs[bus].silenceFlags = outputs[bus].silenceFlags;
-
         // NOTE: Some hosts, like Carla, provide more output channels than what
         //       the plugin wants. We'll have already capped
         //       `outputs[bus].numChannels` to the number of channels requested
         //       by the plugin during `YaProcessData::repopulate()`.
-        for (int channel = 0; channel < outputs[bus].numChannels; channel++) {
-            // We copy the output audio for every bus from the shared memory
-            // object back to the buffer provided by the host
-            if (process_data.symbolicSampleSize == Steinberg::Vst::kSample64) {
-                std::copy_n(
-                    shared_audio_buffers.output_channel_ptr<double>(bus,
-                                                                    channel),
-                    process_data.numSamples,
-                    process_data.outputs[bus].channelBuffers64[channel]);
-            } else {
-                std::copy_n(
-                    shared_audio_buffers.output_channel_ptr<float>(bus,
-                                                                   channel),
-                    process_data.numSamples,
-                    process_data.outputs[bus].channelBuffers32[channel]);
+        auto copy_outputs = [&]<typename T>(T** host_channels) {
+            for (int channel = 0; channel < outputs[bus].numChannels;
+                 channel++) {
+                const T* shm_channel =
+                    output_channel_ptr<T>(shared_audio_buffers, bus, channel);
+
+                // We copy the output audio for every bus from the shared
+                // memory object back to the buffer provided by the host. Most
+                // plugins don't set the silence flags, so we'll set them for
+                // any silent channels so the host can skip those.
+                if (channel < 64 &&
+                    is_silent(shm_channel, process_data.numSamples)) {
+                    std::fill_n(host_channels[channel], process_data.numSamples,
+                                static_cast<T>(0.0));
+                    outputs[bus].silenceFlags |= static_cast<uint64>(1)
+                                                 << channel;
+                } else {
+                    copy_samples(shm_channel, process_data.numSamples,
+                                 host_channels[channel]);
+                }
             }
+        };
+
+        if (process_data.symbolicSampleSize == Steinberg::Vst::kSample64) {
+            copy_outputs(process_data.outputs[bus].channelBuffers64);
+        } else {
+            copy_outputs(process_data.outputs[bus].channelBuffers32);
         }
+
+        process_data.outputs[bus].silenceFlags = outputs[bus].silenceFlags;
     }
 
     if (output_parameter_changes && process_data.outputParameterChanges) {
@@ -237,3 +330,50 @@ void YaProcessData::write_back_outputs(
         output_events->write_back_outputs(*process_data.outputEvents);
     }
 }
+
+void YaProcessData::write_back_silence(
+    Steinberg::Vst::ProcessData& process_data) noexcept {
+    for (int bus = 0; bus < process_data.numOutputs; bus++) {
+        Steinberg::Vst::AudioBusBuffers& host_bus = process_data.outputs[bus];
+        for (int channel = 0; channel < host_bus.numChannels; channel++) {
+            if (process_data.symbolicSampleSize == Steinberg::Vst::kSample64) {
+                std::fill_n(host_bus.channelBuffers64[channel],
+                            process_data.numSamples, 0.0);
+            } else {
+                std::fill_n(host_bus.channelBuffers32[channel],
+                            process_data.numSamples, 0.0f);
+            }
+        }
+
+        host_bus.silenceFlags = all_channels_mask(host_bus.numChannels);
+    }
+}
+
+bool YaProcessData::inputs_silent() noexcept {
+    for (const auto& bus : inputs) {
+        const uint64 mask = all_channels_mask(bus.numChannels);
+        if (bus.numChannels > 64 || (bus.silenceFlags & mask) != mask) {
+            return false;
+        }
+    }
+
+    return input_parameter_changes.getParameterCount() == 0 &&
+           (!input_events || input_events->getEventCount() == 0);
+}
+
+bool YaProcessData::outputs_silent() const noexcept {
+    for (const auto& bus : outputs) {
+        const uint64 mask = all_channels_mask(bus.numChannels);
+        if (bus.numChannels > 64 || (bus.silenceFlags & mask) != mask) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void YaProcessData::clear_silent_inputs() noexcept {
+    for (auto& bus : silent_input_samples) {
+        std::fill(bus.begin(), bus.end(), 0);
+    }
+}
@@ -68,6 +68,11 @@ class YaProcessData {
      * `YaProcessData` object and those buffers, but they should be used as a
      * pair. This is a bit ugly, but optimizations sadly never made code
      * prettier.
+     *
+     * While doing so we'll also compute the silence flags for the inputs.
+     * Silent channels are not copied, and if a channel's region in the shared
+     * memory object already contains silence from a previous processing cycle
+     * then we won't touch it at all.
      */
     void repopulate(const Steinberg::Vst::ProcessData& process_data,
                     AudioShmBuffer& shared_audio_buffers);
@@ -90,10 +95,16 @@ class YaProcessData {
      * but we'll accept these as void pointers since the stride will be
      * different depending on whether the host is going to be sending double or
      * single precision audio.
+     *
+     * For output busses the host processes in place (see `in_place_outputs`),
+     * we'll use the pointers from `in_place_output_pointers` instead. Those
+     * point to the input channels of the bus with the same index where
+     * possible.
      */
     Steinberg::Vst::ProcessData& reconstruct(
         std::vector<std::vector<void*>>& input_pointers,
-        std::vector<std::vector<void*>>& output_pointers);
+        std::vector<std::vector<void*>>& output_pointers,
+        std::vector<std::vector<void*>>& in_place_output_pointers);
 
     /**
      * A serializable wrapper around the output fields of `ProcessData`, so we
@@ -149,11 +160,56 @@ class YaProcessData {
     /**
      * Write all of this output data back to the host's `ProcessData` object.
      * During this process we'll also write the output audio from the
-     * corresponding shared memory audio buffers back.
+     * corresponding shared memory audio buffers back, and we'll set the
+     * silence flags for any output channels that turned out to be silent.
      */
     void write_back_outputs(Steinberg::Vst::ProcessData& process_data,
                             const AudioShmBuffer& shared_audio_buffers);
 
+    /**
+     * Get a pointer to the region in `shared_audio_buffers` the plugin has
+     * written the output for a channel to. When the bus has been processed in
+     * place, the output for channels that also exist as input channels will
+     * have been written to the input channel's region instead.
+     */
+    template <typename T>
+    const T* output_channel_ptr(const AudioShmBuffer& shared_audio_buffers,
+                                uint32_t bus,
+                                uint32_t channel) const noexcept {
+        return in_place_outputs[bus] &&
+                       channel < shared_audio_buffers.num_input_channels(bus)
+                   ? shared_audio_buffers.input_channel_ptr<T>(bus, channel)
+                   : shared_audio_buffers.output_channel_ptr<T>(bus, channel);
+    }
+
+    /**
+     * Write silence to all of the host's output buffers and mark all output
+     * channels as silent. This is used instead of `write_back_outputs()` when
+     * we skip the processing cycle altogether.
+     */
+    static void write_back_silence(
+        Steinberg::Vst::ProcessData& process_data) noexcept;
+
+    /**
+     * Whether all input channels are silent and there are no incoming
+     * parameter changes or events. This should be called after
+     * `repopulate()`.
+     */
+    bool inputs_silent() noexcept;
+
+    /**
+     * Whether all output channels were silent during the last processing
+     * cycle. This should be called after `write_back_outputs()`.
+     */
+    bool outputs_silent() const noexcept;
+
+    /**
+     * Forget which input channels in the shared memory object are known to
+     * contain silence. This needs to be called whenever those buffers get
+     * resized since the audio will have moved around.
+     */
+    void clear_silent_inputs() noexcept;
+
     template <typename S>
     void serialize(S& s) {
         s.value4b(process_mode);
@@ -164,6 +220,7 @@ class YaProcessData {
         // using an accompanying `AudioShmBuffer` object.
         s.container(inputs, max_num_speakers);
         s.container(outputs, max_num_speakers);
+        s.container1b(in_place_outputs, max_num_speakers);
 
         // The output parameter changes and events will remain empty on the
         // plugin side, so by serializing them we merely indicate to the Wine
@@ -216,6 +273,21 @@ class YaProcessData {
      */
     boost::container::small_vector<Steinberg::Vst::AudioBusBuffers, 8> outputs;
 
+    /**
+     * Whether the host processes the output bus with the same index in place,
+     * i.e. whether the host passed the same buffers for that bus's input and
+     * output channels. If that's the case, then we'll also let the Windows
+     * plugin process those channels in place. The plugin then writes its
+     * output to the input channel regions in the shared memory object, and
+     * we'll copy the results back from there in `write_back_outputs()`. This
+     * does not save any copies since the host's buffers still need to be
+     * copied to and from the shared memory object, but it halves the amount of
+     * shared memory the two processes touch for those channels. This is only
+     * enabled if the host provided at least as many input and output channels
+     * as there are aliased channels in the shared memory object.
+     */
+    boost::container::small_vector<bool, 8> in_place_outputs;
+
     /**
      * Incoming parameter changes.
      */
@@ -245,6 +317,17 @@ class YaProcessData {
     std::optional<Steinberg::Vst::ProcessContext> process_context;
 
    private:
+    /**
+     * Used on the plugin side to keep track of how many samples of silence
+     * every input channel's region in the shared memory object currently
+     * contains, indexed by `[bus][channel]`. If a silent input channel already
+     * contains enough silence, then we don't need to write to it again. This
+     * is not serialized.
+     */
+    boost::container::small_vector<boost::container::small_vector<int32, 8>,
+                                   8>
+        silent_input_samples;
+
     // These last few members are used on the Wine plugin host side to
     // reconstruct the original `ProcessData` object. Here we also initialize
     // these `output*` fields so the Windows VST3 plugin can write to them
@@ -16,7 +16,13 @@
 
 #include "utils.h"
 
+#include <array>
+#include <system_error>
+
+#include <fcntl.h>
 #include <sched.h>
+#include <sys/file.h>
+#include <unistd.h>
 #include <xmmintrin.h>
 #include <boost/process/environment.hpp>
 
@@ -103,6 +109,13 @@ bool pid_running(pid_t pid) {
     return !err.failed() || err.value() == EACCES;
 }
 
+bool equals_case_insensitive(const std::string& a, const std::string& b) {
+    return std::equal(a.begin(), a.end(), b.begin(),
+                      [](const char& a_char, const char& b_char) {
+                          return std::tolower(a_char) == std::tolower(b_char);
+                      });
+}
+
 std::string url_encode_path(std::string path) {
     // We only need to escape a couple of special characters here. This is used
     // in the notifications as well as in the XDND proxy. We encode the reserved
@@ -212,6 +225,53 @@ std::string xml_escape(std::string string) {
     return escaped;
 }
 
+PoolSlotLock::PoolSlotLock(const fs::path& pool_socket_path)
+    : fd(open(fs::path(pool_socket_path).replace_extension(".lock").c_str(),
+              O_RDWR | O_CREAT | O_CLOEXEC,
+              0600)) {
+    if (fd == -1) {
+        throw std::system_error(errno, std::system_category(),
+                                "Could not open the pool slot's lock file");
+    }
+
+    if (flock(fd, LOCK_EX) == -1) {
+        const int error = errno;
+        close(fd);
+
+        throw std::system_error(error, std::system_category(),
+                                "Could not lock the pool slot's lock file");
+    }
+}
+
+PoolSlotLock::~PoolSlotLock() noexcept {
+    // Closing the file also releases the lock
+    close(fd);
+}
+
+bool PoolSlotLock::is_owned() {
+    std::array<char, 16> buffer{};
+    const ssize_t size = pread(fd, buffer.data(), buffer.size() - 1, 0);
+    if (size <= 0) {
+        return false;
+    }
+
+    const pid_t owner_pid = static_cast<pid_t>(std::atoi(buffer.data()));
+
+    return owner_pid > 0 && pid_running(owner_pid);
+}
+
+void PoolSlotLock::set_owner(std::optional<pid_t> pid) {
+    // The file is either empty or contains a single PID, so we'll just
+    // overwrite the whole thing
+    const std::string contents = pid ? std::to_string(*pid) : "";
+    if (ftruncate(fd, 0) == -1 ||
+        pwrite(fd, contents.data(), contents.size(), 0) !=
+            static_cast<ssize_t>(contents.size())) {
+        throw std::system_error(errno, std::system_category(),
+                                "Could not write the pool slot's lock file");
+    }
+}
+
 ScopedFlushToZero::ScopedFlushToZero() noexcept {
     old_ftz_mode = _MM_GET_FLUSH_ZERO_MODE();
     _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
@@ -142,6 +142,13 @@ bool is_watchdog_timer_disabled();
  */
 bool pid_running(pid_t pid);
 
+/**
+ * Returns equality for two strings when ignoring casing. Used for comparing
+ * filenames inside of Wine prefixes since Windows/Wine does case folding for
+ * filenames.
+ */
+bool equals_case_insensitive(const std::string& a, const std::string& b);
+
 /**
  * URL encode a file path. We won't escape forward slashes, and `path` should
  * not yet include the `file://` prefix.
@@ -153,6 +160,56 @@ std::string url_encode_path(std::string path);
  */
 std::string xml_escape(std::string string);
 
+/**
+ * An exclusive lock on the ownership file for one of the slots in the pool of
+ * idle Wine plugin host processes used with the `host_pool_size` option. This
+ * file lives next to the slot's socket and contains the PID of the idle host
+ * process that currently owns the slot. A Wine process takes a couple of
+ * seconds to start, and during that time it won't be listening on the slot's
+ * socket yet. Without this file a plugin loaded in the meantime would consider
+ * the slot to be empty and start yet another process for it. The lock is held
+ * only for as long as it takes to check and update the owner.
+ */
+class PoolSlotLock {
+   public:
+    /**
+     * Open the slot's ownership file and lock it, blocking until any other
+     * process holding the lock releases it.
+     *
+     * @param pool_socket_path The slot's socket endpoint, generated by
+     *   `generate_pool_endpoint()`. The ownership file uses the same name with
+     *   a `.lock` extension.
+     *
+     * @throw std::system_error If the file could not be opened or locked.
+     */
+    PoolSlotLock(const boost::filesystem::path& pool_socket_path);
+
+    /**
+     * Unlock and close the file.
+     */
+    ~PoolSlotLock() noexcept;
+
+    PoolSlotLock(const PoolSlotLock&) = delete;
+    PoolSlotLock& operator=(const PoolSlotLock&) = delete;
+
+    /**
+     * Whether the slot is owned by a process that's still running. If this
+     * returns `false`, then the caller may start a new idle host process for
+     * the slot.
+     */
+    bool is_owned();
+
+    /**
+     * Store the PID of the process that now owns the slot, or clear the owner
+     * if `pid` is a nullopt. An idle host process does the latter when it
+     * gets claimed by a plugin so the slot can be filled again.
+     */
+    void set_owner(std::optional<pid_t> pid);
+
+   private:
+    int fd;
+};
+
 /**
  * A RAII wrapper that will temporarily enable the FTZ flag so that denormals
  * are automatically flushed to zero, returning to whatever the flag was
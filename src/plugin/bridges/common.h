@@ -16,8 +16,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <future>
 #include <iomanip>
+#include <mutex>
 
 #include <sys/resource.h>
 
@@ -26,8 +28,10 @@
 #include <version.h>
 
 #include "../../common/configuration.h"
+#include "../../common/metadata-cache.h"
 #include "../../common/utils.h"
 #include "../host-process.h"
+#include "../stats-server.h"
 
 /**
  * If the amount of lockable memory is below this, then we'll warn about it
@@ -59,8 +63,10 @@ class PluginBridge {
    public:
     /**
      * Sets up everything needed to start the host process. Classes deriving
-     * from this should call `log_init_message()` and
+     * from this should call `launch_host()`, `log_init_message()` and
      * `connect_sockets_guarded()` themselves after their initialization list.
+     * Launching the host can be deferred until it's actually needed when the
+     * plugin's metadata could be read from `metadata_cache`.
      *
      * @param plugin_type The type of the plugin we're handling.
      * @param plugin_path The path to the plugin. For VST2 plugins this is the
@@ -68,66 +74,83 @@ class PluginBridge {
      *   module (either a `.vst3` DLL file or a bundle).
      * @param create_socket_instance A function to create a socket instance.
      *   Using a lambda here feels wrong, but I can't think of a better
-     *   solution right now.
+     *   solution right now. This also receives the plugin's configuration
+     *   since that can affect how the sockets are set up.
      *
      * @throw std::runtime_error Thrown when the Wine plugin host could not be
      *   found, or if it could not locate and load a VST3 module.
      */
     template <invocable_returning<TSockets,
                                   boost::asio::io_context&,
-                                  const PluginInfo&> F>
+                                  const PluginInfo&,
+                                  const Configuration&> F>
     PluginBridge(PluginType plugin_type, F&& create_socket_instance)
         // This is still correct for VST3 plugins because we can configure an
         // entire directory (the module's bundle) at once
         : config(load_config_for(get_this_file_location())),
           info(plugin_type, config.vst3_prefer_32bit),
+          metadata_cache(config.cache_plugin_metadata
+                             ? PluginMetadataCache(plugin_type,
+                                                   info.windows_plugin_path,
+                                                   info.library_path())
+                             : PluginMetadataCache()),
           io_context(),
-          sockets(create_socket_instance(io_context, info)),
+          sockets(create_socket_instance(io_context, info, config)),
           generic_logger(Logger::create_from_environment(
               create_logger_prefix(sockets.base_dir))),
-          plugin_host(
-              config.group
-                  ? std::unique_ptr<HostProcess>(std::make_unique<GroupHost>(
-                        io_context,
-                        generic_logger,
-                        config,
-                        sockets,
-                        info,
-                        HostRequest{
-                            .plugin_type = plugin_type,
-                            .plugin_path = info.windows_plugin_path.string(),
-                            .endpoint_base_dir = sockets.base_dir.string(),
-                            .parent_pid = getpid()}))
-                  : std::unique_ptr<HostProcess>(
-                        std::make_unique<IndividualHost>(
-                            io_context,
-                            generic_logger,
-                            config,
-                            sockets,
-                            info,
-                            HostRequest{
-                                .plugin_type = plugin_type,
-                                .plugin_path =
-                                    info.windows_plugin_path.string(),
-                                .endpoint_base_dir = sockets.base_dir.string(),
-                                .parent_pid = getpid()}))),
-          has_realtime_priority(has_realtime_priority_promise.get_future()),
-          wine_io_handler([&]() {
-              // We no longer run this thread with realtime scheduling because
-              // plugins that produce a lot of FIXMEs could in theory cause
-              // dropouts that way, but we still need to run this from a thread
-              // to check whether we support it
-              has_realtime_priority_promise.set_value(
-                  set_realtime_priority(true));
-              set_realtime_priority(false);
-              pthread_setname_np(pthread_self(), "wine-stdio");
-
-              io_context.run();
-          }) {}
+          has_realtime_priority(has_realtime_priority_promise.get_future()) {}
 
     virtual ~PluginBridge() noexcept {};
 
    protected:
+    /**
+     * Start the Wine plugin host process, take an idle one from the host pool,
+     * or connect to an existing group host process, and start relaying its
+     * output. This should be called exactly once, before `log_init_message()`
+     * and `connect_sockets_guarded()`.
+     */
+    void launch_host() {
+        const HostRequest request{
+            .plugin_type = info.plugin_type,
+            .plugin_path = info.windows_plugin_path.string(),
+            .endpoint_base_dir = sockets.base_dir.string(),
+            .parent_pid = getpid()};
+        if (config.group) {
+            plugin_host = std::make_unique<GroupHost>(
+                io_context, generic_logger, config, sockets, info, request);
+        } else if (uses_host_pool()) {
+            plugin_host = std::make_unique<PooledHost>(
+                io_context, generic_logger, config, sockets, info, request);
+        } else {
+            plugin_host = std::make_unique<IndividualHost>(
+                io_context, generic_logger, config, sockets, info, request);
+        }
+
+        wine_io_handler = std::jthread([&]() {
+            // We no longer run this thread with realtime scheduling because
+            // plugins that produce a lot of FIXMEs could in theory cause
+            // dropouts that way, but we still need to run this from a thread
+            // to check whether we support it
+            has_realtime_priority_promise.set_value(
+                set_realtime_priority(true));
+            set_realtime_priority(false);
+            pthread_setname_np(pthread_self(), "wine-stdio");
+
+            io_context.run();
+        });
+    }
+
+    /**
+     * Whether `launch_host()` should take an idle host process from the host
+     * pool. The idle processes are started before we know which plugin will
+     * use them, so they always have their output piped to the plugin that
+     * started them. Plugins that need the `disable_pipes` option to function
+     * can thus never use the pool.
+     */
+    bool uses_host_pool() const noexcept {
+        return config.host_pool_size.value_or(0) > 0 && !config.disable_pipes;
+    }
+
     /**
      * Format and log all relevant debug information during initialization.
      */
@@ -262,6 +285,11 @@ class PluginBridge {
         init_msg << "hosting mode:  '";
         if (config.group) {
             init_msg << "plugin group \"" << *config.group << "\"";
+        } else if (uses_host_pool()) {
+            init_msg << "individually, pool of "
+                     << *config.host_pool_size << " idle hosts";
+        } else if (config.host_pool_size.value_or(0) > 0) {
+            init_msg << "individually, pool disabled by disable_pipes";
         } else {
             init_msg << "individually";
         }
@@ -277,6 +305,20 @@ class PluginBridge {
 
         init_msg << "other options: ";
         std::vector<std::string> other_options;
+        if (config.audio_pipelining) {
+            other_options.push_back("audio: pipelined");
+        }
+        if (config.audio_spin_us) {
+            other_options.push_back("audio: spin for " +
+                                    std::to_string(*config.audio_spin_us) +
+                                    " us");
+        }
+        if (config.cache_plugin_metadata) {
+            other_options.push_back("metadata: cached");
+        }
+        if (config.cache_state) {
+            other_options.push_back("state: cached");
+        }
         if (config.disable_pipes) {
             other_options.push_back(
                 "hack: pipes disabled, plugin output will go to \"" +
@@ -300,12 +342,24 @@ class PluginBridge {
         if (config.hide_daw) {
             other_options.push_back("hack: hide DAW name");
         }
+        if (config.vst2_cache_strings) {
+            other_options.push_back("vst2: parameter strings cached");
+        }
+        if (config.vst2_multiplex_sockets) {
+            other_options.push_back("vst2: multiplexed sockets");
+        }
+        if (config.vst2_shared_parameters) {
+            other_options.push_back("vst2: shared parameters");
+        }
         if (config.vst3_no_scaling) {
             other_options.push_back("vst3: no GUI scaling");
         }
         if (config.vst3_prefer_32bit) {
             other_options.push_back("vst3: prefer 32-bit");
         }
+        if (config.vst3_skip_silence) {
+            other_options.push_back("vst3: skip silence");
+        }
         if (!other_options.empty()) {
             init_msg << join_quoted_strings(other_options) << std::endl;
         } else {
@@ -402,6 +456,43 @@ class PluginBridge {
 #endif
     }
 
+    /**
+     * Start listening on the stats socket in this instance's socket base
+     * directory. See `StatsServer` for more information. The report starts
+     * with some general information about the plugin, followed by whatever
+     * `generate_report` writes to the stream. Failing to set up the socket is
+     * not fatal, so we'll just log a warning when that happens.
+     *
+     * @param stats_server The object to initialize. This should be declared
+     *   after the data used by `generate_report` so it gets destroyed first.
+     * @param generate_report A function that writes this instance's
+     *   performance counters to a stream. This will be called from the IO
+     *   context's thread.
+     */
+    template <std::invocable<std::ostream&> F>
+    void start_stats_server(std::optional<StatsServer>& stats_server,
+                            F generate_report) {
+        try {
+            stats_server.emplace(
+                io_context, sockets.base_dir / stats_endpoint_name,
+                [this, generate_report]() {
+                    std::ostringstream report;
+                    report << "version: " << yabridge_git_version << std::endl;
+                    report << "plugin: " << info.windows_plugin_path.string()
+                           << std::endl;
+                    report << "plugin_type: "
+                           << plugin_type_to_string(info.plugin_type)
+                           << std::endl;
+                    generate_report(report);
+
+                    return report.str();
+                });
+        } catch (const boost::system::system_error& error) {
+            generic_logger.log("WARNING: Could not create the stats socket:");
+            generic_logger.log(std::string("         ") + error.what());
+        }
+    }
+
     /**
      * Show a desktop notification if the Wine plugin host is using a different
      * version of yabridge than this library. Yabridge may still work (and we do
@@ -439,6 +530,14 @@ class PluginBridge {
      */
     const PluginInfo info;
 
+    /**
+     * Metadata from an earlier run that can be used to answer the host's
+     * queries while it's scanning for plugins, without having to start the
+     * Wine plugin host. Only used when the `cache_plugin_metadata` option is
+     * enabled.
+     */
+    const PluginMetadataCache metadata_cache;
+
     boost::asio::io_context io_context;
 
     /**
@@ -463,9 +562,25 @@ class PluginBridge {
      * The Wine process hosting our plugins. In the case of group hosts a
      * `PluginBridge` instance doesn't actually own a process, but rather either
      * spawns a new detached process or it connects to an existing one.
+     *
+     * This will be a null pointer until `launch_host()` has been called.
      */
     std::unique_ptr<HostProcess> plugin_host;
 
+    /**
+     * Used by the derived classes to start the Wine plugin host exactly once,
+     * either during initialization or the first time the plugin gets used
+     * after it has been loaded using cached metadata.
+     */
+    std::once_flag plugin_host_started_flag;
+    /**
+     * Set once the Wine plugin host has been started and the bridge has been
+     * fully initialized. Until this is set, all requests should either be
+     * answered using cached metadata or they should start the Wine plugin
+     * host first.
+     */
+    std::atomic_bool plugin_host_started = false;
+
    private:
     /**
      * The promise belonging to `has_realtime_priority` below.
@@ -484,7 +599,7 @@ class PluginBridge {
 
     /**
      * Runs the Boost.Asio `io_context` thread for logging the Wine process
-     * STDOUT and STDERR messages.
+     * STDOUT and STDERR messages. Started in `launch_host()`.
      */
     std::jthread wine_io_handler;
 
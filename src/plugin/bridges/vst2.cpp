@@ -16,6 +16,7 @@
 
 #include "vst2.h"
 
+#include "../../common/audio-kernels.h"
 #include "../../common/communication/vst2.h"
 #include "../utils.h"
 
@@ -35,16 +36,124 @@ Vst2PluginBridge& get_bridge_instance(const AEffect& plugin) noexcept {
     return *static_cast<Vst2PluginBridge*>(plugin.ptr3);
 }
 
+/**
+ * Whether a dispatcher opcode only queries information from the plugin, and
+ * thus can't change the plugin's state. Every other opcode invalidates the
+ * state cache.
+ */
+static bool is_read_only_opcode(int opcode) noexcept {
+    switch (opcode) {
+        case effGetProgram:
+        case effGetProgramName:
+        case effGetParamLabel:
+        case effGetParamDisplay:
+        case effGetParamName:
+        case effEditGetRect:
+        case effEditIdle:
+        case effGetChunk:
+        case effCanBeAutomated:
+        case effGetProgramNameIndexed:
+        case effGetInputProperties:
+        case effGetOutputProperties:
+        case effGetPlugCategory:
+        case effGetEffectName:
+        case effGetVendorString:
+        case effGetProductString:
+        case effGetVendorVersion:
+        case effCanDo:
+        case effGetTailSize:
+        case effIdle:
+        case effGetParameterProperties:
+        case effGetVstVersion:
+        case effGetMidiKeyName:
+        case effGetSpeakerArrangement:
+            return true;
+            break;
+        default:
+            return false;
+            break;
+    }
+}
+
+/**
+ * Whether the result of a dispatcher call only depends on the plugin itself,
+ * and not on the plugin's state. The results of these calls are stored in the
+ * plugin metadata cache since hosts use them while scanning plugins.
+ */
+static bool is_metadata_opcode(int opcode) noexcept {
+    switch (opcode) {
+        case effGetPlugCategory:
+        case effGetEffectName:
+        case effGetVendorString:
+        case effGetProductString:
+        case effGetVendorVersion:
+        case effCanDo:
+        case effGetVstVersion:
+            return true;
+            break;
+        default:
+            return false;
+            break;
+    }
+}
+
+/**
+ * Whether a metadata opcode writes a string to the `data` argument.
+ */
+static bool is_metadata_string_opcode(int opcode) noexcept {
+    return opcode == effGetEffectName || opcode == effGetVendorString ||
+           opcode == effGetProductString;
+}
+
+/**
+ * Whether a dispatcher opcode can change the plugin's parameter names, labels,
+ * or program names, in which case everything in the parameter string cache
+ * should be refetched.
+ */
+static bool changes_parameter_strings(int opcode) noexcept {
+    switch (opcode) {
+        case effOpen:
+        case effSetProgramName:
+        case effSetChunk:
+        case effBeginLoadBank:
+        case effBeginLoadProgram:
+            return true;
+            break;
+        default:
+            return false;
+            break;
+    }
+}
+
+/**
+ * Whether a dispatcher opcode can change the values of all of the plugin's
+ * parameters at once, without changing their names.
+ */
+static bool changes_parameter_values(int opcode) noexcept {
+    switch (opcode) {
+        case effSetProgram:
+        case effBeginSetProgram:
+        case effEndSetProgram:
+            return true;
+            break;
+        default:
+            return false;
+            break;
+    }
+}
+
 Vst2PluginBridge::Vst2PluginBridge(audioMasterCallback host_callback)
     : PluginBridge(
           PluginType::vst2,
-          [](boost::asio::io_context& io_context, const PluginInfo& info) {
+          [](boost::asio::io_context& io_context,
+             const PluginInfo& info,
+             const Configuration& config) {
               return Vst2Sockets<std::jthread>(
                   io_context,
                   generate_endpoint_base(info.native_library_path.filename()
                                              .replace_extension("")
                                              .string()),
-                  true);
+                  true, config.vst2_multiplex_sockets);
           }),
       // All the fields should be zero initialized because
       // `Vst2PluginInstance::vstAudioMasterCallback` from Bitwig's plugin
@@ -52,14 +161,8 @@ Vst2PluginBridge::Vst2PluginBridge(audioMasterCallback host_callback)
       plugin(),
       host_callback_function(host_callback),
       logger(generic_logger) {
-    log_init_message();
-
-    // This will block until all sockets have been connected to by the Wine VST
-    // host
-    connect_sockets_guarded();
-
     // Set up all pointers for our `AEffect` struct. We will fill this with data
-    // from the VST plugin loaded in Wine at the end of this constructor.
+    // from the VST plugin loaded in Wine, or from the metadata cache.
     plugin.ptr3 = this;
     plugin.dispatcher = dispatch_proxy;
     plugin.process = process_proxy;
@@ -68,6 +171,53 @@ Vst2PluginBridge::Vst2PluginBridge(audioMasterCallback host_callback)
     plugin.processReplacing = process_replacing_proxy;
     plugin.processDoubleReplacing = process_double_replacing_proxy;
 
+    // If we've seen this exact plugin before, then we can answer the host's
+    // queries during plugin scanning without starting Wine at all
+    if (std::optional<Vst2PluginMetadata> cached_metadata =
+            metadata_cache.load<Vst2PluginMetadata>()) {
+        metadata = std::move(*cached_metadata);
+        update_aeffect(plugin, metadata.initialized_plugin);
+
+        logger.log(
+            "Using cached plugin metadata, the Wine plugin host will be "
+            "started when it's first needed");
+    } else {
+        ensure_plugin_host_started();
+    }
+}
+
+void Vst2PluginBridge::ensure_plugin_host_started() {
+    if (plugin_host_started.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::call_once(plugin_host_started_flag, [&]() {
+        start_plugin_host();
+        plugin_host_started.store(true, std::memory_order_release);
+
+        // These calls were answered without involving the plugin while the
+        // Wine plugin host was not yet running, so we'll need to replay them
+        if (deferred_open) {
+            dispatch(&plugin, effOpen, 0, 0, nullptr, 0.0);
+        }
+        if (sample_rate > 0.0) {
+            dispatch(&plugin, effSetSampleRate, 0, 0, nullptr, sample_rate);
+        }
+        if (max_block_size > 0) {
+            dispatch(&plugin, effSetBlockSize, 0,
+                     static_cast<intptr_t>(max_block_size), nullptr, 0.0);
+        }
+    });
+}
+
+void Vst2PluginBridge::start_plugin_host() {
+    launch_host();
+    log_init_message();
+
+    // This will block until all sockets have been connected to by the Wine VST
+    // host
+    connect_sockets_guarded();
+
     // For our communication we use simple threads and blocking operations
     // instead of asynchronous IO since communication has to be handled in
     // lockstep anyway
@@ -78,6 +228,25 @@ Vst2PluginBridge::Vst2PluginBridge(audioMasterCallback host_callback)
         sockets.vst_host_callback.receive_events(
             std::pair<Vst2Logger&, bool>(logger, false),
             [&](Vst2Event& event, bool /*on_main_thread*/) {
+                // These callbacks indicate that the plugin's state has changed
+                if (event.opcode == audioMasterAutomate ||
+                    event.opcode == audioMasterUpdateDisplay ||
+                    event.opcode == audioMasterIOChanged) {
+                    state_cache.invalidate();
+                }
+                // Shell plugins decide which plugin to load based on this, so
+                // their metadata depends on more than just the plugin's library
+                if (event.opcode == audioMasterCurrentId) {
+                    std::lock_guard lock(metadata_mutex);
+                    metadata_cacheable = false;
+                }
+                if (event.opcode == audioMasterAutomate) {
+                    parameter_strings.invalidate_value(event.index);
+                } else if (event.opcode == audioMasterUpdateDisplay ||
+                           event.opcode == audioMasterIOChanged) {
+                    parameter_strings.invalidate();
+                }
+
                 switch (event.opcode) {
                     // MIDI events sent from the plugin back to the host are
                     // a special case here. They have to sent during the
@@ -87,10 +256,28 @@ Vst2PluginBridge::Vst2PluginBridge(audioMasterCallback host_callback)
                     // actually send them to the host at the end of the
                     // `process_replacing()` function.
                     case audioMasterProcessEvents: {
-                        std::lock_guard lock(incoming_midi_events_mutex);
-
-                        incoming_midi_events.push_back(
-                            std::get<DynamicVstEvents>(event.payload));
+                        const auto& events =
+                            std::get<DynamicVstEvents>(event.payload);
+
+                        // The SysEx payloads are stored in order in an
+                        // associative list
+                        auto sysex = events.sysex_data.begin();
+                        for (size_t i = 0; i < events.events.size(); i++) {
+                            std::string_view sysex_data;
+                            if (sysex != events.sysex_data.end() &&
+                                sysex->first == i) {
+                                sysex_data = sysex->second;
+                                sysex++;
+                            }
+
+                            if (!incoming_midi_events.push(events.events[i],
+                                                           sysex_data)) {
+                                logger.log(
+                                    "WARNING: Dropping a MIDI event sent by "
+                                    "the plugin, the queue is full or the "
+                                    "SysEx data is too large");
+                            }
+                        }
 
                         return Vst2EventResult{.return_value = 1,
                                                .payload = nullptr,
@@ -147,6 +334,24 @@ Vst2PluginBridge::Vst2PluginBridge(audioMasterCallback host_callback)
                                 .value_payload = std::nullopt};
                         }
                     } break;
+                    // When using pipelined processing we need to add our own
+                    // latency to the plugin's reported latency before the
+                    // host gets to see the updated `AEffect` object
+                    case audioMasterIOChanged: {
+                        if (output_delay_line.delay() > 0) {
+                            update_aeffect(plugin,
+                                           std::get<AEffect>(event.payload));
+                            plugin.initialDelay +=
+                                static_cast<int>(output_delay_line.delay());
+
+                            return Vst2EventResult{
+                                .return_value = host_callback_function(
+                                    &plugin, event.opcode, event.index,
+                                    event.value, nullptr, event.option),
+                                .payload = nullptr,
+                                .value_payload = std::nullopt};
+                        }
+                    } break;
                     case audioMasterDeadBeef:
                         logger.log("");
                         logger.log(
@@ -187,12 +392,31 @@ Vst2PluginBridge::Vst2PluginBridge(audioMasterCallback host_callback)
     sockets.host_vst_control.send(config);
 
     update_aeffect(plugin, initialized_plugin);
+    {
+        std::lock_guard lock(metadata_mutex);
+        metadata.initialized_plugin = initialized_plugin;
+    }
+
+    start_stats_server(stats_server, [&](std::ostream& report) {
+        process_stats.print(report);
+    });
+
+    // The Wine plugin host will also set up a table containing the plugin's
+    // parameter values in shared memory, see `ParameterShmTable`
+    if (config.vst2_shared_parameters && initialized_plugin.numParams > 0) {
+        parameter_table.emplace(
+            sockets.base_dir.filename().string() + "-parameters",
+            static_cast<uint32_t>(initialized_plugin.numParams));
+    }
 }
 
 Vst2PluginBridge::~Vst2PluginBridge() noexcept {
     try {
-        // Drop all work make sure all sockets are closed
-        plugin_host->terminate();
+        // Drop all work make sure all sockets are closed. The Wine plugin host
+        // may never have been started if the host only scanned the plugin.
+        if (plugin_host) {
+            plugin_host->terminate();
+        }
 
         // The `stop()` method will cause the IO context to just drop all of its
         // outstanding work immediately
@@ -204,6 +428,34 @@ Vst2PluginBridge::~Vst2PluginBridge() noexcept {
     }
 }
 
+/**
+ * Used to fill `Vst2PluginBridge::parameter_strings` using a single
+ * `effYabridgeGetParameterStrings()` request.
+ */
+class ParameterStringsDataConverter : public DefaultDataConverter {
+   public:
+    ParameterStringsDataConverter(WantsParameterStrings request,
+                                  Vst2ParameterStrings& strings) noexcept
+        : request(std::move(request)), strings(strings) {}
+
+    Vst2Event::Payload read_data(const int /*opcode*/,
+                                 const int /*index*/,
+                                 const intptr_t /*value*/,
+                                 const void* /*data*/) const override {
+        return request;
+    }
+
+    void write_data(const int /*opcode*/,
+                    void* /*data*/,
+                    const Vst2EventResult& response) const override {
+        strings = std::get<Vst2ParameterStrings>(response.payload);
+    }
+
+   private:
+    const WantsParameterStrings request;
+    Vst2ParameterStrings& strings;
+};
+
 class DispatchDataConverter : public DefaultDataConverter {
    public:
     DispatchDataConverter(std::optional<AudioShmBuffer>& process_buffers,
@@ -521,6 +773,98 @@ intptr_t Vst2PluginBridge::dispatch(AEffect* /*plugin*/,
         return 0;
     }
 
+    // When the plugin was loaded using cached metadata, we'll keep answering
+    // the host's queries from that metadata until it needs something that
+    // requires the actual plugin
+    if (!plugin_host_started.load(std::memory_order_acquire)) {
+        if (opcode == effClose) {
+            logger.log_event(true, opcode, index, value, nullptr, option,
+                             std::nullopt);
+            logger.log_event_response(true, opcode, 0, nullptr, std::nullopt,
+                                      true);
+
+            delete this;
+
+            return 0;
+        }
+
+        if (const std::optional<intptr_t> result =
+                dispatch_from_metadata(opcode, index, value, data, option)) {
+            return *result;
+        }
+
+        ensure_plugin_host_started();
+    }
+
+    // With pipelined processing the Wine plugin host may still be processing
+    // the last block. The plugin should only receive the events for the next
+    // block, or be suspended or closed, after it has finished processing that
+    // block.
+    if (opcode == effProcessEvents || opcode == effMainsChanged ||
+        opcode == effClose) {
+        finish_pending_process();
+    }
+
+    // The Wine plugin host stops updating the parameter table once the plugin
+    // gets suspended
+    if (opcode == effMainsChanged && value == 0) {
+        parameter_table_active = false;
+    }
+
+    // Hosts will often request the plugin's state over and over again when
+    // creating undo points or autosaving. If nothing could have changed since
+    // the last time we fetched the state, then we can return that same state
+    // again without involving the Wine plugin host.
+    if (config.cache_state && opcode == effGetChunk &&
+        state_cache.contains(index)) {
+        logger.log_event(true, opcode, index, value, WantsChunkBuffer{},
+                         option, std::nullopt);
+        *static_cast<uint8_t**>(data) = chunk_data.data();
+        logger.log_event_response(true, opcode,
+                                  static_cast<intptr_t>(chunk_data.size()),
+                                  nullptr, std::nullopt, true);
+
+        return static_cast<intptr_t>(chunk_data.size());
+    }
+    if (!is_read_only_opcode(opcode)) {
+        state_cache.invalidate();
+    }
+
+    // The same goes for the parameter and program names the host draws in its
+    // mixer and automation lanes. These are fetched in batches and then served
+    // from a cache until they get invalidated.
+    const bool use_parameter_string_cache =
+        config.vst2_cache_strings &&
+        ParameterStringCache::is_cached_opcode(opcode) &&
+        !(opcode == effGetProgramNameIndexed && value > 0);
+    if (use_parameter_string_cache) {
+        if (const auto entry = get_cached_parameter_string(opcode, index)) {
+            logger.log_event(true, opcode, index, value, WantsString{},
+                             option, std::nullopt);
+            char* output = static_cast<char*>(data);
+            std::copy(entry->string.begin(), entry->string.end(), output);
+            output[entry->string.size()] = 0;
+            logger.log_event_response(
+                true, opcode, static_cast<intptr_t>(entry->return_value),
+                entry->string, std::nullopt, true);
+
+            return static_cast<intptr_t>(entry->return_value);
+        }
+    }
+    if (changes_parameter_strings(opcode)) {
+        parameter_strings.invalidate();
+    } else if (changes_parameter_values(opcode)) {
+        parameter_strings.invalidate_values();
+    } else if (opcode == effString2Parameter) {
+        parameter_strings.invalidate_value(index);
+    }
+    if (opcode == effEditOpen) {
+        state_cache.set_editor_open(true);
+    } else if (opcode == effEditClose) {
+        state_cache.set_editor_open(false);
+    }
+    const uint64_t state_generation = state_cache.generation();
+
     DispatchDataConverter converter(process_buffers, chunk_data, plugin,
                                     editor_rectangle);
 
@@ -542,6 +886,13 @@ intptr_t Vst2PluginBridge::dispatch(AEffect* /*plugin*/,
                 logger.log("The plugin crashed during shutdown, ignoring");
             }
 
+            {
+                std::lock_guard lock(metadata_mutex);
+                if (metadata_changed && metadata_cacheable) {
+                    metadata_cache.store(metadata, generic_logger);
+                }
+            }
+
             delete this;
 
             return return_value;
@@ -604,19 +955,319 @@ intptr_t Vst2PluginBridge::dispatch(AEffect* /*plugin*/,
         } break;
     }
 
-    // We don't reuse any buffers here like we do for audio processing. This
-    // would be useful for chunk data, but since that's only needed when saving
-    // and loading plugin state it's much better to have bitsery or our
-    // receiving function temporarily allocate a large enough buffer rather than
-    // to have a bunch of allocated memory sitting around doing nothing.
-    return sockets.host_vst_dispatch.send_event(
+    // We don't reuse any buffers here like we do for audio processing. Chunk
+    // data is only needed when saving and loading plugin state, and large
+    // chunks bypass the socket entirely by going through a temporary memfd
+    // (see `bitsery::ext::BulkBuffer`), so there's no point in
+    // keeping a bunch of allocated memory sitting around doing nothing.
+    const intptr_t return_value = sockets.host_vst_dispatch.send_event(
         converter, std::pair<Vst2Logger&, bool>(logger, true), opcode, index,
         value, data, option);
+
+    if (metadata_cache.enabled()) {
+        record_metadata(opcode, index, data, return_value);
+    }
+
+    switch (opcode) {
+        case effOpen:
+            // The `AEffect` struct will have been updated with the plugin's
+            // own latency, so we'll need to add the pipelining latency again
+            plugin.initialDelay += static_cast<int>(output_delay_line.delay());
+            break;
+        case effSetSampleRate:
+            sample_rate = option;
+            break;
+        case effSetBlockSize:
+            max_block_size = static_cast<uint32_t>(value);
+            break;
+        case effGetChunk:
+            if (config.cache_state && return_value > 0) {
+                state_cache.store(state_generation, index);
+            }
+            break;
+        case effMainsChanged:
+            if (value == 1 && config.audio_pipelining &&
+                process_buffers) {
+                setup_pipelined_processing();
+            }
+            if (value == 1 && parameter_table) {
+                parameter_table_active = true;
+            }
+            break;
+    }
+
+    return return_value;
+}
+
+std::optional<intptr_t> Vst2PluginBridge::dispatch_from_metadata(
+    int opcode,
+    int index,
+    intptr_t value,
+    void* data,
+    float option) {
+    switch (opcode) {
+        case effOpen: {
+            if (!metadata.opened_plugin) {
+                return std::nullopt;
+            }
+
+            logger.log_event(true, opcode, index, value, nullptr, option,
+                             std::nullopt);
+            update_aeffect(plugin, *metadata.opened_plugin);
+            deferred_open = true;
+            logger.log_event_response(true, opcode, 0, nullptr, std::nullopt,
+                                      true);
+
+            return 0;
+        } break;
+        // These only set some values that we'll pass on to the plugin once
+        // the Wine plugin host has been started
+        case effSetSampleRate:
+        case effSetBlockSize: {
+            logger.log_event(true, opcode, index, value, nullptr, option,
+                             std::nullopt);
+            if (opcode == effSetSampleRate) {
+                sample_rate = option;
+            } else {
+                max_block_size = static_cast<uint32_t>(value);
+            }
+            logger.log_event_response(true, opcode, 0, nullptr, std::nullopt,
+                                      true);
+
+            return 0;
+        } break;
+        default: {
+            if (!is_metadata_opcode(opcode)) {
+                return std::nullopt;
+            }
+
+            const std::string query =
+                opcode == effCanDo ? std::string(static_cast<char*>(data))
+                                   : std::string();
+            const auto cached_query = std::find_if(
+                metadata.queries.begin(), metadata.queries.end(),
+                [&](const Vst2PluginMetadata::Query& cached_query) {
+                    return cached_query.opcode == opcode &&
+                           cached_query.index == index &&
+                           cached_query.query == query;
+                });
+            if (cached_query == metadata.queries.end()) {
+                return std::nullopt;
+            }
+
+            if (opcode == effCanDo) {
+                logger.log_event(true, opcode, index, value, query, option,
+                                 std::nullopt);
+            } else if (is_metadata_string_opcode(opcode)) {
+                logger.log_event(true, opcode, index, value, WantsString{},
+                                 option, std::nullopt);
+            } else {
+                logger.log_event(true, opcode, index, value, nullptr, option,
+                                 std::nullopt);
+            }
+
+            if (is_metadata_string_opcode(opcode)) {
+                char* output = static_cast<char*>(data);
+                std::copy(cached_query->result.begin(),
+                          cached_query->result.end(), output);
+                output[cached_query->result.size()] = 0;
+
+                logger.log_event_response(
+                    true, opcode,
+                    static_cast<intptr_t>(cached_query->return_value),
+                    cached_query->result, std::nullopt, true);
+            } else {
+                logger.log_event_response(
+                    true, opcode,
+                    static_cast<intptr_t>(cached_query->return_value), nullptr,
+                    std::nullopt, true);
+            }
+
+            return static_cast<intptr_t>(cached_query->return_value);
+        } break;
+    }
+}
+
+void Vst2PluginBridge::record_metadata(int opcode,
+                                       int index,
+                                       void* data,
+                                       intptr_t return_value) {
+    if (opcode == effOpen) {
+        std::lock_guard lock(metadata_mutex);
+        metadata.opened_plugin = plugin;
+        metadata_changed = true;
+
+        return;
+    }
+    if (!is_metadata_opcode(opcode)) {
+        return;
+    }
+
+    Vst2PluginMetadata::Query new_query{
+        .opcode = opcode,
+        .index = index,
+        .query = opcode == effCanDo ? std::string(static_cast<char*>(data))
+                                    : std::string(),
+        .return_value = return_value,
+        .result = is_metadata_string_opcode(opcode)
+                      ? std::string(static_cast<char*>(data))
+                      : std::string()};
+
+    std::lock_guard lock(metadata_mutex);
+    const auto existing_query = std::find_if(
+        metadata.queries.begin(), metadata.queries.end(),
+        [&](const Vst2PluginMetadata::Query& query) {
+            return query.opcode == new_query.opcode &&
+                   query.index == new_query.index &&
+                   query.query == new_query.query;
+        });
+    if (existing_query == metadata.queries.end()) {
+        metadata.queries.push_back(std::move(new_query));
+        metadata_changed = true;
+    } else if (existing_query->return_value != new_query.return_value ||
+               existing_query->result != new_query.result) {
+        *existing_query = std::move(new_query);
+        metadata_changed = true;
+    }
+}
+
+std::optional<Vst2ParameterStrings::Entry>
+Vst2PluginBridge::get_cached_parameter_string(int opcode, int index) {
+    const ParameterStringCache::Refresh refresh =
+        parameter_strings.refresh_needed(opcode, index);
+    switch (refresh) {
+        case ParameterStringCache::Refresh::none:
+            break;
+        case ParameterStringCache::Refresh::stale_values: {
+            // Hosts tend to query the strings for every parameter that has
+            // changed in one go, so we'll refetch the value strings for all of
+            // those parameters at once instead of one string at a time
+            const ParameterStringCache::Generations generations =
+                parameter_strings.generations();
+            const std::vector<int32_t> parameters =
+                parameter_strings.stale_parameters();
+            if (parameters.empty()) {
+                break;
+            }
+
+            Vst2ParameterStrings strings{};
+            ParameterStringsDataConverter converter(
+                WantsParameterStrings{.values_only = true,
+                                      .parameters = parameters},
+                strings);
+            sockets.host_vst_dispatch.send_event(
+                converter, std::pair<Vst2Logger&, bool>(logger, true),
+                effYabridgeGetParameterStrings, 0, 0, nullptr, 0.0);
+
+            parameter_strings.store_values(generations, parameters,
+                                           std::move(strings));
+        } break;
+        case ParameterStringCache::Refresh::values:
+        case ParameterStringCache::Refresh::all: {
+            const bool values_only =
+                refresh == ParameterStringCache::Refresh::values;
+            const ParameterStringCache::Generations generations =
+                parameter_strings.generations();
+
+            Vst2ParameterStrings strings{};
+            ParameterStringsDataConverter converter(
+                WantsParameterStrings{.values_only = values_only,
+                                      .parameters = {}},
+                strings);
+            sockets.host_vst_dispatch.send_event(
+                converter, std::pair<Vst2Logger&, bool>(logger, true),
+                effYabridgeGetParameterStrings, 0, 0, nullptr, 0.0);
+
+            parameter_strings.store(generations, std::move(strings),
+                                    values_only);
+        } break;
+    }
+
+    return parameter_strings.get(opcode, index);
+}
+
+void Vst2PluginBridge::setup_pipelined_processing() {
+    // Some hosts don't call `effSetBlockSize()`, in which case we'll do the
+    // same thing as the Wine plugin host and ask the host for the block size
+    uint32_t block_size = max_block_size;
+    if (block_size == 0) {
+        block_size = static_cast<uint32_t>(host_callback_function(
+            &plugin, audioMasterGetBlockSize, 0, 0, nullptr, 0.0));
+    }
+
+    // We report the added latency to the host through `initialDelay`. Hosts
+    // will read this after `effMainsChanged()`.
+    const uint32_t old_delay = output_delay_line.delay();
+    output_delay_line.reset(*process_buffers, block_size);
+    delayed_output_events.clear();
+    plugin.initialDelay += static_cast<int>(output_delay_line.delay()) -
+                           static_cast<int>(old_delay);
+}
+
+bool Vst2PluginBridge::finish_pending_process() {
+    if (!pending_process_request) {
+        return true;
+    }
+
+    const Vst2ProcessRequest request = *pending_process_request;
+    pending_process_request.reset();
+
+    // If the Wine plugin host has died, we'll just output whatever is in the
+    // buffers like we would do without pipelining. Any MIDI events produced
+    // during this block will be delayed along with its audio.
+    const bool result =
+        process_buffers->wait_for_response(config.audio_spin_duration());
+    if (result) [[likely]] {
+        read_shm_object(*process_buffers, process_response,
+                        process_message_buffer);
+    }
+    if (request.double_precision) {
+        write_outputs_to_delay_line<double>(request);
+    } else {
+        write_outputs_to_delay_line<float>(request);
+    }
+
+    return result;
+}
+
+template <typename T>
+const T* Vst2PluginBridge::output_channel_ptr(
+    const Vst2ProcessRequest& request,
+    int channel) const noexcept {
+    // When processing in place, the plugin will have written the outputs for
+    // the first `numInputs` channels to the input channel regions
+    return request.in_place && channel < plugin.numInputs
+               ? process_buffers->input_channel_ptr<T>(0, channel)
+               : process_buffers->output_channel_ptr<T>(0, channel);
+}
+
+template <typename T>
+void Vst2PluginBridge::write_outputs_to_delay_line(
+    const Vst2ProcessRequest& request) {
+    // The MIDI events produced during this block need to be delayed just as
+    // much as its audio
+    delay_output_events();
+
+    // This only allocates when the host sends more samples than it promised
+    output_delay_line.reserve(request.sample_frames);
+    for (int channel = 0; channel < plugin.numOutputs &&
+                          channel < static_cast<int>(
+                                        output_delay_line.num_channels(0));
+         channel++) {
+        output_delay_line.write(0, channel,
+                                output_channel_ptr<T>(request, channel),
+                                request.sample_frames);
+    }
+    output_delay_line.commit_write(request.sample_frames);
 }
 
 template <typename T, bool replacing>
 // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
 void Vst2PluginBridge::do_process(T** inputs, T** outputs, int sample_frames) {
+    const auto process_start = std::chrono::steady_clock::now();
+    audio_thread_id.store(std::this_thread::get_id(),
+                          std::memory_order_relaxed);
+
     // During audio processing we'll write the inputs to shared memory buffers,
     // and we'll then send this request alongside it with additional information
     // needed to process audio
@@ -673,44 +1324,110 @@ void Vst2PluginBridge::do_process(T** inputs, T** outputs, int sample_frames) {
         static_assert(std::is_same_v<T, float>);
     }
 
+    // If the host uses the same buffers for the inputs and the outputs, then
+    // we'll also let the plugin process in place on the Wine side. We only do
+    // this when that's the case for every channel, so we don't need to keep
+    // track of this on a per-channel basis. This is not possible with the
+    // accumulating `process()` since that needs to keep the inputs and outputs
+    // separate.
+    request.in_place = replacing && plugin.numInputs > 0 &&
+                       plugin.numOutputs > 0 && inputs != nullptr &&
+                       outputs != nullptr;
+    for (int channel = 0;
+         request.in_place &&
+         channel < std::min(plugin.numInputs, plugin.numOutputs);
+         channel++) {
+        request.in_place = inputs[channel] == outputs[channel];
+    }
+
     // The host should have called `effMainsChanged()` before sending audio to
-    // process
+    // process. When using pipelined processing, the Wine plugin host may still
+    // be processing the last block, so we need to wait for that to finish
+    // before we can touch the shared memory buffers.
     assert(process_buffers);
+    const bool pipelined = output_delay_line.delay() > 0;
+    if (pipelined) {
+        finish_pending_process();
+    }
+
     for (int channel = 0; channel < plugin.numInputs; channel++) {
         T* input_channel = process_buffers->input_channel_ptr<T>(0, channel);
-        std::copy_n(inputs[channel], sample_frames, input_channel);
+        copy_samples(inputs[channel], sample_frames, input_channel);
     }
 
-    // After writing audio to the shared memory buffers, we'll send the
-    // processing request parameters to the Wine plugin host so it can start
-    // processing audio. This is why we don't need any explicit synchronisation.
-    sockets.host_vst_process_replacing.send(request);
+    // After writing audio to the shared memory buffers, we'll write the
+    // processing request parameters to the control region in that same shared
+    // memory object and wake up the Wine plugin host so it can start processing
+    // audio. The Wine side then wakes us up again once it has finished
+    // processing, at which point the audio will have been written to our
+    // buffers. This avoids a socket round trip for every processing cycle. The
+    // request should always fit in the message area, but if it somehow doesn't
+    // then we'll fall back to using the socket.
+    if (const std::optional<uint32_t> request_size = write_shm_object(
+            *process_buffers, request, process_message_buffer))
+        [[likely]] {
+        // With pipelined processing we'll return to the host immediately, and
+        // we'll pick up the results at the start of the next processing cycle.
+        // If the host sends more samples than it said it would, then we can't
+        // do that without changing the latency, so we'll process that block
+        // synchronously instead.
+        if (pipelined && static_cast<uint32_t>(sample_frames) <=
+                             output_delay_line.delay()) {
+            process_buffers->send_request(*request_size);
+            pending_process_request = request;
+        } else {
+            // If this returns `false`, then the Wine plugin host has shut down
+            // and there's nothing we can do except for outputting whatever's
+            // currently in the buffers
+            if (process_buffers->send_request_and_wait(
+                    *request_size, config.audio_spin_duration()))
+                [[likely]] {
+                read_shm_object(*process_buffers, process_response,
+                                process_message_buffer);
+            }
+        }
+    } else {
+        sockets.host_vst_process_replacing.send(request,
+                                                process_message_buffer);
 
-    // From the Wine side we'll send a zero byte struct back as an
-    // acknowledgement that audio processing has finished. At this point the
-    // audio will have been written to our buffers.
-    sockets.host_vst_process_replacing.receive_single<Ack>();
+        // The Wine side will send back any MIDI events produced by the plugin
+        // once it has finished processing audio
+        sockets.host_vst_process_replacing.receive_single<Vst2ProcessResponse>(
+            process_response, process_message_buffer);
+    }
 
-    for (int channel = 0; channel < plugin.numOutputs; channel++) {
-        const T* output_channel =
-            process_buffers->output_channel_ptr<T>(0, channel);
+    if (pipelined) {
+        // When the block was processed synchronously, we'll still need to
+        // write the results to the delay line to keep the latency constant
+        if (!pending_process_request) {
+            write_outputs_to_delay_line<T>(request);
+        }
 
-        if constexpr (replacing) {
-            std::copy_n(output_channel, sample_frames, outputs[channel]);
-        } else {
-            // The old `process()` function expects the plugin to add its output
-            // to the accumulated values in `outputs`. Since no host is ever
-            // going to call this anyways we won't even bother with a separate
-            // implementation and we'll just add `processReplacing()` results to
-            // `outputs`.
-            // We could use `std::execution::unseq` here but that would require
-            // linking to TBB and since this probably won't ever be used anyways
-            // that's a bit of a waste.
-            std::transform(output_channel, output_channel + sample_frames,
-                           outputs[channel], outputs[channel],
-                           [](const T& new_value, T& current_value) -> T {
-                               return new_value + current_value;
-                           });
+        for (int channel = 0; channel < plugin.numOutputs; channel++) {
+            if constexpr (replacing) {
+                output_delay_line.read(0, channel, outputs[channel],
+                                       sample_frames);
+            } else {
+                output_delay_line.read<T, true>(0, channel, outputs[channel],
+                                                sample_frames);
+            }
+        }
+        output_delay_line.commit_read(sample_frames);
+
+        take_delayed_output_events(sample_frames);
+    } else {
+        for (int channel = 0; channel < plugin.numOutputs; channel++) {
+            const T* output_channel = output_channel_ptr<T>(request, channel);
+            if constexpr (replacing) {
+                copy_samples(output_channel, sample_frames, outputs[channel]);
+            } else {
+                // The old `process()` function expects the plugin to add its
+                // output to the accumulated values in `outputs`. Since no host
+                // is ever going to call this anyways we won't even bother with
+                // a separate implementation and we'll just add
+                // `processReplacing()` results to `outputs`.
+                add_samples(output_channel, sample_frames, outputs[channel]);
+            }
         }
     }
 
@@ -720,13 +1437,78 @@ void Vst2PluginBridge::do_process(T** inputs, T** outputs, int sample_frames) {
     // prevent these events from getting delayed by a sample we'll process them
     // after the plugin is done processing audio rather than during the time
     // we're still waiting on the plugin.
-    std::lock_guard lock(incoming_midi_events_mutex);
-    for (DynamicVstEvents& events : incoming_midi_events) {
+    send_output_events();
+
+    // With pipelined processing the processing time is that of the previous
+    // block, but over many cycles this averages out the same
+    process_stats.record(
+        std::chrono::steady_clock::now() - process_start,
+        std::chrono::nanoseconds(process_response.processing_time_ns),
+        sample_rate > 0 ? std::chrono::nanoseconds(static_cast<int64_t>(
+                              (sample_frames * 1e9) / sample_rate))
+                        : std::chrono::nanoseconds(0));
+}
+
+void Vst2PluginBridge::send_output_events() {
+    if (!process_response.output_events.events.empty()) {
         host_callback_function(&plugin, audioMasterProcessEvents, 0, 0,
-                               &events.as_c_events(), 0.0);
+                               &process_response.output_events.as_c_events(),
+                               0.0);
+        process_response.output_events.clear();
+    }
+
+    incoming_midi_events.consume([&](VstEvents& events) {
+        host_callback_function(&plugin, audioMasterProcessEvents, 0, 0,
+                               &events, 0.0);
+    });
+}
+
+void Vst2PluginBridge::delay_output_events() {
+    if (process_response.output_events.events.empty()) {
+        return;
+    }
+
+    // The first sample of this block will be returned to the host after all
+    // samples that are currently stored in the delay line
+    const int delay = static_cast<int>(output_delay_line.stored_samples());
+
+    // SysEx events store `deltaFrames` at the same offset as regular MIDI
+    // events
+    VstEvents& events = process_response.output_events.as_c_events();
+    for (int i = 0; i < events.numEvents; i++) {
+        reinterpret_cast<VstMidiEvent*>(events.events[i])->deltaFrames +=
+            delay;
+    }
+
+    delayed_output_events.append(events);
+    process_response.output_events.clear();
+}
+
+void Vst2PluginBridge::take_delayed_output_events(int sample_frames) {
+    if (delayed_output_events.events.empty()) {
+        return;
+    }
+
+    // `DynamicVstEvents::append()` takes care of copying SysEx data, so we'll
+    // move the events over one at a time
+    VstEvents single_event{};
+    single_event.numEvents = 1;
+
+    VstEvents& events = delayed_output_events.as_c_events();
+    for (int i = 0; i < events.numEvents; i++) {
+        auto event = reinterpret_cast<VstMidiEvent*>(events.events[i]);
+        single_event.events[0] = events.events[i];
+        if (event->deltaFrames < sample_frames) {
+            process_response.output_events.append(single_event);
+        } else {
+            event->deltaFrames -= sample_frames;
+            remaining_output_events.append(single_event);
+        }
     }
 
-    incoming_midi_events.clear();
+    delayed_output_events.clear();
+    delayed_output_events.append(remaining_output_events.as_c_events());
+    remaining_output_events.clear();
 }
 
 void Vst2PluginBridge::process(AEffect* /*plugin*/,
@@ -760,8 +1542,21 @@ void Vst2PluginBridge::process_double_replacing(AEffect* /*plugin*/,
 }
 
 float Vst2PluginBridge::get_parameter(AEffect* /*plugin*/, int index) {
+    ensure_plugin_host_started();
     logger.log_get_parameter(index);
 
+    // While the plugin is processing audio the Wine plugin host will keep the
+    // parameter table up to date, so we don't need to ask the plugin. If we
+    // queued a new value for this parameter then the table won't contain the
+    // value the plugin actually uses until that value has been applied.
+    if (parameter_table_active.load(std::memory_order_relaxed) &&
+        parameter_table->contains(index) && !parameter_table->is_stale(index)) {
+        const float value = parameter_table->get(index);
+        logger.log_get_parameter_response(value, true);
+
+        return value;
+    }
+
     const Parameter request{index, std::nullopt};
     ParameterResult response;
 
@@ -783,7 +1578,23 @@ float Vst2PluginBridge::get_parameter(AEffect* /*plugin*/, int index) {
 void Vst2PluginBridge::set_parameter(AEffect* /*plugin*/,
                                      int index,
                                      float value) {
+    ensure_plugin_host_started();
     logger.log_set_parameter(index, value);
+    state_cache.invalidate();
+    parameter_strings.invalidate_value(index);
+
+    // Automation sent from the audio thread is queued and then applied on the
+    // Wine side right before the next block gets processed. This saves a
+    // round trip for every automated parameter in every processing cycle.
+    if (parameter_table_active.load(std::memory_order_relaxed) &&
+        parameter_table->contains(index) &&
+        std::this_thread::get_id() ==
+            audio_thread_id.load(std::memory_order_relaxed)) {
+        parameter_table->queue(index, value);
+        logger.log_set_parameter_response(true);
+
+        return;
+    }
 
     const Parameter request{index, value};
     ParameterResult response;
@@ -23,6 +23,12 @@
 
 #include "../../common/communication/vst2.h"
 #include "../../common/logging/vst2.h"
+#include "../../common/parameter-shm.h"
+#include "../output-delay-line.h"
+#include "../parameter-string-cache.h"
+#include "../process-stats.h"
+#include "../state-cache.h"
+#include "../vst-event-ring.h"
 #include "common.h"
 
 /**
@@ -121,6 +127,44 @@ class Vst2PluginBridge : PluginBridge<Vst2Sockets<std::jthread>> {
     template <typename T, bool replacing>
     void do_process(T** inputs, T** outputs, int sample_frames);
 
+    /**
+     * When using the `audio_pipelining` option, wait for the Wine plugin
+     * host to finish processing the block we sent during the last processing
+     * cycle and write its outputs to `output_delay_line`. This is called at the
+     * start of the next processing cycle, and before sending events that
+     * should not be handled while the plugin is processing audio. Does nothing
+     * if there is no pending block.
+     *
+     * @return `false` if the Wine plugin host has shut down while we were
+     *   waiting.
+     */
+    bool finish_pending_process();
+
+    /**
+     * Pass the MIDI events the plugin has produced to the host. These are the
+     * events from `process_response` followed by any events that were sent
+     * from outside of the audio thread. This has to be called during the
+     * host's processing function.
+     */
+    void send_output_events();
+
+    /**
+     * When using the `audio_pipelining` option, move the MIDI events the
+     * plugin produced for the block that's being written to
+     * `output_delay_line` from `process_response` to `delayed_output_events`.
+     * Their offsets get shifted by the number of samples already stored in the
+     * delay line so they stay in sync with that block's audio.
+     */
+    void delay_output_events();
+
+    /**
+     * Move the events from `delayed_output_events` that fall within the next
+     * `sample_frames` samples back to `process_response` so they can be sent
+     * to the host by `send_output_events()`. The offsets of the remaining
+     * events are made relative to the start of the next block.
+     */
+    void take_delayed_output_events(int sample_frames);
+
     /**
      * This AEffect struct will be populated using the data passed by the Wine
      * VST host during initialization and then passed as a pointer to the Linux
@@ -129,6 +173,67 @@ class Vst2PluginBridge : PluginBridge<Vst2Sockets<std::jthread>> {
     AEffect plugin;
 
    private:
+    /**
+     * Start the Wine plugin host and initialize the bridge if that has not
+     * happened yet. This is called from the constructor, unless the plugin
+     * could be initialized using cached metadata. In that case this is called
+     * the first time the host does something that can't be answered using
+     * that metadata, after which the calls that were answered from the cache
+     * that change the plugin's settings will be passed through to the plugin.
+     */
+    void ensure_plugin_host_started();
+
+    /**
+     * Launch the Wine plugin host, connect to it, and receive the plugin's
+     * `AEffect` object. Should only be called through
+     * `ensure_plugin_host_started()`.
+     */
+    void start_plugin_host();
+
+    /**
+     * Try to answer a dispatcher call using `metadata` while the Wine plugin
+     * host has not yet been started. Returns an `std::nullopt` if the call
+     * requires the actual plugin.
+     */
+    std::optional<intptr_t> dispatch_from_metadata(int opcode,
+                                                   int index,
+                                                   intptr_t value,
+                                                   void* data,
+                                                   float option);
+
+    /**
+     * Store the result of a dispatcher call in `metadata` if it's one of the
+     * calls hosts make while scanning plugins. This metadata is then written
+     * to the metadata cache when the plugin gets closed.
+     */
+    void record_metadata(int opcode,
+                         int index,
+                         void* data,
+                         intptr_t return_value);
+
+    /**
+     * The metadata for this plugin. If the plugin was loaded from the metadata
+     * cache then this is used to answer the host's queries. Otherwise, or once
+     * the Wine plugin host has been started, it's updated with the results
+     * from the plugin so it can be written back to the cache.
+     */
+    Vst2PluginMetadata metadata;
+    std::mutex metadata_mutex;
+    /**
+     * Whether `metadata` contains anything that's not yet in the cache.
+     */
+    bool metadata_changed = false;
+    /**
+     * Set to `false` when the plugin's metadata depends on more than just the
+     * plugin's library, such as with shell plugins.
+     */
+    bool metadata_cacheable = true;
+    /**
+     * Set when `effOpen()` was answered from `metadata` before the Wine plugin
+     * host was started, so we can call it on the actual plugin later.
+     */
+    bool deferred_open = false;
+
     /**
      * The thread that handles host callbacks.
      */
@@ -142,6 +247,35 @@ class Vst2PluginBridge : PluginBridge<Vst2Sockets<std::jthread>> {
      */
     std::mutex parameters_mutex;
 
+    /**
+     * A mirror of the plugin's parameter values in shared memory, kept up to
+     * date by the Wine plugin host. This lets us handle `getParameter()` calls
+     * without a socket round trip, and it lets us queue `setParameter()` calls
+     * made from the audio thread so they're applied at the start of the next
+     * processing cycle. This is only set up if the `vst2_shared_parameters`
+     * option is enabled and the plugin has any parameters.
+     *
+     * @see ParameterShmTable
+     */
+    std::optional<ParameterShmTable> parameter_table;
+
+    /**
+     * Whether `parameter_table` should be used. The Wine plugin host only
+     * keeps the table up to date while the plugin is processing audio, so
+     * this is set after the host resumes the plugin with `effMainsChanged()`
+     * and cleared again when the host suspends it.
+     */
+    std::atomic_bool parameter_table_active = false;
+
+    /**
+     * The ID of the thread the host last called one of the processing
+     * functions from. Only `setParameter()` calls made from this thread are
+     * queued in `parameter_table`, since those are the only calls we know
+     * will be followed by another processing cycle. Calls from other threads
+     * will still be sent over the sockets so they take effect immediately.
+     */
+    std::atomic<std::thread::id> audio_thread_id;
+
     /**
      * The callback function passed by the host to the VST plugin instance.
      */
@@ -158,15 +292,99 @@ class Vst2PluginBridge : PluginBridge<Vst2Sockets<std::jthread>> {
      * buffers. This is first configured on the Wine plugin host side during
      * `effMainsChanged` and then replicated on the plugin side. This way we
      * reduce the amount of copying during audio processing to only two copies.
-     * We'll write the input audio to this buffer and send the process request
-     * to the Wine plugin host. There the Windows VST2 plugin will then read
-     * from the buffer and write its results to the same buffer. We can then
-     * write those results back to the host.
+     * We'll write the input audio to this buffer and pass the process request
+     * to the Wine plugin host through the buffer's control region. There the
+     * Windows VST2 plugin will then read from the buffer and write its results
+     * to the same buffer. We can then write those results back to the host.
      *
      * This will be a nullopt until `effMainsChanged` has been called.
      */
     std::optional<AudioShmBuffer> process_buffers;
 
+    /**
+     * Set up `output_delay_line` for pipelined processing and add the extra
+     * latency to the plugin's `initialDelay`. Called after `effMainsChanged()`
+     * when the `audio_pipelining` option is enabled.
+     */
+    void setup_pipelined_processing();
+
+    /**
+     * Look up a parameter or program string in `parameter_strings`, fetching
+     * a new batch of strings from the Wine plugin host first if the cached
+     * strings are out of date. Returns an `std::nullopt` if the query should
+     * be passed through to the plugin as usual instead.
+     */
+    std::optional<Vst2ParameterStrings::Entry> get_cached_parameter_string(
+        int opcode,
+        int index);
+
+    /**
+     * Get a pointer to the output channel in `process_buffers` the plugin has
+     * written its results for `channel` to. This differs from the regular
+     * output channel when processing in place.
+     */
+    template <typename T>
+    const T* output_channel_ptr(const Vst2ProcessRequest& request,
+                                int channel) const noexcept;
+
+    /**
+     * Append the outputs for the processed `request` from `process_buffers` to
+     * `output_delay_line`.
+     */
+    template <typename T>
+    void write_outputs_to_delay_line(const Vst2ProcessRequest& request);
+
+    /**
+     * When the `audio_pipelining` option is enabled, the results from the
+     * Wine plugin host are returned to the host one block later. This FIFO
+     * stores those results, and it will add exactly one maximum block size
+     * worth of latency. Its delay will be zero when pipelining is disabled.
+     */
+    OutputDelayLine output_delay_line;
+
+    /**
+     * MIDI events the plugin produced while using pipelined processing. These
+     * are delayed by the same number of samples as the audio in
+     * `output_delay_line`, and their `deltaFrames` are relative to the start
+     * of the next block we'll return to the host.
+     */
+    DynamicVstEvents delayed_output_events;
+
+    /**
+     * Scratch space for the events from `delayed_output_events` that are not
+     * yet due during `take_delayed_output_events()`. Reused to avoid
+     * allocations.
+     */
+    DynamicVstEvents remaining_output_events;
+
+    /**
+     * The block that is currently being processed by the Wine plugin host when
+     * using pipelined processing. We'll pick up its results during the next
+     * processing cycle, or before the next event that needs the plugin to not
+     * be processing audio.
+     */
+    std::optional<Vst2ProcessRequest> pending_process_request;
+
+    /**
+     * The maximum block size set by the host through `effSetBlockSize()`, used
+     * for the pipelining latency. If the host never calls that function we'll
+     * ask it using `audioMasterGetBlockSize()` instead.
+     */
+    uint32_t max_block_size = 0;
+
+    /**
+     * The sample rate set by the host through `effSetSampleRate()`. This is
+     * only used to determine the deadline for a processing cycle in
+     * `process_stats`.
+     */
+    float sample_rate = 0.0;
+
+    /**
+     * Performance counters for this instance's audio processing, exposed
+     * through `stats_server`.
+     */
+    ProcessStats process_stats;
+
     /**
      * We'll periodically synchronize the Wine host's audio thread priority with
      * that of the host. Since the overhead from doing so does add up, we'll
@@ -178,9 +396,26 @@ class Vst2PluginBridge : PluginBridge<Vst2Sockets<std::jthread>> {
      * The VST host can query a plugin for arbitrary binary data such as
      * presets. It will expect the plugin to write back a pointer that points to
      * that data. This vector is where we store the chunk data for the last
-     * `effGetChunk` event.
+     * `effGetChunk` event. When the `cache_state` option is enabled, this also
+     * doubles as the cached state for `state_cache`.
      */
     std::vector<uint8_t> chunk_data;
+    /**
+     * Tracks whether `chunk_data` still contains the plugin's current state,
+     * so repeated `effGetChunk()` calls can be answered without a round trip
+     * when the `cache_state` option is enabled. The cache is invalidated by
+     * every dispatcher call that could change the plugin's state, by
+     * `setParameter()`, and by the plugin's `audioMasterAutomate()`,
+     * `audioMasterUpdateDisplay()` and `audioMasterIOChanged()` callbacks.
+     */
+    StateCache state_cache;
+    /**
+     * Caches the parameter names, labels and display strings, and the program
+     * names, so the host can query these without a round trip to the Wine
+     * plugin host when the `vst2_cache_strings` option is enabled. See
+     * the class for more information on how these are invalidated.
+     */
+    ParameterStringCache parameter_strings;
     /**
      * The VST host will expect to be returned a pointer to a struct that stores
      * the dimensions of the editor window.
@@ -191,17 +426,28 @@ class Vst2PluginBridge : PluginBridge<Vst2Sockets<std::jthread>> {
      * Sending MIDI events sent to the host by the plugin using
      * `audioMasterProcessEvents` function has to be done during the processing
      * function. If they are sent during any other time or from another thread,
-     * then the host will just discard them. Because we're receiving our host
-     * callbacks on a separate thread, we have to temporarily store any events
-     * we receive so we can send them to host on the audio thread at the end of
-     * `process_replacing()`.
+     * then the host will just discard them. Events the plugin sends while
+     * processing audio are returned as part of `process_response`, but events
+     * sent from other threads are received on our host callback threads. We'll
+     * store those here so we can send them to host on the audio thread at the
+     * end of `process_replacing()`. Only the producers share a mutex, so the
+     * audio thread never has to wait on the host callback threads.
      */
-    boost::container::small_vector<DynamicVstEvents, 1> incoming_midi_events;
+    VstEventRing incoming_midi_events;
+
     /**
-     * Mutex for locking the above event queue, since recieving and processing
-     * now happens in two different threads.
+     * The response to the last process request. This contains the MIDI events
+     * the plugin produced during that processing cycle. The object is reused
+     * so we don't have to allocate during audio processing.
      */
-    std::mutex incoming_midi_events_mutex;
+    Vst2ProcessResponse process_response;
+
+    /**
+     * The buffer used to serialize process requests and to deserialize
+     * `process_response`. Like the object above this is reused to avoid
+     * allocations.
+     */
+    SerializationBuffer<2048> process_message_buffer;
 
     /**
      * REAPER requires us to call `audioMasterSizeWidnow()` from the same thread
@@ -213,4 +459,12 @@ class Vst2PluginBridge : PluginBridge<Vst2Sockets<std::jthread>> {
      */
     std::optional<std::pair<int, int>> incoming_resize;
     std::mutex incoming_resize_mutex;
+
+    /**
+     * Serves `process_stats` on a socket in the socket base directory. This is
+     * defined last so it gets destroyed before the data it reads from.
+     *
+     * @see PluginBridge::start_stats_server
+     */
+    std::optional<StatsServer> stats_server;
 };
@@ -16,6 +16,8 @@
 
 #include "plug-view-proxy.h"
 
+#include "plugin-proxy.h"
+
 RunLoopTasks::RunLoopTasks(Steinberg::IPtr<Steinberg::IPlugFrame> plug_frame)
     : run_loop(plug_frame) {
     FUNKNOWN_CTOR
@@ -128,6 +130,13 @@ Vst3PlugViewProxyImpl::isPlatformTypeSupported(Steinberg::FIDString type) {
 tresult PLUGIN_API Vst3PlugViewProxyImpl::attached(void* parent,
                                                    Steinberg::FIDString type) {
     if (parent && type) {
+        // The user can change the plugin's state through its editor in ways
+        // that don't involve any parameter changes, so we can't serve cached
+        // states while the editor is open
+        bridge.plugin_proxies.at(owner_instance_id())
+            .get()
+            .state_cache.set_editor_open(true);
+
         // We will embed the Wine Win32 window into the X11 window provided by
         // the host
         return bridge.send_mutually_recursive_message(YaPlugView::Attached{
@@ -142,8 +151,13 @@ tresult PLUGIN_API Vst3PlugViewProxyImpl::attached(void* parent,
 }
 
 tresult PLUGIN_API Vst3PlugViewProxyImpl::removed() {
-    return bridge.send_mutually_recursive_message(
+    const tresult result = bridge.send_mutually_recursive_message(
         YaPlugView::Removed{.owner_instance_id = owner_instance_id()});
+    bridge.plugin_proxies.at(owner_instance_id())
+        .get()
+        .state_cache.set_editor_open(false);
+
+    return result;
 }
 
 tresult PLUGIN_API Vst3PlugViewProxyImpl::onWheel(float distance) {
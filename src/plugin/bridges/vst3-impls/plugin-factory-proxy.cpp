@@ -71,6 +71,10 @@ Vst3PluginFactoryProxyImpl::createInstance(Steinberg::FIDString cid,
         return Steinberg::kNotImplemented;
     }
 
+    // If the plugin factory was created from cached metadata, then this is
+    // the point where we need the actual plugin
+    bridge.ensure_plugin_host_started();
+
     std::variant<Vst3PluginProxy::ConstructArgs, UniversalTResult> result =
         bridge.send_mutually_recursive_message(Vst3PluginProxy::Construct{
             .cid = cid_array, .requested_interface = requested_interface});
@@ -118,9 +122,14 @@ Vst3PluginFactoryProxyImpl::setHostContext(Steinberg::FUnknown* context) {
         host_application = host_context;
         plug_interface_support = host_context;
 
-        return bridge.send_message(YaPluginFactory3::SetHostContext{
-            .host_context_args = Vst3HostContextProxy::ConstructArgs(
-                host_context, std::nullopt)});
+        // When the plugin factory was created from cached metadata, we'll
+        // pass the context to the plugin once the Wine plugin host has been
+        // started
+        if (!bridge.is_plugin_host_started()) {
+            return Steinberg::kResultOk;
+        }
+
+        return send_host_context();
     } else {
         bridge.logger.log(
             "WARNING: Null pointer passed to "
@@ -128,3 +137,13 @@ Vst3PluginFactoryProxyImpl::setHostContext(Steinberg::FUnknown* context) {
         return Steinberg::kInvalidArgument;
     }
 }
+
+tresult Vst3PluginFactoryProxyImpl::send_host_context() {
+    if (!host_context) {
+        return Steinberg::kResultOk;
+    }
+
+    return bridge.send_message(YaPluginFactory3::SetHostContext{
+        .host_context_args =
+            Vst3HostContextProxy::ConstructArgs(host_context, std::nullopt)});
+}
@@ -40,6 +40,15 @@ class Vst3PluginFactoryProxyImpl : public Vst3PluginFactoryProxy {
                                       void** obj) override;
     tresult PLUGIN_API setHostContext(Steinberg::FUnknown* context) override;
 
+    /**
+     * Pass the host context from `setHostContext()` to the Windows VST3
+     * plugin's factory. If the Wine plugin host has not yet been started when
+     * the host calls `setHostContext()`, then `Vst3PluginBridge` will call
+     * this once it has been. Does nothing if the host has not passed a host
+     * context to the factory.
+     */
+    tresult send_host_context();
+
     // The following pointers are cast from `host_context` if
     // `IPluginFactory3::setHostContext()` has been called
 
@@ -85,6 +85,7 @@ bool Vst3PluginProxyImpl::unregister_context_menu(size_t context_menu_id) {
 
 void Vst3PluginProxyImpl::clear_caches() noexcept {
     clear_bus_cache();
+    state_cache.invalidate();
 
     std::lock_guard lock(function_result_cache_mutex);
     function_result_cache = FunctionResultCache{};
@@ -176,12 +177,18 @@ Vst3PluginProxyImpl::canProcessSampleSize(int32 symbolicSampleSize) {
 }
 
 uint32 PLUGIN_API Vst3PluginProxyImpl::getLatencySamples() {
+    // With pipelined processing we add another block of latency on top of the
+    // plugin's own latency
     return bridge.send_audio_processor_message(
-        YaAudioProcessor::GetLatencySamples{.instance_id = instance_id()});
+               YaAudioProcessor::GetLatencySamples{.instance_id =
+                                                       instance_id()}) +
+           output_delay_line.delay();
 }
 
 tresult PLUGIN_API
 Vst3PluginProxyImpl::setupProcessing(Steinberg::Vst::ProcessSetup& setup) {
+    finish_pending_process();
+
     const YaAudioProcessor::SetupProcessingResponse response =
         bridge.send_audio_processor_message(YaAudioProcessor::SetupProcessing{
             .instance_id = instance_id(), .setup = setup});
@@ -194,10 +201,27 @@ Vst3PluginProxyImpl::setupProcessing(Steinberg::Vst::ProcessSetup& setup) {
         process_buffers->resize(response.audio_buffers_config);
     }
 
+    // The audio will have moved around in the shared memory object, so we can
+    // no longer skip writing silent inputs or skip processing altogether
+    process_request.data.clear_silent_inputs();
+    last_outputs_silent = false;
+
+    sample_rate = setup.sampleRate;
+
+    // The maximum block size is also the latency we'll add when pipelining
+    if (bridge.audio_pipelining()) {
+        output_delay_line.reset(
+            *process_buffers, static_cast<uint32_t>(setup.maxSamplesPerBlock));
+        delayed_output_parameter_changes.clear();
+        delayed_output_events.clear();
+    }
+
     return response.result;
 }
 
 tresult PLUGIN_API Vst3PluginProxyImpl::setProcessing(TBool state) {
+    finish_pending_process();
+
     // REAPER used to repeatedly query the plugin for its bus information on
     // every processing cycle. Because this really adds up in terms of latency
     // we sadly have to deviate from yabridge's principles and implement a
@@ -212,12 +236,24 @@ tresult PLUGIN_API Vst3PluginProxyImpl::setProcessing(TBool state) {
         }
     }
 
-    return bridge.send_audio_processor_message(YaAudioProcessor::SetProcessing{
-        .instance_id = instance_id(), .state = state});
+    // If the `vst3_skip_silence` option is enabled, then we'll need to know the
+    // plugin's tail length to be able to skip processing cycles in `process()`.
+    // We'll query this again whenever the host starts processing.
+    may_skip_silence = false;
+    const tresult result =
+        bridge.send_audio_processor_message(YaAudioProcessor::SetProcessing{
+            .instance_id = instance_id(), .state = state});
+    if (state && bridge.skip_silence()) {
+        may_skip_silence = getTailSamples() == Steinberg::Vst::kNoTail;
+    }
+
+    return result;
 }
 
 tresult PLUGIN_API
 Vst3PluginProxyImpl::process(Steinberg::Vst::ProcessData& data) {
+    const auto process_start = std::chrono::steady_clock::now();
+
     // We'll synchronize the scheduling priority of the audio thread on the Wine
     // plugin host with that of the host's audio thread every once in a while
     std::optional<int> new_realtime_priority = std::nullopt;
@@ -231,11 +267,39 @@ Vst3PluginProxyImpl::process(Steinberg::Vst::ProcessData& data) {
     // We reuse this existing object to avoid allocations.
     // `YaProcessData::repopulate()` will write the input audio to the shared
     // audio buffers, so they're not stored within the request object itself.
+    // When using pipelined processing, the Wine plugin host may still be
+    // processing the last block. We'll need to wait for that to finish before
+    // we can touch the shared memory buffers again. The output parameter
+    // changes and events for that block are delayed along with its audio.
     assert(process_buffers);
+    const bool pipelined = output_delay_line.delay() > 0;
+    if (pipelined) {
+        finish_pending_process();
+    }
+
+    // Automation coming from the host changes the plugin's state, so we can't
+    // keep serving cached states after this
+    if (data.inputParameterChanges &&
+        data.inputParameterChanges->getParameterCount() > 0) {
+        state_cache.invalidate();
+    }
+
     process_request.instance_id = instance_id();
     process_request.data.repopulate(data, *process_buffers);
     process_request.new_realtime_priority = new_realtime_priority;
 
+    // When the `vst3_skip_silence` option is enabled, the plugin doesn't have a
+    // tail, it has already gone silent, and there's nothing for it to process,
+    // then we can output silence ourselves without bothering the Wine plugin
+    // host. We can't do this while pipelining since the delay line may still
+    // contain audio.
+    if (!pipelined && may_skip_silence && last_outputs_silent &&
+        process_request.data.inputs_silent()) {
+        YaProcessData::write_back_silence(data);
+
+        return Steinberg::kResultOk;
+    }
+
     // HACK: This is a bit ugly. This `YaProcessData::Response` object actually
     //       contains pointers to the corresponding `YaProcessData` fields in
     //       this object, so we can only send back the fields that are actually
@@ -250,21 +314,180 @@ Vst3PluginProxyImpl::process(Steinberg::Vst::ProcessData& data) {
     //       clearer.
     process_response.output_data = process_request.data.create_response();
 
-    // We'll also receive the response into an existing object so we can also
-    // avoid heap allocations there
-    bridge.receive_audio_processor_message_into(
-        MessageReference<YaAudioProcessor::Process>(process_request),
-        process_response);
+    // The request is passed to the Wine plugin host through the control region
+    // in the shared memory audio buffers, and the Wine side will wake us up
+    // again after it has written the response there. This avoids a socket
+    // round trip for every processing cycle. If the request doesn't fit in the
+    // message area because the host sent a huge amount of events, then we'll
+    // fall back to using the socket. In both cases we'll receive the response
+    // into an existing object so we can also avoid heap allocations there.
+    if (const std::optional<uint32_t> request_size = write_shm_object(
+            *process_buffers, process_request, process_message_buffer))
+        [[likely]] {
+        const bool should_log_response = bridge.logger.log_request(
+            true, MessageReference<YaAudioProcessor::Process>(process_request));
+
+        // With pipelined processing we'll return to the host immediately and
+        // pick up the response during the next processing cycle. Blocks larger
+        // than the maximum block size are processed synchronously to keep the
+        // latency constant.
+        if (pipelined && static_cast<uint32_t>(data.numSamples) <=
+                             output_delay_line.delay()) {
+            process_buffers->send_request(*request_size);
+            process_pending = true;
+            should_log_pending_response = should_log_response;
+        } else {
+            // If this returns `false` then the Wine plugin host has shut down,
+            // so there won't be any response for us to read
+            if (!process_buffers->send_request_and_wait(
+                    *request_size, bridge.audio_spin_duration()))
+                [[unlikely]] {
+                return Steinberg::kResultFalse;
+            }
+
+            read_shm_object(*process_buffers, process_response,
+                            process_message_buffer);
+
+            if (should_log_response) {
+                bridge.logger.log_response(false, process_response);
+            }
+        }
+    } else {
+        bridge.receive_audio_processor_message_into(
+            MessageReference<YaAudioProcessor::Process>(process_request),
+            process_response);
+    }
+
+    if (pipelined) {
+        // If this block was processed synchronously, then its results still
+        // need to go through the delay line to keep the latency constant
+        if (!process_pending) {
+            write_outputs_to_delay_line();
+        }
+
+        for (int bus = 0;
+             bus < data.numOutputs &&
+             bus < static_cast<int>(output_delay_line.num_busses());
+             bus++) {
+            Steinberg::Vst::AudioBusBuffers& host_bus = data.outputs[bus];
+            const int num_channels = std::min(
+                static_cast<int>(host_bus.numChannels),
+                static_cast<int>(output_delay_line.num_channels(bus)));
+            for (int channel = 0; channel < num_channels; channel++) {
+                if (data.symbolicSampleSize == Steinberg::Vst::kSample64) {
+                    output_delay_line.read(bus, channel,
+                                           host_bus.channelBuffers64[channel],
+                                           data.numSamples);
+                } else {
+                    output_delay_line.read(bus, channel,
+                                           host_bus.channelBuffers32[channel],
+                                           data.numSamples);
+                }
+            }
+
+            host_bus.silenceFlags = 0;
+        }
+        output_delay_line.commit_read(data.numSamples);
+
+        // The parameter changes and events that belong to the audio we just
+        // returned are passed to the host with offsets relative to this block
+        delayed_output_parameter_changes.write_back_delayed_outputs(
+            data.outputParameterChanges, data.numSamples);
+        delayed_output_events.write_back_delayed_outputs(data.outputEvents,
+                                                         data.numSamples);
+
+        record_process_stats(process_start, data.numSamples);
+
+        return Steinberg::kResultOk;
+    }
 
     // At this point the shared audio buffers should contain the output audio,
     // so we'll write that back to the host along with any metadata (which in
     // practice are only the silence flags), as well as any output parameter
     // changes and events
     process_request.data.write_back_outputs(data, *process_buffers);
+    last_outputs_silent = process_request.data.outputs_silent();
+
+    record_process_stats(process_start, data.numSamples);
 
     return process_response.result;
 }
 
+void Vst3PluginProxyImpl::record_process_stats(
+    std::chrono::steady_clock::time_point process_start,
+    int32 num_samples) noexcept {
+    // With pipelined processing the processing time is that of the previous
+    // block, but over many cycles this averages out the same
+    process_stats.record(
+        std::chrono::steady_clock::now() - process_start,
+        std::chrono::nanoseconds(process_response.processing_time_ns),
+        sample_rate > 0 ? std::chrono::nanoseconds(static_cast<int64_t>(
+                              (num_samples * 1e9) / sample_rate))
+                        : std::chrono::nanoseconds(0));
+}
+
+bool Vst3PluginProxyImpl::finish_pending_process() {
+    if (!process_pending) {
+        return true;
+    }
+
+    process_pending = false;
+    if (!process_buffers->wait_for_response(bridge.audio_spin_duration()))
+        [[unlikely]] {
+        return false;
+    }
+
+    read_shm_object(*process_buffers, process_response, process_message_buffer);
+    if (should_log_pending_response) {
+        bridge.logger.log_response(false, process_response);
+    }
+
+    write_outputs_to_delay_line();
+
+    return true;
+}
+
+void Vst3PluginProxyImpl::write_outputs_to_delay_line() {
+    const YaProcessData& processed_data = process_request.data;
+    const uint32_t num_samples =
+        static_cast<uint32_t>(processed_data.num_samples);
+
+    // The first sample of this block will be returned to the host after all
+    // samples that are currently stored in the delay line
+    const int32 delay = static_cast<int32>(output_delay_line.stored_samples());
+    if (processed_data.output_parameter_changes) {
+        delayed_output_parameter_changes.append_delayed(
+            *processed_data.output_parameter_changes, delay);
+    }
+    if (processed_data.output_events) {
+        delayed_output_events.append_delayed(*processed_data.output_events,
+                                             delay);
+    }
+
+    // This only allocates when the host sends more samples than it promised
+    output_delay_line.reserve(num_samples);
+    for (uint32_t bus = 0; bus < output_delay_line.num_busses(); bus++) {
+        for (uint32_t channel = 0;
+             channel < output_delay_line.num_channels(bus); channel++) {
+            if (processed_data.symbolic_sample_size ==
+                Steinberg::Vst::kSample64) {
+                output_delay_line.write(
+                    bus, channel,
+                    processed_data.output_channel_ptr<double>(*process_buffers,
+                                                              bus, channel),
+                    num_samples);
+            } else {
+                output_delay_line.write(
+                    bus, channel,
+                    processed_data.output_channel_ptr<float>(*process_buffers,
+                                                             bus, channel),
+                    num_samples);
+            }
+        }
+    }
+    output_delay_line.commit_write(num_samples);
+}
+
 uint32 PLUGIN_API Vst3PluginProxyImpl::getTailSamples() {
     return bridge.send_audio_processor_message(
         YaAudioProcessor::GetTailSamples{.instance_id = instance_id()});
@@ -418,6 +641,15 @@ tresult PLUGIN_API Vst3PluginProxyImpl::setActive(TBool state) {
     //       workaround of its ownn.  Great!
     clear_bus_cache();
 
+    // Any audio left in the delay line from before the plugin was deactivated
+    // should not end up in the output after reactivating it
+    finish_pending_process();
+    if (state && bridge.audio_pipelining() && process_buffers) {
+        output_delay_line.reset(*process_buffers, output_delay_line.delay());
+        delayed_output_parameter_changes.clear();
+        delayed_output_events.clear();
+    }
+
     return bridge.send_audio_processor_message(
         YaComponent::SetActive{.instance_id = instance_id(), .state = state});
 }
@@ -432,8 +664,19 @@ tresult PLUGIN_API Vst3PluginProxyImpl::setState(Steinberg::IBStream* state) {
         //       GUI thread. So if the GUI is active, we'll use the mutual
         //       recursion mechanism to allow this resize call to also be
         //       performed from the GUI thread.
-        return bridge.send_mutually_recursive_message(Vst3PluginProxy::SetState{
-            .instance_id = instance_id(), .state = state});
+        // NOTE: Only the first window of the state is sent along with the
+        //       request. If the state is larger than that, then the Wine plugin
+        //       host will read the rest directly from `state` as the plugin
+        //       reads it.
+        state_cache.invalidate();
+        const native_size_t stream_id = bridge.register_host_stream(state);
+        const tresult result =
+            bridge.send_mutually_recursive_message(Vst3PluginProxy::SetState{
+                .instance_id = instance_id(),
+                .state = YaBStream(state, stream_id)});
+        bridge.unregister_host_stream(stream_id);
+
+        return result;
     } else {
         bridge.logger.log(
             "WARNING: Null pointer passed to "
@@ -453,12 +696,61 @@ tresult PLUGIN_API Vst3PluginProxyImpl::getState(Steinberg::IBStream* state) {
         //       so when changing a parameter also resizes the GUI we can run
         //       into a situation where we need mutually recursive function
         //       calls.
-        const GetStateResponse response =
+        // NOTE: Large states are written to `state` directly through
+        //       callbacks while the plugin writes them. In that case the
+        //       response's stream will still have its `stream_id` set, and
+        //       we'll only need to move the seek position to the end of the
+        //       state before writing back the stream's meta data.
+        // NOTE: When the `cache_state` option is enabled and nothing could
+        //       have changed the plugin's state since the last call, we'll
+        //       write the state from that last call instead
+        if (bridge.cache_state() && state_cache.contains(0)) {
+            std::lock_guard lock(cached_state_mutex);
+
+            const bool log_response = bridge.logger.log_request(
+                true, Vst3PluginProxy::GetState{.instance_id = instance_id(),
+                                                .state = YaBStream{}});
+            if (log_response) {
+                bridge.logger.log_response(
+                    true, UniversalTResult(Steinberg::kResultOk), true);
+            }
+
+            int32 num_bytes_written = 0;
+            state->write(cached_state.data(),
+                         static_cast<int32>(cached_state.size()),
+                         &num_bytes_written);
+
+            return Steinberg::kResultOk;
+        }
+
+        const uint64_t state_generation = state_cache.generation();
+        const native_size_t stream_id = bridge.register_host_stream(state);
+        GetStateResponse response =
             bridge.send_mutually_recursive_message(Vst3PluginProxy::GetState{
-                .instance_id = instance_id(), .state = state});
+                .instance_id = instance_id(),
+                .state = YaBStream(state, stream_id)});
+        const int64 start_position = bridge.unregister_host_stream(stream_id);
 
+        if (response.state.stream_id) {
+            state->seek(start_position + response.state.stream_size,
+                        Steinberg::IBStream::kIBSeekSet);
+        }
         assert(response.state.write_back(state) == Steinberg::kResultOk);
 
+        // We can only replay the state if the plugin didn't also write any meta
+        // data through `IStreamAttributes`. Streamed states are not cached at
+        // all. Those have already been written to the host's stream, and
+        // keeping a copy around would mean reading the entire state back from
+        // the host and holding on to it for as long as the plugin is alive.
+        if (bridge.cache_state() && response.result == Steinberg::kResultOk &&
+            !response.state.stream_id &&
+            !(response.state.attributes &&
+              !response.state.attributes->keys_and_types().empty())) {
+            std::lock_guard lock(cached_state_mutex);
+            cached_state = std::move(response.state.inline_data());
+            state_cache.store(state_generation, 0);
+        }
+
         return response.result;
     } else {
         bridge.logger.log(
@@ -563,6 +855,7 @@ Vst3PluginProxyImpl::notify(Steinberg::Vst::IMessage* message) {
     // are connected directly we also connected them directly on the Wine side,
     // so we don't have to do any additional when those objects pass through
     // messages.
+    state_cache.invalidate();
     if (auto message_ptr = dynamic_cast<YaMessagePtr*>(message)) {
         return bridge.send_message(YaConnectionPoint::Notify{
             .instance_id = instance_id(), .message_ptr = *message_ptr});
@@ -602,6 +895,7 @@ Vst3PluginProxyImpl::notify(Steinberg::Vst::IMessage* message) {
 tresult PLUGIN_API
 Vst3PluginProxyImpl::setComponentState(Steinberg::IBStream* state) {
     if (state) {
+        state_cache.invalidate();
         return bridge.send_message(YaEditController::SetComponentState{
             .instance_id = instance_id(), .state = state});
     } else {
@@ -616,6 +910,7 @@ int32 PLUGIN_API Vst3PluginProxyImpl::getParameterCount() {
     const auto request =
         YaEditController::GetParameterCount{.instance_id = instance_id()};
 
+    prefetch_parameter_info();
     {
         std::lock_guard lock(function_result_cache_mutex);
         if (function_result_cache.parameter_count) {
@@ -648,6 +943,9 @@ tresult PLUGIN_API Vst3PluginProxyImpl::getParameterInfo(
     const auto request = YaEditController::GetParameterInfo{
         .instance_id = instance_id(), .param_index = paramIndex};
 
+    // Parameters the plugin returned an error for during the prefetch are not
+    // cached, so those will still be requested individually
+    prefetch_parameter_info();
     {
         std::lock_guard lock(function_result_cache_mutex);
         if (auto it = function_result_cache.parameter_info.find(paramIndex);
@@ -749,6 +1047,7 @@ Vst3PluginProxyImpl::getParamNormalized(Steinberg::Vst::ParamID id) {
 tresult PLUGIN_API
 Vst3PluginProxyImpl::setParamNormalized(Steinberg::Vst::ParamID id,
                                         Steinberg::Vst::ParamValue value) {
+    state_cache.invalidate();
     return bridge.send_message(YaEditController::SetParamNormalized{
         .instance_id = instance_id(), .id = id, .value = value});
 }
@@ -1133,6 +1432,7 @@ Vst3PluginProxyImpl::setProgramData(Steinberg::Vst::ProgramListID listId,
                                     int32 programIndex,
                                     Steinberg::IBStream* data) {
     if (data) {
+        state_cache.invalidate();
         return bridge.send_message(
             YaProgramListData::SetProgramData{.instance_id = instance_id(),
                                               .list_id = listId,
@@ -1329,6 +1629,7 @@ Vst3PluginProxyImpl::setUnitProgramData(int32 listOrUnitId,
                                         int32 programIndex,
                                         Steinberg::IBStream* data) {
     if (data) {
+        state_cache.invalidate();
         return bridge.send_message(
             YaUnitInfo::SetUnitProgramData{.instance_id = instance_id(),
                                            .list_or_unit_id = listOrUnitId,
@@ -1361,6 +1662,31 @@ tresult PLUGIN_API Vst3PluginProxyImpl::getXmlRepresentationStream(
     }
 }
 
+void Vst3PluginProxyImpl::prefetch_parameter_info() {
+    {
+        std::lock_guard lock(function_result_cache_mutex);
+        if (function_result_cache.parameter_info_prefetched) {
+            return;
+        }
+    }
+
+    // We can't hold the lock while waiting for the response, since the plugin
+    // may call back into the host while we're fetching this information
+    const GetAllParameterInfoResponse response =
+        bridge.send_message(YaEditController::GetAllParameterInfo{
+            .instance_id = instance_id()});
+
+    std::lock_guard lock(function_result_cache_mutex);
+    function_result_cache.parameter_info_prefetched = true;
+    function_result_cache.parameter_count = response.parameter_count;
+    for (size_t i = 0; i < response.parameter_infos.size(); i++) {
+        if (response.parameter_infos[i].result == Steinberg::kResultOk) {
+            function_result_cache.parameter_info[static_cast<int32>(i)] =
+                response.parameter_infos[i].info;
+        }
+    }
+}
+
 void Vst3PluginProxyImpl::clear_bus_cache() noexcept {
     std::lock_guard lock(processing_bus_cache_mutex);
     if (processing_bus_cache) {
@@ -18,6 +18,9 @@
 
 #include <map>
 
+#include "../../output-delay-line.h"
+#include "../../process-stats.h"
+#include "../../state-cache.h"
 #include "../vst3.h"
 #include "plug-view-proxy.h"
 
@@ -396,6 +399,13 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
     Steinberg::FUnknownPtr<Steinberg::Vst::IUnitHandler> unit_handler;
     Steinberg::FUnknownPtr<Steinberg::Vst::IUnitHandler2> unit_handler_2;
 
+    /**
+     * Performance counters for this instance's audio processing. These are
+     * served on the stats socket by `Vst3PluginBridge`. Cycles skipped because
+     * of the `vst3_skip_silence` option are not counted.
+     */
+    ProcessStats process_stats;
+
    private:
     /**
      * Clear the bus count and information cache. We need this cache for REAPER
@@ -413,6 +423,46 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
      */
     void clear_bus_cache() noexcept;
 
+    /**
+     * Fetch the parameter count and the information for every parameter from
+     * the Wine plugin host in a single request, and store the results in
+     * `function_result_cache`. This is done the first time the host asks for
+     * parameter information after the caches have been cleared, since hosts
+     * tend to query every single parameter right after initializing the plugin
+     * and after the plugin tells the host that its parameters have changed.
+     * This does nothing if the information has already been fetched.
+     */
+    void prefetch_parameter_info();
+
+    /**
+     * When using the `audio_pipelining` option, wait for the Wine plugin host
+     * to finish processing the block we sent during the last processing cycle.
+     * The output audio is written to `output_delay_line`, and any output
+     * parameter changes and events are delayed along with it. Does nothing if
+     * there is no pending block.
+     *
+     * @return `false` if the Wine plugin host has shut down while we were
+     *   waiting.
+     */
+    bool finish_pending_process();
+
+    /**
+     * Append the output audio for the last processed block from
+     * `process_buffers` to `output_delay_line`, and append its output
+     * parameter changes and events to `delayed_output_parameter_changes` and
+     * `delayed_output_events`. Those are shifted by the number of samples
+     * already stored in the delay line so they stay in sync with the audio.
+     */
+    void write_outputs_to_delay_line();
+
+    /**
+     * Record a processing cycle that started at `process_start` in
+     * `process_stats`.
+     */
+    void record_process_stats(
+        std::chrono::steady_clock::time_point process_start,
+        int32 num_samples) noexcept;
+
     Vst3PluginBridge& bridge;
 
     /**
@@ -431,6 +481,13 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
      */
     time_t last_audio_thread_priority_synchronization = 0;
 
+    /**
+     * The sample rate from the last call to
+     * `IAudioProcessor::setupProcessing()`. This is only used to determine the
+     * deadline for a processing cycle in `process_stats`.
+     */
+    double sample_rate = 0.0;
+
     /**
      * Used to assign unique identifiers to context menus created by
      * `IComponentHandler3::CreateContextMenu`.
@@ -460,6 +517,31 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
      */
     YaAudioProcessor::ProcessResponse process_response;
 
+    /**
+     * The buffer used to serialize `process_request` and to deserialize
+     * `process_response` when passing these objects through `process_buffers`'s
+     * control region. Like the objects above this is reused to avoid
+     * allocations.
+     */
+    SerializationBuffer<2048> process_message_buffer;
+
+    /**
+     * Whether the `vst3_skip_silence` option is enabled and the plugin reported
+     * a tail length of zero when the host started processing audio. Hosts may
+     * call `IAudioProcessor::setProcessing()` from a different thread than the
+     * audio thread, hence the atomic.
+     *
+     * @see Vst3PluginProxyImpl::process
+     */
+    std::atomic_bool may_skip_silence = false;
+
+    /**
+     * Whether all of the plugin's output channels were silent during the last
+     * processing cycle. Together with `may_skip_silence` this determines
+     * whether we can skip a processing cycle.
+     */
+    bool last_outputs_silent = false;
+
     /**
      * A shared memory object to share audio buffers between the native plugin
      * and the Wine plugin host. Copying audio is the most significant source of
@@ -471,6 +553,39 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
      */
     std::optional<AudioShmBuffer> process_buffers;
 
+    /**
+     * When the `audio_pipelining` option is enabled, the results from the Wine
+     * plugin host are returned to the host one processing cycle later. This
+     * FIFO stores those results and adds exactly `maxSamplesPerBlock` samples
+     * of latency, which we'll add to the plugin's reported latency. Its delay
+     * will be zero when pipelining is disabled.
+     *
+     * This will be set up during `IAudioProcessor::setupProcessing()`.
+     */
+    OutputDelayLine output_delay_line;
+
+    /**
+     * Output parameter changes and events from the plugin when using
+     * pipelined processing. These are delayed by the same number of samples as
+     * the audio in `output_delay_line`, and their sample offsets are relative
+     * to the start of the next block we'll return to the host.
+     */
+    YaParameterChanges delayed_output_parameter_changes;
+    YaEventList delayed_output_events;
+
+    /**
+     * Whether the Wine plugin host is currently processing the block we sent
+     * during the last processing cycle. The response will be written to
+     * `process_response` once we pick it up.
+     */
+    bool process_pending = false;
+
+    /**
+     * Whether the response for the pending block should be logged. This is
+     * determined when the request gets logged.
+     */
+    bool should_log_pending_response = false;
+
     // Caches
 
     /**
@@ -535,6 +650,11 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
          * Memoizes `IEditController::getParameterInfo()`.
          */
         std::unordered_map<int32, Steinberg::Vst::ParameterInfo> parameter_info;
+        /**
+         * Whether `parameter_count` and `parameter_info` have been filled in
+         * using `prefetch_parameter_info()`.
+         */
+        bool parameter_info_prefetched = false;
     };
 
     /**
@@ -553,4 +673,25 @@ class Vst3PluginProxyImpl : public Vst3PluginProxy {
      */
     FunctionResultCache function_result_cache;
     std::mutex function_result_cache_mutex;
+
+   public:
+    /**
+     * Tracks whether `cached_state` still contains the plugin's current state
+     * so repeated `getState()` calls can be answered without involving the
+     * Wine plugin host when the `cache_state` option is enabled. This is
+     * public so the plug view proxy and the component handler callbacks can
+     * invalidate it.
+     *
+     * @see StateCache
+     */
+    StateCache state_cache;
+
+   private:
+    /**
+     * The state returned by the last call to `getState()`, if it did not
+     * contain any meta data attributes and it was small enough to not be
+     * streamed. Only used when the `cache_state` option is enabled.
+     */
+    std::vector<uint8_t> cached_state;
+    std::mutex cached_state_mutex;
 };
@@ -27,7 +27,9 @@ using namespace std::literals::string_literals;
 Vst3PluginBridge::Vst3PluginBridge()
     : PluginBridge(
           PluginType::vst3,
-          [](boost::asio::io_context& io_context, const PluginInfo& info) {
+          [](boost::asio::io_context& io_context,
+             const PluginInfo& info,
+             const Configuration&) {
               return Vst3Sockets<std::jthread>(
                   io_context,
                   generate_endpoint_base(info.native_library_path.filename()
@@ -36,6 +38,40 @@ Vst3PluginBridge::Vst3PluginBridge()
                   true);
           }),
       logger(generic_logger) {
+    // If we've seen this exact plugin before, then the host can scan the
+    // plugin's factory without us having to start Wine
+    if (std::optional<Vst3PluginFactoryProxy::ConstructArgs> factory_args =
+            metadata_cache.load<Vst3PluginFactoryProxy::ConstructArgs>()) {
+        cached_factory_args = std::move(*factory_args);
+
+        logger.log(
+            "Using cached plugin metadata, the Wine plugin host will be "
+            "started when it's first needed");
+    } else {
+        ensure_plugin_host_started();
+    }
+}
+
+void Vst3PluginBridge::ensure_plugin_host_started() {
+    if (plugin_host_started.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::call_once(plugin_host_started_flag, [&]() {
+        start_plugin_host();
+        plugin_host_started.store(true, std::memory_order_release);
+
+        // If the host already passed a host context to the plugin factory we
+        // created from the cached metadata, then we still need to pass it on
+        // to the actual plugin
+        if (plugin_factory) {
+            plugin_factory->send_host_context();
+        }
+    });
+}
+
+void Vst3PluginBridge::start_plugin_host() {
+    launch_host();
     log_init_message();
 
     // This will block until all sockets have been connected to by the Wine VST
@@ -69,6 +105,14 @@ Vst3PluginBridge::Vst3PluginBridge()
 
                     return config;
                 },
+                [&](const YaBStream::Read& request)
+                    -> YaBStream::Read::Response {
+                    return read_host_stream(request);
+                },
+                [&](const YaBStream::Write& request)
+                    -> YaBStream::Write::Response {
+                    return write_host_stream(request);
+                },
                 [&](const YaComponentHandler::BeginEdit& request)
                     -> YaComponentHandler::BeginEdit::Response {
                     return plugin_proxies.at(request.owner_instance_id)
@@ -77,10 +121,13 @@ Vst3PluginBridge::Vst3PluginBridge()
                 },
                 [&](const YaComponentHandler::PerformEdit& request)
                     -> YaComponentHandler::PerformEdit::Response {
-                    return plugin_proxies.at(request.owner_instance_id)
-                        .get()
-                        .component_handler->performEdit(
-                            request.id, request.value_normalized);
+                    Vst3PluginProxyImpl& proxy_object =
+                        plugin_proxies.at(request.owner_instance_id).get();
+
+                    proxy_object.state_cache.invalidate();
+
+                    return proxy_object.component_handler->performEdit(
+                        request.id, request.value_normalized);
                 },
                 [&](const YaComponentHandler::EndEdit& request)
                     -> YaComponentHandler::EndEdit::Response {
@@ -102,9 +149,13 @@ Vst3PluginBridge::Vst3PluginBridge()
                 },
                 [&](const YaComponentHandler2::SetDirty& request)
                     -> YaComponentHandler2::SetDirty::Response {
-                    return plugin_proxies.at(request.owner_instance_id)
-                        .get()
-                        .component_handler_2->setDirty(request.state);
+                    Vst3PluginProxyImpl& proxy_object =
+                        plugin_proxies.at(request.owner_instance_id).get();
+
+                    proxy_object.state_cache.invalidate();
+
+                    return proxy_object.component_handler_2->setDirty(
+                        request.state);
                 },
                 [&](const YaComponentHandler2::RequestOpenEditor& request)
                     -> YaComponentHandler2::RequestOpenEditor::Response {
@@ -352,10 +403,13 @@ Vst3PluginBridge::Vst3PluginBridge()
                 },
                 [&](const YaUnitHandler::NotifyProgramListChange& request)
                     -> YaUnitHandler::NotifyProgramListChange::Response {
-                    return plugin_proxies.at(request.owner_instance_id)
-                        .get()
-                        .unit_handler->notifyProgramListChange(
-                            request.list_id, request.program_index);
+                    Vst3PluginProxyImpl& proxy_object =
+                        plugin_proxies.at(request.owner_instance_id).get();
+
+                    proxy_object.state_cache.invalidate();
+
+                    return proxy_object.unit_handler->notifyProgramListChange(
+                        request.list_id, request.program_index);
                 },
                 [&](const YaUnitHandler2::NotifyUnitByBusChange& request)
                     -> YaUnitHandler2::NotifyUnitByBusChange::Response {
@@ -365,12 +419,27 @@ Vst3PluginBridge::Vst3PluginBridge()
                 },
             });
     });
+
+    // Every audio processor instance created from this module gets its own
+    // section in the report
+    start_stats_server(stats_server, [&](std::ostream& report) {
+        std::lock_guard lock(plugin_proxies_mutex);
+        for (const auto& [instance_id, proxy] : plugin_proxies) {
+            if (proxy.get().YaAudioProcessor::supported()) {
+                report << "instance " << instance_id << ":" << std::endl;
+                proxy.get().process_stats.print(report, "  ");
+            }
+        }
+    });
 }
 
 Vst3PluginBridge::~Vst3PluginBridge() noexcept {
     try {
-        // Drop all work make sure all sockets are closed
-        plugin_host->terminate();
+        // Drop all work make sure all sockets are closed. The Wine plugin host
+        // may never have been started if the host only scanned the plugin.
+        if (plugin_host) {
+            plugin_host->terminate();
+        }
         io_context.stop();
     } catch (const boost::system::system_error&) {
         // It could be that the sockets have already been closed or that the
@@ -389,13 +458,25 @@ Steinberg::IPluginFactory* Vst3PluginBridge::get_plugin_factory() {
         // Set up the plugin factory, since this is the first thing the host
         // will request after loading the module. Host callback handlers should
         // have started before this since the Wine plugin host will request a
-        // copy of the configuration during its initialization.
-        Vst3PluginFactoryProxy::ConstructArgs factory_args =
-            sockets.host_vst_control.send_message(
-                Vst3PluginFactoryProxy::Construct{},
-                std::pair<Vst3Logger&, bool>(logger, true));
-        plugin_factory = Steinberg::owned(
-            new Vst3PluginFactoryProxyImpl(*this, std::move(factory_args)));
+        // copy of the configuration during its initialization. When the
+        // factory's information could be read from the metadata cache, the
+        // Wine plugin host won't be started until the host creates an
+        // instance of one of the plugin's classes.
+        if (cached_factory_args) {
+            plugin_factory = Steinberg::owned(new Vst3PluginFactoryProxyImpl(
+                *this, std::move(*cached_factory_args)));
+            cached_factory_args.reset();
+        } else {
+            ensure_plugin_host_started();
+
+            Vst3PluginFactoryProxy::ConstructArgs factory_args =
+                sockets.host_vst_control.send_message(
+                    Vst3PluginFactoryProxy::Construct{},
+                    std::pair<Vst3Logger&, bool>(logger, true));
+            metadata_cache.store(factory_args, generic_logger);
+            plugin_factory = Steinberg::owned(
+                new Vst3PluginFactoryProxyImpl(*this, std::move(factory_args)));
+        }
     }
 
     // Because we're returning a raw pointer, we have to increase the reference
@@ -430,3 +511,73 @@ void Vst3PluginBridge::unregister_plugin_proxy(
         sockets.remove_audio_processor(proxy_object.instance_id());
     }
 }
+
+native_size_t Vst3PluginBridge::register_host_stream(
+    Steinberg::IBStream* stream) {
+    int64 start_position = 0;
+    stream->tell(&start_position);
+
+    std::lock_guard lock(host_streams_mutex);
+    const native_size_t stream_id = next_host_stream_id++;
+    host_streams[stream_id] =
+        HostStream{.stream = stream, .start_position = start_position};
+
+    return stream_id;
+}
+
+int64 Vst3PluginBridge::unregister_host_stream(native_size_t stream_id) {
+    std::lock_guard lock(host_streams_mutex);
+    const int64 start_position = host_streams.at(stream_id).start_position;
+    host_streams.erase(stream_id);
+
+    return start_position;
+}
+
+YaBStream::ReadResponse Vst3PluginBridge::read_host_stream(
+    const YaBStream::Read& request) {
+    HostStream host_stream;
+    {
+        std::lock_guard lock(host_streams_mutex);
+        host_stream = host_streams.at(request.stream_id);
+    }
+
+    if (host_stream.stream->seek(host_stream.start_position + request.position,
+                                 Steinberg::IBStream::kIBSeekSet) !=
+        Steinberg::kResultOk) {
+        return YaBStream::ReadResponse{.result = Steinberg::kResultFalse};
+    }
+
+    YaBStream::ReadResponse response{};
+    response.data.resize(request.size);
+    int32 num_bytes_read = 0;
+    response.result = host_stream.stream->read(response.data.data(),
+                                               request.size, &num_bytes_read);
+    response.data.resize(std::max(num_bytes_read, 0));
+
+    return response;
+}
+
+tresult Vst3PluginBridge::write_host_stream(const YaBStream::Write& request) {
+    HostStream host_stream;
+    {
+        std::lock_guard lock(host_streams_mutex);
+        host_stream = host_streams.at(request.stream_id);
+    }
+
+    if (host_stream.stream->seek(host_stream.start_position + request.position,
+                                 Steinberg::IBStream::kIBSeekSet) !=
+        Steinberg::kResultOk) {
+        return Steinberg::kResultFalse;
+    }
+
+    int32 num_bytes_written = 0;
+    const tresult result = host_stream.stream->write(
+        const_cast<uint8_t*>(request.data.data()),
+        static_cast<int32>(request.data.size()), &num_bytes_written);
+    if (result == Steinberg::kResultOk &&
+        static_cast<size_t>(num_bytes_written) != request.data.size()) {
+        return Steinberg::kResultFalse;
+    }
+
+    return result;
+}
@@ -73,6 +73,23 @@ class Vst3PluginBridge : PluginBridge<Vst3Sockets<std::jthread>> {
      */
     Steinberg::IPluginFactory* get_plugin_factory();
 
+    /**
+     * Start the Wine plugin host and initialize the bridge if that has not
+     * happened yet. This is called from the constructor, unless the plugin
+     * factory's information could be read from the metadata cache. In that
+     * case this is called by the plugin factory proxy once the host creates
+     * an instance of one of the plugin's classes.
+     */
+    void ensure_plugin_host_started();
+
+    /**
+     * Whether the Wine plugin host has been started. The plugin factory proxy
+     * uses this to defer passing the host context to the plugin.
+     */
+    inline bool is_plugin_host_started() const noexcept {
+        return plugin_host_started.load(std::memory_order_acquire);
+    }
+
     /**
      * Add a `Vst3PluginProxyImpl` to the list of registered proxy objects so we
      * can handle host callbacks. This function is called in
@@ -99,6 +116,68 @@ class Vst3PluginBridge : PluginBridge<Vst3Sockets<std::jthread>> {
      */
     void unregister_plugin_proxy(Vst3PluginProxyImpl& proxy_object);
 
+    /**
+     * Register a stream passed by the host to
+     * `{IComponent,IEditController}::{get,set}State()` so the Wine plugin host
+     * can read from and write to it through `YaBStream::Read` and
+     * `YaBStream::Write` callbacks while handling that function call. Positions
+     * in those callbacks are relative to the stream's current seek position.
+     * The stream should be unregistered again with `unregister_host_stream()`
+     * before the function returns.
+     *
+     * @return A unique identifier for the stream, to be passed to the
+     *   `YaBStream` constructor.
+     *
+     * @see YaBStream::stream_id
+     */
+    native_size_t register_host_stream(Steinberg::IBStream* stream);
+
+    /**
+     * Remove a stream registered with `register_host_stream()`.
+     *
+     * @return The seek position the stream was registered at.
+     */
+    int64 unregister_host_stream(native_size_t stream_id);
+
+    /**
+     * How long to busy wait for the Wine plugin host to finish processing
+     * before going to sleep during `IAudioProcessor::process()`. This is set
+     * through the `audio_spin_us` option.
+     */
+    inline std::chrono::microseconds audio_spin_duration() const noexcept {
+        return config.audio_spin_duration();
+    }
+
+    /**
+     * Whether we may skip processing cycles for plugins with no tail when
+     * everything is silent. This is set through the `vst3_skip_silence`
+     * option.
+     *
+     * @see Vst3PluginProxyImpl::process
+     */
+    inline bool skip_silence() const noexcept {
+        return config.vst3_skip_silence;
+    }
+
+    /**
+     * Whether the plugin's output should be returned one processing cycle
+     * later so the Wine plugin host can process audio while the host does
+     * other work. This is set through the `audio_pipelining` option.
+     *
+     * @see Vst3PluginProxyImpl::process
+     */
+    inline bool audio_pipelining() const noexcept {
+        return config.audio_pipelining;
+    }
+
+    /**
+     * Whether `getState()` calls should be answered from a cached copy of the
+     * plugin's state when nothing has changed since the last call.
+     *
+     * @see Vst3PluginProxyImpl::getState
+     */
+    inline bool cache_state() const noexcept { return config.cache_state; }
+
     /**
      * Send a control message to the Wine plugin host return the response. This
      * is a shorthand for `sockets.host_vst_control.send_message` for use in
@@ -178,6 +257,19 @@ class Vst3PluginBridge : PluginBridge<Vst3Sockets<std::jthread>> {
     Vst3Logger logger;
 
    private:
+    /**
+     * Launch the Wine plugin host, connect to it, and start handling
+     * callbacks. Should only be called through `ensure_plugin_host_started()`.
+     */
+    void start_plugin_host();
+
+    /**
+     * The plugin factory's information read from the metadata cache, if the
+     * plugin could be loaded this way. This is moved into `plugin_factory`
+     * when the host first requests the plugin factory.
+     */
+    std::optional<Vst3PluginFactoryProxy::ConstructArgs> cached_factory_args;
+
     /**
      * Handles callbacks from the plugin to the host over the
      * `vst_host_callback` sockets.
@@ -210,10 +302,51 @@ class Vst3PluginBridge : PluginBridge<Vst3Sockets<std::jthread>> {
    private:
     std::mutex plugin_proxies_mutex;
 
+    /**
+     * Handle a `YaBStream::Read` callback by reading from a stream registered
+     * with `register_host_stream()`.
+     */
+    YaBStream::ReadResponse read_host_stream(const YaBStream::Read& request);
+
+    /**
+     * Handle a `YaBStream::Write` callback by writing to a stream registered
+     * with `register_host_stream()`.
+     */
+    tresult write_host_stream(const YaBStream::Write& request);
+
+    /**
+     * A stream registered through `register_host_stream()`, along with the seek
+     * position it had when it was registered.
+     */
+    struct HostStream {
+        Steinberg::IBStream* stream;
+        int64 start_position;
+    };
+
+    /**
+     * The host's streams the Wine plugin host can currently read from and
+     * write to. These are only accessed from the callback handler threads
+     * while the host's thread is blocked waiting for the `getState()` or
+     * `setState()` call to return, so we can use the streams directly without
+     * running these functions on the host's thread.
+     */
+    std::unordered_map<native_size_t, HostStream> host_streams;
+    std::mutex host_streams_mutex;
+    native_size_t next_host_stream_id = 0;
+
     /**
      * Used in `Vst3Bridge::send_mutually_recursive_message()` to be able to
      * execute functions from that same calling thread while we're waiting for a
      * response. This is used in `Vst3PlugViewProxyImpl::run_loop_tasks()`.
      */
     MutualRecursionHelper<std::jthread> mutual_recursion;
+
+    /**
+     * Serves the performance counters for all of the plugin instances in
+     * `plugin_proxies` on a socket in the socket base directory. This is
+     * defined last so it gets destroyed first.
+     *
+     * @see PluginBridge::start_stats_server
+     */
+    std::optional<StatsServer> stats_server;
 };
@@ -16,6 +16,9 @@
 
 #include "host-process.h"
 
+#include <poll.h>
+#include <signal.h>
+#include <sys/inotify.h>
 #include <boost/asio/read_until.hpp>
 #include <boost/process/env.hpp>
 #include <boost/process/start_dir.hpp>
@@ -25,6 +28,86 @@
 namespace bp = boost::process;
 namespace fs = boost::filesystem;
 
+/**
+ * Repeatedly call `connect` until it succeeds or until the group host process
+ * exits. Instead of retrying on a fixed interval, we'll use inotify to wait
+ * until the group host process creates its socket. Binding the socket and
+ * listening on it are two separate steps, so if we get woken up in between we
+ * will briefly retry every millisecond. We'll also wake up every so often to
+ * check whether the group host process is still running.
+ *
+ * @param group_socket_path The path to the group socket the group host process
+ *   should be listening on.
+ * @param group_host_pid The process ID of the group host process we spawned.
+ * @param connect A function that tries to connect to the group host process
+ *   and that throws a `boost::system::system_error` when that fails.
+ *
+ * @return Whether `connect` succeeded before the group host process exited.
+ */
+template <typename F>
+static bool wait_for_group_host(const fs::path& group_socket_path,
+                                pid_t group_host_pid,
+                                F&& connect) {
+    using namespace std::literals::chrono_literals;
+
+    // We need to start watching before our first connection attempt, or else
+    // we could miss the socket getting created in between
+    const int inotify_fd = inotify_init1(IN_CLOEXEC);
+    if (inotify_fd != -1) {
+        inotify_add_watch(inotify_fd, group_socket_path.parent_path().c_str(),
+                          IN_CREATE);
+    }
+
+    const std::string socket_name = group_socket_path.filename().string();
+    int quick_retries = 0;
+    bool connected = false;
+    while (pid_running(group_host_pid)) {
+        try {
+            connect();
+            connected = true;
+            break;
+        } catch (const boost::system::system_error&) {
+            // Keep trying to connect until either connection gets accepted or
+            // the group host crashes
+        }
+
+        // Without inotify we'll just fall back to polling
+        if (inotify_fd == -1) {
+            std::this_thread::sleep_for(20ms);
+            continue;
+        }
+
+        pollfd poll_fd{.fd = inotify_fd, .events = POLLIN, .revents = 0};
+        const int timeout_ms = quick_retries > 0 ? 1 : 1000;
+        if (quick_retries > 0) {
+            quick_retries--;
+        }
+        if (poll(&poll_fd, 1, timeout_ms) <= 0) {
+            continue;
+        }
+
+        // The directory contains the sockets for every other plugin instance,
+        // so we need to filter out the events for other files
+        alignas(inotify_event) char buffer[4096];
+        const ssize_t bytes_read = read(inotify_fd, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < bytes_read;) {
+            const auto event =
+                reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0 && event->name == socket_name) {
+                quick_retries = 50;
+            }
+
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+
+    if (inotify_fd != -1) {
+        close(inotify_fd);
+    }
+
+    return connected;
+}
+
 HostProcess::HostProcess(boost::asio::io_context& io_context,
                          Logger& logger,
                          const Configuration& config,
@@ -115,6 +198,125 @@ void IndividualHost::terminate() {
     host.wait();
 }
 
+PooledHost::PooledHost(boost::asio::io_context& io_context,
+                       Logger& logger,
+                       const Configuration& config,
+                       Sockets& sockets,
+                       const PluginInfo& plugin_info,
+                       const HostRequest& host_request)
+    : HostProcess(io_context, logger, config, sockets),
+      plugin_info(plugin_info),
+      host_path(find_vst_host(plugin_info.native_library_path,
+                              plugin_info.plugin_arch,
+                              false)) {
+    // We'll go through the pool's slots in order until we find an idle host
+    // process that accepts our request. A slot without any process listening
+    // on it may still be owned by an idle host process that's starting up, so
+    // the slot is only filled again if its lock file says that nobody owns it,
+    // see `PoolSlotLock`. If we can connect to a slot but the process closes
+    // the connection before replying, then another plugin has claimed that
+    // process at the same time and that plugin will take care of replacing it.
+    // Slots after the one we claimed are left alone, since connecting to them
+    // would wake up those processes for nothing.
+    const fs::path wine_prefix = plugin_info.normalize_wine_prefix();
+    const bp::environment host_env = plugin_info.create_host_env();
+    std::vector<fs::path> slots_to_fill;
+    for (uint32_t slot = 0; slot < config.host_pool_size.value_or(0); slot++) {
+        const fs::path pool_socket_path = generate_pool_endpoint(
+            wine_prefix, host_env, plugin_info.plugin_arch, slot);
+
+        boost::asio::local::stream_protocol::socket pool_socket(io_context);
+        boost::system::error_code error;
+        pool_socket.connect(pool_socket_path.string(), error);
+        if (error) {
+            slots_to_fill.push_back(pool_socket_path);
+            continue;
+        }
+
+        try {
+            write_object(pool_socket, host_request);
+            const auto response = read_object<HostResponse>(pool_socket);
+            assert(response.pid > 0);
+
+            // The idle host process gives up ownership of the slot before
+            // replying, so we can fill it again right away
+            pooled_host_pid = response.pid;
+            slots_to_fill.push_back(pool_socket_path);
+            break;
+        } catch (const boost::system::system_error&) {
+            // Another plugin got to this process first
+        }
+    }
+
+    if (pooled_host_pid) {
+        logger.log("Using idle Wine plugin host process with PID " +
+                   std::to_string(*pooled_host_pid) + " from the pool");
+    } else {
+        host = launch_host(host_path,
+                           plugin_type_to_string(host_request.plugin_type),
+#ifdef WITH_WINEDBG
+                           "\"" + plugin_info.windows_plugin_path + "\"",
+#else
+                           host_request.plugin_path,
+#endif
+                           host_request.endpoint_base_dir,
+                           std::to_string(getpid()),
+                           bp::env = host_env);
+    }
+
+    // The idle host processes shut down on their own if this process exits
+    // before anyone has used them, so they don't linger around after the host
+    // has been closed. Their output will end up in this plugin's log, just like
+    // with group host processes, even when another plugin ends up claiming
+    // them. Once this plugin instance has been unloaded that output is lost.
+    // We hold on to the slot's lock until we've stored the new process's PID,
+    // so other plugins checking the same slot at the same time will see that
+    // it's now owned. `PluginBridge::launch_host()` never uses the pool when
+    // the `disable_pipes` option is enabled, so these processes always have
+    // their output piped to us.
+    for (const auto& pool_socket_path : slots_to_fill) {
+        try {
+            PoolSlotLock slot_lock(pool_socket_path);
+            if (slot_lock.is_owned()) {
+                continue;
+            }
+
+            bp::child pool_host =
+                launch_host(host_path, "--pool", pool_socket_path,
+                            std::to_string(getpid()), bp::env = host_env);
+            slot_lock.set_owner(pool_host.id());
+            pool_host.detach();
+        } catch (const std::system_error& error) {
+            logger.log("Could not fill the host pool's slot at '" +
+                       pool_socket_path.string() + "': " + error.what());
+        }
+    }
+}
+
+fs::path PooledHost::path() {
+    return host_path;
+}
+
+bool PooledHost::running() {
+    if (pooled_host_pid) {
+        return pid_running(*pooled_host_pid);
+    } else {
+        return pid_running(host->id());
+    }
+}
+
+void PooledHost::terminate() {
+    // See `IndividualHost::terminate()`
+    sockets.close();
+
+    if (pooled_host_pid) {
+        kill(*pooled_host_pid, SIGKILL);
+    } else {
+        host->terminate();
+        host->wait();
+    }
+}
+
 GroupHost::GroupHost(boost::asio::io_context& io_context,
                      Logger& logger,
                      const Configuration& config,
@@ -163,24 +365,15 @@ GroupHost::GroupHost(boost::asio::io_context& io_context,
 
         const pid_t group_host_pid = group_host.id();
         group_host_connect_handler =
-            std::jthread([this, connect, group_host_pid]() {
+            std::jthread([this, connect, group_socket_path,
+                          group_host_pid]() {
                 set_realtime_priority(true);
                 pthread_setname_np(pthread_self(), "group-connect");
 
-                using namespace std::literals::chrono_literals;
-
                 // We'll first try to connect to the group host we just spawned
-                // TODO: Replace this polling with inotify
-                while (pid_running(group_host_pid)) {
-                    std::this_thread::sleep_for(20ms);
-
-                    try {
-                        connect();
-                        return;
-                    } catch (const boost::system::system_error&) {
-                        // Keep trying to connect until either connection gets
-                        // accepted or the group host crashes
-                    }
+                if (wait_for_group_host(group_socket_path, group_host_pid,
+                                        connect)) {
+                    return;
                 }
 
                 // When the group host exits before we can connect to it this
@@ -212,6 +212,77 @@ class IndividualHost : public HostProcess {
     boost::process::child host;
 };
 
+/**
+ * Take an idle host process from the pool of pre-spawned Wine plugin host
+ * processes for the plugin's Wine prefix and architecture, and top up the pool
+ * again in the background. This is used with the `host_pool_size` option. The
+ * idle processes are regular `yabridge-host.exe` processes started with the
+ * `--pool` flag. Those processes go through Wine's startup sequence and then
+ * listen on one of the pool's slot sockets (see `generate_pool_endpoint()`)
+ * for a single `HostRequest`, the same message a group host process accepts.
+ * After that they behave exactly like an individually hosted plugin. If there
+ * are no idle processes available, then we'll launch a new host process just
+ * like `IndividualHost` would.
+ *
+ * The pool processes are detached since they can outlive the plugin instance
+ * that spawned them, and they will shut down on their own if that plugin
+ * instance's process exits before they get used. Just like with group host
+ * processes, when two plugins try to fill the same slot at the same time the
+ * last process to start will exit after it fails to listen on the socket.
+ */
+class PooledHost : public HostProcess {
+   public:
+    /**
+     * Claim an idle host process from the pool, or launch a new one if there
+     * are none, and then start new idle host processes for all empty slots we
+     * came across.
+     *
+     * @param io_context The IO context that the STDIO redurection will be
+     *   handled on.
+     * @param logger The `Logger` instance the redirected STDIO streams will be
+     *   written to.
+     * @param config The configuration for this plugin instance. The pool size
+     *   will be retrieved from here.
+     * @param sockets The socket endpoints that will be used for communication
+     *   with the plugin. When the plugin shuts down, we'll close all of the
+     *   sockets used by the plugin.
+     * @param plugin_info Information about the plugin we're going to use. Used
+     *   to retrieve the Wine prefix and the plugin's architecture.
+     * @param host_request The information about the plugin we should launch a
+     *   host process for. This object will be sent to the idle host process.
+     *
+     * @throw std::runtime_error When `plugin_path` does not point to a valid
+     *   32-bit or 64-bit .dll file.
+     */
+    PooledHost(boost::asio::io_context& io_context,
+               Logger& logger,
+               const Configuration& config,
+               Sockets& sockets,
+               const PluginInfo& plugin_info,
+               const HostRequest& host_request);
+
+    boost::filesystem::path path() override;
+    bool running() override;
+    void terminate() override;
+
+   private:
+    const PluginInfo& plugin_info;
+    boost::filesystem::path host_path;
+
+    /**
+     * The process ID of the idle host process we took from the pool. This is
+     * not a child of this process, so we can only check whether it's still
+     * running and kill it using its PID. Only set if we could claim an idle
+     * host process.
+     */
+    std::optional<pid_t> pooled_host_pid;
+    /**
+     * The host process we launched ourselves because there were no idle host
+     * processes available in the pool. Only set if `pooled_host_pid` is not.
+     */
+    std::optional<boost::process::child> host;
+};
+
 /**
  * Either launch a new group host process, or connect to an existing one. This
  * will first try to connect to the plugin group's socket (determined based on
@@ -280,10 +351,9 @@ class GroupHost : public HostProcess {
      * A thread that waits for the group host to have started and then ask it to
      * host our plugin. This is used to defer the request since it may take a
      * little while until the group host process is up and running. This way we
-     * don't have to delay the rest of the initialization process.
-     *
-     * TODO: Replace the polling with inotify to prevent delays and to reduce
-     *       wasting resources
+     * don't have to delay the rest of the initialization process. This uses
+     * inotify to connect as soon as the group host process starts listening on
+     * its socket.
      */
     std::jthread group_host_connect_handler;
 };
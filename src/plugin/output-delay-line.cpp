@@ -0,0 +1,58 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "output-delay-line.h"
+
+void OutputDelayLine::reset(const AudioShmBuffer& buffers,
+                            uint32_t delay_samples) {
+    this->delay_samples = delay_samples;
+    read_position = 0;
+    num_stored = delay_samples;
+
+    // We need room for the silence we start out with, plus one more block of
+    // at most `delay_samples` samples
+    const size_t capacity = std::max<size_t>(delay_samples * 2, 1);
+    channels.resize(buffers.config.output_offsets.size());
+    for (size_t bus = 0; bus < channels.size(); bus++) {
+        channels[bus].resize(buffers.num_output_channels(bus));
+        for (auto& fifo : channels[bus]) {
+            fifo.assign(capacity, 0.0);
+        }
+    }
+}
+
+void OutputDelayLine::reserve(uint32_t num_samples) {
+    const size_t old_capacity = capacity();
+    if (num_stored + num_samples <= old_capacity) {
+        return;
+    }
+
+    // We'll unwrap the ring buffers while growing them so the read position
+    // can start at zero again
+    const size_t new_capacity = num_stored + num_samples;
+    for (auto& bus : channels) {
+        for (auto& fifo : bus) {
+            std::vector<double> grown(new_capacity, 0.0);
+            for (size_t i = 0; i < num_stored; i++) {
+                grown[i] = fifo[(read_position + i) % old_capacity];
+            }
+
+            fifo = std::move(grown);
+        }
+    }
+
+    read_position = 0;
+}
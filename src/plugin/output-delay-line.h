@@ -0,0 +1,164 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "../common/audio-shm.h"
+
+/**
+ * A FIFO for a plugin's output audio, used for the `audio_pipelining` option.
+ * With that option enabled the native plugin returns to the host before the
+ * Wine plugin host has finished processing the current block, and the results
+ * only get picked up during the next processing cycle. To keep the added
+ * latency constant regardless of the block sizes the host uses, those results
+ * are written to this FIFO, and the host is then given the samples from
+ * exactly `delay()` samples ago.
+ *
+ * The FIFO starts out containing `delay()` samples of silence. As long as the
+ * host never processes more than `delay()` samples at a time (which should be
+ * set to the maximum block size), the previous block's output will always have
+ * been written to the FIFO before the host needs it. Samples are always stored
+ * as doubles so the host can switch between single and double precision
+ * processing without us having to reallocate anything.
+ *
+ * All channels move in lockstep. Writing and reading is done one channel at a
+ * time followed by a call to `commit_write()` or `commit_read()`.
+ */
+class OutputDelayLine {
+   public:
+    /**
+     * Set up the FIFO for the output channels in `buffers` and fill it with
+     * `delay_samples` samples of silence. This allocates, so it should not be
+     * called from the audio thread.
+     */
+    void reset(const AudioShmBuffer& buffers, uint32_t delay_samples);
+
+    /**
+     * The latency in samples this FIFO adds to the plugin's output.
+     */
+    inline uint32_t delay() const noexcept { return delay_samples; }
+
+    /**
+     * The number of samples currently stored in the FIFO. Output events for a
+     * block written to the FIFO need to be delayed by this many samples to stay
+     * in sync with that block's audio.
+     */
+    inline uint32_t stored_samples() const noexcept {
+        return static_cast<uint32_t>(num_stored);
+    }
+
+    /**
+     * Make sure `num_samples` more samples can be written to the FIFO. This
+     * only reallocates when the host processes a larger block than it promised
+     * to, which should never happen.
+     */
+    void reserve(uint32_t num_samples);
+
+    /**
+     * Append `num_samples` samples to an output channel. This does not advance
+     * the write position until `commit_write()` gets called.
+     */
+    template <typename T>
+    void write(uint32_t bus,
+               uint32_t channel,
+               const T* samples,
+               uint32_t num_samples) noexcept {
+        std::vector<double>& fifo = channels[bus][channel];
+        const size_t capacity = fifo.size();
+        size_t position = (read_position + num_stored) % capacity;
+        for (uint32_t i = 0; i < num_samples; i++) {
+            fifo[position] = samples[i];
+            if (++position == capacity) {
+                position = 0;
+            }
+        }
+    }
+
+    /**
+     * Read the oldest `num_samples` samples from an output channel. This does
+     * not advance the read position until `commit_read()` gets called. If
+     * `accumulate` is set, then the samples will be added to `samples` instead
+     * of replacing them, for the old accumulating VST2 `process()` function.
+     */
+    template <typename T, bool accumulate = false>
+    void read(uint32_t bus,
+              uint32_t channel,
+              T* samples,
+              uint32_t num_samples) const noexcept {
+        const std::vector<double>& fifo = channels[bus][channel];
+        const size_t capacity = fifo.size();
+        size_t position = read_position;
+        for (uint32_t i = 0; i < num_samples; i++) {
+            if constexpr (accumulate) {
+                samples[i] += static_cast<T>(fifo[position]);
+            } else {
+                samples[i] = static_cast<T>(fifo[position]);
+            }
+            if (++position == capacity) {
+                position = 0;
+            }
+        }
+    }
+
+    /**
+     * Advance the write position after writing `num_samples` samples to every
+     * channel.
+     */
+    inline void commit_write(uint32_t num_samples) noexcept {
+        num_stored += num_samples;
+    }
+
+    /**
+     * Advance the read position after reading `num_samples` samples from every
+     * channel.
+     */
+    inline void commit_read(uint32_t num_samples) noexcept {
+        read_position = (read_position + num_samples) % capacity();
+        num_stored -= num_samples;
+    }
+
+    /**
+     * The number of output busses and channels in this FIFO.
+     */
+    inline size_t num_busses() const noexcept { return channels.size(); }
+    inline size_t num_channels(uint32_t bus) const noexcept {
+        return channels[bus].size();
+    }
+
+   private:
+    inline size_t capacity() const noexcept {
+        for (const auto& bus : channels) {
+            if (!bus.empty()) {
+                return bus.front().size();
+            }
+        }
+
+        return 1;
+    }
+
+    /**
+     * The samples for each output channel, indexed by `[bus][channel]`. These
+     * are ring buffers that all have the same size.
+     */
+    std::vector<std::vector<std::vector<double>>> channels;
+
+    uint32_t delay_samples = 0;
+    size_t read_position = 0;
+    size_t num_stored = 0;
+};
@@ -0,0 +1,195 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "parameter-string-cache.h"
+
+/**
+ * Get an entry from one of the vectors in `Vst2ParameterStrings`, if it
+ * exists.
+ */
+static std::optional<Vst2ParameterStrings::Entry> find_entry(
+    const std::vector<Vst2ParameterStrings::Entry>& entries,
+    int index) {
+    if (index < 0 || static_cast<size_t>(index) >= entries.size()) {
+        return std::nullopt;
+    }
+
+    return entries[index];
+}
+
+bool ParameterStringCache::is_cached_opcode(int opcode) noexcept {
+    switch (opcode) {
+        case effGetParamName:
+        case effGetParamLabel:
+        case effGetParamDisplay:
+        case effGetProgramNameIndexed:
+            return true;
+            break;
+        default:
+            return false;
+            break;
+    }
+}
+
+ParameterStringCache::Generations ParameterStringCache::generations()
+    const noexcept {
+    Generations generations{
+        .strings = strings_generation.load(std::memory_order_acquire),
+        .values = values_generation.load(std::memory_order_acquire),
+        .value_slots = {}};
+    for (size_t i = 0; i < value_generation_slots; i++) {
+        generations.value_slots[i] =
+            value_generations[i].load(std::memory_order_acquire);
+    }
+
+    return generations;
+}
+
+ParameterStringCache::Refresh ParameterStringCache::refresh_needed(int opcode,
+                                                                   int index) {
+    std::lock_guard lock(mutex);
+
+    if (cached_strings_generation !=
+        strings_generation.load(std::memory_order_acquire)) {
+        return Refresh::all;
+    }
+    if (opcode != effGetParamLabel && opcode != effGetParamDisplay) {
+        return Refresh::none;
+    }
+    if (!values_valid()) {
+        return Refresh::values;
+    }
+    if (index >= 0 &&
+        static_cast<size_t>(index) < cached_value_generations.size() &&
+        !value_valid(index)) {
+        return Refresh::stale_values;
+    }
+
+    return Refresh::none;
+}
+
+std::vector<int32_t> ParameterStringCache::stale_parameters() {
+    std::lock_guard lock(mutex);
+
+    std::vector<int32_t> parameters{};
+    for (size_t i = 0; i < cached_value_generations.size(); i++) {
+        if (!value_valid(static_cast<int>(i))) {
+            parameters.push_back(static_cast<int32_t>(i));
+        }
+    }
+
+    return parameters;
+}
+
+std::optional<Vst2ParameterStrings::Entry> ParameterStringCache::get(
+    int opcode,
+    int index) {
+    std::lock_guard lock(mutex);
+
+    if (cached_strings_generation !=
+        strings_generation.load(std::memory_order_acquire)) {
+        return std::nullopt;
+    }
+
+    switch (opcode) {
+        case effGetParamName:
+            return find_entry(strings.names, index);
+            break;
+        case effGetParamLabel:
+            if (!values_valid() || !value_valid(index)) {
+                return std::nullopt;
+            }
+
+            return find_entry(strings.labels, index);
+            break;
+        case effGetParamDisplay:
+            if (!values_valid() || !value_valid(index)) {
+                return std::nullopt;
+            }
+
+            return find_entry(strings.displays, index);
+            break;
+        case effGetProgramNameIndexed:
+            return find_entry(strings.program_names, index);
+            break;
+        default:
+            return std::nullopt;
+            break;
+    }
+}
+
+void ParameterStringCache::store(const Generations& fetched,
+                                 Vst2ParameterStrings new_strings,
+                                 bool values_only) {
+    std::lock_guard lock(mutex);
+
+    // When only the value strings were fetched the names stay as they are. If
+    // those were invalidated in the meantime, then the next query will simply
+    // refetch everything.
+    if (values_only) {
+        strings.labels = std::move(new_strings.labels);
+        strings.displays = std::move(new_strings.displays);
+    } else {
+        strings = std::move(new_strings);
+        cached_strings_generation = fetched.strings;
+    }
+
+    cached_values_generation = fetched.values;
+    cached_value_generations.resize(strings.displays.size());
+    for (size_t i = 0; i < cached_value_generations.size(); i++) {
+        cached_value_generations[i] =
+            fetched.value_slots[i % value_generation_slots];
+    }
+}
+
+void ParameterStringCache::store_values(const Generations& fetched,
+                                        const std::vector<int32_t>& parameters,
+                                        Vst2ParameterStrings new_strings) {
+    std::lock_guard lock(mutex);
+
+    // If all strings or all value strings were invalidated while these strings
+    // were being fetched, then the next query will refetch them anyway
+    if (cached_strings_generation != fetched.strings ||
+        cached_values_generation != fetched.values ||
+        new_strings.labels.size() != parameters.size() ||
+        new_strings.displays.size() != parameters.size()) {
+        return;
+    }
+
+    for (size_t i = 0; i < parameters.size(); i++) {
+        const int32_t index = parameters[i];
+        if (index < 0 ||
+            static_cast<size_t>(index) >= cached_value_generations.size()) {
+            continue;
+        }
+
+        strings.labels[index] = std::move(new_strings.labels[i]);
+        strings.displays[index] = std::move(new_strings.displays[i]);
+        cached_value_generations[index] = fetched.value_slots[slot(index)];
+    }
+}
+
+bool ParameterStringCache::values_valid() const noexcept {
+    return cached_values_generation ==
+           values_generation.load(std::memory_order_acquire);
+}
+
+bool ParameterStringCache::value_valid(int index) const noexcept {
+    return index >= 0 &&
+           static_cast<size_t>(index) < cached_value_generations.size() &&
+           cached_value_generations[index] ==
+               value_generations[slot(index)].load(std::memory_order_acquire);
+}
@@ -0,0 +1,218 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "../common/serialization/vst2.h"
+
+/**
+ * Caches the strings a VST2 plugin returns for `effGetParamName`,
+ * `effGetParamLabel`, `effGetParamDisplay` and `effGetProgramNameIndexed`.
+ * Hosts query these constantly while drawing mixer strips, automation lanes
+ * and parameter menus, and without a cache every single string costs a round
+ * trip to the Wine plugin host. When the `vst2_cache_strings` option is
+ * enabled, `Vst2PluginBridge` fills this cache using a single
+ * `effYabridgeGetParameterStrings` request and then answers these queries
+ * directly.
+ *
+ * A parameter's display string and its label both depend on the parameter's
+ * value (a plugin may switch between `Hz` and `kHz`, for instance), so we'll
+ * refer to those two together as the parameter's value strings. A parameter
+ * change only invalidates the value strings for that parameter. The next query
+ * for an out of date value string then refetches the value strings for all
+ * parameters that have changed in the meantime in a single batch, so
+ * automating many parameters at once doesn't result in a round trip per
+ * parameter. Just like with `StateCache`, invalidation only bumps generation
+ * counters so it can safely be done from the audio thread, and strings that
+ * were fetched while the cache was being invalidated will never be marked as
+ * valid.
+ */
+class ParameterStringCache {
+   public:
+    /**
+     * The number of per-parameter generation counters. Parameters share a
+     * counter when their indices are the same modulo this number, which at
+     * worst causes a few unnecessary refetches for plugins with more
+     * parameters than this.
+     */
+    static constexpr size_t value_generation_slots = 1024;
+
+    /**
+     * What needs to be fetched from the Wine plugin host before a query can be
+     * answered from the cache.
+     */
+    enum class Refresh {
+        /**
+         * Nothing, the query can be answered from the cache.
+         */
+        none,
+        /**
+         * The value strings for some parameters are out of date. The indices
+         * of those parameters can be found using `stale_parameters()`, and
+         * their value strings should then be stored using `store_values()`.
+         */
+        stale_values,
+        /**
+         * The value strings for all parameters are out of date, but the
+         * parameter and program names are still valid.
+         */
+        values,
+        /**
+         * Everything is out of date.
+         */
+        all,
+    };
+
+    /**
+     * The values of the generation counters at the time a batch of strings
+     * was requested.
+     *
+     * @see generations
+     */
+    struct Generations {
+        uint64_t strings;
+        uint64_t values;
+        std::array<uint32_t, value_generation_slots> value_slots;
+    };
+
+    /**
+     * Whether `opcode` is one of the opcodes that can be answered from this
+     * cache.
+     */
+    static bool is_cached_opcode(int opcode) noexcept;
+
+    /**
+     * Mark all cached strings as stale. This should be called when the plugin
+     * tells the host that its parameters have changed, or when the host loads
+     * a new program or state.
+     */
+    inline void invalidate() noexcept {
+        strings_generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    /**
+     * Mark the display strings and labels for all parameters as stale while
+     * keeping the parameter and program names. This should be called when the
+     * host switches to another program.
+     */
+    inline void invalidate_values() noexcept {
+        values_generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    /**
+     * Mark the display string and the label for a single parameter as stale.
+     * This is safe to call from the audio thread.
+     */
+    inline void invalidate_value(int index) noexcept {
+        value_generations[slot(index)].fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    /**
+     * The current generation counters. This should be read right before
+     * fetching new strings, and then passed to `store()` or `store_values()`
+     * afterwards.
+     */
+    Generations generations() const noexcept;
+
+    /**
+     * Determine what needs to be fetched before a query can be answered from
+     * the cache.
+     */
+    Refresh refresh_needed(int opcode, int index);
+
+    /**
+     * The indices of all parameters with out of date value strings. This
+     * should be called after `refresh_needed()` returned
+     * `Refresh::stale_values`.
+     */
+    std::vector<int32_t> stale_parameters();
+
+    /**
+     * Look up the cached string and the plugin's return value for a query.
+     * Returns an `std::nullopt` if the string is not cached or if it's out of
+     * date.
+     */
+    std::optional<Vst2ParameterStrings::Entry> get(int opcode, int index);
+
+    /**
+     * Store the strings for all parameters fetched through an
+     * `effYabridgeGetParameterStrings` request.
+     *
+     * @param fetched The value of `generations()` from before the strings were
+     *   requested.
+     * @param new_strings The strings returned by the Wine plugin host.
+     * @param values_only Whether only the display strings and labels were
+     *   requested.
+     */
+    void store(const Generations& fetched,
+               Vst2ParameterStrings new_strings,
+               bool values_only);
+
+    /**
+     * Store the value strings for the parameters returned by
+     * `stale_parameters()`, fetched through an `effYabridgeGetParameterStrings`
+     * request.
+     *
+     * @param fetched The value of `generations()` from before
+     *   `stale_parameters()` was called.
+     * @param parameters The parameters the value strings were requested for.
+     *   `new_strings.labels` and `new_strings.displays` contain the strings
+     *   for these parameters in the same order.
+     */
+    void store_values(const Generations& fetched,
+                      const std::vector<int32_t>& parameters,
+                      Vst2ParameterStrings new_strings);
+
+   private:
+    static inline size_t slot(int index) noexcept {
+        return static_cast<size_t>(static_cast<uint32_t>(index)) %
+               value_generation_slots;
+    }
+
+    /**
+     * Whether the cached value strings are up to date, not counting the
+     * per-parameter generations. `mutex` should be locked when calling this.
+     */
+    bool values_valid() const noexcept;
+
+    /**
+     * Whether the cached value strings for a single parameter are up to date.
+     * `mutex` should be locked when calling this.
+     */
+    bool value_valid(int index) const noexcept;
+
+    std::atomic_uint64_t strings_generation = 1;
+    std::atomic_uint64_t values_generation = 1;
+    std::array<std::atomic_uint32_t, value_generation_slots>
+        value_generations{};
+
+    std::mutex mutex;
+    Vst2ParameterStrings strings;
+    uint64_t cached_strings_generation = 0;
+    uint64_t cached_values_generation = 0;
+    /**
+     * The per-parameter generation for every entry in `strings.labels` and
+     * `strings.displays`.
+     */
+    std::vector<uint32_t> cached_value_generations;
+};
@@ -0,0 +1,98 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "process-stats.h"
+
+#include <algorithm>
+#include <bit>
+#include <iomanip>
+
+/**
+ * Increment a counter that's only ever written to from a single thread. This
+ * avoids the locked read-modify-write instruction `fetch_add()` would use.
+ */
+static void add_relaxed(std::atomic_uint64_t& counter,
+                        uint64_t value) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + value,
+                  std::memory_order_relaxed);
+}
+
+void ProcessStats::record(std::chrono::nanoseconds round_trip_time,
+                          std::chrono::nanoseconds processing_time,
+                          std::chrono::nanoseconds deadline) noexcept {
+    const uint64_t round_trip_ns =
+        static_cast<uint64_t>(std::max<int64_t>(round_trip_time.count(), 0));
+
+    add_relaxed(num_cycles, 1);
+    add_relaxed(total_round_trip_ns, round_trip_ns);
+    add_relaxed(total_processing_ns, static_cast<uint64_t>(std::max<int64_t>(
+                                         processing_time.count(), 0)));
+    if (round_trip_ns > max_round_trip_ns.load(std::memory_order_relaxed)) {
+        max_round_trip_ns.store(round_trip_ns, std::memory_order_relaxed);
+    }
+    if (deadline.count() > 0 && round_trip_time > deadline) {
+        add_relaxed(num_missed_deadlines, 1);
+    }
+
+    const size_t bucket =
+        std::min<size_t>(std::bit_width(round_trip_ns / 1000),
+                         num_histogram_buckets - 1);
+    add_relaxed(round_trip_histogram[bucket], 1);
+}
+
+void ProcessStats::print(std::ostream& stream, const char* indent) const {
+    const uint64_t cycles = num_cycles.load(std::memory_order_relaxed);
+    const double mean_round_trip_us =
+        cycles > 0 ? total_round_trip_ns.load(std::memory_order_relaxed) /
+                         1000.0 / cycles
+                   : 0.0;
+    const double mean_processing_us =
+        cycles > 0 ? total_processing_ns.load(std::memory_order_relaxed) /
+                         1000.0 / cycles
+                   : 0.0;
+
+    stream << std::fixed << std::setprecision(1);
+    stream << indent << "cycles: " << cycles << std::endl;
+    stream << indent << "mean_round_trip_us: " << mean_round_trip_us
+           << std::endl;
+    stream << indent << "max_round_trip_us: "
+           << max_round_trip_ns.load(std::memory_order_relaxed) / 1000.0
+           << std::endl;
+    stream << indent << "mean_processing_us: " << mean_processing_us
+           << std::endl;
+    stream << indent << "mean_overhead_us: "
+           << mean_round_trip_us - mean_processing_us << std::endl;
+    stream << indent << "missed_deadlines: "
+           << num_missed_deadlines.load(std::memory_order_relaxed)
+           << std::endl;
+
+    stream << indent << "round_trip_histogram_us:" << std::endl;
+    for (size_t bucket = 0; bucket < num_histogram_buckets; bucket++) {
+        stream << indent << "  ";
+        if (bucket == 0) {
+            stream << "<1";
+        } else if (bucket == num_histogram_buckets - 1) {
+            stream << ">=" << (1 << (bucket - 1));
+        } else if (bucket == 1) {
+            stream << "1";
+        } else {
+            stream << (1 << (bucket - 1)) << "-" << (1 << bucket) - 1;
+        }
+        stream << ": "
+               << round_trip_histogram[bucket].load(std::memory_order_relaxed)
+               << std::endl;
+    }
+}
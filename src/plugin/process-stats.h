@@ -0,0 +1,78 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+/**
+ * Performance counters for a single plugin instance's audio processing. These
+ * are updated by the audio thread after every processing cycle, and they can
+ * be read at any time from other threads through `StatsServer`. The counters
+ * are plain relaxed atomics so recording a processing cycle only costs a
+ * handful of loads and stores. Because of that the values read from another
+ * thread may be slightly out of sync with each other, which is fine for
+ * statistics.
+ *
+ * The round trip time is the time the host's audio thread spent inside of our
+ * processing function, and the processing time is the time the Windows plugin
+ * spent processing audio on the Wine side. The difference between the two is
+ * yabridge's own overhead.
+ */
+class ProcessStats {
+   public:
+    /**
+     * The round trip times are stored in a histogram with power of two
+     * buckets, measured in microseconds. Bucket `i` contains the cycles that
+     * took `[2^(i - 1), 2^i)` microseconds, with the first bucket containing
+     * the cycles that took less than a microsecond and the last bucket
+     * containing everything that took longer than that.
+     */
+    static constexpr size_t num_histogram_buckets = 16;
+
+    /**
+     * Record a single processing cycle. This should only ever be called from
+     * one thread at a time.
+     *
+     * @param round_trip_time The time the host spent waiting on us.
+     * @param processing_time The time the Windows plugin spent processing
+     *   audio, as reported by the Wine plugin host.
+     * @param deadline The duration of the processed block. Cycles that take
+     *   longer than this would cause an xrun. This can be zero if the sample
+     *   rate is not known, in which case these won't be counted.
+     */
+    void record(std::chrono::nanoseconds round_trip_time,
+                std::chrono::nanoseconds processing_time,
+                std::chrono::nanoseconds deadline) noexcept;
+
+    /**
+     * Write a human readable overview of these counters to `stream`, one
+     * `key: value` pair per line, with every line prefixed by `indent`.
+     */
+    void print(std::ostream& stream, const char* indent = "") const;
+
+   private:
+    std::atomic_uint64_t num_cycles = 0;
+    std::atomic_uint64_t total_round_trip_ns = 0;
+    std::atomic_uint64_t max_round_trip_ns = 0;
+    std::atomic_uint64_t total_processing_ns = 0;
+    std::atomic_uint64_t num_missed_deadlines = 0;
+    std::array<std::atomic_uint64_t, num_histogram_buckets>
+        round_trip_histogram{};
+};
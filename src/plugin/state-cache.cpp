@@ -0,0 +1,38 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "state-cache.h"
+
+void StateCache::store(uint64_t fetched_generation, int key) noexcept {
+    if (editor_open.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    cached_key.store(key, std::memory_order_relaxed);
+    cached_generation.store(fetched_generation, std::memory_order_release);
+}
+
+bool StateCache::contains(int key) const noexcept {
+    return !editor_open.load(std::memory_order_acquire) &&
+           cached_generation.load(std::memory_order_acquire) ==
+               current_generation.load(std::memory_order_acquire) &&
+           cached_key.load(std::memory_order_relaxed) == key;
+}
+
+void StateCache::set_editor_open(bool is_open) noexcept {
+    editor_open.store(is_open, std::memory_order_release);
+    invalidate();
+}
@@ -0,0 +1,90 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Keeps track of whether a plugin's state may have changed since we last
+ * fetched it. Hosts like REAPER and Bitwig will request the state of every
+ * plugin whenever they create an undo point or autosave the project, and for
+ * large projects that means hundreds of full state transfers between the
+ * native plugin and the Wine plugin host every few minutes even when nothing
+ * has changed. When the `cache_state` option is enabled, the plugin bridges
+ * will keep their copy of the last fetched state around and serve repeat
+ * requests from it as long as this cache hasn't been invalidated.
+ *
+ * This only tracks the validity of the cache. The data itself is stored by
+ * the bridges, since they need to keep a copy of the state around anyways.
+ *
+ * The cache is invalidated by bumping a generation counter, which is safe to do
+ * from any thread including the audio thread. A state that was fetched while
+ * the cache was being invalidated will not be marked as valid since the
+ * generation will have changed in the meantime. While the plugin's editor is
+ * open the cache is never valid since the user could be changing the plugin's
+ * state in ways that don't involve any parameter changes.
+ */
+class StateCache {
+   public:
+    /**
+     * Mark the cached state as stale. This should be called whenever the
+     * plugin's state may have changed, e.g. when a parameter changes, when the
+     * host loads a new state or program, or when the plugin tells the host that
+     * something has changed.
+     */
+    inline void invalidate() noexcept {
+        current_generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    /**
+     * The current generation. This should be read right before fetching a new
+     * state, and then passed to `store()` afterwards.
+     */
+    inline uint64_t generation() const noexcept {
+        return current_generation.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Mark the state stored by the bridge under `key` as valid, as long as the
+     * cache has not been invalidated since `fetched_generation` was read.
+     *
+     * @param fetched_generation The value of `generation()` from before the
+     *   state was fetched.
+     * @param key Identifies the kind of state that was fetched, like the index
+     *   for `effGetChunk()`. Only a single key is cached at a time.
+     */
+    void store(uint64_t fetched_generation, int key) noexcept;
+
+    /**
+     * Whether the state stored by the bridge under `key` is still valid.
+     */
+    bool contains(int key) const noexcept;
+
+    /**
+     * Whether the plugin's editor is currently open. The cache is never valid
+     * while the editor is open, and the cache gets invalidated again when the
+     * editor is closed.
+     */
+    void set_editor_open(bool is_open) noexcept;
+
+   private:
+    std::atomic_uint64_t current_generation = 1;
+    std::atomic_uint64_t cached_generation = 0;
+    std::atomic_int cached_key = 0;
+    std::atomic_bool editor_open = false;
+};
@@ -0,0 +1,55 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "stats-server.h"
+
+#include <memory>
+
+#include <boost/asio/write.hpp>
+
+StatsServer::StatsServer(boost::asio::io_context& io_context,
+                         const boost::filesystem::path& endpoint,
+                         std::function<std::string()> generate_report)
+    : acceptor(
+          io_context,
+          boost::asio::local::stream_protocol::endpoint(endpoint.string())),
+      generate_report(std::move(generate_report)) {
+    accept_connection();
+}
+
+void StatsServer::accept_connection() {
+    acceptor.async_accept(
+        [&](const boost::system::error_code& error,
+            boost::asio::local::stream_protocol::socket socket) {
+            // This happens when the acceptor gets closed
+            if (error) {
+                return;
+            }
+
+            // The socket and the report need to stay alive until the write has
+            // finished, after which the connection gets closed
+            auto connection =
+                std::make_shared<boost::asio::local::stream_protocol::socket>(
+                    std::move(socket));
+            auto report = std::make_shared<std::string>(generate_report());
+            boost::asio::async_write(
+                *connection, boost::asio::buffer(*report),
+                [connection, report](const boost::system::error_code&,
+                                     size_t) {});
+
+            accept_connection();
+        });
+}
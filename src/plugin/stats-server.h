@@ -0,0 +1,68 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/filesystem.hpp>
+
+/**
+ * The name of the stats socket endpoint within a plugin's socket base
+ * directory.
+ */
+constexpr char stats_endpoint_name[] = "stats.sock";
+
+/**
+ * A Unix domain socket that writes a plain text report with a plugin's
+ * processing statistics to anyone who connects to it, and then closes the
+ * connection. This lets you inspect a running plugin using something like
+ * `socat - UNIX-CONNECT:<endpoint>`. The socket lives in the plugin's socket
+ * base directory, so it gets cleaned up together with the other sockets.
+ *
+ * Connections are handled asynchronously on the IO context passed to the
+ * constructor, so this doesn't need its own thread.
+ */
+class StatsServer {
+   public:
+    /**
+     * Start listening on `endpoint`.
+     *
+     * @param io_context The IO context to handle connections on. This should
+     *   already be running on some thread.
+     * @param endpoint The path to the socket endpoint.
+     * @param generate_report A function that returns the report sent to every
+     *   connection. This is called on the IO context's thread.
+     *
+     * @throw boost::system::system_error If the endpoint could not be created.
+     */
+    StatsServer(boost::asio::io_context& io_context,
+                const boost::filesystem::path& endpoint,
+                std::function<std::string()> generate_report);
+
+   private:
+    /**
+     * Wait for the next connection, send it the report, and then wait for the
+     * connection after that.
+     */
+    void accept_connection();
+
+    boost::asio::local::stream_protocol::acceptor acceptor;
+    std::function<std::string()> generate_report;
+};
@@ -16,6 +16,7 @@
 
 #include "utils.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include <unistd.h>
@@ -46,8 +47,6 @@ namespace fs = boost::filesystem;
 fs::path find_plugin_library(const fs::path& this_plugin_path,
                              PluginType plugin_type,
                              bool prefer_32bit_vst3);
-fs::path normalize_plugin_path(const fs::path& windows_library_path,
-                               PluginType plugin_type);
 std::variant<OverridenWinePrefix, fs::path, DefaultWinePrefix> find_wine_prefix(
     fs::path windows_plugin_path);
 
@@ -228,32 +227,6 @@ fs::path find_plugin_library(const fs::path& this_plugin_path,
     }
 }
 
-fs::path normalize_plugin_path(const fs::path& windows_library_path,
-                               PluginType plugin_type) {
-    switch (plugin_type) {
-        case PluginType::vst2:
-            return windows_library_path;
-            break;
-        case PluginType::vst3: {
-            // Now we'll have to figure out if this is a new-style bundle or
-            // an old standalone module
-            const fs::path win_module_name =
-                windows_library_path.filename().replace_extension(".vst3");
-            const fs::path windows_bundle_home =
-                windows_library_path.parent_path().parent_path().parent_path();
-            if (equals_case_insensitive(windows_bundle_home.filename().string(),
-                                        win_module_name.string())) {
-                return windows_bundle_home;
-            } else {
-                return windows_library_path;
-            }
-        } break;
-        default:
-            throw std::runtime_error("How did you manage to get this?");
-            break;
-    }
-}
-
 std::variant<OverridenWinePrefix, fs::path, DefaultWinePrefix> find_wine_prefix(
     fs::path windows_plugin_path) {
     bp::environment env = boost::this_process::environment();
@@ -288,13 +261,6 @@ fs::path get_this_file_location() {
     return this_file;
 }
 
-bool equals_case_insensitive(const std::string& a, const std::string& b) {
-    return std::equal(a.begin(), a.end(), b.begin(),
-                      [](const char& a_char, const char& b_char) {
-                          return std::tolower(a_char) == std::tolower(b_char);
-                      });
-}
-
 std::string join_quoted_strings(std::vector<std::string>& strings) {
     bool is_first = true;
     std::ostringstream joined_strings{};
@@ -366,6 +332,47 @@ boost::filesystem::path generate_group_endpoint(
     return get_temporary_directory() / socket_name.str();
 }
 
+boost::filesystem::path generate_pool_endpoint(
+    const boost::filesystem::path& wine_prefix,
+    const boost::process::environment& host_env,
+    const LibArchitecture architecture,
+    uint32_t slot) {
+    // The environment is stored in whatever order it was defined in, so we'll
+    // sort the variables first to get a stable identifier
+    std::vector<std::string> wine_variables;
+    for (const auto& variable : host_env) {
+        if (variable.get_name().starts_with("WINE")) {
+            wine_variables.push_back(variable.get_name() + "=" +
+                                     variable.to_string());
+        }
+    }
+    std::sort(wine_variables.begin(), wine_variables.end());
+
+    std::string wine_environment;
+    for (const auto& variable : wine_variables) {
+        wine_environment += variable + '\0';
+    }
+
+    std::ostringstream socket_name;
+    socket_name << "yabridge-pool-"
+                << std::to_string(
+                       std::hash<std::string>{}(wine_prefix.string()))
+                << "-"
+                << std::to_string(std::hash<std::string>{}(wine_environment))
+                << "-";
+    switch (architecture) {
+        case LibArchitecture::dll_32:
+            socket_name << "x32";
+            break;
+        case LibArchitecture::dll_64:
+            socket_name << "x64";
+            break;
+    }
+    socket_name << "-" << slot << ".sock";
+
+    return get_temporary_directory() / socket_name.str();
+}
+
 std::vector<boost::filesystem::path> get_augmented_search_path() {
     // HACK: `std::locale("")` would return the current locale, but this
     //       overload is implementation specific, and libstdc++ returns an error
@@ -96,6 +96,17 @@ struct PluginInfo {
      */
     std::string wine_version() const;
 
+    /**
+     * The path to the actual Windows library. For VST3 plugins this may be a
+     * file inside of the bundle `windows_plugin_path` points to. This is used
+     * to detect when the plugin has been updated.
+     *
+     * @see windows_library_path
+     */
+    inline const boost::filesystem::path& library_path() const noexcept {
+        return windows_library_path;
+    }
+
     const PluginType plugin_type;
 
     /**
@@ -148,13 +159,6 @@ struct PluginInfo {
             wine_prefix;
 };
 
-/**
- * Returns equality for two strings when ignoring casing. Used for comparing
- * filenames inside of Wine prefixes since Windows/Wine does case folding for
- * filenames.
- */
-bool equals_case_insensitive(const std::string& a, const std::string& b);
-
 /**
  * Join a vector of strings with commas while wrapping the strings in quotes.
  * For example, `join_quoted_strings(std::vector<string>{"string", "another
@@ -225,6 +229,36 @@ boost::filesystem::path generate_group_endpoint(
     const boost::filesystem::path& wine_prefix,
     const LibArchitecture architecture);
 
+/**
+ * Generate the socket endpoint name for one of the slots in the pool of idle
+ * Wine plugin host processes used with the `host_pool_size` option. This
+ * follows the same scheme as `generate_group_endpoint()`, and the resulting
+ * socket will be called
+ * `yabridge-pool-<wine_prefix_id>-<env_id>-<architecture>-<slot>.sock`.
+ *
+ * Idle host processes are started before we know which plugin is going to use
+ * them, so a plugin should only be able to claim a host process that was
+ * started with the same environment it would have used itself. The
+ * `<env_id>` part is a hash of all `WINE*` environment variables in
+ * `host_env`, since those change how Wine behaves.
+ *
+ * @param wine_prefix The name of the Wine prefix in use. This should be
+ *   obtained from `PluginInfo::normalize_wine_prefix()`.
+ * @param host_env The environment the host process will be started with. This
+ *   should be obtained from `PluginInfo::create_host_env()`.
+ * @param architecture The architecture the plugin is using, since 64-bit
+ *   processes can't host 32-bit plugins and the other way around.
+ * @param slot The index of the slot within the pool, starting at zero.
+ *
+ * @return A socket endpoint path that corresponds to the format described
+ *   above.
+ */
+boost::filesystem::path generate_pool_endpoint(
+    const boost::filesystem::path& wine_prefix,
+    const boost::process::environment& host_env,
+    const LibArchitecture architecture,
+    uint32_t slot);
+
 /**
  * Return the search path as defined in `$PATH`, with `~/.local/share/yabridge`
  * appended to the end. Even though it likely won't be set, this does respect
@@ -0,0 +1,42 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "vst-event-ring.h"
+
+#include <algorithm>
+
+VstEventRing::VstEventRing() noexcept {}
+
+bool VstEventRing::push(const VstEvent& event, std::string_view sysex_data) {
+    std::lock_guard lock(producer_mutex);
+
+    const size_t write = write_index.load(std::memory_order_relaxed);
+    const size_t read = read_index.load(std::memory_order_acquire);
+    if (write - read >= capacity || sysex_data.size() > max_sysex_size) {
+        return false;
+    }
+
+    Slot& slot = slots[write % capacity];
+    slot.event = event;
+    if (slot.sysex_event.type == kVstSysExType) {
+        std::copy(sysex_data.begin(), sysex_data.end(),
+                  slot.sysex_data.begin());
+    }
+
+    write_index.store(write + 1, std::memory_order_release);
+
+    return true;
+}
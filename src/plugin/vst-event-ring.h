@@ -0,0 +1,141 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <mutex>
+#include <string_view>
+
+#include <vestige/aeffectx.h>
+
+/**
+ * A preallocated multi-producer, single-consumer queue for `VstEvent`s. Plugins are allowed to send MIDI events to the host from any
+ * thread, but the host will only accept them during the audio processing
+ * function. Events sent during audio processing are returned as part of the
+ * process response, but events sent from other threads will arrive on our host
+ * callback handler threads. Those are pushed to this queue, and they are then
+ * passed to the host at the end of the next processing cycle. The host callback
+ * handler can run on multiple threads at once, so producers are serialized
+ * using a mutex. The consumer side is lock-free, so the audio thread never has
+ * to lock a mutex or allocate memory for these events.
+ *
+ * Every event gets its own fixed size slot, including SysEx events. SysEx data
+ * larger than `max_sysex_size` bytes will be rejected.
+ */
+class VstEventRing {
+   public:
+    /**
+     * The maximum number of events that can be queued at once.
+     */
+    static constexpr size_t capacity = 256;
+
+    /**
+     * The maximum size of the payload for a single SysEx event.
+     */
+    static constexpr size_t max_sysex_size = 256;
+
+    VstEventRing() noexcept;
+
+    VstEventRing(const VstEventRing&) = delete;
+    VstEventRing& operator=(const VstEventRing&) = delete;
+
+    /**
+     * Add an event to the queue. This is safe to call from multiple threads at
+     * once, but it may block while another thread is pushing an event.
+     *
+     * @param event The event to add. For SysEx events `sysex_data` should
+     *   contain the event's payload, since the event's `sysexDump` pointer may
+     *   not be valid anymore.
+     * @param sysex_data The SysEx payload for the event, if it's a SysEx
+     *   event.
+     *
+     * @return `false` if the queue is full or if the SysEx data does not fit
+     *   in a slot, in which case the event is dropped.
+     */
+    bool push(const VstEvent& event,
+              std::string_view sysex_data = std::string_view());
+
+    /**
+     * Pass all queued events to `callback` as a single `VstEvents` object, and
+     * then remove them from the queue. The `VstEvents` object and the events it
+     * points to are only valid during the callback. Does nothing if the queue
+     * is empty. This should only be called from the consumer thread.
+     */
+    template <std::invocable<VstEvents&> F>
+    void consume(F&& callback) {
+        const size_t read = read_index.load(std::memory_order_relaxed);
+        const size_t write = write_index.load(std::memory_order_acquire);
+        if (read == write) {
+            return;
+        }
+
+        VstEvents& c_events = *reinterpret_cast<VstEvents*>(events_buffer);
+        int num_events = 0;
+        for (size_t index = read; index != write; index++) {
+            Slot& slot = slots[index % capacity];
+            if (slot.sysex_event.type == kVstSysExType) {
+                slot.sysex_event.sysexDump = slot.sysex_data.data();
+            }
+
+            c_events.events[num_events++] = &slot.event;
+        }
+        c_events.numEvents = num_events;
+
+        callback(c_events);
+
+        read_index.store(write, std::memory_order_release);
+    }
+
+   private:
+    /**
+     * A single event. `VstEvent` is only large enough to hold regular MIDI
+     * events, so we'll overlay it with `VstMidiSysExEvent` to also have room
+     * for the SysEx event's fields.
+     */
+    struct Slot {
+        union {
+            VstEvent event;
+            VstMidiSysExEvent sysex_event;
+        };
+        std::array<char, max_sysex_size> sysex_data;
+    };
+
+    std::array<Slot, capacity> slots;
+
+    /**
+     * The buffer we build the variable length `VstEvents` struct in. See
+     * `DynamicVstEvents::vst_events_buffer` for more information.
+     */
+    alignas(VstEvents) unsigned char events_buffer
+        [sizeof(VstEvents) +
+         ((capacity - 1) *
+          sizeof(VstEvent*))];  // NOLINT(bugprone-sizeof-expression)
+
+    // These indices only ever increase, and they're wrapped to `capacity` when
+    // accessing `slots`. The queue is empty when they're equal.
+
+    std::atomic_size_t read_index = 0;
+    std::atomic_size_t write_index = 0;
+
+    /**
+     * Serializes calls to `push()`. Without this two producers could claim the
+     * same slot and then both advance `write_index` past it.
+     */
+    std::mutex producer_mutex;
+};
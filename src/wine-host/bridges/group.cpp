@@ -34,26 +34,6 @@ namespace fs = boost::filesystem;
 
 using namespace std::literals::chrono_literals;
 
-/**
- * Listen on the specified endpoint if no process is already listening there,
- * otherwise throw. This is needed to handle these three situations:
- *
- * 1. The endpoint does not already exist, and we can simply create an endpoint.
- * 2. The endpoint already exists but it is stale and no process is currently
- *    listening. In this case we can remove the file and start listening.
- * 3. The endpoint already exists and another process is currently listening on
- *    it. In this situation we will throw immediately and we'll terminate this
- *    process.
- *
- * If anyone knows a better way to handle this, please let me know!
- *
- * @throw std::runtime_error If another process is already listening on the
- *        endpoint.
- */
-boost::asio::local::stream_protocol::acceptor create_acceptor_if_inactive(
-    boost::asio::io_context& io_context,
-    boost::asio::local::stream_protocol::endpoint& endpoint);
-
 /**
  * Create a logger prefix containing the group name based on the socket path.
  */
@@ -118,8 +98,9 @@ bool GroupBridge::is_event_loop_inhibited() noexcept {
     std::lock_guard lock(active_plugins_mutex);
 
     for (auto& [parameters, value] : active_plugins) {
+        // Plugins that are still being initialized don't have a bridge yet
         auto& [thread, bridge] = value;
-        if (bridge->inhibits_event_loop()) {
+        if (bridge && bridge->inhibits_event_loop()) {
             return true;
         }
     }
@@ -178,87 +159,141 @@ void GroupBridge::accept_requests() {
                 main_context.stop();
             }
 
-            // Read the parameters, and then host the plugin in this process
-            // just like if we would be hosting the plugin individually through
-            // `yabridge-hsot.exe`. We will reply with this process's PID so the
-            // yabridge plugin will be able to tell if the plugin has caused
-            // this process to crash during its initialization to prevent
-            // waiting indefinitely on the sockets to be connected to.
-            const auto request = read_object<HostRequest>(socket);
-            write_object(socket, HostResponse{boost::this_process::get_id()});
-
-            // The plugin has to be initiated on the IO context's thread because
-            // this has to be done on the same thread that's handling messages,
-            // and all window messages have to be handled from the same thread.
-            logger.log("Received request to host " +
-                       plugin_type_to_string(request.plugin_type) +
-                       " plugin at '" + request.plugin_path +
-                       "' using socket endpoint base directory '" +
-                       request.endpoint_base_dir + "'");
-            try {
-                // Cancel the (initial) shutdown timer, since the plugin may
-                // take longer to initialize if it is new
-                shutdown_timer.cancel();
-
-                std::unique_ptr<HostBridge> bridge = nullptr;
-                switch (request.plugin_type) {
-                    case PluginType::vst2:
-                        bridge = std::make_unique<Vst2Bridge>(
-                            main_context, request.plugin_path,
-                            request.endpoint_base_dir, request.parent_pid);
-                        break;
-                    case PluginType::vst3:
+            // Cancel the (initial) shutdown timer, since the plugin may take
+            // longer to initialize if it is new
+            shutdown_timer.cancel();
+
+            // Everything up until the point where the plugin's library needs
+            // to be loaded happens on the plugin's own thread, so we can
+            // immediately start accepting the next request. The plugin's entry
+            // is added to `active_plugins` right away so the process won't
+            // shut down while the plugin is still being initialized.
+            const size_t plugin_id = next_plugin_id.fetch_add(1);
+            active_plugins[plugin_id] = std::pair(
+                Win32Thread([this, plugin_id,
+                             socket = std::move(socket)]() mutable {
+                    const std::string thread_name =
+                        "worker-" + std::to_string(plugin_id);
+                    pthread_setname_np(pthread_self(), thread_name.c_str());
+
+                    handle_plugin_init(plugin_id, socket);
+                }),
+                nullptr);
+
+            accept_requests();
+        });
+}
+
+void GroupBridge::handle_plugin_init(
+    size_t plugin_id,
+    boost::asio::local::stream_protocol::socket& socket) {
+    // Read the parameters, and then host the plugin in this process just like
+    // if we would be hosting the plugin individually through
+    // `yabridge-hsot.exe`. We will reply with this process's PID so the
+    // yabridge plugin will be able to tell if the plugin has caused this
+    // process to crash during its initialization to prevent waiting
+    // indefinitely on the sockets to be connected to.
+    HostRequest request;
+    try {
+        request = read_object<HostRequest>(socket);
+        write_object(socket, HostResponse{boost::this_process::get_id()});
+    } catch (const boost::system::system_error& error) {
+        logger.log("Error while reading a plugin host request:");
+        logger.log(error.what());
+
+        remove_plugin(plugin_id);
+        return;
+    }
+
+    logger.log("Received request to host " +
+               plugin_type_to_string(request.plugin_type) + " plugin at '" +
+               request.plugin_path +
+               "' using socket endpoint base directory '" +
+               request.endpoint_base_dir + "'");
+
+    // Reading a large plugin's library from disk can take a while, and this
+    // does not have to happen on the main thread. When loading a project with
+    // many plugins, this way the libraries for the other plugins will be read
+    // while the main thread is busy initializing the first one.
+    prefetch_plugin_files(request.plugin_path);
+
+    // The plugin has to be initiated on the IO context's thread because this
+    // has to be done on the same thread that's handling messages, and all
+    // window messages have to be handled from the same thread.
+    HostBridge* bridge =
+        main_context
+            .run_in_context([&]() -> HostBridge* {
+                try {
+                    std::unique_ptr<HostBridge> new_bridge = nullptr;
+                    switch (request.plugin_type) {
+                        case PluginType::vst2:
+                            new_bridge = std::make_unique<Vst2Bridge>(
+                                main_context, request.plugin_path,
+                                request.endpoint_base_dir, request.parent_pid);
+                            break;
+                        case PluginType::vst3:
 #ifdef WITH_VST3
-                        bridge = std::make_unique<Vst3Bridge>(
-                            main_context, request.plugin_path,
-                            request.endpoint_base_dir, request.parent_pid);
+                            new_bridge = std::make_unique<Vst3Bridge>(
+                                main_context, request.plugin_path,
+                                request.endpoint_base_dir, request.parent_pid);
 #else
-                        throw std::runtime_error(
-                            "This version of yabridge has not been compiled "
-                            "with VST3 support");
+                            throw std::runtime_error(
+                                "This version of yabridge has not been "
+                                "compiled with VST3 support");
 #endif
-                        break;
-                    case PluginType::unknown:
-                        throw std::runtime_error(
-                            "Invalid plugin host request received, how did you "
-                            "even manage to do this?");
-                        break;
+                            break;
+                        case PluginType::unknown:
+                            throw std::runtime_error(
+                                "Invalid plugin host request received, how did "
+                                "you even manage to do this?");
+                            break;
+                    }
+
+                    logger.log("Finished initializing '" +
+                               request.plugin_path + "'");
+
+                    std::lock_guard lock(active_plugins_mutex);
+                    HostBridge* bridge_ptr = new_bridge.get();
+                    active_plugins[plugin_id].second = std::move(new_bridge);
+
+                    return bridge_ptr;
+                } catch (const std::exception& error) {
+                    logger.log("Error while initializing '" +
+                               request.plugin_path + "':");
+                    logger.log(error.what());
+
+                    return nullptr;
                 }
+            })
+            .get();
+
+    // Start listening for dispatcher events sent to the plugin's socket on
+    // this thread. Parts of the actual event handling will still be posted to
+    // this IO context so that any events that potentially interact with the
+    // Win32 message loop are handled from the main thread. We use the raw
+    // pointer to the plugin we got back here so we don't have to immediately
+    // look the instance up in the map again, as this would require us to
+    // immediately lock the map again. This could otherwise result in a
+    // deadlock when using the Spitfire plugins, as they will block the message
+    // loop until `effOpen()` has been called and thus prevent this lock from
+    // happening.
+    if (bridge) {
+        handle_plugin_run(plugin_id, bridge);
+    } else {
+        remove_plugin(plugin_id);
+    }
+}
 
-                logger.log("Finished initializing '" + request.plugin_path +
-                           "'");
-
-                // Start listening for dispatcher events sent to the plugin's
-                // socket on another thread. Parts of the actual event handling
-                // will still be posted to this IO context so that any events
-                // that potentially interact with the Win32 message loop are
-                // handled from the main thread. We also pass a raw pointer to
-                // the plugin so we don't have to immediately look the instance
-                // up in the map again, as this would require us to immediately
-                // lock the map again. This could otherwise result in a deadlock
-                // when using the Spitfire plugins, as they will block the
-                // message loop until `effOpen()` has been called and thus
-                // prevent this lock from happening.
-                const size_t plugin_id = next_plugin_id.fetch_add(1);
-                active_plugins[plugin_id] = std::pair(
-                    Win32Thread([this, plugin_id, plugin_ptr = bridge.get()]() {
-                        const std::string thread_name =
-                            "worker-" + std::to_string(plugin_id);
-                        pthread_setname_np(pthread_self(), thread_name.c_str());
-
-                        handle_plugin_run(plugin_id, plugin_ptr);
-                    }),
-                    std::move(bridge));
-            } catch (const std::exception& error) {
-                logger.log("Error while initializing '" + request.plugin_path +
-                           "':");
-                logger.log(error.what());
-
-                maybe_schedule_shutdown(5s);
-            }
+void GroupBridge::remove_plugin(size_t plugin_id) {
+    main_context.schedule_task([this, plugin_id]() {
+        std::lock_guard lock(active_plugins_mutex);
 
-            accept_requests();
-        });
+        // The join is implicit because we're using Win32Thread (which mimics
+        // std::jthread)
+        active_plugins.erase(plugin_id);
+    });
+
+    maybe_schedule_shutdown(5s);
 }
 
 void GroupBridge::async_handle_events() {
@@ -279,39 +314,6 @@ void GroupBridge::async_handle_events() {
         [&]() { return !is_event_loop_inhibited(); });
 }
 
-boost::asio::local::stream_protocol::acceptor create_acceptor_if_inactive(
-    boost::asio::io_context& io_context,
-    boost::asio::local::stream_protocol::endpoint& endpoint) {
-    // First try to listen on the endpoint normally
-    try {
-        return boost::asio::local::stream_protocol::acceptor(io_context,
-                                                             endpoint);
-    } catch (const boost::system::system_error&) {
-        // If this failed, then either there is a stale socket file or another
-        // process is already is already listening. In the last case we will
-        // simply throw so the other process can handle the request.
-        std::ifstream open_sockets("/proc/net/unix");
-        std::string endpoint_path = endpoint.path();
-        for (std::string line; std::getline(open_sockets, line);) {
-            if (line.size() < endpoint_path.size()) {
-                continue;
-            }
-
-            std::string file = line.substr(line.size() - endpoint_path.size());
-            if (file == endpoint_path) {
-                // Another process is already listening, so we don't have to do
-                // anything
-                throw;
-            }
-        }
-
-        // At this point we can remove the stale socket and start listening
-        fs::remove(endpoint_path);
-        return boost::asio::local::stream_protocol::acceptor(io_context,
-                                                             endpoint);
-    }
-}
-
 void GroupBridge::maybe_schedule_shutdown(
     std::chrono::steady_clock::duration delay) {
     std::lock_guard lock(shutdown_timer_mutex);
@@ -144,8 +144,8 @@ class GroupBridge {
     /**
      * Run a plugin's dispatcher and message loop, processing all events on the
      * main IO context. The plugin will have already been created in
-     * `accept_requests` since it has to be initiated inside of the IO context's
-     * thread.
+     * `handle_plugin_init()` since it has to be initiated inside of the IO
+     * context's thread.
      *
      * Once the plugin has exited, this thread will then be joined to the main
      * thread and removed from the `active_plugins` from the main IO context. If
@@ -171,22 +171,45 @@ class GroupBridge {
    private:
     /**
      * Listen on the group socket for incoming requests to host a new plugin
-     * within this group process. This will read a `GoupRequest` object
-     * containing information about the plugin, reply with this process's PID so
-     * the yabridge instance can tell if the plugin crashed during
-     * initialization, and it will then try to initialize the plugin. After
-     * intialization the plugin handling will be handed over to a new thread
-     * running `handle_plugin_run()`. Because of the way the Win32 API works,
-     * all plugins have to be initialized from the same thread, and all event
-     * handling and message loop interaction also has to be done from that
-     * thread, which is why we initialize the plugin here and use the
-     * `handle_dispatch()` function to run events within the same
-     * `main_context`.
+     * within this group process. Every accepted connection gets its own thread
+     * running `handle_plugin_init()`, so the next connection can be accepted
+     * right away. That thread will later also run `handle_plugin_run()` for
+     * the plugin.
      *
-     * @see handle_plugin_run
+     * @see handle_plugin_init
      */
     void accept_requests();
 
+    /**
+     * Handle a single connection accepted by `accept_requests()` on the
+     * plugin's own thread. This will read a `HostRequest` object containing
+     * information about the plugin, reply with this process's PID so the
+     * yabridge instance can tell if the plugin crashed during initialization,
+     * and then read the plugin's library from disk ahead of time. Because of
+     * the way the Win32 API works, all plugins have to be initialized from the
+     * same thread, and all event handling and message loop interaction also
+     * has to be done from that thread, which is why the plugin's bridge is
+     * then created on the main context. The steps before that can run
+     * concurrently for any number of plugins, so when loading a project with
+     * many plugins the main thread doesn't have to wait for any of that.
+     * Afterwards this thread will continue with `handle_plugin_run()`.
+     *
+     * @param plugin_id The ID of this plugin in the `active_plugins` map. The
+     *   entry has already been added by `accept_requests()`, and the bridge
+     *   will be stored there once it has been created.
+     * @param socket The connection accepted on the group socket.
+     */
+    void handle_plugin_init(
+        size_t plugin_id,
+        boost::asio::local::stream_protocol::socket& socket);
+
+    /**
+     * Remove a plugin that failed to initialize from `active_plugins` on the
+     * main context, joining its thread, and then shut down the process after
+     * five seconds if no other plugins are left.
+     */
+    void remove_plugin(size_t plugin_id);
+
     /**
      * Handle both Win32 messages and X11 events on a timer within the IO
      * context for all plugins.
@@ -250,12 +273,13 @@ class GroupBridge {
 
     /**
      * A map of threads that are currently hosting a plugin within this process
-     * along with their plugin instance. After a plugin has exited or its
-     * initialization has failed, the thread handling it will remove itself from
-     * this map. This is to keep track of the amount of plugins currently
-     * running with their associated thread handles. The key that identifies the
-     * thread and plugin is a unique plugin ID obtained by doing a fetch-and-add
-     * on `next_plugin_id`.
+     * along with their plugin instance. The plugin instance will be a null
+     * pointer while the plugin is still being initialized. After a plugin has
+     * exited or its initialization has failed, the thread handling it will
+     * remove itself from this map. This is to keep track of the amount of
+     * plugins currently running with their associated thread handles. The key
+     * that identifies the thread and plugin is a unique plugin ID obtained by
+     * doing a fetch-and-add on `next_plugin_id`.
      */
     std::unordered_map<size_t,
                        std::pair<Win32Thread, std::unique_ptr<HostBridge>>>
@@ -114,6 +114,14 @@ static const std::unordered_set<int> unsafe_requests{
 static const std::unordered_set<int> unsafe_requests_realtime{effOpen,
                                                               effMainsChanged};
 
+/**
+ * How many parameter values we'll read from the plugin after every processing
+ * cycle to keep the shared memory parameter table up to date. Plugins with more
+ * parameters than this will have their values refreshed over multiple cycles.
+ * Parameters changed through `audioMasterAutomate()` are updated immediately.
+ */
+constexpr uint32_t parameter_refreshes_per_cycle = 64;
+
 intptr_t VST_CALL_CONV
 host_callback_proxy(AEffect*, int, int, intptr_t, void*, float);
 
@@ -216,6 +224,17 @@ Vst2Bridge::Vst2Bridge(MainContext& main_context,
     // Allow this plugin to configure the main context's tick rate
     main_context.update_timer_interval(config.event_loop_interval());
 
+    // The native plugin also sets up this table after sending the
+    // configuration, and whichever side gets there first creates the shared
+    // memory object. The values will be read from the plugin once the host
+    // resumes it, since some plugins may not like having their parameters
+    // queried before `effOpen()`.
+    if (config.vst2_shared_parameters && plugin->numParams > 0) {
+        parameter_table.emplace(
+            sockets.base_dir.filename().string() + "-parameters",
+            static_cast<uint32_t>(plugin->numParams));
+    }
+
     parameters_handler = Win32Thread([&]() {
         set_realtime_priority(true);
         pthread_setname_np(pthread_self(), "parameters");
@@ -228,13 +247,32 @@ Vst2Bridge::Vst2Bridge(MainContext& main_context,
                 // dealing with.
                 if (request.value) {
                     // `setParameter`
+                    // Any values queued by the native plugin were set before
+                    // this one, so they should also be applied first
+                    apply_queued_parameters();
                     plugin->setParameter(plugin, request.index, *request.value);
+                    if (parameter_table &&
+                        parameter_table->contains(request.index)) {
+                        // The plugin may quantize or clamp the value, so we
+                        // need to store the value it actually ended up using
+                        parameter_table->update(
+                            request.index,
+                            plugin->getParameter(plugin, request.index));
+                    }
 
                     ParameterResult response{std::nullopt};
                     sockets.host_vst_parameters.send(response, buffer);
                 } else {
                     // `getParameter`
+                    // The native plugin only asks for parameters in the table
+                    // when it has queued a new value for them, so that value
+                    // should be applied first
+                    apply_queued_parameters();
                     float value = plugin->getParameter(plugin, request.index);
+                    if (parameter_table &&
+                        parameter_table->contains(request.index)) {
+                        parameter_table->update(request.index, value);
+                    }
 
                     ParameterResult response{value};
                     sockets.host_vst_parameters.send(response, buffer);
@@ -251,124 +289,32 @@ Vst2Bridge::Vst2Bridge(MainContext& main_context,
         // they start producing denormals
         ScopedFlushToZero ftz_guard;
 
+        // The process requests are normally passed through the control region
+        // in the shared audio buffers, see `process_shm_handler`. This socket
+        // is only used as a fallback.
         sockets.host_vst_process_replacing.receive_multi<Vst2ProcessRequest>(
             [&](Vst2ProcessRequest& process_request,
                 SerializationBufferBase& buffer) {
-                // Since the value cannot change during this processing cycle,
-                // we'll send the current transport information as part of the
-                // request so we prefetch it to avoid unnecessary callbacks from
-                // the audio thread
-                std::optional<decltype(time_info_cache)::Guard>
-                    time_info_cache_guard =
-                        process_request.current_time_info
-                            ? std::optional(time_info_cache.set(
-                                  *process_request.current_time_info))
-                            : std::nullopt;
-
-                // We'll also prefetch the process level, since some plugins
-                // will ask for this during every processing cycle
-                decltype(process_level_cache)::Guard process_level_cache_guard =
-                    process_level_cache.set(
-                        process_request.current_process_level);
-
-                // As suggested by Jack Winter, we'll synchronize this thread's
-                // audio processing priority with that of the host's audio
-                // thread every once in a while
-                if (process_request.new_realtime_priority) {
-                    set_realtime_priority(
-                        true, *process_request.new_realtime_priority);
-                }
-
-                // Let the plugin process the MIDI events that were received
-                // since the last buffer, and then clean up those events. This
-                // approach should not be needed but Kontakt only stores
-                // pointers to rather than copies of the events.
-                std::lock_guard lock(next_buffer_midi_events_mutex);
-
-                // As an optimization we no don't pass the input audio along
-                // with `Vst2ProcessRequest`, and instead we'll write it to a
-                // shared memory object on the plugin side. We can then write
-                // the output audio to the same shared memory object. Since the
-                // host should only be calling one of `process()`,
-                // processReplacing()` or `processDoubleReplacing()`, we can all
-                // handle them all at once. We pick which one to call depending
-                // on the type of data we got sent and the plugin's reported
-                // support for these functions.
-                auto do_process = [&]<typename T>(T) {
-                    // These were set up after the host called
-                    // `effMainsChanged()` with the correct size, so this
-                    // reinterpret cast is safe even if the host suddenly starts
-                    // sending 32-bit single precision audio after it set up
-                    // audio processing for double precision (not that the
-                    // Windows VST2 plugin would be able to handle that,
-                    // presumably)
-                    T** input_channel_pointers = reinterpret_cast<T**>(
-                        process_buffers_input_pointers.data());
-                    T** output_channel_pointers = reinterpret_cast<T**>(
-                        process_buffers_output_pointers.data());
-
-                    if constexpr (std::is_same_v<T, float>) {
-                        // Any plugin made in the last fifteen years or so
-                        // should support `processReplacing`. In the off chance
-                        // it does not we can just emulate this behavior
-                        // ourselves.
-                        if (plugin->processReplacing) {
-                            plugin->processReplacing(
-                                plugin, input_channel_pointers,
-                                output_channel_pointers,
-                                process_request.sample_frames);
-                        } else {
-                            // If we zero out this buffer then the behavior is
-                            // the same as `processReplacing`
-                            for (int channel = 0; channel < plugin->numOutputs;
-                                 channel++) {
-                                std::fill(output_channel_pointers[channel],
-                                          output_channel_pointers[channel] +
-                                              process_request.sample_frames,
-                                          static_cast<T>(0.0));
-                            }
-
-                            plugin->process(plugin, input_channel_pointers,
-                                            output_channel_pointers,
-                                            process_request.sample_frames);
-                        }
-                    } else if (std::is_same_v<T, double>) {
-                        plugin->processDoubleReplacing(
-                            plugin, input_channel_pointers,
-                            output_channel_pointers,
-                            process_request.sample_frames);
-                    } else {
-                        static_assert(
-                            std::is_same_v<T, float> ||
-                                std::is_same_v<T, double>,
-                            "Audio processing only works with single and "
-                            "double precision floating point numbers");
-                    }
-                };
-
-                assert(process_buffers);
-                if (process_request.double_precision) {
-                    // XXX: Clangd doesn't let you specify template parameters
-                    //      for templated lambdas. This argument should get
-                    //      optimized out
-                    do_process(double());
-                } else {
-                    do_process(float());
-                }
-
-                // We modified the buffers within the `process_response` object,
-                // so we can just send that object back. Like on the plugin side
-                // we cannot reuse the request object because a plugin may have
-                // a different number of input and output channels
-                sockets.host_vst_process_replacing.send(Ack{}, buffer);
-
-                // See the docstrong on `should_clear_midi_events` for why we
-                // don't just clear `next_buffer_midi_events` here
-                should_clear_midi_events = true;
+                process_audio(process_request);
+
+                // The audio has been written to the shared memory buffers, so
+                // the response only contains the MIDI events produced by the
+                // plugin
+                sockets.host_vst_process_replacing.send(process_response,
+                                                        buffer);
+                refresh_parameter_table(parameter_refreshes_per_cycle);
             });
     });
 }
 
+Vst2Bridge::~Vst2Bridge() noexcept {
+    // The thread handling process requests through the shared memory object
+    // needs to be woken up before it can be joined
+    if (process_buffers) {
+        process_buffers->shutdown();
+    }
+}
+
 bool Vst2Bridge::inhibits_event_loop() noexcept {
     return !is_initialized;
 }
@@ -415,6 +361,28 @@ void Vst2Bridge::run() {
                                        .value_payload = std::nullopt};
             }
 
+            // This opcode only exists within yabridge, so it should never be
+            // passed to the plugin directly
+            if (event.opcode == effYabridgeGetParameterStrings) {
+                const auto& request =
+                    std::get<WantsParameterStrings>(event.payload);
+
+                return Vst2EventResult{
+                    .return_value = 0,
+                    .payload = get_parameter_strings(request),
+                    .value_payload = std::nullopt};
+            }
+
+            // The native plugin may have queued some `setParameter()` calls
+            // that should be applied before the plugin gets suspended, and
+            // before its state gets saved or replaced
+            if ((event.opcode == effMainsChanged && event.value == 0) ||
+                event.opcode == effGetChunk || event.opcode == effSetChunk ||
+                event.opcode == effGetProgram ||
+                event.opcode == effSetProgram) {
+                apply_queued_parameters();
+            }
+
             Vst2EventResult result = passthrough_event(
                 plugin,
                 [&](AEffect* plugin, int opcode, int index, intptr_t value,
@@ -474,6 +442,17 @@ void Vst2Bridge::run() {
                 },
                 event);
 
+            // The native plugin uses the parameter table while the plugin is
+            // processing audio, so it should contain the current values at
+            // that point. Loading a preset or changing the program will also
+            // change (almost) all parameters at once.
+            if ((event.opcode == effMainsChanged && event.value == 1) ||
+                event.opcode == effSetChunk || event.opcode == effSetProgram) {
+                if (parameter_table) {
+                    refresh_parameter_table(parameter_table->size());
+                }
+            }
+
             // We also need some special handling to set up audio processing.
             // After the plugin has finished setting up audio processing, we'll
             // initialize our shared audio buffers on this side and send the
@@ -627,6 +606,25 @@ class HostCallbackDataConverter : public DefaultDataConverter {
         boost::asio::local::stream_protocol::socket& socket,
         const Vst2Event& event,
         SerializationBufferBase& buffer) const override {
+        return send_event_impl(socket, event, buffer);
+    }
+
+    Vst2EventResult send_event(MultiplexedStream& stream,
+                               const Vst2Event& event,
+                               SerializationBufferBase& buffer) const override {
+        return send_event_impl(stream, event, buffer);
+    }
+
+   private:
+    /**
+     * Send the event using the default implementation, but spawn a new thread
+     * to handle mutually recursive function calls if needed. This works the
+     * same way for sockets and multiplexed streams.
+     */
+    template <typename Socket>
+    Vst2EventResult send_event_impl(Socket& socket,
+                                    const Vst2Event& event,
+                                    SerializationBufferBase& buffer) const {
         if (mutually_recursive_callbacks.contains(event.opcode)) {
             return mutual_recursion.fork([&]() {
                 return DefaultDataConverter::send_event(socket, event, buffer);
@@ -636,7 +634,6 @@ class HostCallbackDataConverter : public DefaultDataConverter {
         }
     }
 
-   private:
     AEffect* plugin;
     VstTimeInfo& last_time_info;
     MutualRecursionHelper<Win32Thread>& mutual_recursion;
@@ -682,6 +679,26 @@ intptr_t Vst2Bridge::host_callback(AEffect* effect,
                 return *current_process_level;
             }
         } break;
+        // MIDI events produced during audio processing are sent back as part
+        // of the process response instead of through a separate callback
+        case audioMasterProcessEvents: {
+            if (data && std::this_thread::get_id() ==
+                            processing_thread_id.load(
+                                std::memory_order_relaxed)) {
+                process_response.output_events.append(
+                    *static_cast<const VstEvents*>(data));
+
+                return 1;
+            }
+        } break;
+        // The native plugin reads parameter values from the parameter table
+        // while the plugin is processing audio, so changes made by the plugin
+        // should be visible there immediately
+        case audioMasterAutomate: {
+            if (parameter_table && parameter_table->contains(index)) {
+                parameter_table->update(index, option);
+            }
+        } break;
         // If the plugin changes its window size, we'll also resize the wrapper
         // window accordingly.
         case audioMasterSizeWindow: {
@@ -697,6 +714,57 @@ intptr_t Vst2Bridge::host_callback(AEffect* effect,
                                                 index, value, data, option);
 }
 
+Vst2ParameterStrings Vst2Bridge::get_parameter_strings(
+    const WantsParameterStrings& request) {
+    // Plugins often write more than the eight characters the VST2 API allows
+    // for, so we'll use the same buffer size `passthrough_event()` uses
+    std::array<char, max_string_length> string_buffer;
+    const auto get_string = [&](int opcode, int index) {
+        string_buffer.fill(0);
+        const intptr_t return_value = dispatch_wrapper(
+            plugin, opcode, index, 0, string_buffer.data(), 0.0);
+        string_buffer.back() = 0;
+
+        return Vst2ParameterStrings::Entry{.return_value = return_value,
+                                           .string = string_buffer.data()};
+    };
+
+    Vst2ParameterStrings strings{};
+    const auto get_value_strings = [&](int index) {
+        strings.labels.push_back(get_string(effGetParamLabel, index));
+        strings.displays.push_back(get_string(effGetParamDisplay, index));
+    };
+
+    if (request.values_only && !request.parameters.empty()) {
+        strings.labels.reserve(request.parameters.size());
+        strings.displays.reserve(request.parameters.size());
+        for (const int32_t index : request.parameters) {
+            get_value_strings(index);
+        }
+    } else {
+        strings.labels.reserve(plugin->numParams);
+        strings.displays.reserve(plugin->numParams);
+        for (int i = 0; i < plugin->numParams; i++) {
+            get_value_strings(i);
+        }
+    }
+
+    if (!request.values_only) {
+        strings.names.reserve(plugin->numParams);
+        for (int i = 0; i < plugin->numParams; i++) {
+            strings.names.push_back(get_string(effGetParamName, i));
+        }
+
+        strings.program_names.reserve(plugin->numPrograms);
+        for (int i = 0; i < plugin->numPrograms; i++) {
+            strings.program_names.push_back(
+                get_string(effGetProgramNameIndexed, i));
+        }
+    }
+
+    return strings;
+}
+
 intptr_t Vst2Bridge::dispatch_wrapper(AEffect* plugin,
                                       int opcode,
                                       int index,
@@ -770,6 +838,179 @@ intptr_t Vst2Bridge::dispatch_wrapper(AEffect* plugin,
     }
 }
 
+void Vst2Bridge::process_audio(const Vst2ProcessRequest& process_request) {
+    // Since the value cannot change during this processing cycle, we'll send
+    // the current transport information as part of the request so we prefetch
+    // it to avoid unnecessary callbacks from the audio thread
+    std::optional<decltype(time_info_cache)::Guard> time_info_cache_guard =
+        process_request.current_time_info
+            ? std::optional(
+                  time_info_cache.set(*process_request.current_time_info))
+            : std::nullopt;
+
+    // We'll also prefetch the process level, since some plugins will ask for
+    // this during every processing cycle
+    decltype(process_level_cache)::Guard process_level_cache_guard =
+        process_level_cache.set(process_request.current_process_level);
+
+    // As suggested by Jack Winter, we'll synchronize this thread's audio
+    // processing priority with that of the host's audio thread every once in a
+    // while
+    if (process_request.new_realtime_priority) {
+        set_realtime_priority(true, *process_request.new_realtime_priority);
+    }
+
+    // Any MIDI events the plugin produces on this thread will be collected in
+    // `process_response`, see `host_callback()`
+    process_response.output_events.clear();
+    processing_thread_id.store(std::this_thread::get_id(),
+                               std::memory_order_relaxed);
+
+    // Automation the host sent since the last processing cycle has been queued
+    // by the native plugin, and it should be applied before processing this
+    // block
+    apply_queued_parameters();
+
+    // Let the plugin process the MIDI events that were received since the last
+    // buffer, and then clean up those events. This approach should not be
+    // needed but Kontakt only stores pointers to rather than copies of the
+    // events.
+    std::lock_guard lock(next_buffer_midi_events_mutex);
+
+    // As an optimization we no don't pass the input audio along with
+    // `Vst2ProcessRequest`, and instead we'll write it to a shared memory
+    // object on the plugin side. We can then write the output audio to the same
+    // shared memory object. Since the host should only be calling one of
+    // `process()`, processReplacing()` or `processDoubleReplacing()`, we can
+    // all handle them all at once. We pick which one to call depending on the
+    // type of data we got sent and the plugin's reported support for these
+    // functions.
+    auto do_process = [&]<typename T>(T) {
+        // These were set up after the host called `effMainsChanged()` with the
+        // correct size, so this reinterpret cast is safe even if the host
+        // suddenly starts sending 32-bit single precision audio after it set up
+        // audio processing for double precision (not that the Windows VST2
+        // plugin would be able to handle that, presumably)
+        T** input_channel_pointers =
+            reinterpret_cast<T**>(process_buffers_input_pointers.data());
+        T** output_channel_pointers = reinterpret_cast<T**>(
+            process_request.in_place
+                ? process_buffers_in_place_output_pointers.data()
+                : process_buffers_output_pointers.data());
+
+        if constexpr (std::is_same_v<T, float>) {
+            // Any plugin made in the last fifteen years or so should support
+            // `processReplacing`. In the off chance it does not we can just
+            // emulate this behavior ourselves.
+            if (plugin->processReplacing) {
+                plugin->processReplacing(plugin, input_channel_pointers,
+                                         output_channel_pointers,
+                                         process_request.sample_frames);
+            } else {
+                // The accumulating `process()` can't process in place since we
+                // need to zero out the outputs first, so we'll always use the
+                // separate output regions here
+                T** separate_output_channel_pointers = reinterpret_cast<T**>(
+                    process_buffers_output_pointers.data());
+
+                // If we zero out this buffer then the behavior is the same as
+                // `processReplacing`
+                for (int channel = 0; channel < plugin->numOutputs; channel++) {
+                    std::fill(separate_output_channel_pointers[channel],
+                              separate_output_channel_pointers[channel] +
+                                  process_request.sample_frames,
+                              static_cast<T>(0.0));
+                }
+
+                plugin->process(plugin, input_channel_pointers,
+                                separate_output_channel_pointers,
+                                process_request.sample_frames);
+
+                // The native plugin will read those channels back from the
+                // input regions, so we'll need to move the results there
+                if (process_request.in_place) {
+                    for (int channel = 0;
+                         channel < std::min(plugin->numInputs,
+                                            plugin->numOutputs);
+                         channel++) {
+                        std::copy_n(separate_output_channel_pointers[channel],
+                                    process_request.sample_frames,
+                                    output_channel_pointers[channel]);
+                    }
+                }
+            }
+        } else if (std::is_same_v<T, double>) {
+            plugin->processDoubleReplacing(plugin, input_channel_pointers,
+                                           output_channel_pointers,
+                                           process_request.sample_frames);
+        } else {
+            static_assert(
+                std::is_same_v<T, float> || std::is_same_v<T, double>,
+                "Audio processing only works with single and double "
+                "precision floating point numbers");
+        }
+    };
+
+    assert(process_buffers);
+    const auto processing_start = std::chrono::steady_clock::now();
+    if (process_request.double_precision) {
+        // XXX: Clangd doesn't let you specify template parameters for templated
+        //      lambdas. This argument should get optimized out
+        do_process(double());
+    } else {
+        do_process(float());
+    }
+    process_response.processing_time_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - processing_start)
+            .count());
+
+    processing_thread_id.store(std::thread::id(), std::memory_order_relaxed);
+
+    // See the docstrong on `should_clear_midi_events` for why we don't just
+    // clear `next_buffer_midi_events` here
+    should_clear_midi_events = true;
+}
+
+void Vst2Bridge::forward_process_response_events() {
+    host_callback(plugin, audioMasterProcessEvents, 0, 0,
+                  &process_response.output_events.as_c_events(), 0.0);
+    process_response.output_events.clear();
+}
+
+void Vst2Bridge::apply_queued_parameters() {
+    if (!parameter_table) {
+        return;
+    }
+
+    parameter_table->apply_queued([&](uint32_t index, float value) {
+        plugin->setParameter(plugin, static_cast<int>(index), value);
+
+        return plugin->getParameter(plugin, static_cast<int>(index));
+    });
+}
+
+void Vst2Bridge::refresh_parameter_table(uint32_t max_parameters) {
+    if (!parameter_table) {
+        return;
+    }
+
+    const uint32_t num_parameters = parameter_table->size();
+    uint32_t index =
+        next_parameter_refresh_index.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < std::min(max_parameters, num_parameters); i++) {
+        if (index >= num_parameters) {
+            index = 0;
+        }
+
+        parameter_table->update(
+            index, plugin->getParameter(plugin, static_cast<int>(index)));
+        index++;
+    }
+
+    next_parameter_refresh_index.store(index, std::memory_order_relaxed);
+}
+
 AudioShmBuffer::Config Vst2Bridge::setup_shared_audio_buffers() {
     // We'll first compute the size and channel offsets for our buffer based on
     // the information already passed to us by the host. The offsets for each
@@ -806,6 +1047,40 @@ AudioShmBuffer::Config Vst2Bridge::setup_shared_audio_buffers() {
         .output_offsets = {std::move(output_channel_offsets)}};
     if (!process_buffers) {
         process_buffers.emplace(buffer_config);
+
+        // The native plugin will pass its process requests through the control
+        // region in this shared memory object from now on. Since resizing the
+        // buffer won't touch that region, this thread only needs to be started
+        // once.
+        process_shm_handler = Win32Thread([&]() {
+            set_realtime_priority(true);
+            pthread_setname_np(pthread_self(), "audio-shm");
+
+            ScopedFlushToZero ftz_guard;
+
+            SerializationBuffer<256> buffer{};
+            Vst2ProcessRequest process_request{};
+            while (process_buffers->wait_for_request(
+                config.audio_spin_duration())) {
+                read_shm_object(*process_buffers, process_request, buffer);
+                process_audio(process_request);
+
+                // The response only contains the MIDI events produced by the
+                // plugin. If there are so many of those that they don't fit in
+                // the message area, then we'll send them through the host
+                // callback socket instead.
+                std::optional<uint32_t> response_size = write_shm_object(
+                    *process_buffers, process_response, buffer);
+                if (!response_size) [[unlikely]] {
+                    forward_process_response_events();
+                    response_size = write_shm_object(*process_buffers,
+                                                     process_response, buffer);
+                }
+
+                process_buffers->send_response(*response_size);
+                refresh_parameter_table(parameter_refreshes_per_cycle);
+            }
+        });
     } else {
         process_buffers->resize(buffer_config);
     }
@@ -834,6 +1109,16 @@ AudioShmBuffer::Config Vst2Bridge::setup_shared_audio_buffers() {
         }
     }
 
+    // When the host processes audio in place we'll do the same thing on this
+    // side. Output channels that don't have a corresponding input channel
+    // still get their own region.
+    process_buffers_in_place_output_pointers = process_buffers_output_pointers;
+    for (int channel = 0;
+         channel < std::min(plugin->numInputs, plugin->numOutputs); channel++) {
+        process_buffers_in_place_output_pointers[channel] =
+            process_buffers_input_pointers[channel];
+    }
+
     return buffer_config;
 }
 
@@ -21,9 +21,13 @@
 #include <vestige/aeffectx.h>
 #include <windows.h>
 
+#include <atomic>
+#include <thread>
+
 #include "../../common/communication/vst2.h"
 #include "../../common/configuration.h"
 #include "../../common/mutual-recursion.h"
+#include "../../common/parameter-shm.h"
 #include "../editor.h"
 #include "common.h"
 
@@ -59,6 +63,12 @@ class Vst2Bridge : public HostBridge {
                std::string endpoint_base_dir,
                pid_t parent_pid);
 
+    /**
+     * Wake up the thread handling process requests through the shared memory
+     * audio buffers so it can be joined.
+     */
+    ~Vst2Bridge() noexcept override;
+
     bool inhibits_event_loop() noexcept override;
 
     /**
@@ -89,6 +99,52 @@ class Vst2Bridge : public HostBridge {
                               void* data,
                               float option);
 
+    /**
+     * Ask the plugin for the labels and display strings of all of its
+     * parameters or only of the requested parameters, and unless `values_only`
+     * is set also for all parameter names and program names. This handles
+     * `effYabridgeGetParameterStrings` events, which the native plugin uses to
+     * fill its parameter string cache when the `vst2_cache_strings` option is
+     * enabled.
+     */
+    Vst2ParameterStrings get_parameter_strings(
+        const WantsParameterStrings& request);
+
+    /**
+     * Process a single block of audio using the plugin's `processReplacing()`,
+     * `processDoubleReplacing()`, or `process()` functions. The audio is read
+     * from and written to `process_buffers`. This is called for requests
+     * received through either the shared memory object's control region or
+     * through the `host_vst_process_replacing` socket.
+     */
+    void process_audio(const Vst2ProcessRequest& process_request);
+
+    /**
+     * Forward the MIDI events in `process_response` to the native plugin over
+     * the host callback socket and clear them. This is used as a fallback when
+     * the plugin produced so many events that the response doesn't fit in the
+     * shared memory object's message area.
+     */
+    void forward_process_response_events();
+
+    /**
+     * Apply the `setParameter()` calls the native plugin queued in
+     * `parameter_table` since the last time this was called, and read back the
+     * values the plugin ended up using. This is done at the start of every
+     * processing cycle, before the plugin gets suspended, and before the
+     * plugin's state or program gets saved or changed.
+     */
+    void apply_queued_parameters();
+
+    /**
+     * Read the current values for up to `max_parameters` parameters from the
+     * plugin and store them in `parameter_table`. Every call continues where
+     * the last one left off, so calling this after every processing cycle
+     * keeps the whole table up to date without spending too much time on it
+     * at once.
+     */
+    void refresh_parameter_table(uint32_t max_parameters);
+
     /**
      * Sets up the shared memory audio buffers for this plugin instance and
      * returns the configuration so the native plugin can connect to it as well.
@@ -125,6 +181,23 @@ class Vst2Bridge : public HostBridge {
      */
     std::optional<AudioShmBuffer> process_buffers;
 
+    /**
+     * A table containing the plugin's parameter values in shared memory. The
+     * native plugin reads parameter values from this table and queues
+     * `setParameter()` calls from the host's audio thread in it while the
+     * plugin is processing audio, so we need to keep these values up to date.
+     * This is only set up if the `vst2_shared_parameters` option is enabled and
+     * the plugin has any parameters.
+     *
+     * @see ParameterShmTable
+     */
+    std::optional<ParameterShmTable> parameter_table;
+
+    /**
+     * The index of the next parameter `refresh_parameter_table()` should read.
+     */
+    std::atomic_uint32_t next_parameter_refresh_index = 0;
+
     /**
      * Pointers to the input channels in process_buffers so we can pass them to
      * the plugin. These can be either `float*` or `double*`, so we sadly have
@@ -139,6 +212,15 @@ class Vst2Bridge : public HostBridge {
      */
     std::vector<void*> process_buffers_output_pointers;
 
+    /**
+     * The same as `process_buffers_output_pointers`, but with the output
+     * channels that have a corresponding input channel pointing to that input
+     * channel instead. These are used when the host processes audio in place.
+     *
+     * @see Vst2ProcessRequest::in_place
+     */
+    std::vector<void*> process_buffers_in_place_output_pointers;
+
     /**
      * The maximum number of samples the host will pass to the plugin during
      * `processReplacing()`/`processDoubleReplacing()`/`process()`. This is
@@ -183,6 +265,23 @@ class Vst2Bridge : public HostBridge {
      */
     ScopedValueCache<int> process_level_cache;
 
+    /**
+     * The response for the current processing cycle. Any MIDI events the
+     * plugin sends to the host through `audioMasterProcessEvents()` from the
+     * audio thread during `process_audio()` are stored here so they can be
+     * returned together with the processed audio. This object is reused to
+     * avoid allocations.
+     */
+    Vst2ProcessResponse process_response;
+
+    /**
+     * The ID of the thread currently running `process_audio()`, or a default
+     * constructed ID if the plugin is not processing audio. Only events sent
+     * from this thread are added to `process_response`, since those can't race
+     * with the response being sent.
+     */
+    std::atomic<std::thread::id> processing_thread_id;
+
     // FIXME: This emits `-Wignored-attributes` as of Wine 5.22
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wignored-attributes"
@@ -217,6 +316,14 @@ class Vst2Bridge : public HostBridge {
      * fallback) and `processDoubleReplacing`.
      */
     Win32Thread process_replacing_handler;
+    /**
+     * The thread that waits for process requests in `process_buffers`'s
+     * control region. Audio processing normally happens here instead of in
+     * `process_replacing_handler`, since that lets us avoid a socket round trip
+     * for every processing cycle. This is started after `process_buffers` has
+     * been set up for the first time.
+     */
+    Win32Thread process_shm_handler;
 
     /**
      * All sockets used for communicating with this specific plugin.
@@ -0,0 +1,241 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "host-stream-proxy.h"
+
+Vst3HostStreamProxy::Vst3HostStreamProxy(Vst3Bridge& bridge,
+                                         native_size_t owner_instance_id,
+                                         YaBStream& stream)
+    : bridge(bridge),
+      owner_instance_id(owner_instance_id),
+      stream(stream),
+      window(std::move(stream.inline_data())),
+      stream_size(stream.stream_size) {
+    FUNKNOWN_CTOR
+
+    stream.inline_data().clear();
+}
+
+Vst3HostStreamProxy::~Vst3HostStreamProxy() noexcept {
+    FUNKNOWN_DTOR
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdelete-non-virtual-dtor"
+IMPLEMENT_REFCOUNT(Vst3HostStreamProxy)
+#pragma GCC diagnostic pop
+
+tresult PLUGIN_API
+Vst3HostStreamProxy::queryInterface(Steinberg::FIDString _iid, void** obj) {
+    QUERY_INTERFACE(_iid, obj, Steinberg::FUnknown::iid, Steinberg::IBStream)
+    QUERY_INTERFACE(_iid, obj, Steinberg::IBStream::iid, Steinberg::IBStream)
+    if (stream.supports_stream_attributes) {
+        QUERY_INTERFACE(_iid, obj, Steinberg::Vst::IStreamAttributes::iid,
+                        Steinberg::Vst::IStreamAttributes)
+    }
+
+    *obj = nullptr;
+    return Steinberg::kNoInterface;
+}
+
+void Vst3HostStreamProxy::finish() {
+    if (!has_written_back && window_start == 0 &&
+        static_cast<int64_t>(window.size()) == stream_size) {
+        stream.inline_data() = std::move(window);
+        stream.stream_id.reset();
+    } else {
+        flush_window();
+        stream.stream_size = stream_size;
+    }
+}
+
+tresult PLUGIN_API Vst3HostStreamProxy::read(void* buffer,
+                                             int32 numBytes,
+                                             int32* numBytesRead) {
+    if (!buffer || numBytes < 0) {
+        return Steinberg::kInvalidArgument;
+    }
+
+    const int64_t bytes_to_read =
+        std::min(static_cast<int64_t>(numBytes), stream_size - seek_position);
+
+    int64_t bytes_read = 0;
+    while (bytes_read < bytes_to_read) {
+        if (seek_position < window_start ||
+            seek_position >=
+                window_start + static_cast<int64_t>(window.size())) {
+            if (!load_window(seek_position)) {
+                break;
+            }
+        }
+
+        const int64_t window_offset = seek_position - window_start;
+        const int64_t chunk_size =
+            std::min(bytes_to_read - bytes_read,
+                     static_cast<int64_t>(window.size()) - window_offset);
+        std::copy_n(&window[window_offset], chunk_size,
+                    static_cast<uint8_t*>(buffer) + bytes_read);
+
+        bytes_read += chunk_size;
+        seek_position += chunk_size;
+    }
+
+    if (numBytesRead) {
+        *numBytesRead = static_cast<int32>(bytes_read);
+    }
+
+    return bytes_read > 0 ? Steinberg::kResultOk : Steinberg::kResultFalse;
+}
+
+tresult PLUGIN_API Vst3HostStreamProxy::write(void* buffer,
+                                              int32 numBytes,
+                                              int32* numBytesWritten) {
+    if (!buffer || numBytes < 0) {
+        return Steinberg::kInvalidArgument;
+    }
+
+    int64_t bytes_written = 0;
+    while (bytes_written < numBytes) {
+        // Writes can extend the current window as long as they're contiguous
+        // with it and the window has room left. Otherwise we'll write the
+        // current window back to the host and start a new one.
+        const int64_t window_end =
+            window_start + static_cast<int64_t>(window.size());
+        if (seek_position < window_start || seek_position > window_end ||
+            seek_position - window_start >=
+                static_cast<int64_t>(streamed_bstream_window_size)) {
+            if (!flush_window()) {
+                break;
+            }
+
+            window.clear();
+            window_start = seek_position;
+        }
+
+        const int64_t window_offset = seek_position - window_start;
+        const int64_t chunk_size = std::min(
+            static_cast<int64_t>(numBytes) - bytes_written,
+            static_cast<int64_t>(streamed_bstream_window_size) - window_offset);
+        if (window_offset + chunk_size > static_cast<int64_t>(window.size())) {
+            window.resize(window_offset + chunk_size);
+        }
+        std::copy_n(static_cast<uint8_t*>(buffer) + bytes_written, chunk_size,
+                    &window[window_offset]);
+        window_dirty = true;
+
+        bytes_written += chunk_size;
+        seek_position += chunk_size;
+        stream_size = std::max(stream_size, seek_position);
+    }
+
+    if (numBytesWritten) {
+        *numBytesWritten = static_cast<int32>(bytes_written);
+    }
+
+    return bytes_written == numBytes ? Steinberg::kResultOk
+                                     : Steinberg::kResultFalse;
+}
+
+// NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
+tresult PLUGIN_API Vst3HostStreamProxy::seek(int64 pos,
+                                             int32 mode,
+                                             int64* result) {
+    switch (mode) {
+        case kIBSeekSet:
+            seek_position = pos;
+            break;
+        case kIBSeekCur:
+            seek_position += pos;
+            break;
+        case kIBSeekEnd:
+            seek_position = stream_size + pos;
+            break;
+        default:
+            return Steinberg::kInvalidArgument;
+            break;
+    }
+
+    seek_position =
+        std::clamp(seek_position, static_cast<int64_t>(0), stream_size);
+    if (result) {
+        *result = static_cast<int64>(seek_position);
+    }
+
+    return Steinberg::kResultOk;
+}
+
+tresult PLUGIN_API Vst3HostStreamProxy::tell(int64* pos) {
+    if (pos) {
+        *pos = seek_position;
+        return Steinberg::kResultOk;
+    } else {
+        return Steinberg::kInvalidArgument;
+    }
+}
+
+tresult PLUGIN_API
+Vst3HostStreamProxy::getFileName(Steinberg::Vst::String128 name) {
+    return stream.getFileName(name);
+}
+
+Steinberg::Vst::IAttributeList* PLUGIN_API
+Vst3HostStreamProxy::getAttributes() {
+    return stream.getAttributes();
+}
+
+bool Vst3HostStreamProxy::flush_window() {
+    if (!window_dirty) {
+        return true;
+    }
+
+    // We'll move the window into the request and back again to avoid copying
+    // it
+    YaBStream::Write request{.owner_instance_id = owner_instance_id,
+                             .stream_id = *stream.stream_id,
+                             .position = window_start,
+                             .data = std::move(window)};
+    const UniversalTResult result = bridge.send_message(request);
+    window = std::move(request.data);
+
+    has_written_back = true;
+    window_dirty = false;
+
+    return result == Steinberg::kResultOk;
+}
+
+bool Vst3HostStreamProxy::load_window(int64_t position) {
+    if (!flush_window()) {
+        return false;
+    }
+
+    const int64_t bytes_to_read =
+        std::min(static_cast<int64_t>(streamed_bstream_window_size),
+                 stream_size - position);
+    YaBStream::ReadResponse response =
+        bridge.send_message(YaBStream::Read{
+            .owner_instance_id = owner_instance_id,
+            .stream_id = *stream.stream_id,
+            .position = position,
+            .size = static_cast<int32>(bytes_to_read)});
+    if (response.result != Steinberg::kResultOk || response.data.empty()) {
+        return false;
+    }
+
+    window = std::move(response.data);
+    window_start = position;
+
+    return true;
+}
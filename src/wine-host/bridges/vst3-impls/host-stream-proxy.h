@@ -0,0 +1,134 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "../vst3.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wnon-virtual-dtor"
+
+/**
+ * An `IBStream` that reads from and writes to a stream provided by the host, in
+ * windows of `streamed_bstream_window_size` bytes. This is used in place of a
+ * streamed `YaBStream` for `{IComponent,IEditController}::{get,set}State()`, so
+ * neither side needs to hold a full copy of a plugin's state in memory when
+ * that state is hundreds of megabytes large. The first window is sent along
+ * with the request, and the rest of the data is read and written through
+ * `YaBStream::Read` and `YaBStream::Write` callbacks as the plugin reads or
+ * writes past the current window.
+ *
+ * When the plugin writes its state, the data is buffered in the current window
+ * until the plugin writes past it. If the plugin's state fits in a single
+ * window, then `finish()` will send it back inline with the response just like
+ * with a regular `YaBStream`, so small states don't need any additional round
+ * trips.
+ */
+class Vst3HostStreamProxy : public Steinberg::IBStream,
+                            public Steinberg::Vst::IStreamAttributes {
+   public:
+    /**
+     * Create a proxy for the host's stream.
+     *
+     * @param bridge The bridge to send callbacks through.
+     * @param owner_instance_id The instance ID of the object the stream was
+     *   passed to, used in the log messages.
+     * @param stream The streamed stream sent by the native plugin. `stream_id`
+     *   needs to be set. The proxy takes over its first window of data. This
+     *   object should outlive the proxy since stream attributes are read from
+     *   it, and since `finish()` writes the results back to it.
+     */
+    Vst3HostStreamProxy(Vst3Bridge& bridge,
+                        native_size_t owner_instance_id,
+                        YaBStream& stream);
+
+    virtual ~Vst3HostStreamProxy() noexcept;
+
+    DECLARE_FUNKNOWN_METHODS
+
+    /**
+     * Flush any pending writes and update the `YaBStream` passed to the
+     * constructor so it can be sent back to the native plugin in the
+     * `getState()` response. If the entire stream fits in the current window
+     * and we never had to write anything back to the host, then the data is
+     * moved back to that stream's buffer and `stream_id` is cleared so it gets
+     * written back like any other `YaBStream`.
+     */
+    void finish();
+
+    // From `IBstream`
+    tresult PLUGIN_API read(void* buffer,
+                            int32 numBytes,
+                            int32* numBytesRead = nullptr) override;
+    tresult PLUGIN_API write(void* buffer,
+                             int32 numBytes,
+                             int32* numBytesWritten = nullptr) override;
+    tresult PLUGIN_API seek(int64 pos,
+                            int32 mode,
+                            int64* result = nullptr) override;
+    tresult PLUGIN_API tell(int64* pos) override;
+
+    // From `IStreamAttributes`
+    tresult PLUGIN_API getFileName(Steinberg::Vst::String128 name) override;
+    Steinberg::Vst::IAttributeList* PLUGIN_API getAttributes() override;
+
+   private:
+    /**
+     * Write the current window back to the host if it contains any changes.
+     *
+     * @return Whether writing succeeded.
+     */
+    bool flush_window();
+
+    /**
+     * Flush the current window and then read a new window starting at
+     * `position` from the host.
+     *
+     * @return Whether we read any data.
+     */
+    bool load_window(int64_t position);
+
+    Vst3Bridge& bridge;
+    native_size_t owner_instance_id;
+    YaBStream& stream;
+
+    /**
+     * The data between `window_start` and `window_start + window.size()`. This
+     * always contains the most recent data, so reads should be served from
+     * here when possible.
+     */
+    std::vector<uint8_t> window;
+    int64_t window_start = 0;
+    /**
+     * Whether `window` has been written to since it was last read from or
+     * written to the host.
+     */
+    bool window_dirty = false;
+    /**
+     * Whether we have written any data back to the host's stream. If we have
+     * not, then small states can be returned inline in `finish()`.
+     */
+    bool has_written_back = false;
+
+    int64_t seek_position = 0;
+    /**
+     * The size of the entire stream. This grows as the plugin writes past the
+     * end of the stream.
+     */
+    int64_t stream_size;
+};
+
+#pragma GCC diagnostic pop
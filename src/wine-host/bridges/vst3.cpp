@@ -22,6 +22,7 @@
 #include "vst3-impls/connection-point-proxy.h"
 #include "vst3-impls/context-menu-proxy.h"
 #include "vst3-impls/host-context-proxy.h"
+#include "vst3-impls/host-stream-proxy.h"
 #include "vst3-impls/plug-frame-proxy.h"
 
 // Generated inside of the build directory
@@ -237,14 +238,23 @@ void Vst3Bridge::run() {
                 // NOTE: We also try to handle mutual recursion here, in case
                 //       this happens during a resize
                 return do_mutual_recursion_on_gui_thread([&]() -> tresult {
+                    // Large states are streamed from the host's stream instead
+                    // of being sent along with the request
+                    Steinberg::IBStream* state = &request.state;
+                    std::optional<Vst3HostStreamProxy> streamed_state;
+                    if (request.state.stream_id) {
+                        streamed_state.emplace(*this, request.instance_id,
+                                               request.state);
+                        state = &*streamed_state;
+                    }
+
                     // This same function is defined in both `IComponent` and
                     // `IEditController`, so the host is calling one or the
                     // other
                     if (interfaces.component) {
-                        return interfaces.component->setState(&request.state);
+                        return interfaces.component->setState(state);
                     } else {
-                        return interfaces.edit_controller->setState(
-                            &request.state);
+                        return interfaces.edit_controller->setState(state);
                     }
                 });
             },
@@ -259,16 +269,35 @@ void Vst3Bridge::run() {
                 //       call `getState()` while opening a popup menu
                 const tresult result =
                     do_mutual_recursion_on_gui_thread([&]() -> tresult {
+                        // When the native plugin allows streaming, everything
+                        // past the first window is written directly to the
+                        // host's stream as the plugin writes its state. See
+                        // `Vst3HostStreamProxy` for more information.
+                        Steinberg::IBStream* state = &request.state;
+                        std::optional<Vst3HostStreamProxy> streamed_state;
+                        if (request.state.stream_id) {
+                            streamed_state.emplace(*this, request.instance_id,
+                                                   request.state);
+                            state = &*streamed_state;
+                        }
+
                         // This same function is defined in both `IComponent`
                         // and `IEditController`, so the host is calling one or
                         // the other
+                        tresult get_state_result;
                         if (interfaces.component) {
-                            return interfaces.component->getState(
-                                &request.state);
+                            get_state_result =
+                                interfaces.component->getState(state);
                         } else {
-                            return interfaces.edit_controller->getState(
-                                &request.state);
+                            get_state_result =
+                                interfaces.edit_controller->getState(state);
                         }
+
+                        if (streamed_state) {
+                            streamed_state->finish();
+                        }
+
+                        return get_state_result;
                     });
 
                 return Vst3PluginProxy::GetStateResponse{
@@ -407,6 +436,28 @@ void Vst3Bridge::run() {
                 return YaEditController::GetParameterInfoResponse{
                     .result = result, .info = std::move(info)};
             },
+            [&](const YaEditController::GetAllParameterInfo& request)
+                -> YaEditController::GetAllParameterInfo::Response {
+                const auto& edit_controller =
+                    object_instances.at(request.instance_id)
+                        .interfaces.edit_controller;
+
+                YaEditController::GetAllParameterInfoResponse response{
+                    .parameter_count = edit_controller->getParameterCount()};
+                response.parameter_infos.reserve(
+                    std::max(response.parameter_count, 0));
+                for (int32 i = 0; i < response.parameter_count; i++) {
+                    Steinberg::Vst::ParameterInfo info{};
+                    const tresult result =
+                        edit_controller->getParameterInfo(i, info);
+
+                    response.parameter_infos.push_back(
+                        YaEditController::GetParameterInfoResponse{
+                            .result = result, .info = std::move(info)});
+                }
+
+                return response;
+            },
             [&](const YaEditController::GetParamStringByValue& request)
                 -> YaEditController::GetParamStringByValue::Response {
                 Steinberg::Vst::String128 string{0};
@@ -1304,6 +1355,58 @@ AudioShmBuffer::Config Vst3Bridge::setup_shared_audio_buffers(
         .output_offsets = std::move(output_bus_offsets)};
     if (!instance.process_buffers) {
         instance.process_buffers.emplace(buffer_config);
+
+        // The native plugin will pass its process requests through the control
+        // region in this shared memory object from now on. Since resizing the
+        // buffer won't touch that region, this thread only needs to be started
+        // once.
+        instance.process_shm_handler = Win32Thread([&, instance_id]() {
+            set_realtime_priority(true);
+
+            const std::string thread_name =
+                "audio-shm-" + std::to_string(instance_id);
+            pthread_setname_np(pthread_self(), thread_name.c_str());
+
+            // Like on the plugin side, we'll reuse these objects to avoid
+            // allocations during audio processing. References to elements in
+            // `object_instances` are stable, and this instance will outlive
+            // this thread.
+            Vst3PluginInstance& instance = object_instances.at(instance_id);
+            SerializationBuffer<2048> buffer{};
+            YaAudioProcessor::Process request{};
+            while (instance.process_buffers->wait_for_request(
+                config.audio_spin_duration())) {
+                read_shm_object(*instance.process_buffers, request, buffer);
+                const YaAudioProcessor::ProcessResponse response =
+                    process_audio(request);
+
+                std::optional<uint32_t> response_size = write_shm_object(
+                    *instance.process_buffers, response, buffer);
+                if (!response_size) [[unlikely]] {
+                    // This would require the plugin to output tens of
+                    // thousands of events in a single processing cycle. If
+                    // that ever happens, then dropping those events is the
+                    // only thing we can do without blocking the audio thread.
+                    std::cerr << "WARNING: The plugin's output events did not "
+                                 "fit in the shared memory object, dropping "
+                                 "them"
+                              << std::endl;
+
+                    if (request.data.output_parameter_changes) {
+                        request.data.output_parameter_changes->clear();
+                    }
+                    if (request.data.output_events) {
+                        request.data.output_events->clear();
+                    }
+
+                    response_size = write_shm_object(*instance.process_buffers,
+                                                     response, buffer);
+                    assert(response_size);
+                }
+
+                instance.process_buffers->send_response(*response_size);
+            }
+        });
     } else {
         instance.process_buffers->resize(buffer_config);
     }
@@ -1356,9 +1459,64 @@ AudioShmBuffer::Config Vst3Bridge::setup_shared_audio_buffers(
             }
         });
 
+    // When the host processes a bus in place, we'll let the plugin do the same
+    // thing by pointing the output channels that also exist as input channels
+    // to those input channels. The native plugin only does this when the host
+    // provided all of those input channels, see `YaProcessData::repopulate()`.
+    set_bus_pointers(
+        instance.process_buffers_in_place_output_pointers,
+        instance.process_buffers->config.output_offsets,
+        [&](uint32_t bus, uint32_t channel) -> void* {
+            if (bus < instance.process_buffers_input_pointers.size() &&
+                channel < instance.process_buffers_input_pointers[bus].size()) {
+                return instance.process_buffers_input_pointers[bus][channel];
+            } else {
+                return instance.process_buffers_output_pointers[bus][channel];
+            }
+        });
+
     return buffer_config;
 }
 
+YaAudioProcessor::ProcessResponse Vst3Bridge::process_audio(
+    YaAudioProcessor::Process& request) {
+    // As suggested by Jack Winter, we'll synchronize this thread's audio
+    // processing priority with that of the host's audio thread every once in a
+    // while
+    if (request.new_realtime_priority) {
+        set_realtime_priority(true, *request.new_realtime_priority);
+    }
+
+    Vst3PluginInstance& instance = object_instances.at(request.instance_id);
+
+    // Most plugins will already enable FTZ, but there are a handful of plugins
+    // that don't that suffer from extreme DSP load increases when they start
+    // producing denormals
+    ScopedFlushToZero ftz_guard;
+
+    // The actual audio is stored in the shared memory buffers, so the
+    // reconstruction function will need to know where it should point the
+    // `AudioBusBuffers` to
+    Steinberg::Vst::ProcessData& reconstructed_data = request.data.reconstruct(
+        instance.process_buffers_input_pointers,
+        instance.process_buffers_output_pointers,
+        instance.process_buffers_in_place_output_pointers);
+
+    // The time spent in the plugin is returned for the native plugin's
+    // performance counters
+    const auto processing_start = std::chrono::steady_clock::now();
+    const tresult result =
+        instance.interfaces.audio_processor->process(reconstructed_data);
+    const auto processing_time =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - processing_start);
+
+    return YaAudioProcessor::ProcessResponse{
+        .result = result,
+        .output_data = request.data.create_response(),
+        .processing_time_ns = static_cast<uint64_t>(processing_time.count())};
+}
+
 size_t Vst3Bridge::register_object_instance(
     Steinberg::IPtr<Steinberg::FUnknown> object) {
     std::lock_guard lock(object_instances_mutex);
@@ -1475,35 +1633,10 @@ size_t Vst3Bridge::register_object_instance(
                         //       `bitsery::ext::MessageReference`)
                         YaAudioProcessor::Process& request = request_ref.get();
 
-                        // As suggested by Jack Winter, we'll synchronize this
-                        // thread's audio processing priority with that of the
-                        // host's audio thread every once in a while
-                        if (request.new_realtime_priority) {
-                            set_realtime_priority(
-                                true, *request.new_realtime_priority);
-                        }
-
-                        Vst3PluginInstance& instance =
-                            object_instances.at(request.instance_id);
-
-                        // Most plugins will already enable FTZ, but there are a
-                        // handful of plugins that don't that suffer from
-                        // extreme DSP load increases when they start producing
-                        // denormals
-                        ScopedFlushToZero ftz_guard;
-
-                        // The actual audio is stored in the shared memory
-                        // buffers, so the reconstruction function will need to
-                        // know where it should point the `AudioBusBuffers` to
-                        const tresult result =
-                            instance.interfaces.audio_processor->process(
-                                request.data.reconstruct(
-                                    instance.process_buffers_input_pointers,
-                                    instance.process_buffers_output_pointers));
-
-                        return YaAudioProcessor::ProcessResponse{
-                            .result = result,
-                            .output_data = request.data.create_response()};
+                        // Process requests are normally passed through the
+                        // control region in the instance's shared audio
+                        // buffers instead, see `setup_shared_audio_buffers()`
+                        return process_audio(request);
                     },
                     [&](const YaAudioProcessor::GetTailSamples& request)
                         -> YaAudioProcessor::GetTailSamples::Response {
@@ -1608,6 +1741,12 @@ size_t Vst3Bridge::register_object_instance(
 }
 
 void Vst3Bridge::unregister_object_instance(size_t instance_id) {
+    // The thread handling process requests through the shared memory object
+    // needs to be woken up before the instance can be destroyed
+    if (object_instances.at(instance_id).process_buffers) {
+        object_instances.at(instance_id).process_buffers->shutdown();
+    }
+
     // Tear the dedicated audio processing socket down again if we
     // created one while handling `Vst3PluginProxy::Construct`
     if (object_instances.at(instance_id).interfaces.audio_processor ||
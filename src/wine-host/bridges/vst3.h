@@ -194,6 +194,25 @@ struct Vst3PluginInstance {
      */
     std::vector<std::vector<void*>> process_buffers_output_pointers;
 
+    /**
+     * The same as `process_buffers_output_pointers`, but with the output
+     * channels that also exist on the input bus with the same index pointing
+     * to those input channels instead. These are used for busses the host
+     * processes in place.
+     *
+     * @see YaProcessData::in_place_outputs
+     */
+    std::vector<std::vector<void*>> process_buffers_in_place_output_pointers;
+
+    /**
+     * A dedicated thread that waits for process requests in `process_buffers`'s
+     * control region. Audio processing normally happens here instead of on
+     * `audio_processor_handler`, since that lets us avoid a socket round trip
+     * for every processing cycle. This is started after `process_buffers` has
+     * been set up for the first time.
+     */
+    Win32Thread process_shm_handler;
+
     /**
      * This instance's editor, if it has an open editor. Embedding here works
      * exactly the same as how it works for VST2 plugins.
@@ -431,6 +450,16 @@ class Vst3Bridge : public HostBridge {
      */
     size_t generate_instance_id() noexcept;
 
+    /**
+     * Call `IAudioProcessor::process()` on a plugin instance using the audio
+     * stored in that instance's shared memory audio buffers. This is called for
+     * requests received through either the shared memory object's control
+     * region or through the instance's audio processor socket. The response
+     * points to the output fields in `request`.
+     */
+    YaAudioProcessor::ProcessResponse process_audio(
+        YaAudioProcessor::Process& request);
+
     /**
      * Sets up the shared memory audio buffers for a plugin instance plugin
      * instance and return the configuration so the native plugin can connect to
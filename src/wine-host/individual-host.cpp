@@ -17,10 +17,17 @@
 #include <iostream>
 #include <thread>
 
+#include "boost-fix.h"
+
+#include <unistd.h>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/filesystem.hpp>
+
 // Generated inside of the build directory
 #include <config.h>
 #include <version.h>
 
+#include "../common/communication/common.h"
 #include "../common/utils.h"
 #include "bridges/vst2.h"
 #ifdef WITH_VST3
@@ -34,6 +41,118 @@ static const std::string host_name = "yabridge host version " +
 #endif
     ;
 
+using namespace std::literals::chrono_literals;
+
+/**
+ * The flag that turns this process into an idle host process for the host
+ * pool. See `PooledHost` on the plugin side.
+ */
+static const std::string pool_flag = "--pool";
+
+/**
+ * Listen on one of the host pool's slot sockets until a plugin sends us a
+ * `HostRequest`, and reply with this process's PID just like a group host
+ * process would. We stop listening on the socket and give up ownership of the
+ * slot before replying so the idle host process the plugin starts to replace
+ * us can immediately take over the slot. We'll also periodically check
+ * whether the process that spawned us is still running, so idle host processes
+ * don't stay around after the host has been closed.
+ *
+ * @param pool_socket_path The slot's socket endpoint, generated by
+ *   `generate_pool_endpoint()` on the plugin side.
+ * @param spawner_pid The process ID of the process that started this process.
+ *
+ * @return The request from the plugin, or `std::nullopt` if another process was
+ *   already listening on this slot or if the process that started us has
+ *   exited before we got used.
+ */
+static std::optional<HostRequest> wait_for_pool_request(
+    const std::string& pool_socket_path,
+    pid_t spawner_pid) {
+    boost::asio::io_context io_context;
+    boost::asio::local::stream_protocol::endpoint pool_socket_endpoint(
+        pool_socket_path);
+    std::optional<boost::asio::local::stream_protocol::acceptor> acceptor;
+    try {
+        acceptor.emplace(
+            create_acceptor_if_inactive(io_context, pool_socket_endpoint));
+    } catch (const boost::system::system_error&) {
+        // Just like with group host processes, the plugin that started this
+        // process may have been racing with another plugin
+        std::cerr << "Another process is already listening on this slot, "
+                     "shutting down"
+                  << std::endl;
+        return std::nullopt;
+    }
+
+    std::optional<HostRequest> request;
+    std::function<void()> accept_request = [&]() {
+        acceptor->async_accept(
+            [&](const boost::system::error_code& error,
+                boost::asio::local::stream_protocol::socket socket) {
+                // This happens when the watchdog below closes the acceptor
+                if (error.failed()) {
+                    io_context.stop();
+                    return;
+                }
+
+                // If two plugins try to claim this process at the same time,
+                // then the second connection gets dropped when we close the
+                // acceptor and that plugin will move on to the next slot
+                try {
+                    request = read_object<HostRequest>(socket);
+                } catch (const boost::system::system_error&) {
+                    accept_request();
+                    return;
+                }
+
+                // The plugin that claimed us will fill this slot again once
+                // we've given up ownership of it, see `PoolSlotLock`
+                acceptor->close();
+                boost::filesystem::remove(pool_socket_path);
+                try {
+                    PoolSlotLock(pool_socket_path).set_owner(std::nullopt);
+                } catch (const std::system_error& error) {
+                    std::cerr << "Could not release the pool slot: "
+                              << error.what() << std::endl;
+                }
+                try {
+                    write_object(socket, HostResponse{getpid()});
+                } catch (const boost::system::system_error&) {
+                    request.reset();
+                }
+
+                io_context.stop();
+            });
+    };
+
+    boost::asio::steady_timer spawner_watchdog(io_context);
+    std::function<void()> watch_spawner = [&]() {
+        spawner_watchdog.expires_after(1s);
+        spawner_watchdog.async_wait(
+            [&](const boost::system::error_code& error) {
+                if (error.failed()) {
+                    return;
+                }
+
+                if (pid_running(spawner_pid)) {
+                    watch_spawner();
+                } else {
+                    std::cerr << "The process that started this idle host "
+                                 "process has exited, shutting down"
+                              << std::endl;
+                    acceptor->close();
+                }
+            });
+    };
+
+    accept_request();
+    watch_spawner();
+    io_context.run();
+
+    return request;
+}
+
 /**
  * This is the default plugin host application. It will load the specified
  * plugin plugin, and then connect back to the `libyabridge-{vst2,vst3}.so`
@@ -47,8 +166,11 @@ __cdecl
     // We pass the plugin format, the name of the VST2 plugin .dll file or VST3
     // bundle to load, the base directory for the Unix domain socket endpoints
     // to connect to and the process ID of the process the native plugin is
-    // being hosted in as arguments for yabridge-host.exe
-    if (argc < 5) {
+    // being hosted in as arguments for yabridge-host.exe. When this process
+    // gets started as part of the host pool, it will instead receive these
+    // values from the plugin through a `HostRequest` after Wine has started.
+    const bool is_pool_host = argc >= 2 && argv[1] == pool_flag;
+    if ((is_pool_host && argc < 4) || (!is_pool_host && argc < 5)) {
         std::cerr << host_name << std::endl;
         std::cerr << "Usage: "
 #ifdef __i386__
@@ -59,25 +181,60 @@ __cdecl
                   << " <plugin_type> <plugin_location> "
                      "<endpoint_base_directory> <parent_pid>"
                   << std::endl;
+        std::cerr << "       "
+#ifdef __i386__
+                  << yabridge_individual_host_name_32bit
+#else
+                  << yabridge_individual_host_name
+#endif
+                  << " " << pool_flag << " <unix_domain_socket> <spawner_pid>"
+                  << std::endl;
 
         return 1;
     }
 
-    const std::string plugin_type_str(argv[1]);
-    const PluginType plugin_type = plugin_type_from_string(plugin_type_str);
-    const std::string plugin_location(argv[2]);
-    const std::string socket_endpoint_path(argv[3]);
-    const pid_t parent_pid = std::stoi(argv[4]);
-
     std::cerr << "Initializing " << host_name << std::endl;
-    std::cerr << "Preparing to load " << plugin_type_to_string(plugin_type)
-              << " plugin at '" << plugin_location << "'" << std::endl;
 
     // NOTE: Some plugins use Microsoft COM, but don't initialize it first and
     //       just pray the host does it for them. Examples of this are
     //       PSPaudioware's InfiniStrip and Shattered Glass Audio Code Red Free.
     OleInitialize(nullptr);
 
+    std::string plugin_type_str;
+    HostRequest request;
+    if (is_pool_host) {
+        const std::string pool_socket_path(argv[2]);
+        const pid_t spawner_pid = std::stoi(argv[3]);
+
+        std::cerr << "Waiting for a plugin to host on '" << pool_socket_path
+                  << "'" << std::endl;
+        if (const auto pool_request =
+                wait_for_pool_request(pool_socket_path, spawner_pid)) {
+            request = *pool_request;
+            plugin_type_str = plugin_type_to_string(request.plugin_type);
+        } else {
+            // See below
+            TerminateProcess(GetCurrentProcess(), 0);
+
+            return 0;
+        }
+    } else {
+        plugin_type_str = argv[1];
+        request = HostRequest{
+            .plugin_type = plugin_type_from_string(plugin_type_str),
+            .plugin_path = argv[2],
+            .endpoint_base_dir = argv[3],
+            .parent_pid = std::stoi(argv[4])};
+    }
+
+    const PluginType plugin_type = request.plugin_type;
+    const std::string& plugin_location = request.plugin_path;
+    const std::string& socket_endpoint_path = request.endpoint_base_dir;
+    const pid_t parent_pid = request.parent_pid;
+
+    std::cerr << "Preparing to load " << plugin_type_to_string(plugin_type)
+              << " plugin at '" << plugin_location << "'" << std::endl;
+
     // As explained in `Vst2Bridge`, the plugin has to be initialized in the
     // same thread as the one that calls `io_context.run()`. This setup is
     // slightly more convoluted than it has to be, but doing it this way we
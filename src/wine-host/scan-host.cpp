@@ -0,0 +1,376 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+
+#include "boost-fix.h"
+
+#include <vestige/aeffectx.h>
+#include <windows.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+
+#ifdef WITH_VST3
+#include <public.sdk/source/vst/hosting/module.h>
+#endif
+
+// Generated inside of the build directory
+#include <config.h>
+#include <version.h>
+
+#include "../common/metadata-cache.h"
+#include "../common/serialization/vst2.h"
+#ifdef WITH_VST3
+#include "../common/serialization/vst3/plugin-factory-proxy.h"
+#endif
+
+namespace fs = boost::filesystem;
+
+static const std::string host_name = "yabridge scanner version " +
+                                     std::string(yabridge_git_version)
+#ifdef __i386__
+                                     + " (32-bit compatibility mode)"
+#endif
+    ;
+
+/**
+ * Every line this process prints to STDOUT that starts with this prefix is the
+ * result for a scan job. Plugins are free to print whatever they want to
+ * STDOUT, so yabridgectl ignores all other lines.
+ */
+constexpr char scan_result_prefix[] = "yabridge-scan-result";
+
+/**
+ * A function pointer to what should be the entry point of a VST plugin.
+ */
+using VstEntryPoint = AEffect*(VST_CALL_CONV*)(audioMasterCallback);
+
+/**
+ * The dispatcher calls hosts commonly make while scanning a VST2 plugin,
+ * besides `effCanDo()`. The results are stored as `Vst2PluginMetadata::Query`s.
+ * Anything else the host asks for will be recorded by the plugin library the
+ * first time the host actually starts the plugin.
+ */
+constexpr int scanned_opcodes[] = {effGetEffectName,    effGetVendorString,
+                                   effGetProductString, effGetVendorVersion,
+                                   effGetPlugCategory,  effGetVstVersion};
+
+/**
+ * The `effCanDo()` queries hosts commonly make while scanning a VST2 plugin.
+ */
+constexpr const char* scanned_can_do_queries[] = {
+    "receiveVstEvents", "receiveVstMidiEvent", "receiveVstTimeInfo",
+    "sendVstEvents",    "sendVstMidiEvent",    "offline",
+    "midiProgramNames", "bypass",              "MPE"};
+
+/**
+ * Set when the plugin calls `audioMasterCurrentId()` while it's being scanned.
+ * That means that this is a shell plugin, and the plugin library never caches
+ * metadata for those since what's inside of the shell depends on the host.
+ */
+static bool is_shell_plugin = false;
+
+/**
+ * The outcome of a single scan job, printed back to yabridgectl.
+ */
+enum class ScanStatus { scanned, cached, skipped };
+
+static intptr_t VST_CALL_CONV scan_host_callback(AEffect* /*effect*/,
+                                                 int opcode,
+                                                 int /*index*/,
+                                                 intptr_t /*value*/,
+                                                 void* /*data*/,
+                                                 float /*option*/) {
+    switch (opcode) {
+        case audioMasterVersion:
+            return 2400;
+            break;
+        case audioMasterCurrentId:
+            is_shell_plugin = true;
+            return 0;
+            break;
+        default:
+            return 0;
+            break;
+    }
+}
+
+/**
+ * Load a VST2 plugin, open it, and record the information the plugin library
+ * needs to answer a host's scanning queries. This follows the same steps as
+ * `Vst2Bridge`'s constructor, minus all of the socket setup.
+ *
+ * @return The plugin's metadata, or an `std::nullopt` if this turned out to be
+ *   a shell plugin.
+ *
+ * @throw std::runtime_error If the plugin could not be loaded.
+ */
+static std::optional<Vst2PluginMetadata> scan_vst2_plugin(
+    const fs::path& plugin_path) {
+    const std::unique_ptr<std::remove_pointer_t<HMODULE>,
+                          decltype(&FreeLibrary)>
+        plugin_handle(LoadLibrary(plugin_path.string().c_str()), FreeLibrary);
+    if (!plugin_handle) {
+        throw std::runtime_error("Could not load the Windows .dll file at '" +
+                                 plugin_path.string() + "'");
+    }
+
+    // VST plugin entry point functions should be called `VSTPluginMain`, but
+    // pre-VST2.4 `main` was also a valid name
+    VstEntryPoint vst_entry_point = nullptr;
+    for (auto name : {"VSTPluginMain", "main"}) {
+        vst_entry_point =
+            reinterpret_cast<VstEntryPoint>(reinterpret_cast<size_t>(
+                GetProcAddress(plugin_handle.get(), name)));
+
+        if (vst_entry_point) {
+            break;
+        }
+    }
+    if (!vst_entry_point) {
+        throw std::runtime_error(
+            "Could not find a valid VST entry point for '" +
+            plugin_path.string() + "'.");
+    }
+
+    is_shell_plugin = false;
+    AEffect* plugin = vst_entry_point(
+        reinterpret_cast<audioMasterCallback>(scan_host_callback));
+    if (!plugin) {
+        throw std::runtime_error("VST plugin at '" + plugin_path.string() +
+                                 "' failed to initialize.");
+    }
+
+    Vst2PluginMetadata metadata{};
+    metadata.initialized_plugin = *plugin;
+
+    plugin->dispatcher(plugin, effOpen, 0, 0, nullptr, 0.0);
+    metadata.opened_plugin = *plugin;
+
+    // Plugins should never write more than this to the string buffers, and
+    // `Vst2Bridge` uses the same limit
+    std::array<char, max_string_length> string_buffer;
+    for (const int opcode : scanned_opcodes) {
+        string_buffer.fill(0);
+        const intptr_t return_value = plugin->dispatcher(
+            plugin, opcode, 0, 0, string_buffer.data(), 0.0);
+
+        const bool returns_string = opcode == effGetEffectName ||
+                                    opcode == effGetVendorString ||
+                                    opcode == effGetProductString;
+        metadata.queries.push_back(Vst2PluginMetadata::Query{
+            .opcode = opcode,
+            .index = 0,
+            .query = "",
+            .return_value = return_value,
+            .result = returns_string
+                          ? std::string(string_buffer.data(),
+                                        strnlen(string_buffer.data(),
+                                                string_buffer.size() - 1))
+                          : std::string()});
+    }
+    for (const char* query : scanned_can_do_queries) {
+        const intptr_t return_value = plugin->dispatcher(
+            plugin, effCanDo, 0, 0, const_cast<char*>(query), 0.0);
+
+        metadata.queries.push_back(
+            Vst2PluginMetadata::Query{.opcode = effCanDo,
+                                      .index = 0,
+                                      .query = query,
+                                      .return_value = return_value,
+                                      .result = ""});
+    }
+
+    plugin->dispatcher(plugin, effClose, 0, 0, nullptr, 0.0);
+
+    if (is_shell_plugin) {
+        return std::nullopt;
+    } else {
+        return metadata;
+    }
+}
+
+#ifdef WITH_VST3
+/**
+ * Load a VST3 module and read its plugin factory. This is all the VST3 plugin
+ * library caches.
+ *
+ * @throw std::runtime_error If the module could not be loaded.
+ */
+static Vst3PluginFactoryProxy::ConstructArgs scan_vst3_plugin(
+    const fs::path& plugin_path) {
+    std::string error;
+    const VST3::Hosting::Module::Ptr module =
+        VST3::Hosting::Module::create(plugin_path.string(), error);
+    if (!module) {
+        throw std::runtime_error("Could not load the VST3 module for '" +
+                                 plugin_path.string() + "': " + error);
+    }
+
+    return Vst3PluginFactoryProxy::ConstructArgs(module->getFactory().get());
+}
+#endif
+
+/**
+ * Scan a single plugin and write the results to the plugin metadata cache.
+ * Plugins that already have an up to date cache entry are skipped.
+ *
+ * @param plugin_type The type of the plugin.
+ * @param library_path The path to the plugin's `.dll` or `.vst3` library file.
+ *   This does not need to be canonicalized.
+ *
+ * @throw std::runtime_error If the plugin could not be scanned.
+ */
+static ScanStatus scan_plugin(PluginType plugin_type,
+                              const fs::path& library_path,
+                              Logger& logger) {
+    // These need to match the paths the plugin library uses in `PluginInfo`,
+    // since those are part of the cache key
+    const fs::path windows_library_path = fs::canonical(library_path);
+    const fs::path windows_plugin_path =
+        normalize_plugin_path(windows_library_path, plugin_type);
+
+    const PluginMetadataCache metadata_cache(
+        plugin_type, windows_plugin_path, windows_library_path);
+    if (!metadata_cache.enabled()) {
+        throw std::runtime_error("Could not read '" +
+                                 windows_library_path.string() + "'");
+    }
+    if (metadata_cache.contains_entry()) {
+        return ScanStatus::cached;
+    }
+
+    switch (plugin_type) {
+        case PluginType::vst2: {
+            const std::optional<Vst2PluginMetadata> metadata =
+                scan_vst2_plugin(windows_plugin_path);
+            if (!metadata) {
+                return ScanStatus::skipped;
+            }
+
+            metadata_cache.store(*metadata, logger);
+        } break;
+        case PluginType::vst3:
+#ifdef WITH_VST3
+            metadata_cache.store(scan_vst3_plugin(windows_plugin_path),
+                                 logger);
+#else
+            throw std::runtime_error(
+                "This version of yabridge has not been compiled with VST3 "
+                "support");
+#endif
+            break;
+        default:
+            throw std::runtime_error("Unknown plugin type");
+            break;
+    }
+
+    // Writing the cache file never throws, so we'll check whether it actually
+    // ended up on disk
+    if (!metadata_cache.contains_entry()) {
+        throw std::runtime_error("Could not write the plugin metadata cache");
+    }
+
+    return ScanStatus::scanned;
+}
+
+/**
+ * A Wine host application that scans plugins ahead of time and writes their
+ * metadata to the same cache the `cache_plugin_metadata` option reads from.
+ * This is started by `yabridgectl sync --scan`. Instead of paying for Wine's
+ * startup for every plugin, yabridgectl keeps a pool of these processes alive
+ * per Wine prefix and feeds them plugins over STDIN, one per line in the
+ * format `<plugin_type>\t<library_path>`. For every job this prints a single
+ * line in the format `yabridge-scan-result\t<status>\t<message>` to STDOUT,
+ * where the status is one of `scanned`, `cached`, `skipped` or `failed`.
+ *
+ * If a plugin crashes this process, then yabridgectl will mark that plugin as
+ * failed and start a new process for the remaining plugins.
+ */
+int __attribute__((visibility("default")))
+#ifdef WINE_USE_CDECL
+__cdecl
+#endif
+    main(int argc, char* argv[]) {
+    if (argc > 1) {
+        std::cerr << host_name << std::endl;
+        std::cerr << "Usage: "
+#ifdef __i386__
+                  << yabridge_scan_host_name_32bit
+#else
+                  << yabridge_scan_host_name
+#endif
+                  << " < <scan_jobs>" << std::endl;
+
+        return 1;
+    }
+
+    std::cerr << "Initializing " << host_name << std::endl;
+
+    // NOTE: Some plugins use Microsoft COM, but don't initialize it first and
+    //       just pray the host does it for them. See `individual-host.cpp`.
+    OleInitialize(nullptr);
+
+    Logger logger = Logger::create_wine_stderr();
+
+    std::string job;
+    while (std::getline(std::cin, job)) {
+        const size_t separator = job.find('\t');
+        const std::string plugin_type_str = job.substr(0, separator);
+        const std::string library_path =
+            separator == std::string::npos ? "" : job.substr(separator + 1);
+
+        std::string status;
+        std::string message;
+        try {
+            const PluginType plugin_type =
+                plugin_type_from_string(plugin_type_str);
+            if (plugin_type == PluginType::unknown) {
+                throw std::runtime_error("Unknown plugin type '" +
+                                         plugin_type_str + "'");
+            }
+
+            switch (scan_plugin(plugin_type, library_path, logger)) {
+                case ScanStatus::scanned:
+                    status = "scanned";
+                    break;
+                case ScanStatus::cached:
+                    status = "cached";
+                    break;
+                case ScanStatus::skipped:
+                    status = "skipped";
+                    message = "Shell plugins cannot be cached";
+                    break;
+            }
+        } catch (const std::exception& error) {
+            status = "failed";
+            message = error.what();
+            std::replace(message.begin(), message.end(), '\n', ' ');
+        }
+
+        std::cout << scan_result_prefix << '\t' << status << '\t' << message
+                  << std::endl;
+    }
+
+    // Just like in `individual-host.cpp`, some plugins leave behind threads
+    // that would otherwise prevent this process from exiting
+    TerminateProcess(GetCurrentProcess(), 0);
+}
@@ -16,8 +16,13 @@
 
 #include "utils.h"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <fstream>
 #include <iostream>
 
+#include <boost/filesystem.hpp>
+
 #include "bridges/common.h"
 
 using namespace std::literals::chrono_literals;
@@ -183,3 +188,74 @@ void MainContext::async_handle_watchdog_timer(
         async_handle_watchdog_timer(30s);
     });
 }
+
+boost::asio::local::stream_protocol::acceptor create_acceptor_if_inactive(
+    boost::asio::io_context& io_context,
+    boost::asio::local::stream_protocol::endpoint& endpoint) {
+    // First try to listen on the endpoint normally
+    try {
+        return boost::asio::local::stream_protocol::acceptor(io_context,
+                                                             endpoint);
+    } catch (const boost::system::system_error&) {
+        // If this failed, then either there is a stale socket file or another
+        // process is already is already listening. In the last case we will
+        // simply throw so the other process can handle the request.
+        std::ifstream open_sockets("/proc/net/unix");
+        std::string endpoint_path = endpoint.path();
+        for (std::string line; std::getline(open_sockets, line);) {
+            if (line.size() < endpoint_path.size()) {
+                continue;
+            }
+
+            std::string file = line.substr(line.size() - endpoint_path.size());
+            if (file == endpoint_path) {
+                // Another process is already listening, so we don't have to do
+                // anything
+                throw;
+            }
+        }
+
+        // At this point we can remove the stale socket and start listening
+        boost::filesystem::remove(endpoint_path);
+        return boost::asio::local::stream_protocol::acceptor(io_context,
+                                                             endpoint);
+    }
+}
+
+void prefetch_plugin_files(const std::string& plugin_path) noexcept {
+    const auto prefetch_file = [](const boost::filesystem::path& path) {
+        const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) {
+            return;
+        }
+
+        // This blocks until the file has been read into the page cache
+        struct stat stat_buffer;
+        if (fstat(fd, &stat_buffer) == 0) {
+            readahead(fd, 0, stat_buffer.st_size);
+        }
+
+        close(fd);
+    };
+
+    boost::system::error_code error;
+    if (!boost::filesystem::is_directory(plugin_path, error)) {
+        prefetch_file(plugin_path);
+        return;
+    }
+
+    const boost::filesystem::path module_dir =
+        boost::filesystem::path(plugin_path) / "Contents" /
+#ifdef __i386__
+        "x86-win";
+#else
+        "x86_64-win";
+#endif
+    for (boost::filesystem::directory_iterator it(module_dir, error);
+         !error && it != boost::filesystem::directory_iterator();
+         it.increment(error)) {
+        if (boost::filesystem::is_regular_file(it->status())) {
+            prefetch_file(it->path());
+        }
+    }
+}
@@ -26,6 +26,7 @@
 #include <windows.h>
 #include <boost/asio/dispatch.hpp>
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
 #include <function2/function2.hpp>
 
 #include "../common/utils.h"
@@ -373,3 +374,36 @@ class MainContext {
      */
     Win32Thread watchdog_handler;
 };
+
+/**
+ * Listen on the specified endpoint if no process is already listening there,
+ * otherwise throw. This is needed to handle these three situations:
+ *
+ * 1. The endpoint does not already exist, and we can simply create an endpoint.
+ * 2. The endpoint already exists but it is stale and no process is currently
+ *    listening. In this case we can remove the file and start listening.
+ * 3. The endpoint already exists and another process is currently listening on
+ *    it. In this situation we will throw immediately and we'll terminate this
+ *    process.
+ *
+ * If anyone knows a better way to handle this, please let me know!
+ *
+ * @throw std::runtime_error If another process is already listening on the
+ *        endpoint.
+ */
+boost::asio::local::stream_protocol::acceptor create_acceptor_if_inactive(
+    boost::asio::io_context& io_context,
+    boost::asio::local::stream_protocol::endpoint& endpoint);
+
+/**
+ * Read a plugin's library into the page cache so the `LoadLibrary()` call that
+ * later happens on the main thread doesn't have to wait for the disk. For VST3
+ * bundles this reads all files in the bundle's `Contents/x86_64-win` (or
+ * `Contents/x86-win` for the 32-bit host) directory. This is used by group host
+ * processes so the libraries for multiple plugins can be read in parallel.
+ * Errors are ignored since this is only an optimization.
+ *
+ * @param plugin_path The path to the plugin's `.dll` file, or to the VST3
+ *   module or bundle, as passed through `HostRequest::plugin_path`.
+ */
+void prefetch_plugin_files(const std::string& plugin_path) noexcept;
@@ -24,7 +24,8 @@ use std::path::{Path, PathBuf};
 use walkdir::WalkDir;
 
 use crate::config::{yabridge_vst3_home, Config, InstallationMethod, YabridgeFiles};
-use crate::files::{self, NativeFile, Plugin, Vst2Plugin};
+use crate::files::{self, LibArchitecture, NativeFile, Plugin, Vst2Plugin};
+use crate::scan::{self, ScanJob, ScanResult};
 use crate::utils::{self, get_file_type};
 use crate::utils::{verify_path_setup, verify_wine_setup};
 
@@ -218,6 +219,7 @@ pub struct SyncOptions {
     pub force: bool,
     pub no_verify: bool,
     pub prune: bool,
+    pub scan: bool,
     pub verbose: bool,
 }
 
@@ -269,6 +271,11 @@ pub fn do_sync(config: &mut Config, options: &SyncOptions) -> Result<()> {
     // during the syncing process, so we'll keep track of which VST3 files we touched per-bundle. We
     // can then at the end remove all unkonwn bundles, and all unkonwn files within a bundle.
     let mut known_vst3_files: HashMap<PathBuf, HashSet<PathBuf>> = HashMap::new();
+    // The plugins we'll scan with `yabridge-scan.exe` when the scan option is set. VST3 plugins are
+    // indexed by their bundle since yabridge will only load one module from a bundle. Just like
+    // yabridge, we'll prefer the 64-bit version if both are available.
+    let mut vst2_scan_jobs: Vec<ScanJob> = Vec::new();
+    let mut vst3_scan_jobs: HashMap<PathBuf, ScanJob> = HashMap::new();
     for (path, search_results) in results {
         orphan_files.extend(search_results.vst2_orphans().into_iter().cloned());
         skipped_dll_files.extend(search_results.skipped_files);
@@ -284,7 +291,8 @@ pub fn do_sync(config: &mut Config, options: &SyncOptions) -> Result<()> {
             let plugin_path: PathBuf = match plugin {
                 // We'll set up the copies or symlinks for VST2 plugins
                 Plugin::Vst2(Vst2Plugin {
-                    path: plugin_path, ..
+                    path: plugin_path,
+                    architecture,
                 }) => {
                     let target_path = plugin_path.with_extension("so");
                     let normalized_target_path = if config.method == InstallationMethod::Symlink {
@@ -307,6 +315,11 @@ pub fn do_sync(config: &mut Config, options: &SyncOptions) -> Result<()> {
                         new_plugins.insert(normalized_target_path.clone());
                     }
                     managed_plugins.insert(normalized_target_path);
+                    vst2_scan_jobs.push(ScanJob {
+                        plugin_type: "VST2",
+                        library_path: plugin_path.clone(),
+                        architecture,
+                    });
 
                     plugin_path.clone()
                 }
@@ -402,6 +415,18 @@ pub fn do_sync(config: &mut Config, options: &SyncOptions) -> Result<()> {
                         managed_vst3_bundle_files.insert(target_resources_dir);
                     }
 
+                    let scan_job = vst3_scan_jobs
+                        .entry(target_bundle_home)
+                        .or_insert_with(|| ScanJob {
+                            plugin_type: "VST3",
+                            library_path: module.original_module_path(),
+                            architecture: module.architecture,
+                        });
+                    if module.architecture == LibArchitecture::Lib64 {
+                        scan_job.library_path = module.original_module_path();
+                        scan_job.architecture = module.architecture;
+                    }
+
                     module.original_path().to_path_buf()
                 }
             };
@@ -526,6 +551,14 @@ pub fn do_sync(config: &mut Config, options: &SyncOptions) -> Result<()> {
         num_skipped_files
     );
 
+    if options.scan {
+        let scan_jobs: Vec<ScanJob> = vst2_scan_jobs
+            .into_iter()
+            .chain(vst3_scan_jobs.into_iter().map(|(_, job)| job))
+            .collect();
+        scan_plugins(&files, scan_jobs, options.verbose);
+    }
+
     // Skipping the post-installation seting checks can be done only for this invocation of
     // `yabridgectl sync`, or it can be skipped permanently through a config file option
     if options.no_verify || config.no_verify {
@@ -544,6 +577,50 @@ pub fn do_sync(config: &mut Config, options: &SyncOptions) -> Result<()> {
     Ok(())
 }
 
+/// Scan plugins using `yabridge-scan.exe` as part of `yabridgectl sync --scan`, and print a summary
+/// of the results. Plugins that could not be scanned are always listed.
+fn scan_plugins(files: &YabridgeFiles, jobs: Vec<ScanJob>, verbose: bool) {
+    println!("\nScanning {} plugins...", jobs.len());
+
+    let mut num_scanned = 0;
+    let mut num_cached = 0;
+    let mut num_skipped = 0;
+    let mut failed_plugins: Vec<(PathBuf, String)> = Vec::new();
+    for (job, result) in scan::scan_plugins(files, jobs) {
+        match result {
+            ScanResult::Scanned => {
+                num_scanned += 1;
+                if verbose {
+                    println!("- {}", job.library_path.display());
+                }
+            }
+            ScanResult::Cached => num_cached += 1,
+            ScanResult::Skipped(reason) => {
+                num_skipped += 1;
+                if verbose {
+                    println!("- {} (skipped: {})", job.library_path.display(), reason);
+                }
+            }
+            ScanResult::Failed(reason) => failed_plugins.push((job.library_path, reason)),
+        }
+    }
+
+    if !failed_plugins.is_empty() {
+        println!("Could not scan {} plugins:", failed_plugins.len());
+        for (path, reason) in &failed_plugins {
+            println!("- {}: {}", path.display(), reason);
+        }
+    }
+
+    println!(
+        "Finished scanning plugins, {} new, {} already cached, {} skipped, {} failed",
+        num_scanned,
+        num_cached,
+        num_skipped,
+        failed_plugins.len()
+    );
+}
+
 /// Create a copy or symlink of `from` to `to`. Depending on `force`, we might not actually create a
 /// new copy or symlink if `to` matches `from_hash`.
 fn install_file(
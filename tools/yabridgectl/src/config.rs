@@ -46,6 +46,10 @@ pub const YABRIDGE_HOST_EXE_NAME: &str = "yabridge-host.exe";
 /// `WINEARCH=win32` set, then it won't be possible to run the 64-bit `yabridge-host.exe` in there.
 /// In that case we'll just run the 32-bit version isntead, if it exists.
 pub const YABRIDGE_HOST_32_EXE_NAME: &str = "yabridge-host-32.exe";
+/// The name of the plugin scanner used by `yabridgectl sync --scan`.
+pub const YABRIDGE_SCAN_EXE_NAME: &str = "yabridge-scan.exe";
+/// The 32-bit verison of `YABRIDGE_SCAN_EXE_NAME`, used to scan 32-bit plugins.
+pub const YABRIDGE_SCAN_32_EXE_NAME: &str = "yabridge-scan-32.exe";
 /// The name of the XDG base directory prefix for yabridge's own files, relative to
 /// `$XDG_CONFIG_HOME` and `$XDG_DATA_HOME`.
 const YABRIDGE_PREFIX: &str = "yabridge";
@@ -162,6 +166,10 @@ pub struct YabridgeFiles {
     /// The same as `yabridge_host_exe_so`, but for the 32-bit verison. We will hash this instead of
     /// there's no 64-bit version available.
     pub yabridge_host_32_exe_so: Option<PathBuf>,
+    /// The path to `yabridge-scan.exe`, used to scan 64-bit plugins ahead of time.
+    pub yabridge_scan_exe: Option<PathBuf>,
+    /// The same as `yabridge_scan_exe`, but for the 32-bit version.
+    pub yabridge_scan_32_exe: Option<PathBuf>,
 }
 
 impl Default for Config {
@@ -296,6 +304,8 @@ impl Config {
         let yabridge_host_32_exe_so = yabridge_host_32_exe
             .as_ref()
             .map(|path| path.with_extension("exe.so"));
+        let yabridge_scan_exe = which(YABRIDGE_SCAN_EXE_NAME).ok();
+        let yabridge_scan_32_exe = which(YABRIDGE_SCAN_32_EXE_NAME).ok();
 
         Ok(YabridgeFiles {
             libyabridge_vst2,
@@ -304,6 +314,8 @@ impl Config {
             yabridge_host_exe_so,
             yabridge_host_32_exe,
             yabridge_host_32_exe_so,
+            yabridge_scan_exe,
+            yabridge_scan_32_exe,
         })
     }
 
@@ -26,6 +26,7 @@ use crate::config::Config;
 mod actions;
 mod config;
 mod files;
+mod scan;
 mod utils;
 
 fn main() -> Result<()> {
@@ -110,6 +111,20 @@ fn main() -> Result<()> {
                         .long("prune")
                         .about("Remove unrelated or leftover .so files"),
                 )
+                .arg(
+                    Arg::new("scan")
+                        .short('s')
+                        .long("scan")
+                        .about("Scan plugins ahead of time for the plugin metadata cache")
+                        .long_about(
+                            "Scan plugins ahead of time for the plugin metadata cache. This uses \
+                             a pool of 'yabridge-scan.exe' processes to load many plugins in \
+                             parallel, and it only scans plugins that have been added or updated \
+                             since the last scan. Hosts can then scan plugins without having to \
+                             start Wine when the 'cache_plugin_metadata' option is enabled in \
+                             'yabridge.toml'.",
+                        ),
+                )
                 .arg(
                     Arg::new("verbose")
                         .short('v')
@@ -256,6 +271,7 @@ fn main() -> Result<()> {
                 force: options.is_present("force"),
                 no_verify: options.is_present("no-verify"),
                 prune: options.is_present("prune"),
+                scan: options.is_present("scan"),
                 verbose: options.is_present("verbose"),
             },
         ),
@@ -0,0 +1,271 @@
+// yabridge: a Wine VST bridge
+// Copyright (C) 2020-2021 Robbert van der Helm
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+//! Scanning plugins ahead of time with `yabridge-scan.exe` so yabridge's plugin metadata cache
+//! is already populated by the time the host scans the plugins.
+
+use anyhow::{anyhow, Context, Result};
+use std::collections::BTreeMap;
+use std::env;
+use std::io::{BufRead, BufReader, Write};
+use std::path::{Path, PathBuf};
+use std::process::{Child, ChildStdin, Command, Stdio};
+use std::sync::mpsc::{self, Receiver};
+use std::sync::Mutex;
+use std::thread;
+use std::time::Duration;
+
+use crate::config::{YabridgeFiles, YABRIDGE_SCAN_32_EXE_NAME, YABRIDGE_SCAN_EXE_NAME};
+use crate::files::LibArchitecture;
+
+/// Every line `yabridge-scan.exe` prints to STDOUT that starts with this prefix contains the result
+/// for a single plugin. Any other output was printed by the plugins themselves.
+const SCAN_RESULT_PREFIX: &str = "yabridge-scan-result";
+
+/// How long we'll wait for a single plugin before giving up on it. Some plugins show a dialog
+/// during initialization, and those would otherwise block the scan forever.
+const SCAN_TIMEOUT: Duration = Duration::from_secs(60);
+
+/// A plugin that should be scanned.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct ScanJob {
+    /// Either `VST2` or `VST3`. These are the same strings `plugin_type_from_string()` in
+    /// `src/common/plugins.cpp` parses.
+    pub plugin_type: &'static str,
+    /// The path to the plugin's `.dll` or `.vst3` library file. For VST 3.6.10 bundles this is the
+    /// module inside of the bundle.
+    pub library_path: PathBuf,
+    /// The architecture of the plugin, which determines which version of `yabridge-scan.exe` we
+    /// need to use.
+    pub architecture: LibArchitecture,
+}
+
+/// The result of scanning a single plugin.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub enum ScanResult {
+    /// The plugin's metadata has been written to the cache.
+    Scanned,
+    /// The cache already contained an entry for this version of the plugin.
+    Cached,
+    /// The plugin was loaded, but its metadata cannot be cached. This happens for shell plugins.
+    Skipped(String),
+    /// The plugin could not be scanned.
+    Failed(String),
+}
+
+/// A `yabridge-scan.exe` process that's kept alive to scan multiple plugins, so we only have to
+/// pay for Wine's startup once per process instead of once per plugin.
+struct ScanWorker {
+    process: Child,
+    stdin: ChildStdin,
+    /// The status and message parsed from every result line. These are read on a separate thread
+    /// so we can time out plugins that hang.
+    results: Receiver<(String, String)>,
+}
+
+impl ScanWorker {
+    /// Start a new scanner process inside of a Wine prefix. If `wine_prefix` is `None`, then the
+    /// prefix will be determined by `WINEPREFIX` or Wine's default.
+    fn spawn(scanner: &Path, wine_prefix: Option<&Path>) -> Result<ScanWorker> {
+        let mut command = Command::new(scanner);
+        command
+            .stdin(Stdio::piped())
+            .stdout(Stdio::piped())
+            .stderr(Stdio::null());
+        if let Some(wine_prefix) = wine_prefix {
+            command.env("WINEPREFIX", wine_prefix);
+        }
+
+        let mut process = command
+            .spawn()
+            .with_context(|| format!("Could not run '{}'", scanner.display()))?;
+        let stdin = process.stdin.take().unwrap();
+        let stdout = process.stdout.take().unwrap();
+
+        let (sender, results) = mpsc::channel();
+        thread::spawn(move || {
+            // Plugins can print anything to STDOUT, including invalid UTF-8
+            let mut reader = BufReader::new(stdout);
+            let mut line = Vec::new();
+            loop {
+                line.clear();
+                match reader.read_until(b'\n', &mut line) {
+                    Ok(0) | Err(_) => break,
+                    Ok(_) => (),
+                }
+
+                let line = String::from_utf8_lossy(&line);
+                let result = line
+                    .trim_end_matches(&['\r', '\n'][..])
+                    .strip_prefix(SCAN_RESULT_PREFIX)
+                    .and_then(|result| result.strip_prefix('\t'));
+                if let Some(result) = result {
+                    let mut fields = result.splitn(2, '\t');
+                    let status = fields.next().unwrap_or_default().to_owned();
+                    let message = fields.next().unwrap_or_default().to_owned();
+                    if sender.send((status, message)).is_err() {
+                        break;
+                    }
+                }
+            }
+        });
+
+        Ok(ScanWorker {
+            process,
+            stdin,
+            results,
+        })
+    }
+
+    /// Scan a single plugin. Returns `None` if the process crashed or if the plugin timed out, in
+    /// which case this worker should no longer be used.
+    fn scan(&mut self, job: &ScanJob) -> Option<ScanResult> {
+        writeln!(
+            self.stdin,
+            "{}\t{}",
+            job.plugin_type,
+            job.library_path.display()
+        )
+        .ok()?;
+        self.stdin.flush().ok()?;
+
+        let (status, message) = self.results.recv_timeout(SCAN_TIMEOUT).ok()?;
+        Some(match status.as_str() {
+            "scanned" => ScanResult::Scanned,
+            "cached" => ScanResult::Cached,
+            "skipped" => ScanResult::Skipped(message),
+            _ => ScanResult::Failed(message),
+        })
+    }
+}
+
+impl Drop for ScanWorker {
+    fn drop(&mut self) {
+        // The process exits by itself once STDIN gets closed, but it may also be stuck on a plugin
+        let _ = self.process.kill();
+        let _ = self.process.wait();
+    }
+}
+
+/// Scan all plugins in `jobs` and write their metadata to yabridge's plugin metadata cache.
+/// Plugins are grouped by Wine prefix and architecture, and every group is scanned by a pool of
+/// `yabridge-scan.exe` processes running in parallel. Each of those processes scans plugins until
+/// the group is done, so Wine only has to start up once per process. Plugins that crash the scanner
+/// are marked as failed, after which a new process is started for the remaining plugins.
+pub fn scan_plugins(files: &YabridgeFiles, jobs: Vec<ScanJob>) -> Vec<(ScanJob, ScanResult)> {
+    let mut groups: BTreeMap<(Option<PathBuf>, LibArchitecture), Vec<ScanJob>> = BTreeMap::new();
+    for job in jobs {
+        groups
+            .entry((find_wine_prefix(&job.library_path), job.architecture))
+            .or_default()
+            .push(job);
+    }
+
+    let results: Mutex<Vec<(ScanJob, ScanResult)>> = Mutex::new(Vec::new());
+    for ((wine_prefix, architecture), jobs) in groups {
+        let scanner = match architecture {
+            LibArchitecture::Lib64 => files
+                .yabridge_scan_exe
+                .as_ref()
+                .ok_or_else(|| anyhow!("Could not find '{}'", YABRIDGE_SCAN_EXE_NAME)),
+            LibArchitecture::Lib32 => files
+                .yabridge_scan_32_exe
+                .as_ref()
+                .ok_or_else(|| anyhow!("Could not find '{}'", YABRIDGE_SCAN_32_EXE_NAME)),
+        };
+        let scanner = match scanner {
+            Ok(scanner) => scanner,
+            Err(err) => {
+                let mut results = results.lock().unwrap();
+                for job in jobs {
+                    results.push((job, ScanResult::Failed(err.to_string())));
+                }
+
+                continue;
+            }
+        };
+
+        let num_workers = rayon::current_num_threads().min(jobs.len());
+        let queue = Mutex::new(jobs);
+        rayon::scope(|s| {
+            for _ in 0..num_workers {
+                s.spawn(|_| run_worker(scanner, wine_prefix.as_deref(), &queue, &results));
+            }
+        });
+    }
+
+    results.into_inner().unwrap()
+}
+
+/// Keep taking jobs from `queue` until it's empty, scanning them using a single `yabridge-scan.exe`
+/// process. A new process is started whenever the previous one crashed or timed out.
+fn run_worker(
+    scanner: &Path,
+    wine_prefix: Option<&Path>,
+    queue: &Mutex<Vec<ScanJob>>,
+    results: &Mutex<Vec<(ScanJob, ScanResult)>>,
+) {
+    let mut worker: Option<ScanWorker> = None;
+    loop {
+        // Don't hold the lock while scanning
+        let job = match queue.lock().unwrap().pop() {
+            Some(job) => job,
+            None => break,
+        };
+
+        if worker.is_none() {
+            match ScanWorker::spawn(scanner, wine_prefix) {
+                Ok(new_worker) => worker = Some(new_worker),
+                Err(err) => {
+                    results
+                        .lock()
+                        .unwrap()
+                        .push((job, ScanResult::Failed(format!("{:#}", err))));
+                    continue;
+                }
+            }
+        }
+
+        let result = match worker.as_mut().unwrap().scan(&job) {
+            Some(result) => result,
+            None => {
+                worker = None;
+                ScanResult::Failed(format!(
+                    "The plugin crashed or did not respond within {} seconds",
+                    SCAN_TIMEOUT.as_secs()
+                ))
+            }
+        };
+        results.lock().unwrap().push((job, result));
+    }
+}
+
+/// Find the Wine prefix a plugin will be run in, mirroring `find_wine_prefix()` from
+/// `src/plugin/utils.cpp`. Returns `None` when the prefix should be left to `WINEPREFIX` or to
+/// Wine's default.
+fn find_wine_prefix(library_path: &Path) -> Option<PathBuf> {
+    if env::var_os("WINEPREFIX").is_some() {
+        return None;
+    }
+
+    let library_path = library_path
+        .canonicalize()
+        .unwrap_or_else(|_| library_path.to_owned());
+    library_path
+        .ancestors()
+        .find(|directory| directory.join("dosdevices").is_dir())
+        .map(|prefix| prefix.to_owned())
+}